@@ -19,6 +19,7 @@
 #include <fcntl.h>
 #include <pwd.h>
 #include <signal.h>
+#include <spawn.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -28,6 +29,8 @@
 
 static void run_command(int ptm_fd, String command)
 {
+    // NOTE: This can't be a posix_spawn(), since the child has to make the pseudoterminal
+    //       its controlling terminal (TIOCSCTTY), and there's no file action for that.
     pid_t pid = fork();
     if (pid == 0) {
         const char* tty_name = ptsname(ptm_fd);
@@ -194,10 +197,10 @@ int main(int argc, char** argv)
 
     auto app_menu = GMenu::construct("Terminal");
     app_menu->add_action(GAction::create("Open new terminal", { Mod_Ctrl | Mod_Shift, Key_N }, GraphicsBitmap::load_from_file("/res/icons/16x16/app-terminal.png"), [&](auto&) {
-        if (!fork()) {
-            execl("/bin/Terminal", "Terminal", nullptr);
-            exit(1);
-        }
+        pid_t child;
+        const char* argv[] = { "Terminal", nullptr };
+        if ((errno = posix_spawn(&child, "/bin/Terminal", nullptr, nullptr, const_cast<char**>(argv), environ)))
+            perror("posix_spawn");
     }));
     app_menu->add_action(GAction::create("Settings...", load_png("/res/icons/gear16.png"),
         [&](const GAction&) {
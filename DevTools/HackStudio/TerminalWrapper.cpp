@@ -54,6 +54,8 @@ void TerminalWrapper::run_command(const String& command)
             on_command_exit();
     };
 
+    // NOTE: This can't be a posix_spawn(), since the child has to make the pseudoterminal
+    //       its controlling terminal (TIOCSCTTY), and there's no file action for that.
     m_pid = fork();
     if (m_pid == 0) {
         // Create a new process group.
@@ -203,6 +203,7 @@ int main(int argc, char** argv)
     dbg() << "#include <LibDraw/Rect.h>";
     dbg() << "#include <LibIPC/IEncoder.h>";
     dbg() << "#include <LibIPC/IEndpoint.h>";
+    dbg() << "#include <LibIPC/IFile.h>";
     dbg() << "#include <LibIPC/IMessage.h>";
     dbg();
 
@@ -271,11 +272,18 @@ int main(int argc, char** argv)
             dbg() << "    static i32 static_message_id() { return (int)MessageID::" << name << "; }";
             dbg() << "    virtual String message_name() const override { return \"" << endpoint.name << "::" << name << "\"; }";
             dbg() << "    static String static_message_name() { return \"" << endpoint.name << "::" << name << "\"; }";
-            dbg() << "    static OwnPtr<" << name << "> decode(BufferStream& stream, size_t& size_in_bytes)";
+            dbg() << "    static OwnPtr<" << name << "> decode(BufferStream& stream, Queue<int>& fds, size_t& size_in_bytes)";
             dbg() << "    {";
 
             if (parameters.is_empty())
                 dbg() << "        (void)stream;";
+            bool has_file_parameters = false;
+            for (auto& parameter : parameters) {
+                if (parameter.type == "IFile")
+                    has_file_parameters = true;
+            }
+            if (!has_file_parameters)
+                dbg() << "        (void)fds;";
 
             for (auto& parameter : parameters) {
                 String initial_value = "{}";
@@ -298,6 +306,14 @@ int main(int argc, char** argv)
                     dbg() << "            }";
                     dbg() << "            " << parameter.name << " = *" << parameter.name << "_impl;";
                     dbg() << "        }";
+                } else if (parameter.type == "IFile") {
+                    dbg() << "        bool " << parameter.name << "_is_valid = false;";
+                    dbg() << "        stream >> " << parameter.name << "_is_valid;";
+                    dbg() << "        if (" << parameter.name << "_is_valid) {";
+                    dbg() << "            if (fds.is_empty())";
+                    dbg() << "                return nullptr;";
+                    dbg() << "            " << parameter.name << " = IFile(fds.dequeue());";
+                    dbg() << "        }";
                 } else if (parameter.type == "Color") {
                     dbg() << "        u32 " << parameter.name << "_rgba = 0;";
                     dbg() << "        stream >> " << parameter.name << "_rgba;";
@@ -430,7 +446,7 @@ int main(int argc, char** argv)
         dbg() << "    virtual int magic() const override { return " << endpoint.magic << "; }";
         dbg() << "    static String static_name() { return \"" << endpoint.name << "\"; };";
         dbg() << "    virtual String name() const override { return \"" << endpoint.name << "\"; };";
-        dbg() << "    static OwnPtr<IMessage> decode_message(const ByteBuffer& buffer, size_t& size_in_bytes)";
+        dbg() << "    static OwnPtr<IMessage> decode_message(const ByteBuffer& buffer, Queue<int>& fds, size_t& size_in_bytes)";
         dbg() << "    {";
         dbg() << "        BufferStream stream(const_cast<ByteBuffer&>(buffer));";
         dbg() << "        i32 message_endpoint_magic = 0;";
@@ -447,7 +463,7 @@ int main(int argc, char** argv)
         for (auto& message : endpoint.messages) {
             auto do_decode_message = [&](const String& name) {
                 dbg() << "        case (int)" << endpoint.name << "::MessageID::" << name << ":";
-                dbg() << "            return " << endpoint.name << "::" << name << "::decode(stream, size_in_bytes);";
+                dbg() << "            return " << endpoint.name << "::" << name << "::decode(stream, fds, size_in_bytes);";
             };
             do_decode_message(message.name);
             if (message.is_synchronous)
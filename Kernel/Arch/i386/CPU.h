@@ -8,6 +8,10 @@
 #define PAGE_SIZE 4096
 #define PAGE_MASK 0xfffff000
 
+// With PAE paging, a large page is 2 MB and is mapped directly by a page directory entry.
+#define LARGE_PAGE_SIZE 0x200000
+#define LARGE_PAGE_MASK 0xffe00000
+
 class MemoryManager;
 class PageDirectory;
 class PageTableEntry;
@@ -94,6 +98,13 @@ public:
         m_raw |= value & 0xfffff000;
     }
 
+    u32 large_page_base() const { return m_raw & LARGE_PAGE_MASK; }
+    void set_large_page_base(u32 value)
+    {
+        m_raw &= 0x8000000000000fffULL;
+        m_raw |= value & LARGE_PAGE_MASK;
+    }
+
     u64 raw() const { return m_raw; }
     void copy_from(Badge<PageDirectory>, const PageDirectoryEntry& other) { m_raw = other.m_raw; }
 
@@ -103,6 +114,7 @@ public:
         UserSupervisor = 1 << 2,
         WriteThrough = 1 << 3,
         CacheDisabled = 1 << 4,
+        Huge = 1 << 7,
         Global = 1 << 8,
         NoExecute = 0x8000000000000000ULL,
     };
@@ -122,12 +134,17 @@ public:
     bool is_cache_disabled() const { return raw() & CacheDisabled; }
     void set_cache_disabled(bool b) { set_bit(CacheDisabled, b); }
 
+    bool is_huge() const { return raw() & Huge; }
+    void set_huge(bool b) { set_bit(Huge, b); }
+
     bool is_global() const { return raw() & Global; }
     void set_global(bool b) { set_bit(Global, b); }
 
     bool is_execute_disabled() const { return raw() & NoExecute; }
     void set_execute_disabled(bool b) { set_bit(NoExecute, b); }
 
+    void clear() { m_raw = 0; }
+
     void set_bit(u64 bit, bool value)
     {
         if (value)
@@ -157,7 +174,10 @@ public:
         UserSupervisor = 1 << 2,
         WriteThrough = 1 << 3,
         CacheDisabled = 1 << 4,
+        Accessed = 1 << 5,
+        Dirty = 1 << 6,
         Global = 1 << 8,
+        Swapped = 1 << 9,
         NoExecute = 0x8000000000000000ULL,
     };
 
@@ -179,9 +199,27 @@ public:
     bool is_global() const { return raw() & Global; }
     void set_global(bool b) { set_bit(Global, b); }
 
+    bool is_accessed() const { return raw() & Accessed; }
+    void set_accessed(bool b) { set_bit(Accessed, b); }
+
+    bool is_dirty() const { return raw() & Dirty; }
+    void set_dirty(bool b) { set_bit(Dirty, b); }
+
+    // NOTE: The CPU ignores everything else in a not-present entry, so we stash the swap slot
+    //       of a swapped-out page in the physical page base bits.
+    bool is_swapped() const { return !is_present() && (raw() & Swapped); }
+    u32 swap_slot() const { return (u32)raw() >> 12; }
+    void set_swap_slot(u32 slot)
+    {
+        set_physical_page_base(slot << 12);
+        set_bit(Swapped, slot != 0);
+    }
+
     bool is_execute_disabled() const { return raw() & NoExecute; }
     void set_execute_disabled(bool b) { set_bit(NoExecute, b); }
 
+    void clear() { m_raw = 0; }
+
     void set_bit(u64 bit, bool value)
     {
         if (value)
@@ -20,6 +20,7 @@ public:
     virtual bool write_blocks(unsigned index, u16 count, const u8*) = 0;
 
     virtual bool is_disk_device() const override { return true; };
+    virtual bool is_disk_partition() const { return false; }
 
 protected:
     DiskDevice(int major, int minor, size_t block_size = 512);
@@ -12,6 +12,9 @@ public:
     virtual bool write_block(unsigned index, const u8*) override;
     virtual bool read_blocks(unsigned index, u16 count, u8*) override;
     virtual bool write_blocks(unsigned index, u16 count, const u8*) override;
+    virtual bool is_disk_partition() const override { return true; }
+
+    unsigned block_count() const { return m_block_limit - m_block_offset; }
 
     // ^BlockDevice
     virtual ssize_t read(FileDescription&, u8*, ssize_t) override { return 0; }
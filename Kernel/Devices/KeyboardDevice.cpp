@@ -295,6 +295,7 @@ void KeyboardDevice::key_state_changed(u8 raw, bool pressed)
     if (m_client)
         m_client->on_key_pressed(event);
     m_queue.enqueue(event);
+    did_change_readiness();
 
     m_has_e0_prefix = false;
 }
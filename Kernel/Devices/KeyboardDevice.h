@@ -25,6 +25,7 @@ public:
 
     // ^CharacterDevice
     virtual ssize_t read(FileDescription&, u8* buffer, ssize_t) override;
+    virtual bool notifies_readiness() const override { return true; }
     virtual bool can_read(const FileDescription&) const override;
     virtual ssize_t write(FileDescription&, const u8* buffer, ssize_t) override;
     virtual bool can_write(const FileDescription&) const override { return true; }
@@ -0,0 +1,19 @@
+#include <Kernel/Devices/MemoryPressureDevice.h>
+#include <Kernel/Devices/MemoryPressureWatcher.h>
+#include <Kernel/FileSystem/FileDescription.h>
+
+MemoryPressureDevice::MemoryPressureDevice()
+    : CharacterDevice(1, 19)
+{
+}
+
+MemoryPressureDevice::~MemoryPressureDevice()
+{
+}
+
+KResultOr<NonnullRefPtr<FileDescription>> MemoryPressureDevice::open(int options)
+{
+    auto description = FileDescription::create(MemoryPressureWatcher::create());
+    description->set_rw_mode(options);
+    return description;
+}
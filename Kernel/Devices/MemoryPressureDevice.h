@@ -0,0 +1,24 @@
+#pragma once
+
+#include <Kernel/Devices/CharacterDevice.h>
+
+// /dev/mempressure: Every open() vends a MemoryPressureWatcher, which becomes
+// readable whenever the kernel's memory pressure level changes.
+
+class MemoryPressureDevice final : public CharacterDevice {
+    AK_MAKE_ETERNAL
+public:
+    MemoryPressureDevice();
+    virtual ~MemoryPressureDevice() override;
+
+    // ^CharacterDevice
+    virtual KResultOr<NonnullRefPtr<FileDescription>> open(int options) override;
+    virtual ssize_t read(FileDescription&, u8*, ssize_t) override { return 0; }
+    virtual ssize_t write(FileDescription&, const u8*, ssize_t) override { return -EIO; }
+    virtual bool can_read(const FileDescription&) const override { return true; }
+    virtual bool can_write(const FileDescription&) const override { return true; }
+
+private:
+    // ^CharacterDevice
+    virtual const char* class_name() const override { return "MemoryPressureDevice"; }
+};
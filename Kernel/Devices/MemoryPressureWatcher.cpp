@@ -0,0 +1,53 @@
+#include <Kernel/Devices/MemoryPressureWatcher.h>
+#include <Kernel/VM/MemoryManager.h>
+#include <LibC/errno_numbers.h>
+
+NonnullRefPtr<MemoryPressureWatcher> MemoryPressureWatcher::create()
+{
+    return adopt(*new MemoryPressureWatcher);
+}
+
+MemoryPressureWatcher::MemoryPressureWatcher()
+{
+    // Make the current level readable right away, unless everything is fine.
+    InterruptDisabler disabler;
+    m_seen_generation = MM.memory_pressure_generation();
+    if (MM.memory_pressure() != MemoryManager::MemoryPressure::None)
+        --m_seen_generation;
+}
+
+MemoryPressureWatcher::~MemoryPressureWatcher()
+{
+}
+
+bool MemoryPressureWatcher::can_read(const FileDescription&) const
+{
+    return MM.memory_pressure_generation() != m_seen_generation;
+}
+
+ssize_t MemoryPressureWatcher::read(FileDescription&, u8* buffer, ssize_t size)
+{
+    MemoryManager::MemoryPressure pressure;
+    {
+        InterruptDisabler disabler;
+        pressure = MM.memory_pressure();
+        m_seen_generation = MM.memory_pressure_generation();
+    }
+
+    const char* level = nullptr;
+    switch (pressure) {
+    case MemoryManager::MemoryPressure::None:
+        level = "none\n";
+        break;
+    case MemoryManager::MemoryPressure::Low:
+        level = "low\n";
+        break;
+    case MemoryManager::MemoryPressure::Critical:
+        level = "critical\n";
+        break;
+    }
+
+    ssize_t nread = min((ssize_t)strlen(level), size);
+    memcpy(buffer, level, nread);
+    return nread;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <Kernel/FileSystem/File.h>
+
+class MemoryPressureWatcher final : public File {
+public:
+    static NonnullRefPtr<MemoryPressureWatcher> create();
+    virtual ~MemoryPressureWatcher() override;
+
+    virtual bool can_read(const FileDescription&) const override;
+    virtual bool can_write(const FileDescription&) const override { return true; }
+    virtual ssize_t read(FileDescription&, u8*, ssize_t) override;
+    virtual ssize_t write(FileDescription&, const u8*, ssize_t) override { return -EIO; }
+    virtual String absolute_path(const FileDescription&) const override { return "MemoryPressureWatcher"; }
+    virtual const char* class_name() const override { return "MemoryPressureWatcher"; };
+
+private:
+    MemoryPressureWatcher();
+
+    u32 m_seen_generation { 0 };
+};
@@ -119,6 +119,7 @@ void PS2MouseDevice::parse_data_packet()
     packet.buttons = m_data[0] & 0x07;
 
     m_queue.enqueue(packet);
+    did_change_readiness();
 }
 
 void PS2MouseDevice::wait_then_write(u8 port, u8 data)
@@ -14,6 +14,7 @@ public:
     static PS2MouseDevice& the();
 
     // ^CharacterDevice
+    virtual bool notifies_readiness() const override { return true; }
     virtual bool can_read(const FileDescription&) const override;
     virtual ssize_t read(FileDescription&, u8*, ssize_t) override;
     virtual ssize_t write(FileDescription&, const u8*, ssize_t) override;
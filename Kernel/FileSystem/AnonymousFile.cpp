@@ -0,0 +1,59 @@
+#include <Kernel/FileSystem/AnonymousFile.h>
+#include <Kernel/Process.h>
+#include <Kernel/VM/MemoryManager.h>
+#include <LibC/errno_numbers.h>
+
+NonnullRefPtr<AnonymousFile> AnonymousFile::create(const String& name)
+{
+    return adopt(*new AnonymousFile(name));
+}
+
+AnonymousFile::AnonymousFile(const String& name)
+    : m_name(name)
+{
+}
+
+AnonymousFile::~AnonymousFile()
+{
+}
+
+KResult AnonymousFile::truncate(off_t size)
+{
+    if (size < 0)
+        return KResult(-EINVAL);
+
+    LOCKER(m_lock);
+    if (!m_vmobject) {
+        if (size == 0)
+            return KSuccess;
+        m_vmobject = AnonymousVMObject::create_with_size(PAGE_ROUND_UP(size));
+        m_size = size;
+        return KSuccess;
+    }
+    // FIXME: Allow resizing once VMObjects can grow and shrink. Until then, the size
+    //        may only change within the pages we already have.
+    if ((size_t)PAGE_ROUND_UP(size) != m_vmobject->size())
+        return KResult(-EBUSY);
+    m_size = size;
+    return KSuccess;
+}
+
+KResultOr<Region*> AnonymousFile::mmap(Process& process, FileDescription&, VirtualAddress preferred_vaddr, size_t offset, size_t size, int prot)
+{
+    LOCKER(m_lock);
+    if (!m_vmobject)
+        return KResult(-EINVAL);
+    if (offset + size > m_vmobject->size())
+        return KResult(-EINVAL);
+    auto* region = process.allocate_region_with_vmobject(preferred_vaddr, size, *m_vmobject, offset, String::format("memfd:%s", m_name.characters()), prot);
+    if (!region)
+        return KResult(-ENOMEM);
+    // NOTE: Everyone who maps us sees the same pages, even across fork().
+    region->set_shared(true);
+    return region;
+}
+
+String AnonymousFile::absolute_path(const FileDescription&) const
+{
+    return String::format("memfd:%s", m_name.characters());
+}
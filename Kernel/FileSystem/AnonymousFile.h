@@ -0,0 +1,37 @@
+#pragma once
+
+#include <Kernel/FileSystem/File.h>
+#include <Kernel/Lock.h>
+#include <Kernel/VM/AnonymousVMObject.h>
+
+// AnonymousFile is what memfd_create() hands out: a file that exists only in memory,
+// with no name in the file system. It is given a size with ftruncate() and then
+// accessed through mmap(). Every mapping of it shares the same pages, so passing its
+// file descriptor to another process is how the two of them come to share memory.
+class AnonymousFile final : public File {
+public:
+    static NonnullRefPtr<AnonymousFile> create(const String& name);
+    virtual ~AnonymousFile() override;
+
+    size_t size() const { return m_size; }
+
+    // ^File
+    virtual bool can_read(const FileDescription&) const override { return true; }
+    virtual bool can_write(const FileDescription&) const override { return true; }
+    // FIXME: Support read() and write() too, not just mmap().
+    virtual ssize_t read(FileDescription&, u8*, ssize_t) override { return -EINVAL; }
+    virtual ssize_t write(FileDescription&, const u8*, ssize_t) override { return -EINVAL; }
+    virtual KResultOr<Region*> mmap(Process&, FileDescription&, VirtualAddress preferred_vaddr, size_t offset, size_t size, int prot) override;
+    virtual KResult truncate(off_t) override;
+    virtual String absolute_path(const FileDescription&) const override;
+    virtual const char* class_name() const override { return "AnonymousFile"; }
+    virtual bool is_anonymous_file() const override { return true; }
+
+private:
+    explicit AnonymousFile(const String& name);
+
+    String m_name;
+    size_t m_size { 0 };
+    RefPtr<AnonymousVMObject> m_vmobject;
+    Lock m_lock { "AnonymousFile" };
+};
@@ -69,6 +69,16 @@ public:
     const CacheEntry* entries() const { return (const CacheEntry*)m_entries.data(); }
     CacheEntry* entries() { return (CacheEntry*)m_entries.data(); }
 
+    size_t resident_page_count() const
+    {
+        size_t count = 0;
+        for (size_t i = 0; i < m_entry_count; ++i) {
+            if (entries()[i].has_data)
+                ++count;
+        }
+        return PAGE_ROUND_UP(count * m_fs.block_size()) / PAGE_SIZE;
+    }
+
     template<typename Callback>
     void for_each_entry(Callback callback)
     {
@@ -108,6 +118,9 @@ bool DiskBackedFS::write_block(unsigned index, const u8* data, FileDescription*
         return true;
     }
 
+    // NOTE: The cache entry is only valid while we hold the lock,
+    //       shrink_cache() may drop the whole cache from under us otherwise.
+    LOCKER(m_lock);
     auto& entry = cache().get(index);
     memcpy(entry.data, data, block_size());
     entry.is_dirty = true;
@@ -143,6 +156,7 @@ bool DiskBackedFS::read_block(unsigned index, u8* buffer, FileDescription* descr
         return true;
     }
 
+    LOCKER(m_lock);
     auto& entry = cache().get(index);
     if (!entry.has_data) {
         DiskOffset base_offset = static_cast<DiskOffset>(index) * static_cast<DiskOffset>(block_size());
@@ -208,6 +222,18 @@ void DiskBackedFS::flush_writes()
     flush_writes_impl();
 }
 
+size_t DiskBackedFS::shrink_cache()
+{
+    LOCKER(m_lock);
+    if (!m_cache)
+        return 0;
+    flush_writes_impl();
+    size_t freed_page_count = m_cache->resident_page_count();
+    m_cache = nullptr;
+    dbg() << class_name() << ": Dropped block cache (" << freed_page_count << " pages)";
+    return freed_page_count;
+}
+
 DiskCache& DiskBackedFS::cache() const
 {
     if (!m_cache)
@@ -15,6 +15,7 @@ public:
     const DiskDevice& device() const { return *m_device; }
 
     virtual void flush_writes() override;
+    virtual size_t shrink_cache() override;
 
     void flush_writes_impl();
 
@@ -0,0 +1,220 @@
+#include <Kernel/Arch/i386/CPU.h>
+#include <Kernel/FileSystem/EventQueue.h>
+#include <Kernel/FileSystem/FileDescription.h>
+#include <LibC/errno_numbers.h>
+
+//#define EVENT_QUEUE_DEBUG
+
+static constexpr u32 supported_events = EPOLLIN | EPOLLOUT | EPOLLET | EPOLLONESHOT;
+
+EventQueueWatch::EventQueueWatch(EventQueue& queue, FileDescription& description, int fd, const epoll_event& event)
+    : m_queue(queue)
+    , m_description(description)
+    , m_fd(fd)
+    , m_event(event)
+{
+}
+
+u32 EventQueueWatch::ready_events() const
+{
+    u32 events = 0;
+    if ((m_event.events & EPOLLIN) && m_description.can_read())
+        events |= EPOLLIN;
+    if ((m_event.events & EPOLLOUT) && m_description.can_write())
+        events |= EPOLLOUT;
+    return events;
+}
+
+NonnullRefPtr<EventQueue> EventQueue::create()
+{
+    return adopt(*new EventQueue);
+}
+
+EventQueue::EventQueue()
+{
+}
+
+EventQueue::~EventQueue()
+{
+    // NOTE: Nobody else can get to us anymore, except a dying FileDescription
+    //       looking through its file's watches. Unhooking them all at once stops that.
+    InterruptDisabler disabler;
+    for (auto& it : m_watches)
+        it.value->description().file().m_event_queue_watches.remove_first_matching([&](auto* watch) { return watch == it.value.ptr(); });
+}
+
+KResult EventQueue::add(int fd, FileDescription& description, const epoll_event& event)
+{
+    if (&description.file() == this)
+        return KResult(-EINVAL);
+    if (event.events & ~supported_events)
+        return KResult(-EINVAL);
+
+    LOCKER(m_lock);
+    auto it = m_watches.find(fd);
+    if (it != m_watches.end()) {
+        if (&(*it).value->description() == &description)
+            return KResult(-EEXIST);
+        // The fd was closed and reused, but the old description is still open somewhere else.
+        unregister_watch(*(*it).value);
+        m_watches.remove(it);
+    }
+
+    auto watch = make<EventQueueWatch>(*this, description, fd, event);
+    auto& file = description.file();
+    InterruptDisabler disabler;
+    file.m_event_queue_watches.append(watch.ptr());
+    if (!file.notifies_readiness())
+        m_unnotified_watches.append(watch.ptr());
+    // It may well be ready already, in which case we'd never hear about it.
+    enqueue(*watch);
+    m_watches.set(fd, move(watch));
+
+#ifdef EVENT_QUEUE_DEBUG
+    dbgprintf("EventQueue{%p}: Watching fd %d (%s) for %x\n", this, fd, file.class_name(), event.events);
+#endif
+    return KSuccess;
+}
+
+KResult EventQueue::modify(int fd, FileDescription& description, const epoll_event& event)
+{
+    if (event.events & ~supported_events)
+        return KResult(-EINVAL);
+
+    LOCKER(m_lock);
+    auto it = m_watches.find(fd);
+    if (it == m_watches.end() || &(*it).value->description() != &description)
+        return KResult(-ENOENT);
+
+    auto& watch = *(*it).value;
+    InterruptDisabler disabler;
+    watch.m_event = event;
+    watch.m_was_ready = false;
+    enqueue(watch);
+    return KSuccess;
+}
+
+KResult EventQueue::remove(int fd, FileDescription& description)
+{
+    LOCKER(m_lock);
+    auto it = m_watches.find(fd);
+    if (it == m_watches.end() || &(*it).value->description() != &description)
+        return KResult(-ENOENT);
+
+    unregister_watch(*(*it).value);
+    m_watches.remove(it);
+    return KSuccess;
+}
+
+void EventQueue::forget_watches_for(FileDescription& description)
+{
+    struct Entry {
+        NonnullRefPtr<EventQueue> queue;
+        int fd;
+    };
+    Vector<Entry> entries;
+    {
+        InterruptDisabler disabler;
+        for (auto* watch : description.file().m_event_queue_watches) {
+            if (&watch->description() == &description)
+                entries.append({ watch->queue(), watch->fd() });
+        }
+    }
+    for (auto& entry : entries)
+        entry.queue->remove(entry.fd, description);
+}
+
+void EventQueue::unregister_watch(EventQueueWatch& watch)
+{
+    ASSERT(m_lock.is_locked());
+    InterruptDisabler disabler;
+    watch.description().file().m_event_queue_watches.remove_first_matching([&](auto* entry) { return entry == &watch; });
+    m_unnotified_watches.remove_first_matching([&](auto* entry) { return entry == &watch; });
+    if (watch.m_queued) {
+        m_ready_watches.remove(&watch);
+        watch.m_queued = false;
+    }
+}
+
+void EventQueue::enqueue(EventQueueWatch& watch)
+{
+    ASSERT_INTERRUPTS_DISABLED();
+    if (watch.m_queued)
+        return;
+    // A one-shot watch that has fired stays quiet until it's modified.
+    if (!(watch.m_event.events & (EPOLLIN | EPOLLOUT)))
+        return;
+    bool was_empty = m_ready_watches.is_empty();
+    watch.m_queued = true;
+    m_ready_watches.append(&watch);
+    if (was_empty)
+        did_change_readiness();
+}
+
+void EventQueue::poll_unnotified_watches()
+{
+    InterruptDisabler disabler;
+    for (auto* watch : m_unnotified_watches) {
+        bool is_ready = watch->ready_events();
+        // Edge-triggered watches only get queued when they go from not ready to ready.
+        if (is_ready && (!watch->m_was_ready || !(watch->m_event.events & EPOLLET)))
+            enqueue(*watch);
+        watch->m_was_ready = is_ready;
+    }
+}
+
+int EventQueue::collect(epoll_event* events, int max_events)
+{
+    LOCKER(m_lock);
+    poll_unnotified_watches();
+
+    // Level-triggered watches that were ready go back on the ready list when we're done,
+    // so that the next wait looks at them again. They stay marked as queued meanwhile.
+    InlineLinkedList<EventQueueWatch> still_ready;
+
+    int count = 0;
+    while (count < max_events) {
+        EventQueueWatch* watch;
+        {
+            InterruptDisabler disabler;
+            watch = m_ready_watches.remove_head();
+            if (!watch)
+                break;
+            watch->m_queued = false;
+        }
+
+        u32 ready_events = watch->ready_events();
+        if (!ready_events)
+            continue;
+
+        events[count].events = ready_events;
+        events[count].data = watch->m_event.data;
+        ++count;
+
+        InterruptDisabler disabler;
+        if (watch->m_event.events & EPOLLONESHOT) {
+            watch->m_event.events &= ~(EPOLLIN | EPOLLOUT);
+            continue;
+        }
+        if (watch->m_event.events & EPOLLET)
+            continue;
+        if (!watch->m_queued) {
+            watch->m_queued = true;
+            still_ready.append(watch);
+        }
+    }
+
+    InterruptDisabler disabler;
+    m_ready_watches.append(still_ready);
+    return count;
+}
+
+bool EventQueue::can_read(const FileDescription&) const
+{
+    return has_queued_watches();
+}
+
+String EventQueue::absolute_path(const FileDescription&) const
+{
+    return String::format("eventqueue:%u", this);
+}
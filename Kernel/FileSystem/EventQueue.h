@@ -0,0 +1,87 @@
+#pragma once
+
+#include <AK/HashMap.h>
+#include <AK/InlineLinkedList.h>
+#include <AK/OwnPtr.h>
+#include <Kernel/FileSystem/File.h>
+#include <Kernel/Lock.h>
+#include <Kernel/UnixTypes.h>
+
+class EventQueue;
+
+// One file description being watched by an EventQueue.
+class EventQueueWatch : public InlineLinkedListNode<EventQueueWatch> {
+    friend class InlineLinkedListNode<EventQueueWatch>;
+
+public:
+    EventQueueWatch(EventQueue&, FileDescription&, int fd, const epoll_event&);
+
+    EventQueue& queue() { return m_queue; }
+    FileDescription& description() { return m_description; }
+    int fd() const { return m_fd; }
+
+    // The events we're interested in that the description is currently ready for.
+    u32 ready_events() const;
+
+private:
+    friend class EventQueue;
+
+    EventQueue& m_queue;
+    // NOTE: We don't keep the description alive; it forgets about us when it dies.
+    FileDescription& m_description;
+    int m_fd { -1 };
+    epoll_event m_event;
+
+    bool m_queued { false };
+    bool m_was_ready { false };
+
+    // for InlineLinkedList
+    EventQueueWatch* m_prev { nullptr };
+    EventQueueWatch* m_next { nullptr };
+};
+
+// EventQueue implements epoll(). Watches on files that call File::did_change_readiness()
+// are put on a ready list as things happen, so waiting doesn't scale with the number of
+// watched files. Watches on other files are polled when the queue is waited on.
+class EventQueue final : public File {
+public:
+    static NonnullRefPtr<EventQueue> create();
+    virtual ~EventQueue() override;
+
+    KResult add(int fd, FileDescription&, const epoll_event&);
+    KResult modify(int fd, FileDescription&, const epoll_event&);
+    KResult remove(int fd, FileDescription&);
+
+    // Called by a dying FileDescription, so that nobody keeps watching it.
+    static void forget_watches_for(FileDescription&);
+
+    // Called by File::did_change_readiness() with interrupts disabled.
+    void enqueue(EventQueueWatch&);
+
+    // Checks the watches that we can't be notified about, and queues any that are ready.
+    void poll_unnotified_watches();
+    bool has_queued_watches() const { return !m_ready_watches.is_empty(); }
+
+    // Fills `events` with up to `max_events` ready events, and returns the number of events filled in.
+    int collect(epoll_event* events, int max_events);
+
+    // ^File
+    virtual bool is_event_queue() const override { return true; }
+    virtual bool notifies_readiness() const override { return true; }
+    virtual bool can_read(const FileDescription&) const override;
+    virtual bool can_write(const FileDescription&) const override { return false; }
+    virtual ssize_t read(FileDescription&, u8*, ssize_t) override { return -EINVAL; }
+    virtual ssize_t write(FileDescription&, const u8*, ssize_t) override { return -EINVAL; }
+    virtual String absolute_path(const FileDescription&) const override;
+    virtual const char* class_name() const override { return "EventQueue"; }
+
+private:
+    EventQueue();
+
+    void unregister_watch(EventQueueWatch&);
+
+    Lock m_lock { "EventQueue" };
+    HashMap<int, OwnPtr<EventQueueWatch>> m_watches;
+    Vector<EventQueueWatch*> m_unnotified_watches;
+    InlineLinkedList<EventQueueWatch> m_ready_watches;
+};
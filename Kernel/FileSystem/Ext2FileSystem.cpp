@@ -664,6 +664,14 @@ ssize_t Ext2FSInode::read_bytes(off_t offset, ssize_t count, u8* buffer, FileDes
     return nread;
 }
 
+Vector<unsigned> Ext2FSInode::data_block_list() const
+{
+    Locker fs_locker(fs().m_lock);
+    if (m_block_list.is_empty())
+        m_block_list = fs().block_list_for_inode(m_raw_inode);
+    return m_block_list;
+}
+
 KResult Ext2FSInode::resize(u64 new_size)
 {
     u64 old_size = size();
@@ -718,6 +726,9 @@ ssize_t Ext2FSInode::write_bytes(off_t offset, ssize_t count, const u8* data, Fi
     ASSERT(offset >= 0);
     ASSERT(count >= 0);
 
+    if (is_swap_file())
+        return -ETXTBSY;
+
     Locker inode_locker(m_lock);
     Locker fs_locker(fs().m_lock);
 
@@ -1534,6 +1545,8 @@ KResult Ext2FSInode::chown(uid_t uid, gid_t gid)
 
 KResult Ext2FSInode::truncate(off_t size)
 {
+    if (is_swap_file())
+        return KResult(-ETXTBSY);
     LOCKER(m_lock);
     if ((off_t)m_raw_inode.i_size == size)
         return KSuccess;
@@ -8,6 +8,9 @@
 
 //#define FIFO_DEBUG
 
+// How much a FIFO holds before writers have to wait for a reader to catch up.
+static constexpr size_t fifo_buffer_size = 16 * KB;
+
 Lockable<HashTable<FIFO*>>& all_fifos()
 {
     static Lockable<HashTable<FIFO*>>* s_table;
@@ -39,7 +42,8 @@ NonnullRefPtr<FileDescription> FIFO::open_direction(FIFO::Direction direction)
 }
 
 FIFO::FIFO(uid_t uid)
-    : m_uid(uid)
+    : m_buffer(fifo_buffer_size)
+    , m_uid(uid)
 {
     LOCKER(all_fifos().lock());
     all_fifos().resource().set(this);
@@ -64,6 +68,7 @@ void FIFO::attach(Direction direction)
         kprintf("open writer (%u)\n", m_writers);
 #endif
     }
+    did_change_readiness();
 }
 
 void FIFO::detach(Direction direction)
@@ -81,6 +86,7 @@ void FIFO::detach(Direction direction)
         ASSERT(m_writers);
         --m_writers;
     }
+    did_change_readiness();
 }
 
 bool FIFO::can_read(const FileDescription&) const
@@ -90,33 +96,59 @@ bool FIFO::can_read(const FileDescription&) const
 
 bool FIFO::can_write(const FileDescription&) const
 {
-    return m_buffer.bytes_in_write_buffer() < 4096 || !m_readers;
+    return !m_buffer.is_full() || !m_readers;
+}
+
+size_t FIFO::write_capacity(const FileDescription&) const
+{
+    // Without readers, a write fails right away, and there's no point in holding it back.
+    if (!m_readers)
+        return 0xffffffff;
+    return m_buffer.free_bytes();
+}
+
+ssize_t FIFO::read(FileDescription& description, u8* buffer, ssize_t size)
+{
+    iovec vec { buffer, (size_t)size };
+    return readv(description, &vec, 1);
 }
 
-ssize_t FIFO::read(FileDescription&, u8* buffer, ssize_t size)
+ssize_t FIFO::readv(FileDescription&, const iovec* vecs, int iov_count)
 {
     if (!m_writers && m_buffer.is_empty())
         return 0;
 #ifdef FIFO_DEBUG
-    dbgprintf("fifo: read(%u)\n", size);
+    dbgprintf("fifo: read(%u)\n", total_length(vecs, iov_count));
 #endif
-    ssize_t nread = m_buffer.read(buffer, size);
+    ssize_t nread = m_buffer.read(vecs, iov_count);
 #ifdef FIFO_DEBUG
-    dbgprintf("   -> read (%c) %u\n", buffer[0], nread);
+    dbgprintf("   -> read %u\n", nread);
 #endif
+    if (nread > 0)
+        did_change_readiness();
     return nread;
 }
 
-ssize_t FIFO::write(FileDescription&, const u8* buffer, ssize_t size)
+ssize_t FIFO::write(FileDescription& description, const u8* buffer, ssize_t size)
+{
+    iovec vec { const_cast<u8*>(buffer), (size_t)size };
+    return writev(description, &vec, 1);
+}
+
+ssize_t FIFO::writev(FileDescription&, const iovec* vecs, int iov_count)
 {
     if (!m_readers) {
         current->process().send_signal(SIGPIPE, &current->process());
         return -EPIPE;
     }
 #ifdef FIFO_DEBUG
-    dbgprintf("fifo: write(%p, %u)\n", buffer, size);
+    dbgprintf("fifo: write(%u)\n", total_length(vecs, iov_count));
 #endif
-    return m_buffer.write(buffer, size);
+    // NOTE: This only writes what fits; the caller blocks until there's room for the rest.
+    ssize_t nwritten = m_buffer.write(vecs, iov_count);
+    if (nwritten > 0)
+        did_change_readiness();
+    return nwritten;
 }
 
 String FIFO::absolute_path(const FileDescription&) const
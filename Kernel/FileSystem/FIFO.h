@@ -1,7 +1,7 @@
 #pragma once
 
-#include <Kernel/DoubleBuffer.h>
 #include <Kernel/FileSystem/File.h>
+#include <Kernel/RingBuffer.h>
 #include <Kernel/UnixTypes.h>
 
 class FileDescription;
@@ -30,8 +30,12 @@ private:
     // ^File
     virtual ssize_t write(FileDescription&, const u8*, ssize_t) override;
     virtual ssize_t read(FileDescription&, u8*, ssize_t) override;
+    virtual ssize_t writev(FileDescription&, const iovec*, int iov_count) override;
+    virtual ssize_t readv(FileDescription&, const iovec*, int iov_count) override;
+    virtual bool notifies_readiness() const override { return true; }
     virtual bool can_read(const FileDescription&) const override;
     virtual bool can_write(const FileDescription&) const override;
+    virtual size_t write_capacity(const FileDescription&) const override;
     virtual String absolute_path(const FileDescription&) const override;
     virtual const char* class_name() const override { return "FIFO"; }
     virtual bool is_fifo() const override { return true; }
@@ -40,7 +44,7 @@ private:
 
     unsigned m_writers { 0 };
     unsigned m_readers { 0 };
-    DoubleBuffer m_buffer;
+    RingBuffer m_buffer;
 
     uid_t m_uid { 0 };
 };
@@ -1,3 +1,5 @@
+#include <Kernel/Arch/i386/CPU.h>
+#include <Kernel/FileSystem/EventQueue.h>
 #include <Kernel/FileSystem/File.h>
 #include <Kernel/FileSystem/FileDescription.h>
 
@@ -7,6 +9,7 @@ File::File()
 
 File::~File()
 {
+    ASSERT(m_event_queue_watches.is_empty());
 }
 
 KResultOr<NonnullRefPtr<FileDescription>> File::open(int options)
@@ -20,6 +23,34 @@ void File::close()
 {
 }
 
+ssize_t File::readv(FileDescription& description, const iovec* vecs, int iov_count)
+{
+    ssize_t nread = 0;
+    for (int i = 0; i < iov_count; ++i) {
+        ssize_t rc = read(description, (u8*)vecs[i].iov_base, vecs[i].iov_len);
+        if (rc < 0)
+            return nread ? nread : rc;
+        nread += rc;
+        if ((size_t)rc < vecs[i].iov_len)
+            break;
+    }
+    return nread;
+}
+
+ssize_t File::writev(FileDescription& description, const iovec* vecs, int iov_count)
+{
+    ssize_t nwritten = 0;
+    for (int i = 0; i < iov_count; ++i) {
+        ssize_t rc = write(description, (const u8*)vecs[i].iov_base, vecs[i].iov_len);
+        if (rc < 0)
+            return nwritten ? nwritten : rc;
+        nwritten += rc;
+        if ((size_t)rc < vecs[i].iov_len)
+            break;
+    }
+    return nwritten;
+}
+
 int File::ioctl(FileDescription&, unsigned, unsigned)
 {
     return -ENOTTY;
@@ -29,3 +60,10 @@ KResultOr<Region*> File::mmap(Process&, FileDescription&, VirtualAddress, size_t
 {
     return KResult(-ENODEV);
 }
+
+void File::did_change_readiness()
+{
+    InterruptDisabler disabler;
+    for (auto* watch : m_event_queue_watches)
+        watch->queue().enqueue(*watch);
+}
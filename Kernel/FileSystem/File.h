@@ -4,10 +4,12 @@
 #include <AK/RefCounted.h>
 #include <AK/NonnullRefPtr.h>
 #include <AK/Types.h>
+#include <AK/Vector.h>
 #include <Kernel/KResult.h>
 #include <Kernel/UnixTypes.h>
 #include <Kernel/VM/VirtualAddress.h>
 
+class EventQueueWatch;
 class FileDescription;
 class Process;
 class Region;
@@ -20,6 +22,12 @@ class Region;
 //   - Implement reading and writing.
 //   - Return the number of bytes read/written, OR a negative error code.
 //
+// readv() and writev()
+//
+//   - Optional. Scatter/gather versions of read() and write().
+//   - By default they call read() or write() once per buffer, stopping at the first
+//     short transfer. Files that can move all the buffers in one go should override them.
+//
 // can_read() and can_write()
 //
 //   - Used to implement blocking I/O, and the select() and poll() syscalls.
@@ -27,6 +35,14 @@ class Region;
 //   - Note that can_read() should return true in EOF conditions,
 //     and a subsequent call to read() should return 0.
 //
+// did_change_readiness()
+//
+//   - Should be called whenever can_read() or can_write() may have become true.
+//   - This is what lets an EventQueue find out about ready files without polling them.
+//   - Subclasses that call it everywhere they should must override notifies_readiness()
+//     to return true; all others are polled by any EventQueue watching them.
+//   - Safe to call from IRQ handlers.
+//
 // ioctl()
 //
 //   - Optional. If unimplemented, ioctl() on this File will fail with -ENOTTY.
@@ -49,8 +65,14 @@ public:
     virtual bool can_read(const FileDescription&) const = 0;
     virtual bool can_write(const FileDescription&) const = 0;
 
+    // How much a write could take right now without coming up short. Only files whose
+    // writes may take less than they're given need to override this.
+    virtual size_t write_capacity(const FileDescription&) const { return 0xffffffff; }
+
     virtual ssize_t read(FileDescription&, u8*, ssize_t) = 0;
     virtual ssize_t write(FileDescription&, const u8*, ssize_t) = 0;
+    virtual ssize_t readv(FileDescription&, const iovec*, int iov_count);
+    virtual ssize_t writev(FileDescription&, const iovec*, int iov_count);
     virtual int ioctl(FileDescription&, unsigned request, unsigned arg);
     virtual KResultOr<Region*> mmap(Process&, FileDescription&, VirtualAddress preferred_vaddr, size_t offset, size_t size, int prot);
 
@@ -72,7 +94,16 @@ public:
     virtual bool is_block_device() const { return false; }
     virtual bool is_character_device() const { return false; }
     virtual bool is_socket() const { return false; }
+    virtual bool is_event_queue() const { return false; }
+    virtual bool is_anonymous_file() const { return false; }
+
+    virtual bool notifies_readiness() const { return false; }
+    void did_change_readiness();
 
 protected:
     File();
+
+private:
+    friend class EventQueue;
+    Vector<EventQueueWatch*> m_event_queue_watches;
 };
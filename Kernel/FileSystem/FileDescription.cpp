@@ -1,7 +1,9 @@
 #include <AK/BufferStream.h>
 #include <Kernel/Devices/BlockDevice.h>
 #include <Kernel/Devices/CharacterDevice.h>
+#include <Kernel/FileSystem/AnonymousFile.h>
 #include <Kernel/FileSystem/Custody.h>
+#include <Kernel/FileSystem/EventQueue.h>
 #include <Kernel/FileSystem/FIFO.h>
 #include <Kernel/FileSystem/FileDescription.h>
 #include <Kernel/FileSystem/FileSystem.h>
@@ -38,6 +40,7 @@ FileDescription::FileDescription(File& file)
 
 FileDescription::~FileDescription()
 {
+    EventQueue::forget_watches_for(*this);
     if (is_socket())
         socket()->detach(*this);
     if (is_fifo())
@@ -59,6 +62,12 @@ KResult FileDescription::fstat(stat& buffer)
         buffer.st_mode = 0140000;
         return KSuccess;
     }
+    if (m_file->is_anonymous_file()) {
+        memset(&buffer, 0, sizeof(buffer));
+        buffer.st_mode = 0100600;
+        buffer.st_size = static_cast<AnonymousFile&>(*m_file).size();
+        return KSuccess;
+    }
 
     if (!m_inode)
         return KResult(-EBADF);
@@ -119,6 +128,43 @@ ssize_t FileDescription::write(const u8* data, ssize_t size)
     return nwritten;
 }
 
+ssize_t FileDescription::readv(const iovec* vecs, int iov_count)
+{
+    if (m_file->is_seekable()) {
+        // NOTE: Seekable files need the offset moved along between buffers.
+        ssize_t nread = 0;
+        for (int i = 0; i < iov_count; ++i) {
+            ssize_t rc = read((u8*)vecs[i].iov_base, vecs[i].iov_len);
+            if (rc < 0)
+                return nread ? nread : rc;
+            nread += rc;
+            if ((size_t)rc < vecs[i].iov_len)
+                break;
+        }
+        return nread;
+    }
+    SmapDisabler disabler;
+    return m_file->readv(*this, vecs, iov_count);
+}
+
+ssize_t FileDescription::writev(const iovec* vecs, int iov_count)
+{
+    if (m_file->is_seekable()) {
+        ssize_t nwritten = 0;
+        for (int i = 0; i < iov_count; ++i) {
+            ssize_t rc = write((const u8*)vecs[i].iov_base, vecs[i].iov_len);
+            if (rc < 0)
+                return nwritten ? nwritten : rc;
+            nwritten += rc;
+            if ((size_t)rc < vecs[i].iov_len)
+                break;
+        }
+        return nwritten;
+    }
+    SmapDisabler disabler;
+    return m_file->writev(*this, vecs, iov_count);
+}
+
 bool FileDescription::can_write() const
 {
     return m_file->can_write(*this);
@@ -50,6 +50,8 @@ public:
     off_t seek(off_t, int whence);
     ssize_t read(u8*, ssize_t);
     ssize_t write(const u8* data, ssize_t);
+    ssize_t readv(const iovec*, int iov_count);
+    ssize_t writev(const iovec*, int iov_count);
     KResult fstat(stat&);
 
     KResult chmod(mode_t);
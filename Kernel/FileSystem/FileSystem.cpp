@@ -71,6 +71,21 @@ void FS::sync()
         fs.flush_writes();
 }
 
+size_t FS::shrink_caches()
+{
+    NonnullRefPtrVector<FS, 32> fses;
+    {
+        InterruptDisabler disabler;
+        for (auto& it : all_fses())
+            fses.append(*it.value);
+    }
+
+    size_t freed_page_count = 0;
+    for (auto& fs : fses)
+        freed_page_count += fs.shrink_cache();
+    return freed_page_count;
+}
+
 void FS::lock_all()
 {
     for (auto& it : all_fses()) {
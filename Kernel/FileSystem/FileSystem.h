@@ -33,6 +33,7 @@ public:
     static FS* from_fsid(u32);
     static void sync();
     static void lock_all();
+    static size_t shrink_caches();
 
     virtual bool initialize() = 0;
     virtual const char* class_name() const = 0;
@@ -65,6 +66,9 @@ public:
 
     virtual void flush_writes() {}
 
+    // Releases memory held by caches that can be rebuilt later. Returns the number of pages freed.
+    virtual size_t shrink_cache() { return 0; }
+
     int block_size() const { return m_block_size; }
 
     virtual bool is_disk_backed() const { return false; }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <AK/Badge.h>
 #include <AK/String.h>
 #include <AK/Function.h>
 #include <AK/InlineLinkedList.h>
@@ -15,6 +16,7 @@ class FileDescription;
 class InodeVMObject;
 class InodeWatcher;
 class LocalSocket;
+class SwapArea;
 
 class Inode : public RefCounted<Inode>
     , public Weakable<Inode>
@@ -54,6 +56,15 @@ public:
     virtual KResult chown(uid_t, gid_t) = 0;
     virtual KResult truncate(off_t) { return KSuccess; }
 
+    // The on-disk blocks holding this inode's data, in file order.
+    // Returns an empty list if the file system can't tell (or has no disk).
+    virtual Vector<unsigned> data_block_list() const { return {}; }
+
+    // An active swap file is written to behind the file system's back, so its data and
+    // blocks have to stay where they are. Writing, truncating or unlinking it fails.
+    bool is_swap_file() const { return m_is_swap_file; }
+    void set_swap_file(Badge<SwapArea>, bool is_swap_file) { m_is_swap_file = is_swap_file; }
+
     LocalSocket* socket() { return m_socket.ptr(); }
     const LocalSocket* socket() const { return m_socket.ptr(); }
     bool bind_socket(LocalSocket&);
@@ -101,4 +112,5 @@ private:
     RefPtr<LocalSocket> m_socket;
     HashTable<InodeWatcher*> m_watchers;
     bool m_metadata_dirty { false };
+    bool m_is_swap_file { false };
 };
@@ -26,6 +26,7 @@
 #include <Kernel/Profiling.h>
 #include <Kernel/VM/MemoryManager.h>
 #include <Kernel/VM/PurgeableVMObject.h>
+#include <Kernel/VM/SwapArea.h>
 #include <LibC/errno_numbers.h>
 
 enum ProcParentDirectory {
@@ -66,6 +67,7 @@ enum ProcFileType {
 
     FI_Root_net_adapters,
     FI_Root_net_arp,
+    FI_Root_net_route,
     FI_Root_net_tcp,
     FI_Root_net_udp,
     FI_Root_net_local,
@@ -420,12 +422,27 @@ Optional<KBuffer> procfs$net_arp(InodeIdentifier)
 {
     KBufferBuilder builder;
     JsonArraySerializer array { builder };
-    LOCKER(arp_table().lock());
-    for (auto& it : arp_table().resource()) {
+    for_each_arp_table_entry([&array](auto& address, auto& entry) {
         auto obj = array.add_object();
-        obj.add("mac_address", it.value.to_string());
-        obj.add("ip_address", it.key.to_string());
-    }
+        obj.add("mac_address", entry.mac_address.to_string());
+        obj.add("ip_address", address.to_string());
+        obj.add("state", to_string(entry.state));
+    });
+    array.finish();
+    return builder.build();
+}
+
+Optional<KBuffer> procfs$net_route(InodeIdentifier)
+{
+    KBufferBuilder builder;
+    JsonArraySerializer array { builder };
+    for_each_route([&array](auto& route) {
+        auto obj = array.add_object();
+        obj.add("destination", route.destination.to_string());
+        obj.add("netmask", route.netmask.to_string());
+        obj.add("gateway", route.gateway.to_string());
+        obj.add("adapter", route.adapter ? route.adapter->name() : "");
+    });
     array.finish();
     return builder.build();
 }
@@ -447,6 +464,13 @@ Optional<KBuffer> procfs$net_tcp(InodeIdentifier)
         obj.add("bytes_in", socket.bytes_in());
         obj.add("packets_out", socket.packets_out());
         obj.add("bytes_out", socket.bytes_out());
+        obj.add("send_window", socket.send_window());
+        obj.add("mss", socket.send_mss());
+        obj.add("congestion_window", socket.congestion_window());
+        obj.add("slow_start_threshold", socket.slow_start_threshold());
+        obj.add("srtt", socket.smoothed_rtt());
+        obj.add("rto", socket.retransmission_timeout());
+        obj.add("retransmissions", socket.retransmissions());
     });
     array.finish();
     return builder.build();
@@ -725,6 +749,12 @@ Optional<KBuffer> procfs$memstat(InodeIdentifier)
     json.add("user_physical_available", MM.user_physical_pages() - MM.user_physical_pages_used());
     json.add("super_physical_allocated", MM.super_physical_pages_used());
     json.add("super_physical_available", MM.super_physical_pages() - MM.super_physical_pages_used());
+    json.add("memory_pressure", (u32)MM.memory_pressure());
+    json.add("low_watermark", MM.low_watermark());
+    json.add("high_watermark", MM.high_watermark());
+    json.add("critical_watermark", MM.critical_watermark());
+    json.add("swap_total", (u32)(SwapArea::the() ? SwapArea::the()->slot_count() - 1 : 0));
+    json.add("swap_used", (u32)(SwapArea::the() ? SwapArea::the()->used_slot_count() : 0));
     json.add("kmalloc_call_count", g_kmalloc_call_count);
     json.add("kfree_call_count", g_kfree_call_count);
     slab_alloc_stats([&json](size_t slab_size, size_t num_allocated, size_t num_free) {
@@ -778,6 +808,7 @@ Optional<KBuffer> procfs$all(InodeIdentifier)
             thread_object.add("inode_faults", thread.inode_faults());
             thread_object.add("zero_faults", thread.zero_faults());
             thread_object.add("cow_faults", thread.cow_faults());
+            thread_object.add("swap_faults", thread.swap_faults());
             thread_object.add("file_read_bytes", thread.file_read_bytes());
             thread_object.add("file_write_bytes", thread.file_write_bytes());
             thread_object.add("unix_socket_read_bytes", thread.unix_socket_read_bytes());
@@ -1165,6 +1196,7 @@ bool ProcFSInode::traverse_as_directory(Function<bool(const FS::DirectoryEntry&)
     case FI_Root_net:
         callback({ "adapters", 8, to_identifier(fsid(), PDI_Root_net, 0, FI_Root_net_adapters), 0 });
         callback({ "arp", 3, to_identifier(fsid(), PDI_Root_net, 0, FI_Root_net_arp), 0 });
+        callback({ "route", 5, to_identifier(fsid(), PDI_Root_net, 0, FI_Root_net_route), 0 });
         callback({ "tcp", 3, to_identifier(fsid(), PDI_Root_net, 0, FI_Root_net_tcp), 0 });
         callback({ "udp", 3, to_identifier(fsid(), PDI_Root_net, 0, FI_Root_net_udp), 0 });
         callback({ "local", 5, to_identifier(fsid(), PDI_Root_net, 0, FI_Root_net_local), 0 });
@@ -1254,6 +1286,8 @@ InodeIdentifier ProcFSInode::lookup(StringView name)
             return to_identifier(fsid(), PDI_Root, 0, FI_Root_net_adapters);
         if (name == "arp")
             return to_identifier(fsid(), PDI_Root, 0, FI_Root_net_arp);
+        if (name == "route")
+            return to_identifier(fsid(), PDI_Root, 0, FI_Root_net_route);
         if (name == "tcp")
             return to_identifier(fsid(), PDI_Root, 0, FI_Root_net_tcp);
         if (name == "udp")
@@ -1392,6 +1426,7 @@ ProcFS::ProcFS()
 
     m_entries[FI_Root_net_adapters] = { "adapters", FI_Root_net_adapters, false, procfs$net_adapters };
     m_entries[FI_Root_net_arp] = { "arp", FI_Root_net_arp, true, procfs$net_arp };
+    m_entries[FI_Root_net_route] = { "route", FI_Root_net_route, true, procfs$net_route };
     m_entries[FI_Root_net_tcp] = { "tcp", FI_Root_net_tcp, false, procfs$net_tcp };
     m_entries[FI_Root_net_udp] = { "udp", FI_Root_net_udp, false, procfs$net_udp };
     m_entries[FI_Root_net_local] = { "local", FI_Root_net_local, false, procfs$net_local };
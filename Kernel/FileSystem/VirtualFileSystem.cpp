@@ -163,7 +163,7 @@ KResult VFS::utime(StringView path, Custody& base, time_t atime, time_t mtime)
     auto& inode = *descriptor_or_error.value()->inode();
     if (inode.fs().is_readonly())
         return KResult(-EROFS);
-    if (!current->process().is_superuser() && inode.metadata().uid != current->process().euid())
+    if (!current->credentials_process().is_superuser() && inode.metadata().uid != current->credentials_process().euid())
         return KResult(-EACCES);
 
     int error = inode.set_atime(atime);
@@ -216,11 +216,11 @@ KResultOr<NonnullRefPtr<FileDescription>> VFS::open(StringView path, int options
     // NOTE: Read permission is a bit weird, since O_RDONLY == 0,
     //       so we check if (NOT write_only OR read_and_write)
     if (!(options & O_WRONLY) || (options & O_RDWR)) {
-        if (!metadata.may_read(current->process()))
+        if (!metadata.may_read(current->credentials_process()))
             return KResult(-EACCES);
     }
     if ((options & O_WRONLY) || (options & O_RDWR)) {
-        if (!metadata.may_write(current->process()))
+        if (!metadata.may_write(current->credentials_process()))
             return KResult(-EACCES);
         if (metadata.is_directory())
             return KResult(-EISDIR);
@@ -257,13 +257,13 @@ KResult VFS::mknod(StringView path, mode_t mode, dev_t dev, Custody& base)
     if (existing_file_or_error.error() != -ENOENT)
         return existing_file_or_error.error();
     auto& parent_inode = parent_custody->inode();
-    if (!parent_inode.metadata().may_write(current->process()))
+    if (!parent_inode.metadata().may_write(current->credentials_process()))
         return KResult(-EACCES);
 
     FileSystemPath p(path);
     dbg() << "VFS::mknod: '" << p.basename() << "' mode=" << mode << " dev=" << dev << " in " << parent_inode.identifier();
     int error;
-    auto new_file = parent_inode.fs().create_inode(parent_inode.identifier(), p.basename(), mode, 0, dev, current->process().uid(), current->process().gid(), error);
+    auto new_file = parent_inode.fs().create_inode(parent_inode.identifier(), p.basename(), mode, 0, dev, current->credentials_process().uid(), current->credentials_process().gid(), error);
     if (!new_file)
         return KResult(error);
 
@@ -280,14 +280,14 @@ KResultOr<NonnullRefPtr<FileDescription>> VFS::create(StringView path, int optio
     }
 
     auto& parent_inode = parent_custody.inode();
-    if (!parent_inode.metadata().may_write(current->process()))
+    if (!parent_inode.metadata().may_write(current->credentials_process()))
         return KResult(-EACCES);
     FileSystemPath p(path);
     dbg() << "VFS::create: '" << p.basename() << "' in " << parent_inode.identifier();
     int error;
 
-    uid_t uid = owner.has_value() ? owner.value().uid : current->process().uid();
-    gid_t gid = owner.has_value() ? owner.value().gid : current->process().gid();
+    uid_t uid = owner.has_value() ? owner.value().uid : current->credentials_process().uid();
+    gid_t gid = owner.has_value() ? owner.value().gid : current->credentials_process().gid();
     auto new_file = parent_inode.fs().create_inode(parent_inode.identifier(), p.basename(), mode, 0, 0, uid, gid, error);
     if (!new_file)
         return KResult(error);
@@ -308,13 +308,13 @@ KResult VFS::mkdir(StringView path, mode_t mode, Custody& base)
         return result.error();
 
     auto& parent_inode = parent_custody->inode();
-    if (!parent_inode.metadata().may_write(current->process()))
+    if (!parent_inode.metadata().may_write(current->credentials_process()))
         return KResult(-EACCES);
 
     FileSystemPath p(path);
     dbg() << "VFS::mkdir: '" << p.basename() << "' in " << parent_inode.identifier();
     int error;
-    auto new_dir = parent_inode.fs().create_directory(parent_inode.identifier(), p.basename(), mode, current->process().uid(), current->process().gid(), error);
+    auto new_dir = parent_inode.fs().create_directory(parent_inode.identifier(), p.basename(), mode, current->credentials_process().uid(), current->credentials_process().gid(), error);
     if (new_dir)
         return KSuccess;
     return KResult(error);
@@ -329,15 +329,15 @@ KResult VFS::access(StringView path, int mode, Custody& base)
     auto& inode = custody.inode();
     auto metadata = inode.metadata();
     if (mode & R_OK) {
-        if (!metadata.may_read(current->process()))
+        if (!metadata.may_read(current->credentials_process()))
             return KResult(-EACCES);
     }
     if (mode & W_OK) {
-        if (!metadata.may_write(current->process()))
+        if (!metadata.may_write(current->credentials_process()))
             return KResult(-EACCES);
     }
     if (mode & X_OK) {
-        if (!metadata.may_execute(current->process()))
+        if (!metadata.may_execute(current->credentials_process()))
             return KResult(-EACCES);
     }
     return KSuccess;
@@ -352,7 +352,7 @@ KResultOr<NonnullRefPtr<Custody>> VFS::open_directory(StringView path, Custody&
     auto& inode = custody.inode();
     if (!inode.is_directory())
         return KResult(-ENOTDIR);
-    if (!inode.metadata().may_execute(current->process()))
+    if (!inode.metadata().may_execute(current->credentials_process()))
         return KResult(-EACCES);
     return custody;
 }
@@ -362,7 +362,7 @@ KResult VFS::chmod(Inode& inode, mode_t mode)
     if (inode.fs().is_readonly())
         return KResult(-EROFS);
 
-    if (current->process().euid() != inode.metadata().uid && !current->process().is_superuser())
+    if (current->credentials_process().euid() != inode.metadata().uid && !current->credentials_process().is_superuser())
         return KResult(-EPERM);
 
     // Only change the permission bits.
@@ -402,14 +402,14 @@ KResult VFS::rename(StringView old_path, StringView new_path, Custody& base)
     if (&old_parent_inode.fs() != &new_parent_inode.fs())
         return KResult(-EXDEV);
 
-    if (!new_parent_inode.metadata().may_write(current->process()))
+    if (!new_parent_inode.metadata().may_write(current->credentials_process()))
         return KResult(-EACCES);
 
-    if (!old_parent_inode.metadata().may_write(current->process()))
+    if (!old_parent_inode.metadata().may_write(current->credentials_process()))
         return KResult(-EACCES);
 
     if (old_parent_inode.metadata().is_sticky()) {
-        if (!current->process().is_superuser() && old_inode.metadata().uid != current->process().euid())
+        if (!current->credentials_process().is_superuser() && old_inode.metadata().uid != current->credentials_process().euid())
             return KResult(-EACCES);
     }
 
@@ -422,11 +422,13 @@ KResult VFS::rename(StringView old_path, StringView new_path, Custody& base)
         if (&new_inode == &old_inode)
             return KSuccess;
         if (new_parent_inode.metadata().is_sticky()) {
-            if (!current->process().is_superuser() && new_inode.metadata().uid != current->process().euid())
+            if (!current->credentials_process().is_superuser() && new_inode.metadata().uid != current->credentials_process().euid())
                 return KResult(-EACCES);
         }
         if (new_inode.is_directory() && !old_inode.is_directory())
             return KResult(-EISDIR);
+        if (new_inode.is_swap_file())
+            return KResult(-ETXTBSY);
         auto result = new_parent_inode.remove_child(new_basename);
         if (result.is_error())
             return result;
@@ -452,19 +454,19 @@ KResult VFS::chown(Inode& inode, uid_t a_uid, gid_t a_gid)
 
     auto metadata = inode.metadata();
 
-    if (current->process().euid() != metadata.uid && !current->process().is_superuser())
+    if (current->credentials_process().euid() != metadata.uid && !current->credentials_process().is_superuser())
         return KResult(-EPERM);
 
     uid_t new_uid = metadata.uid;
     gid_t new_gid = metadata.gid;
 
     if (a_uid != (uid_t)-1) {
-        if (current->process().euid() != a_uid && !current->process().is_superuser())
+        if (current->credentials_process().euid() != a_uid && !current->credentials_process().is_superuser())
             return KResult(-EPERM);
         new_uid = a_uid;
     }
     if (a_gid != (gid_t)-1) {
-        if (!current->process().in_group(a_gid) && !current->process().is_superuser())
+        if (!current->credentials_process().in_group(a_gid) && !current->credentials_process().is_superuser())
             return KResult(-EPERM);
         new_gid = a_gid;
     }
@@ -507,7 +509,7 @@ KResult VFS::link(StringView old_path, StringView new_path, Custody& base)
     if (parent_inode.fs().is_readonly())
         return KResult(-EROFS);
 
-    if (!parent_inode.metadata().may_write(current->process()))
+    if (!parent_inode.metadata().may_write(current->credentials_process()))
         return KResult(-EACCES);
 
     return parent_inode.add_child(old_inode.identifier(), FileSystemPath(new_path).basename(), old_inode.mode());
@@ -524,13 +526,15 @@ KResult VFS::unlink(StringView path, Custody& base)
 
     if (inode.is_directory())
         return KResult(-EISDIR);
+    if (inode.is_swap_file())
+        return KResult(-ETXTBSY);
 
     auto& parent_inode = parent_custody->inode();
-    if (!parent_inode.metadata().may_write(current->process()))
+    if (!parent_inode.metadata().may_write(current->credentials_process()))
         return KResult(-EACCES);
 
     if (parent_inode.metadata().is_sticky()) {
-        if (!current->process().is_superuser() && inode.metadata().uid != current->process().euid())
+        if (!current->credentials_process().is_superuser() && inode.metadata().uid != current->credentials_process().euid())
             return KResult(-EACCES);
     }
 
@@ -553,13 +557,13 @@ KResult VFS::symlink(StringView target, StringView linkpath, Custody& base)
     if (existing_custody_or_error.error() != -ENOENT)
         return existing_custody_or_error.error();
     auto& parent_inode = parent_custody->inode();
-    if (!parent_inode.metadata().may_write(current->process()))
+    if (!parent_inode.metadata().may_write(current->credentials_process()))
         return KResult(-EACCES);
 
     FileSystemPath p(linkpath);
     dbg() << "VFS::symlink: '" << p.basename() << "' (-> '" << target << "') in " << parent_inode.identifier();
     int error;
-    auto new_file = parent_inode.fs().create_inode(parent_inode.identifier(), p.basename(), 0120644, 0, 0, current->process().uid(), current->process().gid(), error);
+    auto new_file = parent_inode.fs().create_inode(parent_inode.identifier(), p.basename(), 0120644, 0, 0, current->credentials_process().uid(), current->credentials_process().gid(), error);
     if (!new_file)
         return KResult(error);
     ssize_t nwritten = new_file->write_bytes(0, target.length(), (const u8*)target.characters_without_null_termination(), nullptr);
@@ -588,7 +592,7 @@ KResult VFS::rmdir(StringView path, Custody& base)
 
     auto& parent_inode = parent_custody->inode();
 
-    if (!parent_inode.metadata().may_write(current->process()))
+    if (!parent_inode.metadata().may_write(current->credentials_process()))
         return KResult(-EACCES);
 
     if (inode.directory_entry_count() != 2)
@@ -689,7 +693,7 @@ KResultOr<NonnullRefPtr<Custody>> VFS::resolve_path(StringView path, Custody& ba
         auto metadata = crumb_inode->metadata();
         if (!metadata.is_directory())
             return KResult(-ENOTDIR);
-        if (!metadata.may_execute(current->process()))
+        if (!metadata.may_execute(current->credentials_process()))
             return KResult(-EACCES);
 
         auto& part = parts[i];
@@ -1,12 +1,17 @@
 #include <Kernel/IO.h>
 #include <Kernel/Net/E1000NetworkAdapter.h>
+#include <Kernel/Net/EthernetFrameHeader.h>
+#include <Kernel/Net/TCP.h>
 #include <Kernel/Thread.h>
 
 #define REG_CTRL 0x0000
 #define REG_STATUS 0x0008
 #define REG_EEPROM 0x0014
 #define REG_CTRL_EXT 0x0018
-#define REG_IMASK 0x00D0
+#define REG_ICR 0x00C0   // Interrupt Cause Read
+#define REG_ITR 0x00C4   // Interrupt Throttling
+#define REG_IMASK 0x00D0 // Interrupt Mask Set
+#define REG_IMC 0x00D8   // Interrupt Mask Clear
 #define REG_RCTRL 0x0100
 #define REG_RXDESCLO 0x2800
 #define REG_RXDESCHI 0x2804
@@ -24,6 +29,7 @@
 #define REG_RADV 0x282C             // RX Int. Absolute Delay Timer
 #define REG_RSRPD 0x2C00            // RX Small Packet Detect Interrupt
 #define REG_TIPG 0x0410             // Transmit Inter Packet Gap
+#define REG_RXCSUM 0x5000           // RX Checksum Control
 #define ECTRL_SLU 0x40              //set link up
 #define RCTL_EN (1 << 1)            // Receiver Enable
 #define RCTL_SBP (1 << 2)           // Store Bad Packets
@@ -47,6 +53,18 @@
 #define RCTL_PMCF (1 << 23)         // Pass MAC Control Frames
 #define RCTL_SECRC (1 << 26)        // Strip Ethernet CRC
 
+#define RXCSUM_IPOFLD (1 << 8) // IP Checksum Offload Enable
+#define RXCSUM_TUOFLD (1 << 9) // TCP/UDP Checksum Offload Enable
+
+// Receive Status and Errors
+
+#define RSTA_DD (1 << 0)    // Descriptor Done
+#define RSTA_IXSM (1 << 2)  // Ignore Checksum Indication
+#define RSTA_TCPCS (1 << 5) // TCP/UDP Checksum Calculated
+#define RSTA_IPCS (1 << 6)  // IP Checksum Calculated
+#define RERR_TCPE (1 << 5)  // TCP/UDP Checksum Error
+#define RERR_IPE (1 << 6)   // IP Checksum Error
+
 // Buffer Sizes
 #define RCTL_BSIZE_256 (3 << 16)
 #define RCTL_BSIZE_512 (2 << 16)
@@ -66,6 +84,21 @@
 #define CMD_VLE (1 << 6)  // VLAN Packet Enable
 #define CMD_IDE (1 << 7)  // Interrupt Delay Enable
 
+// These only mean something in the extended descriptor formats (CMD_DEXT.)
+
+#define CMD_TSE (1 << 2)  // TCP Segmentation Enable
+#define CMD_DEXT (1 << 5) // Descriptor Extension
+
+#define DTYP_DATA (1 << 20) // Data descriptor (a context descriptor is type 0)
+
+#define TUCMD_TCP (1 << 0)  // The packet is TCP (rather than UDP)
+#define TUCMD_IP (1 << 1)   // The packet is IPv4 (rather than IPv6)
+#define TUCMD_TSE (1 << 2)  // TCP Segmentation Enable
+#define TUCMD_DEXT (1 << 5) // Descriptor Extension
+
+#define POPTS_IXSM (1 << 0) // Insert IP Checksum
+#define POPTS_TXSM (1 << 1) // Insert TCP/UDP Checksum
+
 // TCTL Register
 
 #define TCTL_EN (1 << 1)      // Transmit Enable
@@ -91,6 +124,19 @@
 #define STATUS_SPEED_1000MB1 0x80
 #define STATUS_SPEED_1000MB2 0xC0
 
+// Interrupt causes
+
+#define INTERRUPT_TXDW (1 << 0)   // Transmit Descriptor Written Back
+#define INTERRUPT_LSC (1 << 2)    // Link Status Change
+#define INTERRUPT_RXDMT0 (1 << 4) // RX Descriptor Minimum Threshold
+#define INTERRUPT_RXO (1 << 6)    // RX Overrun
+#define INTERRUPT_RXT0 (1 << 7)   // RX Timer
+#define INTERRUPTS_RX (INTERRUPT_RXDMT0 | INTERRUPT_RXO | INTERRUPT_RXT0)
+
+// Don't interrupt us more than this many times per second. The ITR register counts in 256 ns units.
+#define MAX_INTERRUPTS_PER_SECOND 8000
+#define ITR_INTERVAL (1000000000 / (MAX_INTERRUPTS_PER_SECOND * 256))
+
 OwnPtr<E1000NetworkAdapter> E1000NetworkAdapter::autodetect()
 {
     static const PCI::ID qemu_bochs_vbox_id = { 0x8086, 0x100e };
@@ -143,9 +189,13 @@ E1000NetworkAdapter::E1000NetworkAdapter(PCI::Address pci_address, u8 irq)
     initialize_rx_descriptors();
     initialize_tx_descriptors();
 
+    set_capabilities(TxIPv4Checksum | TxTCPChecksum | TxUDPChecksum | RxChecksum | TCPSegmentation);
+
+    out32(REG_ITR, ITR_INTERVAL);
+
     out32(REG_IMASK, 0x1f6dc);
     out32(REG_IMASK, 0xff & ~4);
-    in32(0xc0);
+    in32(REG_ICR);
 
     enable_irq();
 }
@@ -156,23 +206,32 @@ E1000NetworkAdapter::~E1000NetworkAdapter()
 
 void E1000NetworkAdapter::handle_irq()
 {
-    out32(REG_IMASK, 0x1);
-
-    u32 status = in32(0xc0);
-    if (status & 4) {
+    u32 status = in32(REG_ICR);
+    if (status & INTERRUPT_LSC) {
         u32 flags = in32(REG_CTRL);
         out32(REG_CTRL, flags | ECTRL_SLU);
     }
-    if (status & 0x10) {
-        // Threshold OK?
-    }
-    if (status & 0x80) {
-        receive();
+    if (status & INTERRUPTS_RX) {
+        // No more receive interrupts until the NetworkTask has drained the ring in poll().
+        out32(REG_IMC, INTERRUPTS_RX);
+        schedule_poll();
     }
 
     m_wait_queue.wake_all();
 }
 
+size_t E1000NetworkAdapter::poll(size_t budget)
+{
+    size_t received = receive(budget);
+    if (received < budget) {
+        // The ring is empty, so go back to being interrupted for the next packet.
+        // NOTE: Anything that arrived in the meantime is still pending in ICR, and will interrupt us right away.
+        poll_completed();
+        out32(REG_IMASK, INTERRUPTS_RX);
+    }
+    return received;
+}
+
 void E1000NetworkAdapter::detect_eeprom()
 {
     out32(REG_EEPROM, 0x1);
@@ -236,7 +295,10 @@ void E1000NetworkAdapter::initialize_rx_descriptors()
     m_rx_descriptors = (e1000_rx_desc*)ptr;
     for (int i = 0; i < number_of_rx_descriptors; ++i) {
         auto& descriptor = m_rx_descriptors[i];
-        descriptor.addr = (u64)kmalloc_eternal(8192 + 16);
+        m_rx_buffers[i] = PacketBuffer::create(rx_buffer_size, 0);
+        ASSERT(m_rx_buffers[i]);
+        descriptor.addr = m_rx_buffers[i]->physical_address().get();
+        ASSERT(descriptor.addr);
         descriptor.status = 0;
     }
 
@@ -246,7 +308,8 @@ void E1000NetworkAdapter::initialize_rx_descriptors()
     out32(REG_RXDESCHEAD, 0);
     out32(REG_RXDESCTAIL, number_of_rx_descriptors - 1);
 
-    out32(REG_RCTRL, RCTL_EN | RCTL_SBP | RCTL_UPE | RCTL_MPE | RCTL_LBM_NONE | RTCL_RDMTS_HALF | RCTL_BAM | RCTL_SECRC | RCTL_BSIZE_8192);
+    out32(REG_RXCSUM, RXCSUM_IPOFLD | RXCSUM_TUOFLD);
+    out32(REG_RCTRL, RCTL_EN | RCTL_SBP | RCTL_UPE | RCTL_MPE | RCTL_LBM_NONE | RTCL_RDMTS_HALF | RCTL_BAM | RCTL_SECRC | RCTL_BSIZE_2048);
 }
 
 void E1000NetworkAdapter::initialize_tx_descriptors()
@@ -258,7 +321,8 @@ void E1000NetworkAdapter::initialize_tx_descriptors()
     m_tx_descriptors = (e1000_tx_desc*)ptr;
     for (int i = 0; i < number_of_tx_descriptors; ++i) {
         auto& descriptor = m_tx_descriptors[i];
-        descriptor.addr = (u64)kmalloc_eternal(8192 + 16);
+        m_tx_buffers[i] = (u8*)kmalloc_eternal(tx_buffer_size + 16);
+        descriptor.addr = (u64)m_tx_buffers[i];
         descriptor.cmd = 0;
     }
 
@@ -325,53 +389,213 @@ u32 E1000NetworkAdapter::in32(u16 address)
 
 void E1000NetworkAdapter::send_raw(const u8* data, int length)
 {
+    ASSERT(length <= (int)tx_buffer_size);
+    disable_irq();
+    u32 tx_current = in32(REG_TXDESCTAIL);
+    memcpy(m_tx_buffers[tx_current], data, length);
+    PhysicalRange range { PhysicalAddress((u32)m_tx_buffers[tx_current]), (size_t)length };
+    transmit(&range, 1, nullptr);
+}
+
+void E1000NetworkAdapter::send_packet(NonnullRefPtr<PacketBuffer> packet)
+{
+    PhysicalRange ranges[max_tx_ranges];
+    size_t range_count = packet->physical_ranges(ranges, max_tx_ranges);
+    if (!range_count) {
+        ASSERT(packet->size() <= tx_buffer_size);
+        disable_irq();
+        u32 tx_current = in32(REG_TXDESCTAIL);
+        memcpy(m_tx_buffers[tx_current], packet->data(), packet->size());
+        ranges[0] = { PhysicalAddress((u32)m_tx_buffers[tx_current]), packet->size() };
+        return transmit(ranges, 1, packet.ptr());
+    }
+    // NOTE: We hang on to the packet until the NIC is done with it, since transmit() waits for that.
     disable_irq();
+    transmit(ranges, range_count, packet.ptr());
+}
+
+size_t E1000NetworkAdapter::free_tx_descriptors()
+{
+    u32 head = in32(REG_TXDESCHEAD);
+    u32 tail = in32(REG_TXDESCTAIL);
+    // NOTE: One descriptor always stays unused, so that a full ring doesn't look like an empty one.
+    return (head + number_of_tx_descriptors - tail - 1) % number_of_tx_descriptors;
+}
+
+void E1000NetworkAdapter::write_context_descriptor(e1000_tx_context_desc& context, const PacketBuffer& packet)
+{
+    // NOTE: Offloads are only asked for on IPv4 packets, so we know what the headers look like.
+    u8 offloads = packet.offloads();
+    size_t ipv4_start = sizeof(EthernetFrameHeader);
+    auto& ipv4_packet = *(const IPv4Packet*)(packet.data() + ipv4_start);
+    size_t transport_start = ipv4_start + ipv4_packet.internet_header_length() * sizeof(u32);
+    bool is_tcp = offloads & (PacketBuffer::OffloadTCPChecksum | PacketBuffer::OffloadTCPSegmentation);
+
+    u32 tucmd = TUCMD_DEXT | TUCMD_IP;
+    context.ipcss = ipv4_start;
+    context.ipcso = ipv4_start + 10; // The IPv4 header checksum
+    context.ipcse = transport_start - 1;
+    context.tucss = transport_start;
+    context.tucso = transport_start + (is_tcp ? 16 : 6); // The TCP or UDP checksum
+    context.tucse = 0;
+    context.status = 0;
+    if (is_tcp)
+        tucmd |= TUCMD_TCP;
+
+    u32 payload_length = 0;
+    if (offloads & PacketBuffer::OffloadTCPSegmentation) {
+        auto& tcp_packet = *(const TCPPacket*)(packet.data() + transport_start);
+        size_t header_length = transport_start + tcp_packet.header_size();
+        tucmd |= TUCMD_TSE;
+        payload_length = packet.size() - header_length;
+        context.hdrlen = header_length;
+        context.mss = packet.segment_size();
+    } else {
+        context.hdrlen = 0;
+        context.mss = 0;
+    }
+    context.paylen_dtyp_tucmd = payload_length | (tucmd << 24);
+}
+
+void E1000NetworkAdapter::transmit(const PhysicalRange* ranges, size_t range_count, const PacketBuffer* packet)
+{
+    // NOTE: This is called with our IRQ disabled.
+    u8 offloads = packet ? packet->offloads() : 0;
+    size_t descriptors_needed = offloads ? 1 : 0;
+    for (size_t i = 0; i < range_count; ++i)
+        descriptors_needed += (ranges[i].length + max_tx_descriptor_length - 1) / max_tx_descriptor_length;
+    ASSERT(descriptors_needed < number_of_tx_descriptors);
+
+    while (free_tx_descriptors() < descriptors_needed) {
+        cli();
+        enable_irq();
+        current->wait_on(m_wait_queue);
+        sti();
+        disable_irq();
+    }
+
     u32 tx_current = in32(REG_TXDESCTAIL);
 #ifdef E1000_DEBUG
-    kprintf("E1000: Sending packet (%d bytes)\n", length);
+    kprintf("E1000: Sending packet (%u pieces, offloads %b)\n", range_count, offloads);
 #endif
-    auto& descriptor = m_tx_descriptors[tx_current];
-    ASSERT(length <= 8192);
-    memcpy((void*)descriptor.addr, data, length);
-    descriptor.length = length;
-    descriptor.status = 0;
-    descriptor.cmd = CMD_EOP | CMD_IFCS | CMD_RS;
+
+    // The context descriptor tells the NIC where the headers are, for the data descriptors that come after it.
+    u8 popts = 0;
+    u8 dcmd = CMD_DEXT | CMD_IFCS;
+    if (offloads) {
+        write_context_descriptor(*(e1000_tx_context_desc*)&m_tx_descriptors[tx_current], *packet);
+        tx_current = (tx_current + 1) % number_of_tx_descriptors;
+        if (offloads & PacketBuffer::OffloadIPv4Checksum)
+            popts |= POPTS_IXSM;
+        if (offloads & (PacketBuffer::OffloadTCPChecksum | PacketBuffer::OffloadUDPChecksum | PacketBuffer::OffloadTCPSegmentation))
+            popts |= POPTS_TXSM;
+        if (offloads & PacketBuffer::OffloadTCPSegmentation)
+            dcmd |= CMD_TSE;
+    }
+
+    volatile u8* last_status = nullptr;
+    for (size_t i = 0; i < range_count; ++i) {
+        for (size_t offset = 0; offset < ranges[i].length; offset += max_tx_descriptor_length) {
+            u64 address = ranges[i].address.offset(offset).get();
+            u32 length = min(ranges[i].length - offset, max_tx_descriptor_length);
+            bool is_last = i == range_count - 1 && offset + length == ranges[i].length;
+            if (offloads) {
+                auto& descriptor = *(e1000_tx_data_desc*)&m_tx_descriptors[tx_current];
+                descriptor.addr = address;
+                descriptor.status = 0;
+                descriptor.popts = popts;
+                descriptor.special = 0;
+                descriptor.dtalen_dtyp_dcmd = length | DTYP_DATA | ((u32)(dcmd | (is_last ? CMD_EOP | CMD_RS : 0)) << 24);
+                last_status = &descriptor.status;
+            } else {
+                auto& descriptor = m_tx_descriptors[tx_current];
+                descriptor.addr = address;
+                descriptor.length = length;
+                descriptor.cso = 0;
+                descriptor.css = 0;
+                descriptor.special = 0;
+                descriptor.status = 0;
+                descriptor.cmd = CMD_IFCS | (is_last ? CMD_EOP | CMD_RS : 0);
+                last_status = &descriptor.status;
+            }
+            tx_current = (tx_current + 1) % number_of_tx_descriptors;
+        }
+    }
+    ASSERT(last_status);
+
 #ifdef E1000_DEBUG
-    kprintf("E1000: Using tx descriptor %d (head is at %d)\n", tx_current, in32(REG_TXDESCHEAD));
+    kprintf("E1000: Moving tx tail to %d (head is at %d)\n", tx_current, in32(REG_TXDESCHEAD));
 #endif
-    tx_current = (tx_current + 1) % number_of_tx_descriptors;
     out32(REG_TXDESCTAIL, tx_current);
     cli();
     enable_irq();
     for (;;) {
-        if (descriptor.status) {
+        if (*last_status) {
             sti();
             break;
         }
         current->wait_on(m_wait_queue);
     }
 #ifdef E1000_DEBUG
-    kprintf("E1000: Sent packet, status is now %b!\n", descriptor.status);
+    kprintf("E1000: Sent packet, status is now %b!\n", *last_status);
 #endif
 }
 
-void E1000NetworkAdapter::receive()
+size_t E1000NetworkAdapter::receive(size_t budget)
 {
     u32 rx_current;
-    for (;;) {
+    size_t received = 0;
+    while (received < budget) {
         rx_current = in32(REG_RXDESCTAIL);
         if (rx_current == in32(REG_RXDESCHEAD))
-            return;
+            break;
         rx_current = (rx_current + 1) % number_of_rx_descriptors;
-        if (!(m_rx_descriptors[rx_current].status & 1))
+        auto& descriptor = m_rx_descriptors[rx_current];
+        if (!(descriptor.status & RSTA_DD))
             break;
-        auto* buffer = (u8*)m_rx_descriptors[rx_current].addr;
-        u16 length = m_rx_descriptors[rx_current].length;
+        ++received;
+        if (has_bad_checksum(descriptor)) {
+#ifdef E1000_DEBUG
+            kprintf("E1000: Dropping packet with bad checksum (status %b, errors %b)\n", descriptor.status, descriptor.errors);
+#endif
+            // Just give the NIC its buffer back.
+            descriptor.status = 0;
+            out32(REG_RXDESCTAIL, rx_current);
+            continue;
+        }
+        // Hand the NIC a fresh buffer for this slot; the old one is on its way up the stack.
+        // If we're out of packet memory, drop the packet and let the NIC reuse its buffer.
+        auto fresh_buffer = PacketBuffer::create(rx_buffer_size, 0);
+        if (!fresh_buffer) {
+            descriptor.status = 0;
+            out32(REG_RXDESCTAIL, rx_current);
+            continue;
+        }
+        auto buffer = m_rx_buffers[rx_current].release_nonnull();
+        u16 length = descriptor.length;
 #ifdef E1000_DEBUG
-        kprintf("E1000: Received 1 packet @ %p (%u) bytes!\n", buffer, length);
+        kprintf("E1000: Received 1 packet @ %p (%u) bytes!\n", buffer->data(), length);
 #endif
-        did_receive(buffer, length);
-        m_rx_descriptors[rx_current].status = 0;
+        buffer->trim(length);
+        did_receive(move(buffer));
+        m_rx_buffers[rx_current] = move(fresh_buffer);
+        descriptor.addr = m_rx_buffers[rx_current]->physical_address().get();
+        descriptor.status = 0;
         out32(REG_RXDESCTAIL, rx_current);
     }
+    return received;
+}
+
+bool E1000NetworkAdapter::has_bad_checksum(const e1000_rx_desc& descriptor)
+{
+    if (descriptor.status & RSTA_IXSM)
+        return false;
+    if ((descriptor.status & RSTA_IPCS) && (descriptor.errors & RERR_IPE))
+        return true;
+    // NOTE: A UDP checksum of zero means there is no checksum, which the NIC may not know about.
+    // We don't check UDP checksums ourselves, so don't trust the NIC to do it either.
+    if (!(descriptor.status & RSTA_TCPCS) || !(descriptor.errors & RERR_TCPE))
+        return false;
+    auto& ipv4_packet = *(const IPv4Packet*)(m_rx_buffers[&descriptor - m_rx_descriptors]->data() + sizeof(EthernetFrameHeader));
+    return ipv4_packet.protocol() == (u8)IPv4Protocol::TCP;
 }
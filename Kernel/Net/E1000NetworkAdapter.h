@@ -14,7 +14,9 @@ public:
     virtual ~E1000NetworkAdapter() override;
 
     virtual void send_raw(const u8*, int) override;
+    virtual void send_packet(NonnullRefPtr<PacketBuffer>) override;
     virtual bool link_up() override;
+    virtual size_t poll(size_t budget) override;
 
 private:
     virtual void handle_irq() override;
@@ -41,6 +43,31 @@ private:
         volatile uint16_t special { 0 };
     };
 
+    // Sets up checksum offload and TCP segmentation for the data descriptors that follow it.
+    struct [[gnu::packed]] e1000_tx_context_desc
+    {
+        volatile uint8_t ipcss { 0 };
+        volatile uint8_t ipcso { 0 };
+        volatile uint16_t ipcse { 0 };
+        volatile uint8_t tucss { 0 };
+        volatile uint8_t tucso { 0 };
+        volatile uint16_t tucse { 0 };
+        volatile uint32_t paylen_dtyp_tucmd { 0 };
+        volatile uint8_t status { 0 };
+        volatile uint8_t hdrlen { 0 };
+        volatile uint16_t mss { 0 };
+    };
+
+    // A data descriptor in the extended format, which goes with a context descriptor.
+    struct [[gnu::packed]] e1000_tx_data_desc
+    {
+        volatile uint64_t addr { 0 };
+        volatile uint32_t dtalen_dtyp_dcmd { 0 };
+        volatile uint8_t status { 0 };
+        volatile uint8_t popts { 0 };
+        volatile uint16_t special { 0 };
+    };
+
     void detect_eeprom();
     u32 read_eeprom(u8 address);
     void read_mac_address();
@@ -58,7 +85,11 @@ private:
     u16 in16(u16 address);
     u32 in32(u16 address);
 
-    void receive();
+    size_t receive(size_t budget);
+    bool has_bad_checksum(const e1000_rx_desc&);
+    void transmit(const PhysicalRange*, size_t range_count, const PacketBuffer*);
+    void write_context_descriptor(e1000_tx_context_desc&, const PacketBuffer&);
+    size_t free_tx_descriptors();
 
     PCI::Address m_pci_address;
     u16 m_io_base { 0 };
@@ -68,10 +99,23 @@ private:
     bool m_use_mmio { false };
 
     static const int number_of_rx_descriptors = 32;
-    static const int number_of_tx_descriptors = 8;
+    static const int number_of_tx_descriptors = 32;
+
+    static const size_t rx_buffer_size = 2048;
+    static const size_t tx_buffer_size = 2048;
+
+    // A packet as big as IPv4 allows can be scattered across 17 pages.
+    static constexpr size_t max_tx_ranges = 18;
+    // What a single data descriptor can point to.
+    static constexpr size_t max_tx_descriptor_length = 16 * KB - 96;
 
     e1000_rx_desc* m_rx_descriptors;
     e1000_tx_desc* m_tx_descriptors;
 
+    // The NIC receives straight into these, and they're passed up the stack as-is.
+    RefPtr<PacketBuffer> m_rx_buffers[number_of_rx_descriptors];
+    // Bounce buffers for packets that can't be DMA'd from directly. Only plain Ethernet-sized packets end up here.
+    u8* m_tx_buffers[number_of_tx_descriptors];
+
     WaitQueue m_wait_queue;
 };
@@ -70,17 +70,81 @@ private:
 
 static_assert(sizeof(IPv4Packet) == 20);
 
-inline NetworkOrdered<u16> internet_checksum(const void* ptr, size_t count)
+// Adds `count` bytes onto a running one's complement sum, a 32-bit word at a time.
+// The one's complement sum comes out the same whichever byte order the words are added up in
+// (RFC 1071), so we add them up as they are in memory and only put the result in order once,
+// in internet_checksum_finish(). Sums can be chained over several pieces of a packet, but only
+// the last piece may have an odd length.
+inline u32 internet_checksum_add(u32 sum, const void* ptr, size_t count)
 {
-    u32 checksum = 0;
-    auto* w = (const u16*)ptr;
-    while (count > 1) {
-        checksum += convert_between_host_and_network(*w++);
-        if (checksum & 0x80000000)
-            checksum = (checksum & 0xffff) | (checksum >> 16);
+    u64 accumulator = sum;
+    auto* words = (const u32*)ptr;
+    while (count >= 16) {
+        accumulator += words[0];
+        accumulator += words[1];
+        accumulator += words[2];
+        accumulator += words[3];
+        words += 4;
+        count -= 16;
+    }
+    while (count >= 4) {
+        accumulator += *words++;
+        count -= 4;
+    }
+    auto* bytes = (const u8*)words;
+    if (count >= 2) {
+        accumulator += *(const u16*)bytes;
+        bytes += 2;
         count -= 2;
     }
-    while (checksum >> 16)
-        checksum = (checksum & 0xffff) + (checksum >> 16);
-    return ~checksum & 0xffff;
+    if (count) {
+        // An odd byte at the end is padded with a zero byte to make a whole word.
+        u16 last_word = 0;
+        *(u8*)&last_word = *bytes;
+        accumulator += last_word;
+    }
+    accumulator = (accumulator & 0xffffffff) + (accumulator >> 32);
+    accumulator = (accumulator & 0xffffffff) + (accumulator >> 32);
+    return (u32)accumulator;
+}
+
+inline u16 internet_checksum_fold(u32 sum)
+{
+    sum = (sum & 0xffff) + (sum >> 16);
+    sum = (sum & 0xffff) + (sum >> 16);
+    return (u16)sum;
+}
+
+// Turns a sum from internet_checksum_add() into the checksum that goes in a header.
+inline NetworkOrdered<u16> internet_checksum_finish(u32 sum)
+{
+    return convert_between_host_and_network<u16>(~internet_checksum_fold(sum));
+}
+
+inline NetworkOrdered<u16> internet_checksum(const void* ptr, size_t count)
+{
+    return internet_checksum_finish(internet_checksum_add(0, ptr, count));
+}
+
+// The sum of the pseudo-header that TCP and UDP checksums cover on top of the packet itself.
+inline u32 ipv4_pseudo_header_sum(const IPv4Address& source, const IPv4Address& destination, IPv4Protocol protocol, u16 length)
+{
+    struct [[gnu::packed]] PseudoHeader
+    {
+        IPv4Address source;
+        IPv4Address destination;
+        u8 zero;
+        u8 protocol;
+        NetworkOrdered<u16> length;
+    };
+
+    PseudoHeader pseudo_header { source, destination, 0, (u8)protocol, length };
+    return internet_checksum_add(0, &pseudo_header, sizeof(pseudo_header));
+}
+
+// What goes in the checksum field of a TCP or UDP packet whose checksum is left for the
+// network adapter to finish: the pseudo-header sum, not yet complemented.
+inline NetworkOrdered<u16> ipv4_pseudo_header_checksum(const IPv4Address& source, const IPv4Address& destination, IPv4Protocol protocol, u16 length)
+{
+    return convert_between_host_and_network<u16>(internet_checksum_fold(ipv4_pseudo_header_sum(source, destination, protocol, length)));
 }
@@ -25,6 +25,24 @@ Lockable<HashTable<IPv4Socket*>>& IPv4Socket::all_sockets()
     return *s_table;
 }
 
+Lockable<HashMap<unsigned, Vector<IPv4Socket*>>>& IPv4Socket::raw_sockets_by_protocol()
+{
+    static Lockable<HashMap<unsigned, Vector<IPv4Socket*>>>* s_map;
+    if (!s_map)
+        s_map = new Lockable<HashMap<unsigned, Vector<IPv4Socket*>>>;
+    return *s_map;
+}
+
+void IPv4Socket::for_each_raw_socket(IPv4Protocol protocol, Function<void(IPv4Socket&)> callback)
+{
+    LOCKER(raw_sockets_by_protocol().lock());
+    auto it = raw_sockets_by_protocol().resource().find((unsigned)protocol);
+    if (it == raw_sockets_by_protocol().resource().end())
+        return;
+    for (auto* socket : (*it).value)
+        callback(*socket);
+}
+
 NonnullRefPtr<IPv4Socket> IPv4Socket::create(int type, int protocol)
 {
     if (type == SOCK_STREAM)
@@ -41,8 +59,12 @@ IPv4Socket::IPv4Socket(int type, int protocol)
     kprintf("%s(%u) IPv4Socket{%p} created with type=%u, protocol=%d\n", current->process().name().characters(), current->pid(), this, type, protocol);
 #endif
     m_buffer_mode = type == SOCK_STREAM ? BufferMode::Bytes : BufferMode::Packets;
-    if (m_buffer_mode == BufferMode::Bytes) {
-        m_scratch_buffer = KBuffer::create_with_size(65536);
+    if (type == SOCK_RAW) {
+        LOCKER(raw_sockets_by_protocol().lock());
+        auto& map = raw_sockets_by_protocol().resource();
+        if (!map.contains((unsigned)protocol))
+            map.set((unsigned)protocol, {});
+        (*map.find((unsigned)protocol)).value.append(this);
     }
     LOCKER(all_sockets().lock());
     all_sockets().resource().set(this);
@@ -50,6 +72,16 @@ IPv4Socket::IPv4Socket(int type, int protocol)
 
 IPv4Socket::~IPv4Socket()
 {
+    if (type() == SOCK_RAW) {
+        LOCKER(raw_sockets_by_protocol().lock());
+        auto& map = raw_sockets_by_protocol().resource();
+        auto it = map.find((unsigned)protocol());
+        ASSERT(it != map.end());
+        auto& sockets = (*it).value;
+        sockets.remove_first_matching([this](auto* socket) { return socket == this; });
+        if (sockets.is_empty())
+            map.remove(it);
+    }
     LOCKER(all_sockets().lock());
     all_sockets().resource().remove(this);
 }
@@ -159,7 +191,22 @@ bool IPv4Socket::can_read(const FileDescription&) const
 
 bool IPv4Socket::can_write(const FileDescription&) const
 {
-    return is_connected();
+    return is_connected() && protocol_can_write();
+}
+
+size_t IPv4Socket::write_capacity(const FileDescription&) const
+{
+    // NOTE: Writing to an unconnected socket fails (or sends a datagram) without coming up short.
+    if (!is_connected())
+        return 0xffffffff;
+    return protocol_write_capacity();
+}
+
+size_t IPv4Socket::receive_buffer_space() const
+{
+    if (m_receive_buffer_size >= receive_buffer_capacity)
+        return 0;
+    return receive_buffer_capacity - m_receive_buffer_size;
 }
 
 int IPv4Socket::allocate_local_port_if_needed()
@@ -173,9 +220,8 @@ int IPv4Socket::allocate_local_port_if_needed()
     return port;
 }
 
-ssize_t IPv4Socket::sendto(FileDescription&, const void* data, size_t data_length, int flags, const sockaddr* addr, socklen_t addr_length)
+ssize_t IPv4Socket::sendto(FileDescription& description, const void* data, size_t data_length, int flags, const sockaddr* addr, socklen_t addr_length)
 {
-    (void)flags;
     if (addr && addr_length != sizeof(sockaddr_in))
         return -EINVAL;
 
@@ -210,6 +256,13 @@ ssize_t IPv4Socket::sendto(FileDescription&, const void* data, size_t data_lengt
         return data_length;
     }
 
+    if (is_connected() && !protocol_can_write()) {
+        if (!description.is_blocking() || (flags & MSG_DONTWAIT))
+            return -EAGAIN;
+        if (current->block<Thread::WriteBlocker>(description) == Thread::BlockResult::InterruptedBySignal)
+            return -EINTR;
+    }
+
     int nsent = protocol_send(data, data_length);
     if (nsent > 0)
         current->did_ipv4_socket_write(nsent);
@@ -227,11 +280,11 @@ ssize_t IPv4Socket::recvfrom(FileDescription& description, void* buffer, size_t
 
     if (buffer_mode() == BufferMode::Bytes) {
         LOCKER(lock());
-        if (m_receive_buffer.is_empty()) {
+        if (!m_receive_buffer_size) {
             if (protocol_is_disconnected()) {
                 return 0;
             }
-            if (!description.is_blocking()) {
+            if (!description.is_blocking() || (flags & MSG_DONTWAIT)) {
                 return -EAGAIN;
             }
 
@@ -248,12 +301,24 @@ ssize_t IPv4Socket::recvfrom(FileDescription& description, void* buffer, size_t
             }
         }
 
-        ASSERT(!m_receive_buffer.is_empty());
-        int nreceived = m_receive_buffer.read((u8*)buffer, buffer_length);
+        ASSERT(m_receive_buffer_size);
+        int nreceived = 0;
+        while ((size_t)nreceived < buffer_length && !m_receive_buffer.is_empty()) {
+            auto& packet = *m_receive_buffer.first();
+            size_t nread = min(buffer_length - nreceived, packet.size());
+            memcpy((u8*)buffer + nreceived, packet.data(), nread);
+            packet.pull(nread);
+            nreceived += nread;
+            if (!packet.size())
+                m_receive_buffer.dequeue();
+        }
+        m_receive_buffer_size -= nreceived;
         if (nreceived > 0)
             current->did_ipv4_socket_read((size_t)nreceived);
 
-        m_can_read = !m_receive_buffer.is_empty();
+        m_can_read = m_receive_buffer_size > 0;
+        if (nreceived > 0)
+            protocol_did_read((size_t)nreceived);
         return nreceived;
     }
 
@@ -265,7 +330,7 @@ ssize_t IPv4Socket::recvfrom(FileDescription& description, void* buffer, size_t
             //        But if so, we still need to deliver at least one EOF read to userspace.. right?
             if (protocol_is_disconnected())
                 return 0;
-            if (!description.is_blocking())
+            if (!description.is_blocking() || (flags & MSG_DONTWAIT))
                 return -EAGAIN;
         }
 
@@ -273,11 +338,11 @@ ssize_t IPv4Socket::recvfrom(FileDescription& description, void* buffer, size_t
             packet = m_receive_queue.take_first();
             m_can_read = !m_receive_queue.is_empty();
 #ifdef IPV4_SOCKET_DEBUG
-            kprintf("IPv4Socket(%p): recvfrom without blocking %d bytes, packets in queue: %zu\n", this, packet.data.value().size(), m_receive_queue.size_slow());
+            kprintf("IPv4Socket(%p): recvfrom without blocking %d bytes, packets in queue: %zu\n", this, packet.data->size(), m_receive_queue.size_slow());
 #endif
         }
     }
-    if (!packet.data.has_value()) {
+    if (!packet.data) {
         if (protocol_is_disconnected()) {
             kprintf("IPv4Socket{%p} is protocol-disconnected, returning 0 in recvfrom!\n", this);
             return 0;
@@ -299,11 +364,11 @@ ssize_t IPv4Socket::recvfrom(FileDescription& description, void* buffer, size_t
         packet = m_receive_queue.take_first();
         m_can_read = !m_receive_queue.is_empty();
 #ifdef IPV4_SOCKET_DEBUG
-        kprintf("IPv4Socket(%p): recvfrom with blocking %d bytes, packets in queue: %zu\n", this, packet.data.value().size(), m_receive_queue.size_slow());
+        kprintf("IPv4Socket(%p): recvfrom with blocking %d bytes, packets in queue: %zu\n", this, packet.data->size(), m_receive_queue.size_slow());
 #endif
     }
-    ASSERT(packet.data.has_value());
-    auto& ipv4_packet = *(const IPv4Packet*)(packet.data.value().data());
+    ASSERT(packet.data);
+    auto& ipv4_packet = *(const IPv4Packet*)(packet.data->data());
 
     if (addr) {
 #ifdef IPV4_SOCKET_DEBUG
@@ -323,42 +388,54 @@ ssize_t IPv4Socket::recvfrom(FileDescription& description, void* buffer, size_t
         return ipv4_packet.payload_size();
     }
 
-    int nreceived = protocol_receive(packet.data.value(), buffer, buffer_length, flags);
+    int nreceived = protocol_receive(*packet.data, buffer, buffer_length, flags);
     if (nreceived > 0)
         current->did_ipv4_socket_read(nreceived);
     return nreceived;
 }
 
-bool IPv4Socket::did_receive(const IPv4Address& source_address, u16 source_port, KBuffer&& packet)
+bool IPv4Socket::did_receive(const IPv4Address& source_address, u16 source_port, NonnullRefPtr<PacketBuffer> packet)
 {
     LOCKER(lock());
-    auto packet_size = packet.size();
+    auto packet_size = packet->size();
 
     if (buffer_mode() == BufferMode::Bytes) {
-        constexpr size_t max_buffer_amount = 128 * KB;
-        ASSERT((size_t)m_receive_buffer.bytes_in_write_buffer() < max_buffer_amount);
-        size_t space_in_receive_buffer = max_buffer_amount - (size_t)m_receive_buffer.bytes_in_write_buffer();
-        if (packet_size > space_in_receive_buffer) {
+        // NOTE: We trim a clone so that whoever gave us the packet can keep looking at its headers.
+        auto payload = packet->clone();
+        protocol_trim_to_payload(*payload);
+        size_t payload_size = payload->size();
+        if (payload_size > receive_buffer_space()) {
+#ifdef IPV4_SOCKET_DEBUG
             kprintf("IPv4Socket(%p): did_receive refusing packet since buffer is full.\n", this);
+#endif
             ASSERT(m_can_read);
             return false;
         }
-        int nreceived = protocol_receive(packet, m_scratch_buffer.value().data(), m_scratch_buffer.value().size(), 0);
-        m_receive_buffer.write(m_scratch_buffer.value().data(), nreceived);
-        m_can_read = !m_receive_buffer.is_empty();
+        // A trickle of tiny segments shouldn't pin down a whole packet buffer each,
+        // so fold them into the last one if it has room to spare.
+        auto* last = m_receive_buffer.last();
+        if (last && payload_size <= small_payload_size && !last->is_shared() && last->tailroom() >= payload_size)
+            memcpy(last->put(payload_size), payload->data(), payload_size);
+        else
+            m_receive_buffer.enqueue(move(payload));
+        m_receive_buffer_size += payload_size;
+        m_can_read = m_receive_buffer_size > 0;
     } else {
         // FIXME: Maybe track the number of packets so we don't have to walk the entire packet queue to count them..
         if (m_receive_queue.size_slow() > 2000) {
+#ifdef IPV4_SOCKET_DEBUG
             kprintf("IPv4Socket(%p): did_receive refusing packet since queue is full.\n", this);
+#endif
             return false;
         }
         m_receive_queue.append({ source_address, source_port, move(packet) });
         m_can_read = true;
     }
     m_bytes_received += packet_size;
+    did_change_readiness();
 #ifdef IPV4_SOCKET_DEBUG
     if (buffer_mode() == BufferMode::Bytes)
-        kprintf("IPv4Socket(%p): did_receive %d bytes, total_received=%u, bytes in buffer: %zu\n", this, packet_size, m_bytes_received, m_receive_buffer.bytes_in_write_buffer());
+        kprintf("IPv4Socket(%p): did_receive %d bytes, total_received=%u, bytes in buffer: %zu\n", this, packet_size, m_bytes_received, m_receive_buffer_size);
     else
         kprintf("IPv4Socket(%p): did_receive %d bytes, total_received=%u, packets in queue: %zu\n", this, packet_size, m_bytes_received, m_receive_queue.size_slow());
 #endif
@@ -431,8 +508,50 @@ KResult IPv4Socket::getsockopt(FileDescription& description, int level, int opti
     }
 }
 
+static IPv4Address to_ipv4_address(const sockaddr& address)
+{
+    return IPv4Address(((const sockaddr_in&)address).sin_addr.s_addr);
+}
+
+static int route_ioctl(unsigned request, const rtentry* route)
+{
+    if (!current->process().is_superuser())
+        return -EPERM;
+    if (!current->process().validate_read_typed(route))
+        return -EFAULT;
+    if (route->rt_dst.sa_family != AF_INET || route->rt_genmask.sa_family != AF_INET)
+        return -EAFNOSUPPORT;
+
+    auto destination = to_ipv4_address(route->rt_dst);
+    auto netmask = to_ipv4_address(route->rt_genmask);
+
+    if (request == SIOCDELRT)
+        return delete_route(destination, netmask);
+
+    IPv4Address gateway;
+    if (route->rt_flags & RTF_GATEWAY) {
+        if (route->rt_gateway.sa_family != AF_INET)
+            return -EAFNOSUPPORT;
+        gateway = to_ipv4_address(route->rt_gateway);
+    }
+
+    WeakPtr<NetworkAdapter> adapter;
+    if (route->rt_dev) {
+        if (!current->process().validate_read_str(route->rt_dev))
+            return -EFAULT;
+        adapter = NetworkAdapter::lookup_by_name(route->rt_dev);
+        if (!adapter)
+            return -ENODEV;
+    }
+
+    return add_route(destination, netmask, gateway, move(adapter));
+}
+
 int IPv4Socket::ioctl(FileDescription&, unsigned request, unsigned arg)
 {
+    if (request == SIOCADDRT || request == SIOCDELRT)
+        return route_ioctl(request, (const rtentry*)arg);
+
     auto* ifr = (ifreq*)arg;
     if (!current->process().validate_read_typed(ifr))
         return -EFAULT;
@@ -1,12 +1,14 @@
 #pragma once
 
+#include <AK/Function.h>
 #include <AK/HashMap.h>
 #include <AK/SinglyLinkedList.h>
-#include <Kernel/DoubleBuffer.h>
+#include <AK/Vector.h>
 #include <Kernel/KBuffer.h>
 #include <Kernel/Lock.h>
 #include <Kernel/Net/IPv4.h>
 #include <Kernel/Net/IPv4SocketTuple.h>
+#include <Kernel/Net/PacketBuffer.h>
 #include <Kernel/Net/Socket.h>
 
 class NetworkAdapter;
@@ -20,6 +22,9 @@ public:
 
     static Lockable<HashTable<IPv4Socket*>>& all_sockets();
 
+    // Raw sockets are also kept by protocol, so inbound packets only need to visit the ones that want them.
+    static void for_each_raw_socket(IPv4Protocol, Function<void(IPv4Socket&)>);
+
     virtual KResult bind(const sockaddr*, socklen_t) override;
     virtual KResult connect(FileDescription&, const sockaddr*, socklen_t, ShouldBlock = ShouldBlock::Yes) override;
     virtual KResult listen(int) override;
@@ -29,6 +34,7 @@ public:
     virtual void detach(FileDescription&) override;
     virtual bool can_read(const FileDescription&) const override;
     virtual bool can_write(const FileDescription&) const override;
+    virtual size_t write_capacity(const FileDescription&) const override;
     virtual ssize_t sendto(FileDescription&, const void*, size_t, int, const sockaddr*, socklen_t) override;
     virtual ssize_t recvfrom(FileDescription&, void*, size_t, int flags, sockaddr*, socklen_t*) override;
     virtual KResult setsockopt(int level, int option, const void*, socklen_t) override;
@@ -36,7 +42,8 @@ public:
 
     virtual int ioctl(FileDescription&, unsigned request, unsigned arg) override;
 
-    bool did_receive(const IPv4Address& peer_address, u16 peer_port, KBuffer&&);
+    // NOTE: The packet starts at the IPv4 header. Sockets hang on to it instead of copying it.
+    bool did_receive(const IPv4Address& peer_address, u16 peer_port, NonnullRefPtr<PacketBuffer>);
 
     const IPv4Address& local_address() const { return m_local_address; }
     u16 local_port() const { return m_local_port; }
@@ -59,6 +66,14 @@ public:
     };
     BufferMode buffer_mode() const { return m_buffer_mode; }
 
+    static constexpr size_t receive_buffer_capacity = 128 * KB;
+
+    // Received payloads up to this size may get copied into the tail of the receive buffer.
+    static constexpr size_t small_payload_size = 256;
+
+    // How many more bytes fit in the receive buffer (only meaningful in BufferMode::Bytes.)
+    size_t receive_buffer_space() const;
+
 protected:
     IPv4Socket(int type, int protocol);
     virtual const char* class_name() const override { return "IPv4Socket"; }
@@ -67,11 +82,16 @@ protected:
 
     virtual KResult protocol_bind() { return KSuccess; }
     virtual KResult protocol_listen() { return KSuccess; }
-    virtual int protocol_receive(const KBuffer&, void*, size_t, int) { return -ENOTIMPL; }
+    virtual int protocol_receive(const PacketBuffer&, void*, size_t, int) { return -ENOTIMPL; }
+    // In BufferMode::Bytes, strip everything but the payload off a received packet.
+    virtual void protocol_trim_to_payload(PacketBuffer& packet) { packet.pull(sizeof(IPv4Packet)); }
     virtual int protocol_send(const void*, int) { return -ENOTIMPL; }
     virtual KResult protocol_connect(FileDescription&, ShouldBlock) { return KSuccess; }
     virtual int protocol_allocate_local_port() { return 0; }
     virtual bool protocol_is_disconnected() const { return false; }
+    virtual bool protocol_can_write() const { return true; }
+    virtual size_t protocol_write_capacity() const { return 0xffffffff; }
+    virtual void protocol_did_read(size_t) {}
 
     void set_local_address(IPv4Address address) { m_local_address = address; }
     void set_peer_address(IPv4Address address) { m_peer_address = address; }
@@ -79,18 +99,22 @@ protected:
 private:
     virtual bool is_ipv4() const override { return true; }
 
+    static Lockable<HashMap<unsigned, Vector<IPv4Socket*>>>& raw_sockets_by_protocol();
+
     IPv4Address m_local_address;
     IPv4Address m_peer_address;
 
     struct ReceivedPacket {
         IPv4Address peer_address;
         u16 peer_port;
-        Optional<KBuffer> data;
+        RefPtr<PacketBuffer> data;
     };
 
     SinglyLinkedList<ReceivedPacket> m_receive_queue;
 
-    DoubleBuffer m_receive_buffer;
+    // NOTE: In BufferMode::Bytes, these are clones of the received packets, trimmed down to their payload.
+    PacketQueue m_receive_buffer;
+    size_t m_receive_buffer_size { 0 };
 
     u16 m_local_port { 0 };
     u16 m_peer_port { 0 };
@@ -102,6 +126,4 @@ private:
     bool m_can_read { false };
 
     BufferMode m_buffer_mode { BufferMode::Packets };
-
-    Optional<KBuffer> m_scratch_buffer;
 };
@@ -8,6 +8,14 @@
 
 //#define DEBUG_LOCAL_SOCKET
 
+// How much each direction of a connection holds before the writer has to wait for the reader.
+static constexpr size_t local_socket_buffer_size = 32 * KB;
+// The socket counts as writable once this much is free, and writes of up to this size
+// are never split up, so a whole IPC message always goes in (or fails) in one piece.
+static constexpr size_t local_socket_atomic_write_size = local_socket_buffer_size / 2;
+// How many passed file descriptions may be waiting for the receiver at once.
+static constexpr size_t max_passed_descriptions = 64;
+
 Lockable<InlineLinkedList<LocalSocket>>& LocalSocket::all_sockets()
 {
     static Lockable<InlineLinkedList<LocalSocket>>* s_list;
@@ -30,6 +38,8 @@ NonnullRefPtr<LocalSocket> LocalSocket::create(int type)
 
 LocalSocket::LocalSocket(int type)
     : Socket(AF_LOCAL, type, 0)
+    , m_for_client(local_socket_buffer_size)
+    , m_for_server(local_socket_buffer_size)
 {
     LOCKER(all_sockets().lock());
     all_sockets().resource().append(this);
@@ -138,6 +148,7 @@ KResult LocalSocket::connect(FileDescription& description, const sockaddr* addre
 
     if (is_connected()) {
         m_connect_side_role = Role::Connected;
+        did_change_readiness();
         return KSuccess;
     }
 
@@ -155,6 +166,7 @@ KResult LocalSocket::connect(FileDescription& description, const sockaddr* addre
         return KResult(-ECONNREFUSED);
     }
     m_connect_side_role = Role::Connected;
+    did_change_readiness();
     return KSuccess;
 }
 
@@ -181,6 +193,7 @@ void LocalSocket::attach(FileDescription& description)
         ASSERT(m_connect_side_fd != &description);
         m_accept_side_fd_open = true;
     }
+    did_change_readiness();
 }
 
 void LocalSocket::detach(FileDescription& description)
@@ -191,6 +204,8 @@ void LocalSocket::detach(FileDescription& description)
         ASSERT(m_accept_side_fd_open);
         m_accept_side_fd_open = false;
     }
+    // The other side gets to see EOF now.
+    did_change_readiness();
 }
 
 bool LocalSocket::can_read(const FileDescription& description) const
@@ -219,23 +234,88 @@ bool LocalSocket::can_write(const FileDescription& description) const
 {
     auto role = this->role(description);
     if (role == Role::Accepted)
-        return !has_attached_peer(description) || m_for_client.bytes_in_write_buffer() < 16384;
+        return !has_attached_peer(description) || m_for_client.free_bytes() >= local_socket_atomic_write_size;
     if (role == Role::Connected)
-        return !has_attached_peer(description) || m_for_server.bytes_in_write_buffer() < 16384;
+        return !has_attached_peer(description) || m_for_server.free_bytes() >= local_socket_atomic_write_size;
     return false;
 }
 
-ssize_t LocalSocket::sendto(FileDescription& description, const void* data, size_t data_size, int, const sockaddr*, socklen_t)
+size_t LocalSocket::write_capacity(const FileDescription& description) const
+{
+    if (!has_attached_peer(description))
+        return 0xffffffff;
+    // NOTE: Small writes are all-or-nothing, so we don't count a bit of room as any room at all.
+    if (!can_write(description))
+        return 0;
+    auto role = this->role(description);
+    if (role == Role::Accepted)
+        return m_for_client.free_bytes();
+    if (role == Role::Connected)
+        return m_for_server.free_bytes();
+    return 0;
+}
+
+ssize_t LocalSocket::sendto(FileDescription& description, const void* data, size_t data_size, int flags, const sockaddr*, socklen_t)
+{
+    iovec vec { const_cast<void*>(data), data_size };
+    return sendmsg(description, &vec, 1, {}, !description.is_blocking() || (flags & MSG_DONTWAIT));
+}
+
+ssize_t LocalSocket::writev(FileDescription& description, const iovec* vecs, int iov_count)
+{
+    return sendmsg(description, vecs, iov_count, {}, !description.is_blocking());
+}
+
+ssize_t LocalSocket::sendmsg(FileDescription& description, const iovec* vecs, int iov_count, const NonnullRefPtrVector<FileDescription>& passed_descriptions, bool nonblocking)
 {
     if (!has_attached_peer(description))
         return -EPIPE;
-    ssize_t nwritten = send_buffer_for(description).write((const u8*)data, data_size);
-    if (nwritten > 0)
-        current->did_unix_socket_write(nwritten);
+    auto& buffer = send_buffer_for(description);
+    size_t total = total_length(vecs, iov_count);
+    bool allow_partial = total > local_socket_atomic_write_size;
+
+    // The descriptions need some data to ride along with.
+    if (!passed_descriptions.is_empty() && !total)
+        return -EINVAL;
+
+    size_t nwritten = 0;
+    while (nwritten < total) {
+        ssize_t rc;
+        if (!nwritten && !passed_descriptions.is_empty()) {
+            // NOTE: We check the limit, write and attach the descriptions all while holding the lock,
+            //       so that concurrent senders can't overshoot the limit, and a reader who sees the
+            //       data is guaranteed to see the descriptions with it.
+            LOCKER(m_descriptions_lock);
+            size_t queued_count = 0;
+            for (auto& passed : passed_descriptions_for_sender(description))
+                queued_count += passed.descriptions.size();
+            if (queued_count + passed_descriptions.size() > max_passed_descriptions)
+                return -ENOBUFS;
+            u32 position;
+            rc = buffer.write(vecs, iov_count, 0, allow_partial, &position);
+            if (rc > 0)
+                passed_descriptions_for_sender(description).append({ position, passed_descriptions });
+        } else {
+            rc = buffer.write(vecs, iov_count, nwritten, allow_partial);
+        }
+        if (rc > 0) {
+            nwritten += rc;
+            current->did_unix_socket_write(rc);
+            did_change_readiness();
+            continue;
+        }
+        // The buffer is full, so wait for the other side to drain it.
+        if (nonblocking)
+            return nwritten ? nwritten : -EAGAIN;
+        if (current->block<Thread::WriteBlocker>(description) == Thread::BlockResult::InterruptedBySignal)
+            return nwritten ? nwritten : -EINTR;
+        if (!has_attached_peer(description))
+            return nwritten ? nwritten : -EPIPE;
+    }
     return nwritten;
 }
 
-DoubleBuffer& LocalSocket::receive_buffer_for(FileDescription& description)
+RingBuffer& LocalSocket::receive_buffer_for(FileDescription& description)
 {
     auto role = this->role(description);
     if (role == Role::Accepted)
@@ -245,7 +325,7 @@ DoubleBuffer& LocalSocket::receive_buffer_for(FileDescription& description)
     ASSERT_NOT_REACHED();
 }
 
-DoubleBuffer& LocalSocket::send_buffer_for(FileDescription& description)
+RingBuffer& LocalSocket::send_buffer_for(FileDescription& description)
 {
     auto role = this->role(description);
     if (role == Role::Connected)
@@ -255,10 +335,26 @@ DoubleBuffer& LocalSocket::send_buffer_for(FileDescription& description)
     ASSERT_NOT_REACHED();
 }
 
-ssize_t LocalSocket::recvfrom(FileDescription& description, void* buffer, size_t buffer_size, int, sockaddr*, socklen_t*)
+ssize_t LocalSocket::recvfrom(FileDescription& description, void* buffer, size_t buffer_size, int flags, sockaddr*, socklen_t*)
 {
+    iovec vec { buffer, buffer_size };
+    NonnullRefPtrVector<FileDescription> passed_descriptions;
+    bool truncated;
+    return recvmsg(description, &vec, 1, passed_descriptions, 0, truncated, !description.is_blocking() || (flags & MSG_DONTWAIT));
+}
+
+ssize_t LocalSocket::readv(FileDescription& description, const iovec* vecs, int iov_count)
+{
+    NonnullRefPtrVector<FileDescription> passed_descriptions;
+    bool truncated;
+    return recvmsg(description, vecs, iov_count, passed_descriptions, 0, truncated, !description.is_blocking());
+}
+
+ssize_t LocalSocket::recvmsg(FileDescription& description, const iovec* vecs, int iov_count, NonnullRefPtrVector<FileDescription>& passed_descriptions, int max_count, bool& truncated, bool nonblocking)
+{
+    truncated = false;
     auto& buffer_for_me = receive_buffer_for(description);
-    if (!description.is_blocking()) {
+    if (nonblocking) {
         if (buffer_for_me.is_empty()) {
             if (!has_attached_peer(description))
                 return 0;
@@ -272,12 +368,60 @@ ssize_t LocalSocket::recvfrom(FileDescription& description, void* buffer, size_t
     if (!has_attached_peer(description) && buffer_for_me.is_empty())
         return 0;
     ASSERT(!buffer_for_me.is_empty());
-    int nread = buffer_for_me.read((u8*)buffer, buffer_size);
-    if (nread > 0)
+
+    // NOTE: Descriptions are attached before their data becomes visible to us, so anything
+    //       attached to the data we're about to read is already in the queue.
+    u32 head = buffer_for_me.read_position();
+    size_t max_length = buffer_for_me.write_position() - head;
+    Optional<PassedDescriptions> taken;
+    {
+        LOCKER(m_descriptions_lock);
+        auto& queue = passed_descriptions_for_receiver(description);
+        if (!queue.is_empty() && queue.first().position == head)
+            taken = queue.take_first();
+        if (!queue.is_empty())
+            max_length = min(max_length, (size_t)(queue.first().position - head));
+    }
+
+    ssize_t nread = buffer_for_me.read(vecs, iov_count, max_length);
+    if (nread > 0) {
         current->did_unix_socket_read(nread);
+        did_change_readiness();
+    }
+
+    if (taken.has_value()) {
+        auto& descriptions = taken.value().descriptions;
+        for (int i = 0; i < descriptions.size(); ++i) {
+            if (i == max_count) {
+                truncated = true;
+                break;
+            }
+            passed_descriptions.append(descriptions[i]);
+        }
+    }
     return nread;
 }
 
+Vector<LocalSocket::PassedDescriptions>& LocalSocket::passed_descriptions_for_receiver(FileDescription& description)
+{
+    auto role = this->role(description);
+    if (role == Role::Accepted)
+        return m_descriptions_for_server;
+    if (role == Role::Connected)
+        return m_descriptions_for_client;
+    ASSERT_NOT_REACHED();
+}
+
+Vector<LocalSocket::PassedDescriptions>& LocalSocket::passed_descriptions_for_sender(FileDescription& description)
+{
+    auto role = this->role(description);
+    if (role == Role::Connected)
+        return m_descriptions_for_server;
+    if (role == Role::Accepted)
+        return m_descriptions_for_client;
+    ASSERT_NOT_REACHED();
+}
+
 StringView LocalSocket::socket_path() const
 {
     size_t len = strnlen(m_address.sun_path, sizeof(m_address.sun_path));
@@ -1,8 +1,9 @@
 #pragma once
 
 #include <AK/InlineLinkedList.h>
-#include <Kernel/DoubleBuffer.h>
+#include <AK/NonnullRefPtrVector.h>
 #include <Kernel/Net/Socket.h>
+#include <Kernel/RingBuffer.h>
 
 class FileDescription;
 
@@ -17,6 +18,13 @@ public:
     StringView socket_path() const;
     String absolute_path(const FileDescription& description) const override;
 
+    // SCM_RIGHTS: File descriptions passed along with some data are attached to the first byte
+    // of it, and handed over when the receiver reads that byte. A read never goes past the next
+    // byte with descriptions attached, so each batch comes out with the data it was sent with.
+    // Descriptions that the receiver has no room for (or didn't ask for) are dropped.
+    ssize_t sendmsg(FileDescription&, const iovec*, int iov_count, const NonnullRefPtrVector<FileDescription>&, bool nonblocking);
+    ssize_t recvmsg(FileDescription&, const iovec*, int iov_count, NonnullRefPtrVector<FileDescription>&, int max_count, bool& truncated, bool nonblocking);
+
     // ^Socket
     virtual KResult bind(const sockaddr*, socklen_t) override;
     virtual KResult connect(FileDescription&, const sockaddr*, socklen_t, ShouldBlock = ShouldBlock::Yes) override;
@@ -27,8 +35,11 @@ public:
     virtual void detach(FileDescription&) override;
     virtual bool can_read(const FileDescription&) const override;
     virtual bool can_write(const FileDescription&) const override;
+    virtual size_t write_capacity(const FileDescription&) const override;
     virtual ssize_t sendto(FileDescription&, const void*, size_t, int, const sockaddr*, socklen_t) override;
     virtual ssize_t recvfrom(FileDescription&, void*, size_t, int flags, sockaddr*, socklen_t*) override;
+    virtual ssize_t readv(FileDescription&, const iovec*, int iov_count) override;
+    virtual ssize_t writev(FileDescription&, const iovec*, int iov_count) override;
     virtual KResult getsockopt(FileDescription&, int level, int option, void*, socklen_t*) override;
     virtual KResult chown(uid_t, gid_t) override;
     virtual KResult chmod(mode_t) override;
@@ -39,8 +50,16 @@ private:
     virtual bool is_local() const override { return true; }
     bool has_attached_peer(const FileDescription&) const;
     static Lockable<InlineLinkedList<LocalSocket>>& all_sockets();
-    DoubleBuffer& receive_buffer_for(FileDescription&);
-    DoubleBuffer& send_buffer_for(FileDescription&);
+    RingBuffer& receive_buffer_for(FileDescription&);
+    RingBuffer& send_buffer_for(FileDescription&);
+
+    struct PassedDescriptions {
+        // The receive buffer position of the byte they're attached to.
+        u32 position { 0 };
+        NonnullRefPtrVector<FileDescription> descriptions;
+    };
+    Vector<PassedDescriptions>& passed_descriptions_for_receiver(FileDescription&);
+    Vector<PassedDescriptions>& passed_descriptions_for_sender(FileDescription&);
 
     // An open socket file on the filesystem.
     RefPtr<FileDescription> m_file;
@@ -67,8 +86,13 @@ private:
     bool m_accept_side_fd_open { false };
     sockaddr_un m_address;
 
-    DoubleBuffer m_for_client;
-    DoubleBuffer m_for_server;
+    RingBuffer m_for_client;
+    RingBuffer m_for_server;
+
+    // FIXME: A socket that gets passed through itself keeps itself alive forever.
+    Vector<PassedDescriptions> m_descriptions_for_client;
+    Vector<PassedDescriptions> m_descriptions_for_server;
+    Lock m_descriptions_lock { "LocalSocket::descriptions" };
 
     // for InlineLinkedList
     LocalSocket* m_prev { nullptr };
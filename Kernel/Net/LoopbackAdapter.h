@@ -10,7 +10,9 @@ public:
     virtual ~LoopbackAdapter() override;
 
     virtual void send_raw(const u8*, int) override;
+    virtual void send_packet(NonnullRefPtr<PacketBuffer>) override;
     virtual const char* class_name() const override { return "LoopbackAdapter"; }
+    virtual bool requires_address_resolution() const override { return false; }
 
 private:
     LoopbackAdapter();
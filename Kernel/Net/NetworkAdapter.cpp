@@ -6,6 +6,8 @@
 #include <Kernel/Net/EthernetFrameHeader.h>
 #include <Kernel/Net/LoopbackAdapter.h>
 #include <Kernel/Net/NetworkAdapter.h>
+#include <Kernel/Net/NetworkTask.h>
+#include <Kernel/Net/Routing.h>
 #include <Kernel/StdLib.h>
 
 static Lockable<HashTable<NetworkAdapter*>>& all_adapters()
@@ -59,89 +61,113 @@ NetworkAdapter::~NetworkAdapter()
 
 void NetworkAdapter::send(const MACAddress& destination, const ARPPacket& packet)
 {
-    int size_in_bytes = sizeof(EthernetFrameHeader) + sizeof(ARPPacket);
-    auto buffer = ByteBuffer::create_zeroed(size_in_bytes);
-    auto* eth = (EthernetFrameHeader*)buffer.data();
-    eth->set_source(mac_address());
-    eth->set_destination(destination);
-    eth->set_ether_type(EtherType::ARP);
+    auto buffer = PacketBuffer::copy(&packet, sizeof(ARPPacket));
+    if (!buffer)
+        return;
+    send_ethernet(destination, EtherType::ARP, buffer.release_nonnull());
+}
+
+void NetworkAdapter::send_ethernet(const MACAddress& destination, u16 ether_type, NonnullRefPtr<PacketBuffer> packet)
+{
+    auto& eth = *(EthernetFrameHeader*)packet->push(sizeof(EthernetFrameHeader));
+    eth.set_source(mac_address());
+    eth.set_destination(destination);
+    eth.set_ether_type(ether_type);
     m_packets_out++;
-    m_bytes_out += size_in_bytes;
-    memcpy(eth->payload(), &packet, sizeof(ARPPacket));
-    send_raw((const u8*)eth, size_in_bytes);
+    m_bytes_out += packet->size();
+    send_packet(move(packet));
 }
 
-void NetworkAdapter::send_ipv4(const MACAddress& destination_mac, const IPv4Address& destination_ipv4, IPv4Protocol protocol, const u8* payload, size_t payload_size, u8 ttl)
+void NetworkAdapter::push_ipv4_header(PacketBuffer& packet, const IPv4Address& destination_ipv4, IPv4Protocol protocol, u8 ttl)
 {
+    size_t payload_size = packet.size();
     size_t ipv4_packet_size = sizeof(IPv4Packet) + payload_size;
-    if (ipv4_packet_size > mtu()) {
+    if (ipv4_packet_size > mtu() && !(packet.offloads() & PacketBuffer::OffloadTCPSegmentation)) {
         // FIXME: Implement IP fragmentation.
         ASSERT_NOT_REACHED();
     }
 
-    size_t ethernet_frame_size = sizeof(EthernetFrameHeader) + sizeof(IPv4Packet) + payload_size;
-    auto buffer = ByteBuffer::create_zeroed(ethernet_frame_size);
-    auto& eth = *(EthernetFrameHeader*)buffer.data();
-    eth.set_source(mac_address());
-    eth.set_destination(destination_mac);
-    eth.set_ether_type(EtherType::IPv4);
-    auto& ipv4 = *(IPv4Packet*)eth.payload();
+    auto& ipv4 = *(IPv4Packet*)packet.push(sizeof(IPv4Packet));
+    memset(&ipv4, 0, sizeof(IPv4Packet));
     ipv4.set_version(4);
     ipv4.set_internet_header_length(5);
     ipv4.set_source(ipv4_address());
     ipv4.set_destination(destination_ipv4);
     ipv4.set_protocol((u8)protocol);
-    ipv4.set_length(sizeof(IPv4Packet) + payload_size);
+    ipv4.set_length(ipv4_packet_size);
     ipv4.set_ident(1);
     ipv4.set_ttl(ttl);
-    ipv4.set_checksum(ipv4.compute_checksum());
-    m_packets_out++;
-    m_bytes_out += ethernet_frame_size;
-    memcpy(ipv4.payload(), payload, payload_size);
-    send_raw((const u8*)&eth, ethernet_frame_size);
+    if (has_capability(TxIPv4Checksum))
+        packet.request_offload(PacketBuffer::OffloadIPv4Checksum);
+    else
+        ipv4.set_checksum(ipv4.compute_checksum());
+}
+
+void NetworkAdapter::send_ipv4(const MACAddress& destination_mac, const IPv4Address& destination_ipv4, IPv4Protocol protocol, const u8* payload, size_t payload_size, u8 ttl)
+{
+    auto packet = PacketBuffer::copy(payload, payload_size);
+    if (!packet)
+        return;
+    send_ipv4(destination_mac, destination_ipv4, protocol, packet.release_nonnull(), ttl);
+}
+
+void NetworkAdapter::send_ipv4(const MACAddress& destination_mac, const IPv4Address& destination_ipv4, IPv4Protocol protocol, NonnullRefPtr<PacketBuffer> packet, u8 ttl)
+{
+    push_ipv4_header(*packet, destination_ipv4, protocol, ttl);
+    send_ethernet(destination_mac, EtherType::IPv4, move(packet));
+}
+
+void NetworkAdapter::send_ipv4(const IPv4Address& next_hop, const IPv4Address& destination_ipv4, IPv4Protocol protocol, const u8* payload, size_t payload_size, u8 ttl)
+{
+    auto packet = PacketBuffer::copy(payload, payload_size);
+    if (!packet)
+        return;
+    send_ipv4(next_hop, destination_ipv4, protocol, packet.release_nonnull(), ttl);
+}
+
+void NetworkAdapter::send_ipv4(const IPv4Address& next_hop, const IPv4Address& destination_ipv4, IPv4Protocol protocol, NonnullRefPtr<PacketBuffer> packet, u8 ttl)
+{
+    if (!requires_address_resolution())
+        return send_ipv4(MACAddress(), destination_ipv4, protocol, move(packet), ttl);
+    push_ipv4_header(*packet, destination_ipv4, protocol, ttl);
+    send_via_arp_table(*this, next_hop, move(packet));
+}
+
+void NetworkAdapter::send_packet(NonnullRefPtr<PacketBuffer> packet)
+{
+    send_raw(packet->data(), packet->size());
 }
 
 void NetworkAdapter::did_receive(const u8* data, int length)
+{
+    auto packet = PacketBuffer::copy(data, length, 0);
+    if (!packet)
+        return;
+    did_receive(packet.release_nonnull());
+}
+
+void NetworkAdapter::did_receive(NonnullRefPtr<PacketBuffer> packet)
 {
     InterruptDisabler disabler;
     m_packets_in++;
-    m_bytes_in += length;
-
-    Optional<KBuffer> buffer;
-
-    if (m_unused_packet_buffers.is_empty()) {
-        buffer = KBuffer::copy(data, length);
-    } else {
-        buffer = m_unused_packet_buffers.take_first();
-        --m_unused_packet_buffers_count;
-        if ((size_t)length <= buffer.value().size()) {
-            memcpy(buffer.value().data(), data, length);
-            buffer.value().set_size(length);
-        } else {
-            buffer = KBuffer::copy(data, length);
-        }
-    }
+    m_bytes_in += packet->size();
 
-    m_packet_queue.append(buffer.value());
+    m_packet_queue.enqueue(move(packet));
 
     if (on_receive)
         on_receive();
 }
 
-size_t NetworkAdapter::dequeue_packet(u8* buffer, size_t buffer_size)
+void NetworkAdapter::schedule_poll()
+{
+    m_needs_poll = true;
+    NetworkTask_wake();
+}
+
+RefPtr<PacketBuffer> NetworkAdapter::dequeue_packet()
 {
     InterruptDisabler disabler;
-    if (m_packet_queue.is_empty())
-        return 0;
-    auto packet = m_packet_queue.take_first();
-    size_t packet_size = packet.size();
-    ASSERT(packet_size <= buffer_size);
-    memcpy(buffer, packet.data(), packet_size);
-    if (m_unused_packet_buffers_count < 100) {
-        m_unused_packet_buffers.append(packet);
-        ++m_unused_packet_buffers_count;
-    }
-    return packet_size;
+    return m_packet_queue.dequeue();
 }
 
 void NetworkAdapter::set_ipv4_address(const IPv4Address& address)
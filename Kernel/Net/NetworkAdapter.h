@@ -11,11 +11,23 @@
 #include <Kernel/Net/ICMP.h>
 #include <Kernel/Net/IPv4.h>
 #include <Kernel/Net/MACAddress.h>
+#include <Kernel/Net/PacketBuffer.h>
 
 class NetworkAdapter;
 
 class NetworkAdapter : public Weakable<NetworkAdapter> {
 public:
+    // Work that the adapter can take off our hands. Outgoing packets ask for it with PacketBuffer::request_offload().
+    enum Capability : u32 {
+        TxIPv4Checksum = 1 << 0,
+        TxTCPChecksum = 1 << 1,
+        TxUDPChecksum = 1 << 2,
+        // The adapter checks the checksums of incoming packets, and drops the ones that are wrong.
+        RxChecksum = 1 << 3,
+        // The adapter cuts TCP segments bigger than the MSS up into MSS-sized ones (and checksums each of them.)
+        TCPSegmentation = 1 << 4,
+    };
+
     static void for_each(Function<void(NetworkAdapter&)>);
     static WeakPtr<NetworkAdapter> from_ipv4_address(const IPv4Address&);
     static WeakPtr<NetworkAdapter> lookup_by_name(const StringView&);
@@ -29,6 +41,8 @@ public:
     IPv4Address ipv4_netmask() const { return m_ipv4_netmask; }
     IPv4Address ipv4_gateway() const { return m_ipv4_gateway; }
     virtual bool link_up() { return false; }
+    // Whether we need to know a host's hardware address before we can send it anything.
+    virtual bool requires_address_resolution() const { return true; }
 
     void set_ipv4_address(const IPv4Address&);
     void set_ipv4_netmask(const IPv4Address&);
@@ -36,14 +50,33 @@ public:
 
     void send(const MACAddress&, const ARPPacket&);
     void send_ipv4(const MACAddress&, const IPv4Address&, IPv4Protocol, const u8* payload, size_t payload_size, u8 ttl);
+    // NOTE: The packet's data is the IPv4 payload; the IPv4 and Ethernet headers get pushed into its headroom.
+    void send_ipv4(const MACAddress&, const IPv4Address&, IPv4Protocol, NonnullRefPtr<PacketBuffer>, u8 ttl);
+    // These send to a next hop (see route_to()) whose hardware address gets looked up in the ARP table.
+    void send_ipv4(const IPv4Address& next_hop, const IPv4Address&, IPv4Protocol, const u8* payload, size_t payload_size, u8 ttl);
+    void send_ipv4(const IPv4Address& next_hop, const IPv4Address&, IPv4Protocol, NonnullRefPtr<PacketBuffer>, u8 ttl);
+    void send_ethernet(const MACAddress&, u16 ether_type, NonnullRefPtr<PacketBuffer>);
 
-    size_t dequeue_packet(u8* buffer, size_t buffer_size);
+    RefPtr<PacketBuffer> dequeue_packet();
 
     bool has_queued_packets() const { return !m_packet_queue.is_empty(); }
 
+    // Adapters that support polling mask their receive interrupt and call schedule_poll() instead of
+    // handling packets one interrupt at a time. The NetworkTask then calls poll() to pick up to `budget`
+    // packets off the hardware, until poll() comes up short and the adapter unmasks the interrupt again.
+    bool needs_poll() const { return m_needs_poll; }
+    virtual size_t poll(size_t budget)
+    {
+        (void)budget;
+        return 0;
+    }
+
     u32 mtu() const { return m_mtu; }
     void set_mtu(u32 mtu) { m_mtu = mtu; }
 
+    u32 capabilities() const { return m_capabilities; }
+    bool has_capability(Capability capability) const { return m_capabilities & capability; }
+
     u32 packets_in() const { return m_packets_in; }
     u32 bytes_in() const { return m_bytes_in; }
     u32 packets_out() const { return m_packets_out; }
@@ -55,21 +88,28 @@ protected:
     NetworkAdapter();
     void set_interface_name(const StringView& basename);
     void set_mac_address(const MACAddress& mac_address) { m_mac_address = mac_address; }
+    void set_capabilities(u32 capabilities) { m_capabilities = capabilities; }
     virtual void send_raw(const u8*, int) = 0;
+    // Adapters that can transmit straight out of a PacketBuffer should override this.
+    virtual void send_packet(NonnullRefPtr<PacketBuffer>);
     void did_receive(const u8*, int);
+    void did_receive(NonnullRefPtr<PacketBuffer>);
+    void schedule_poll();
+    void push_ipv4_header(PacketBuffer&, const IPv4Address&, IPv4Protocol, u8 ttl);
+    void poll_completed() { m_needs_poll = false; }
 
 private:
     MACAddress m_mac_address;
     IPv4Address m_ipv4_address;
     IPv4Address m_ipv4_netmask;
     IPv4Address m_ipv4_gateway;
-    SinglyLinkedList<KBuffer> m_packet_queue;
-    SinglyLinkedList<KBuffer> m_unused_packet_buffers;
-    size_t m_unused_packet_buffers_count { 0 };
+    PacketQueue m_packet_queue;
     String m_name;
     u32 m_packets_in { 0 };
     u32 m_bytes_in { 0 };
     u32 m_packets_out { 0 };
     u32 m_bytes_out { 0 };
     u32 m_mtu { 1500 };
+    u32 m_capabilities { 0 };
+    volatile bool m_needs_poll { false };
 };
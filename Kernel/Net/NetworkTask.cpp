@@ -6,6 +6,7 @@
 #include <Kernel/Net/IPv4.h>
 #include <Kernel/Net/IPv4Socket.h>
 #include <Kernel/Net/LoopbackAdapter.h>
+#include <Kernel/Net/NetworkTask.h>
 #include <Kernel/Net/Routing.h>
 #include <Kernel/Net/TCP.h>
 #include <Kernel/Net/TCPSocket.h>
@@ -23,14 +24,26 @@
 //#define TCP_DEBUG
 
 static void handle_arp(const EthernetFrameHeader&, size_t frame_size);
-static void handle_ipv4(const EthernetFrameHeader&, size_t frame_size);
-static void handle_icmp(const EthernetFrameHeader&, const IPv4Packet&);
-static void handle_udp(const IPv4Packet&);
-static void handle_tcp(const IPv4Packet&);
+static void handle_ipv4(PacketBuffer&);
+static void handle_icmp(const EthernetFrameHeader&, PacketBuffer&);
+static void handle_udp(PacketBuffer&);
+static void handle_tcp(PacketBuffer&);
+
+// How many packets we take off an adapter in one go before processing them.
+static constexpr size_t poll_budget = 64;
+
+static WaitQueue* s_packet_wait_queue;
+
+void NetworkTask_wake()
+{
+    if (s_packet_wait_queue)
+        s_packet_wait_queue->wake_all();
+}
 
 void NetworkTask_main()
 {
     WaitQueue packet_wait_queue;
+    s_packet_wait_queue = &packet_wait_queue;
     u8 octet = 15;
     int pending_packets = 0;
     NetworkAdapter::for_each([&](auto& adapter) {
@@ -57,38 +70,51 @@ void NetworkTask_main()
         };
     });
 
-    auto dequeue_packet = [&pending_packets](u8* buffer, size_t buffer_size) -> size_t {
+    auto dequeue_packet = [&pending_packets]() -> RefPtr<PacketBuffer> {
         if (pending_packets == 0)
-            return 0;
-        size_t packet_size = 0;
+            return nullptr;
+        RefPtr<PacketBuffer> packet;
         NetworkAdapter::for_each([&](auto& adapter) {
-            if (packet_size || !adapter.has_queued_packets())
+            if (packet || !adapter.has_queued_packets())
                 return;
-            packet_size = adapter.dequeue_packet(buffer, buffer_size);
+            packet = adapter.dequeue_packet();
             pending_packets--;
 #ifdef NETWORK_TASK_DEBUG
-            kprintf("NetworkTask: Dequeued packet from %s (%d bytes)\n", adapter.name().characters(), packet_size);
+            kprintf("NetworkTask: Dequeued packet from %s (%d bytes)\n", adapter.name().characters(), packet->size());
 #endif
         });
-        return packet_size;
+        return packet;
     };
 
-    size_t buffer_size = 64 * KB;
-    auto buffer_region = MM.allocate_kernel_region(buffer_size, "Kernel Packet Buffer", Region::Access::Read | Region::Access::Write, false, true);
-    auto buffer = (u8*)buffer_region->vaddr().get();
+    auto poll_adapters = [] {
+        size_t packets_polled = 0;
+        NetworkAdapter::for_each([&](auto& adapter) {
+            if (adapter.needs_poll())
+                packets_polled += adapter.poll(poll_budget);
+        });
+        return packets_polled;
+    };
 
     kprintf("NetworkTask: Enter main loop.\n");
     for (;;) {
-        size_t packet_size = dequeue_packet(buffer, buffer_size);
-        if (!packet_size) {
+        if (TCPSocket::has_expired_timers())
+            TCPSocket::handle_expired_timers();
+        if (arp_table_needs_sweep())
+            sweep_arp_table();
+        auto packet = dequeue_packet();
+        if (!packet) {
+            // We've caught up, so pick up the next batch from any adapter that's waiting to be polled.
+            if (poll_adapters())
+                continue;
             current->wait_on(packet_wait_queue);
             continue;
         }
+        size_t packet_size = packet->size();
         if (packet_size < sizeof(EthernetFrameHeader)) {
             kprintf("NetworkTask: Packet is too small to be an Ethernet packet! (%zu)\n", packet_size);
             continue;
         }
-        auto& eth = *(const EthernetFrameHeader*)buffer;
+        auto& eth = *(const EthernetFrameHeader*)packet->data();
 #ifdef ETHERNET_DEBUG
         kprintf("NetworkTask: From %s to %s, ether_type=%w, packet_length=%u\n",
             eth.source().to_string().characters(),
@@ -99,7 +125,7 @@ void NetworkTask_main()
 
 #ifdef ETHERNET_VERY_DEBUG
         for (size_t i = 0; i < packet_size; i++) {
-            kprintf("%b", buffer[i]);
+            kprintf("%b", packet->data()[i]);
 
             switch (i % 16) {
             case 7:
@@ -122,7 +148,7 @@ void NetworkTask_main()
             handle_arp(eth, packet_size);
             break;
         case EtherType::IPv4:
-            handle_ipv4(eth, packet_size);
+            handle_ipv4(*packet);
             break;
         case EtherType::IPv6:
             // ignore
@@ -164,24 +190,28 @@ void handle_arp(const EthernetFrameHeader& eth, size_t frame_size)
 #endif
 
     if (!packet.sender_hardware_address().is_zero() && !packet.sender_protocol_address().is_zero()) {
-        // Someone has this IPv4 address. I guess we can try to remember that.
-        // FIXME: Protect against ARP spamming.
+        // Someone has this IPv4 address. If we were asking, or they're asking for us (and are
+        // thus likely to talk to us soon), remember that. Anything else is none of our business.
         // FIXME: Support static ARP table entries.
-        LOCKER(arp_table().lock());
-        arp_table().resource().set(packet.sender_protocol_address(), packet.sender_hardware_address());
+        bool is_asking_for_us = packet.operation() == ARPOperation::Request && NetworkAdapter::from_ipv4_address(packet.target_protocol_address());
+        update_arp_table(packet.sender_protocol_address(), packet.sender_hardware_address(), is_asking_for_us ? ShouldCreateARPEntry::Yes : ShouldCreateARPEntry::No);
 
-        kprintf("ARP table (%d entries):\n", arp_table().resource().size());
-        for (auto& it : arp_table().resource()) {
-            kprintf("%s :: %s\n", it.value.to_string().characters(), it.key.to_string().characters());
-        }
+#ifdef ARP_DEBUG
+        kprintf("ARP table:\n");
+        for_each_arp_table_entry([](auto& address, auto& entry) {
+            kprintf("%s :: %s (%s)\n", entry.mac_address.to_string().characters(), address.to_string().characters(), to_string(entry.state));
+        });
+#endif
     }
 
     if (packet.operation() == ARPOperation::Request) {
         // Who has this IP address?
         if (auto adapter = NetworkAdapter::from_ipv4_address(packet.target_protocol_address())) {
             // We do!
+#ifdef ARP_DEBUG
             kprintf("handle_arp: Responding to ARP request for my IPv4 address (%s)\n",
                 adapter->ipv4_address().to_string().characters());
+#endif
             ARPPacket response;
             response.set_operation(ARPOperation::Response);
             response.set_target_hardware_address(packet.sender_hardware_address());
@@ -195,8 +225,10 @@ void handle_arp(const EthernetFrameHeader& eth, size_t frame_size)
     }
 }
 
-void handle_ipv4(const EthernetFrameHeader& eth, size_t frame_size)
+void handle_ipv4(PacketBuffer& frame)
 {
+    size_t frame_size = frame.size();
+    auto& eth = *(const EthernetFrameHeader*)frame.data();
     constexpr size_t minimum_ipv4_frame_size = sizeof(EthernetFrameHeader) + sizeof(IPv4Packet);
     if (frame_size < minimum_ipv4_frame_size) {
         kprintf("handle_ipv4: Frame too small (%d, need %d)\n", frame_size, minimum_ipv4_frame_size);
@@ -221,21 +253,26 @@ void handle_ipv4(const EthernetFrameHeader& eth, size_t frame_size)
         packet.destination().to_string().characters());
 #endif
 
+    // From here on, the frame is just the IPv4 packet. (The Ethernet header stays put in the headroom.)
+    frame.pull(sizeof(EthernetFrameHeader));
+    frame.trim(packet.length());
+
     switch ((IPv4Protocol)packet.protocol()) {
     case IPv4Protocol::ICMP:
-        return handle_icmp(eth, packet);
+        return handle_icmp(eth, frame);
     case IPv4Protocol::UDP:
-        return handle_udp(packet);
+        return handle_udp(frame);
     case IPv4Protocol::TCP:
-        return handle_tcp(packet);
+        return handle_tcp(frame);
     default:
         kprintf("handle_ipv4: Unhandled protocol %u\n", packet.protocol());
         break;
     }
 }
 
-void handle_icmp(const EthernetFrameHeader& eth, const IPv4Packet& ipv4_packet)
+void handle_icmp(const EthernetFrameHeader& eth, PacketBuffer& packet)
 {
+    auto& ipv4_packet = *(const IPv4Packet*)packet.data();
     auto& icmp_header = *static_cast<const ICMPHeader*>(ipv4_packet.payload());
 #ifdef ICMP_DEBUG
     kprintf("handle_icmp: source=%s, destination=%s, type=%b, code=%b\n",
@@ -245,15 +282,9 @@ void handle_icmp(const EthernetFrameHeader& eth, const IPv4Packet& ipv4_packet)
         icmp_header.code());
 #endif
 
-    {
-        LOCKER(IPv4Socket::all_sockets().lock());
-        for (RefPtr<IPv4Socket> socket : IPv4Socket::all_sockets().resource()) {
-            LOCKER(socket->lock());
-            if (socket->protocol() != (unsigned)IPv4Protocol::ICMP)
-                continue;
-            socket->did_receive(ipv4_packet.source(), 0, KBuffer::copy(&ipv4_packet, sizeof(IPv4Packet) + ipv4_packet.payload_size()));
-        }
-    }
+    IPv4Socket::for_each_raw_socket(IPv4Protocol::ICMP, [&](auto& socket) {
+        socket.did_receive(ipv4_packet.source(), 0, packet);
+    });
 
     auto adapter = NetworkAdapter::from_ipv4_address(ipv4_packet.destination());
     if (!adapter)
@@ -261,13 +292,18 @@ void handle_icmp(const EthernetFrameHeader& eth, const IPv4Packet& ipv4_packet)
 
     if (icmp_header.type() == ICMPType::EchoRequest) {
         auto& request = reinterpret_cast<const ICMPEchoPacket&>(icmp_header);
+#ifdef ICMP_DEBUG
         kprintf("handle_icmp: EchoRequest from %s: id=%u, seq=%u\n",
             ipv4_packet.source().to_string().characters(),
             (u16)request.identifier,
             (u16)request.sequence_number);
+#endif
         size_t icmp_packet_size = ipv4_packet.payload_size();
-        auto buffer = ByteBuffer::create_zeroed(icmp_packet_size);
-        auto& response = *(ICMPEchoPacket*)buffer.data();
+        auto reply = PacketBuffer::create(icmp_packet_size);
+        if (!reply)
+            return;
+        memset(reply->data(), 0, icmp_packet_size);
+        auto& response = *(ICMPEchoPacket*)reply->data();
         response.header.set_type(ICMPType::EchoReply);
         response.header.set_code(0);
         response.identifier = request.identifier;
@@ -276,12 +312,13 @@ void handle_icmp(const EthernetFrameHeader& eth, const IPv4Packet& ipv4_packet)
             memcpy(response.payload(), request.payload(), icmp_payload_size);
         response.header.set_checksum(internet_checksum(&response, icmp_packet_size));
         // FIXME: What is the right TTL value here? Is 64 ok? Should we use the same TTL as the echo request?
-        adapter->send_ipv4(eth.source(), ipv4_packet.source(), IPv4Protocol::ICMP, buffer.data(), buffer.size(), 64);
+        adapter->send_ipv4(eth.source(), ipv4_packet.source(), IPv4Protocol::ICMP, reply.release_nonnull(), 64);
     }
 }
 
-void handle_udp(const IPv4Packet& ipv4_packet)
+void handle_udp(PacketBuffer& packet)
 {
+    auto& ipv4_packet = *(const IPv4Packet*)packet.data();
     if (ipv4_packet.payload_size() < sizeof(UDPPacket)) {
         kprintf("handle_udp: Packet too small (%u, need %zu)\n", ipv4_packet.payload_size());
         return;
@@ -289,7 +326,9 @@ void handle_udp(const IPv4Packet& ipv4_packet)
 
     auto adapter = NetworkAdapter::from_ipv4_address(ipv4_packet.destination());
     if (!adapter) {
+#ifdef UDP_DEBUG
         kprintf("handle_udp: this packet is not for me, it's for %s\n", ipv4_packet.destination().to_string().characters());
+#endif
         return;
     }
 
@@ -303,19 +342,22 @@ void handle_udp(const IPv4Packet& ipv4_packet)
         udp_packet.length());
 #endif
 
-    auto socket = UDPSocket::from_port(udp_packet.destination_port());
+    auto socket = UDPSocket::from_endpoint(ipv4_packet.destination(), udp_packet.destination_port());
     if (!socket) {
-        kprintf("handle_udp: No UDP socket for port %u\n", udp_packet.destination_port());
+#ifdef UDP_DEBUG
+        kprintf("handle_udp: No UDP socket for %s:%u\n", ipv4_packet.destination().to_string().characters(), udp_packet.destination_port());
+#endif
         return;
     }
 
     ASSERT(socket->type() == SOCK_DGRAM);
     ASSERT(socket->local_port() == udp_packet.destination_port());
-    socket->did_receive(ipv4_packet.source(), udp_packet.source_port(), KBuffer::copy(&ipv4_packet, sizeof(IPv4Packet) + ipv4_packet.payload_size()));
+    socket->did_receive(ipv4_packet.source(), udp_packet.source_port(), packet);
 }
 
-void handle_tcp(const IPv4Packet& ipv4_packet)
+void handle_tcp(PacketBuffer& packet)
 {
+    auto& ipv4_packet = *(const IPv4Packet*)packet.data();
     if (ipv4_packet.payload_size() < sizeof(TCPPacket)) {
         kprintf("handle_tcp: IPv4 payload is too small to be a TCP packet (%u, need %zu)\n", ipv4_packet.payload_size(), sizeof(TCPPacket));
         return;
@@ -327,6 +369,7 @@ void handle_tcp(const IPv4Packet& ipv4_packet)
     size_t maximum_tcp_header_size = 15 * sizeof(u32);
     if (tcp_packet.header_size() < minimum_tcp_header_size || tcp_packet.header_size() > maximum_tcp_header_size) {
         kprintf("handle_tcp: TCP packet header has invalid size %zu\n", tcp_packet.header_size());
+        return;
     }
 
     if (ipv4_packet.payload_size() < tcp_packet.header_size()) {
@@ -355,7 +398,9 @@ void handle_tcp(const IPv4Packet& ipv4_packet)
 
     auto adapter = NetworkAdapter::from_ipv4_address(ipv4_packet.destination());
     if (!adapter) {
+#ifdef TCP_DEBUG
         kprintf("handle_tcp: this packet is not for me, it's for %s\n", ipv4_packet.destination().to_string().characters());
+#endif
         return;
     }
 
@@ -367,6 +412,7 @@ void handle_tcp(const IPv4Packet& ipv4_packet)
 
     auto socket = TCPSocket::from_tuple(tuple);
     if (!socket) {
+#ifdef TCP_DEBUG
         kprintf("handle_tcp: No TCP socket for tuple %s\n", tuple.to_string().characters());
         kprintf("handle_tcp: source=%s:%u, destination=%s:%u seq_no=%u, ack_no=%u, flags=%w (%s%s%s%s), window_size=%u, payload_size=%u\n",
             ipv4_packet.source().to_string().characters(),
@@ -382,6 +428,7 @@ void handle_tcp(const IPv4Packet& ipv4_packet)
             tcp_packet.has_rst() ? "RST " : "",
             tcp_packet.window_size(),
             payload_size);
+#endif
         return;
     }
 
@@ -396,11 +443,15 @@ void handle_tcp(const IPv4Packet& ipv4_packet)
 
     switch (socket->state()) {
     case TCPSocket::State::Closed:
+#ifdef TCP_DEBUG
         kprintf("handle_tcp: unexpected flags in Closed state\n");
+#endif
         // TODO: we may want to send an RST here, maybe as a configurable option
         return;
     case TCPSocket::State::TimeWait:
+#ifdef TCP_DEBUG
         kprintf("handle_tcp: unexpected flags in TimeWait state\n");
+#endif
         socket->send_tcp_packet(TCPFlags::RST);
         socket->set_state(TCPSocket::State::Closed);
         return;
@@ -422,12 +473,15 @@ void handle_tcp(const IPv4Packet& ipv4_packet)
 #endif
             client->set_sequence_number(1000);
             client->set_ack_number(tcp_packet.sequence_number() + payload_size + 1);
+            client->process_syn_options(tcp_packet);
             client->send_tcp_packet(TCPFlags::SYN | TCPFlags::ACK);
             client->set_state(TCPSocket::State::SynReceived);
             return;
         }
         default:
+#ifdef TCP_DEBUG
             kprintf("handle_tcp: unexpected flags in Listen state\n");
+#endif
             // socket->send_tcp_packet(TCPFlags::RST);
             return;
         }
@@ -460,7 +514,9 @@ void handle_tcp(const IPv4Packet& ipv4_packet)
             socket->set_setup_state(Socket::SetupState::Completed);
             return;
         default:
+#ifdef TCP_DEBUG
             kprintf("handle_tcp: unexpected flags in SynSent state\n");
+#endif
             socket->send_tcp_packet(TCPFlags::RST);
             socket->set_state(TCPSocket::State::Closed);
             socket->set_error(TCPSocket::Error::UnexpectedFlagsDuringConnect);
@@ -499,7 +555,9 @@ void handle_tcp(const IPv4Packet& ipv4_packet)
 
             return;
         default:
+#ifdef TCP_DEBUG
             kprintf("handle_tcp: unexpected flags in SynReceived state\n");
+#endif
             socket->send_tcp_packet(TCPFlags::RST);
             socket->set_state(TCPSocket::State::Closed);
             return;
@@ -507,7 +565,9 @@ void handle_tcp(const IPv4Packet& ipv4_packet)
     case TCPSocket::State::CloseWait:
         switch (tcp_packet.flags()) {
         default:
+#ifdef TCP_DEBUG
             kprintf("handle_tcp: unexpected flags in CloseWait state\n");
+#endif
             socket->send_tcp_packet(TCPFlags::RST);
             socket->set_state(TCPSocket::State::Closed);
             return;
@@ -519,7 +579,9 @@ void handle_tcp(const IPv4Packet& ipv4_packet)
             socket->set_state(TCPSocket::State::Closed);
             return;
         default:
+#ifdef TCP_DEBUG
             kprintf("handle_tcp: unexpected flags in LastAck state\n");
+#endif
             socket->send_tcp_packet(TCPFlags::RST);
             socket->set_state(TCPSocket::State::Closed);
             return;
@@ -535,7 +597,9 @@ void handle_tcp(const IPv4Packet& ipv4_packet)
             socket->set_state(TCPSocket::State::Closing);
             return;
         default:
+#ifdef TCP_DEBUG
             kprintf("handle_tcp: unexpected flags in FinWait1 state\n");
+#endif
             socket->send_tcp_packet(TCPFlags::RST);
             socket->set_state(TCPSocket::State::Closed);
             return;
@@ -547,7 +611,9 @@ void handle_tcp(const IPv4Packet& ipv4_packet)
             socket->set_state(TCPSocket::State::TimeWait);
             return;
         default:
+#ifdef TCP_DEBUG
             kprintf("handle_tcp: unexpected flags in FinWait2 state\n");
+#endif
             socket->send_tcp_packet(TCPFlags::RST);
             socket->set_state(TCPSocket::State::Closed);
             return;
@@ -559,15 +625,24 @@ void handle_tcp(const IPv4Packet& ipv4_packet)
             socket->set_state(TCPSocket::State::TimeWait);
             return;
         default:
+#ifdef TCP_DEBUG
             kprintf("handle_tcp: unexpected flags in Closing state\n");
+#endif
             socket->send_tcp_packet(TCPFlags::RST);
             socket->set_state(TCPSocket::State::Closed);
             return;
         }
     case TCPSocket::State::Established:
+        if (tcp_packet.sequence_number() != socket->ack_number() && (payload_size || tcp_packet.has_fin())) {
+            // We don't keep out-of-order segments around, so drop this one and repeat our last
+            // acknowledgement. A few of those will make the peer fast retransmit what we're missing.
+            socket->send_tcp_packet(TCPFlags::ACK);
+            return;
+        }
+
         if (tcp_packet.has_fin()) {
             if (payload_size != 0)
-                socket->did_receive(ipv4_packet.source(), tcp_packet.source_port(), KBuffer::copy(&ipv4_packet, sizeof(IPv4Packet) + ipv4_packet.payload_size()));
+                socket->did_receive(ipv4_packet.source(), tcp_packet.source_port(), packet);
 
             socket->set_ack_number(tcp_packet.sequence_number() + payload_size + 1);
             // TODO: We should only send a FIN packet out once we're shutting
@@ -580,6 +655,14 @@ void handle_tcp(const IPv4Packet& ipv4_packet)
             return;
         }
 
+        // A bare ACK doesn't get acknowledged; it's already been processed by receive_tcp_packet().
+        if (payload_size == 0)
+            return;
+
+        // If there's no room for the data, drop it without acknowledging it so the peer sends it again.
+        if (!socket->did_receive(ipv4_packet.source(), tcp_packet.source_port(), packet))
+            return;
+
         socket->set_ack_number(tcp_packet.sequence_number() + payload_size);
 
 #ifdef TCP_DEBUG
@@ -591,12 +674,6 @@ void handle_tcp(const IPv4Packet& ipv4_packet)
             socket->sequence_number());
 #endif
 
-        bool should_ack = true;
-        if (payload_size != 0) {
-            should_ack = socket->did_receive(ipv4_packet.source(), tcp_packet.source_port(), KBuffer::copy(&ipv4_packet, sizeof(IPv4Packet) + ipv4_packet.payload_size()));
-        }
-
-        if (should_ack)
-            socket->send_tcp_packet(TCPFlags::ACK);
+        socket->acknowledge_received_data();
     }
 }
@@ -1,3 +1,4 @@
 #pragma once
 
 void NetworkTask_main();
+void NetworkTask_wake();
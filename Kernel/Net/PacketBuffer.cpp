@@ -0,0 +1,246 @@
+#include <Kernel/Net/PacketBuffer.h>
+#include <Kernel/VM/MemoryManager.h>
+
+//#define PACKET_BUFFER_DEBUG
+
+// Each pool region is carved into pool_chunk_size chunks, which never straddle a page.
+static constexpr size_t pool_region_size = 64 * KB;
+static constexpr size_t max_pool_regions = 16;
+static constexpr size_t max_cached_large_regions = 16;
+
+static_assert(PAGE_SIZE % PacketStorage::pool_chunk_size == 0);
+
+struct FreeChunk {
+    FreeChunk* next;
+    Region* region;
+};
+
+static Region* s_pool_regions[max_pool_regions];
+static size_t s_pool_region_count;
+static FreeChunk* s_free_chunks;
+
+static Region* s_cached_large_regions[max_cached_large_regions];
+static size_t s_cached_large_region_count;
+
+static bool grow_pool()
+{
+    if (s_pool_region_count >= max_pool_regions)
+        return false;
+    auto region = MM.allocate_kernel_region(pool_region_size, "Packet Buffers", Region::Access::Read | Region::Access::Write);
+    if (!region)
+        return false;
+
+    InterruptDisabler disabler;
+    if (s_pool_region_count >= max_pool_regions)
+        return true;
+    auto* pool_region = region.leak_ptr();
+    s_pool_regions[s_pool_region_count++] = pool_region;
+    for (size_t offset = 0; offset < pool_region_size; offset += PacketStorage::pool_chunk_size) {
+        auto* chunk = (FreeChunk*)(pool_region->vaddr().as_ptr() + offset);
+        chunk->next = s_free_chunks;
+        chunk->region = pool_region;
+        s_free_chunks = chunk;
+    }
+#ifdef PACKET_BUFFER_DEBUG
+    dbgprintf("PacketStorage: Pool grew to %u regions\n", s_pool_region_count);
+#endif
+    return true;
+}
+
+static FreeChunk* take_pool_chunk()
+{
+    InterruptDisabler disabler;
+    auto* chunk = s_free_chunks;
+    if (chunk)
+        s_free_chunks = chunk->next;
+    return chunk;
+}
+
+RefPtr<PacketStorage> PacketStorage::create(size_t capacity)
+{
+    // NOTE: We may get here from an IRQ handler, and allocating a region may block,
+    //       so with interrupts disabled we can only use memory we already have.
+    bool can_allocate = are_interrupts_enabled();
+
+    if (capacity <= pool_chunk_size) {
+        auto* chunk = take_pool_chunk();
+        if (!chunk && can_allocate && grow_pool())
+            chunk = take_pool_chunk();
+        if (chunk)
+            return adopt(*new PacketStorage((u8*)chunk, pool_chunk_size, *chunk->region, nullptr));
+    }
+
+    // NOTE: If the pool is exhausted, small packets get a dedicated region rather than a large one.
+    if (capacity > pool_chunk_size && capacity <= large_chunk_size) {
+        capacity = large_chunk_size;
+        InterruptDisabler disabler;
+        if (s_cached_large_region_count) {
+            OwnPtr<Region> region(s_cached_large_regions[--s_cached_large_region_count]);
+            auto* data = region->vaddr().as_ptr();
+            auto& region_ref = *region;
+            return adopt(*new PacketStorage(data, capacity, region_ref, move(region)));
+        }
+    }
+
+    if (!can_allocate)
+        return nullptr;
+    auto region = MM.allocate_kernel_region(PAGE_ROUND_UP(capacity), "Packet Buffer", Region::Access::Read | Region::Access::Write);
+    if (!region)
+        return nullptr;
+    auto* data = region->vaddr().as_ptr();
+    auto& region_ref = *region;
+    return adopt(*new PacketStorage(data, capacity, region_ref, move(region)));
+}
+
+PacketStorage::PacketStorage(u8* data, size_t capacity, Region& region, OwnPtr<Region>&& owned_region)
+    : m_data(data)
+    , m_capacity(capacity)
+    , m_region(region)
+    , m_owned_region(move(owned_region))
+{
+}
+
+PacketStorage::~PacketStorage()
+{
+    InterruptDisabler disabler;
+    if (!m_owned_region) {
+        auto* chunk = (FreeChunk*)m_data;
+        chunk->next = s_free_chunks;
+        chunk->region = &m_region;
+        s_free_chunks = chunk;
+        return;
+    }
+    if (m_capacity == large_chunk_size && s_cached_large_region_count < max_cached_large_regions)
+        s_cached_large_regions[s_cached_large_region_count++] = m_owned_region.leak_ptr();
+}
+
+PhysicalAddress PacketStorage::physical_address(size_t offset) const
+{
+    size_t region_offset = (m_data + offset) - m_region.vaddr().as_ptr();
+    size_t region_end = (m_data + m_capacity) - m_region.vaddr().as_ptr();
+    auto& physical_pages = m_region.vmobject().physical_pages();
+    size_t first_page = m_region.first_page_index() + region_offset / PAGE_SIZE;
+    size_t last_page = m_region.first_page_index() + (region_end - 1) / PAGE_SIZE;
+    if (!physical_pages[first_page])
+        return {};
+    auto base = physical_pages[first_page]->paddr();
+    for (size_t page = first_page + 1; page <= last_page; ++page) {
+        if (!physical_pages[page] || physical_pages[page]->paddr().get() != base.get() + (page - first_page) * PAGE_SIZE)
+            return {};
+    }
+    return base.offset(region_offset % PAGE_SIZE);
+}
+
+size_t PacketStorage::physical_ranges(size_t offset, size_t length, PhysicalRange* ranges, size_t max_ranges) const
+{
+    auto& physical_pages = m_region.vmobject().physical_pages();
+    size_t region_offset = (m_data + offset) - m_region.vaddr().as_ptr();
+    size_t count = 0;
+    while (length) {
+        auto& page = physical_pages[m_region.first_page_index() + region_offset / PAGE_SIZE];
+        if (!page)
+            return 0;
+        size_t offset_in_page = region_offset % PAGE_SIZE;
+        size_t chunk_size = min(length, (size_t)PAGE_SIZE - offset_in_page);
+        auto address = page->paddr().offset(offset_in_page);
+        if (count && ranges[count - 1].address.offset(ranges[count - 1].length).get() == address.get()) {
+            ranges[count - 1].length += chunk_size;
+        } else {
+            if (count == max_ranges)
+                return 0;
+            ranges[count++] = { address, chunk_size };
+        }
+        region_offset += chunk_size;
+        length -= chunk_size;
+    }
+    return count;
+}
+
+RefPtr<PacketBuffer> PacketBuffer::create(size_t size, size_t headroom, size_t tailroom)
+{
+    auto storage = PacketStorage::create(headroom + size + tailroom);
+    if (!storage)
+        return nullptr;
+    return adopt(*new PacketBuffer(storage.release_nonnull(), headroom, size));
+}
+
+RefPtr<PacketBuffer> PacketBuffer::copy(const void* data, size_t size, size_t headroom)
+{
+    auto packet = create(size, headroom);
+    if (packet)
+        memcpy(packet->data(), data, size);
+    return packet;
+}
+
+PacketBuffer::PacketBuffer(NonnullRefPtr<PacketStorage>&& storage, size_t offset, size_t size)
+    : m_storage(move(storage))
+    , m_offset(offset)
+    , m_size(size)
+{
+    ASSERT(m_offset + m_size <= m_storage->capacity());
+}
+
+NonnullRefPtr<PacketBuffer> PacketBuffer::clone()
+{
+    return adopt(*new PacketBuffer(NonnullRefPtr<PacketStorage>(m_storage), m_offset, m_size));
+}
+
+RefPtr<PacketBuffer> PacketBuffer::copy() const
+{
+    auto packet = create(m_size, m_offset);
+    if (packet)
+        memcpy(packet->data(), data(), m_size);
+    return packet;
+}
+
+u8* PacketBuffer::push(size_t amount)
+{
+    ASSERT(amount <= m_offset);
+    m_offset -= amount;
+    m_size += amount;
+    return data();
+}
+
+void PacketBuffer::pull(size_t amount)
+{
+    ASSERT(amount <= m_size);
+    m_offset += amount;
+    m_size -= amount;
+}
+
+u8* PacketBuffer::put(size_t amount)
+{
+    ASSERT(amount <= tailroom());
+    u8* tail = data() + m_size;
+    m_size += amount;
+    return tail;
+}
+
+void PacketBuffer::trim(size_t new_size)
+{
+    ASSERT(new_size <= m_size);
+    m_size = new_size;
+}
+
+void PacketQueue::enqueue(NonnullRefPtr<PacketBuffer>&& packet)
+{
+    ASSERT(!packet->m_queue_node.is_in_list());
+    // NOTE: The queue holds on to a reference until the packet is dequeued.
+    m_packets.append(packet.leak_ref());
+    ++m_size;
+}
+
+RefPtr<PacketBuffer> PacketQueue::dequeue()
+{
+    auto* packet = m_packets.take_first();
+    if (!packet)
+        return nullptr;
+    --m_size;
+    return adopt(*packet);
+}
+
+void PacketQueue::clear()
+{
+    while (dequeue())
+        ;
+}
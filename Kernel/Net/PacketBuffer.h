@@ -0,0 +1,145 @@
+#pragma once
+
+// PacketBuffer: A reference-counted network packet.
+//
+// The bytes of a packet live in a PacketStorage, which is reference-counted separately,
+// so several PacketBuffers can look at the same bytes (see clone()) without copying them.
+// Each PacketBuffer has its own window into the storage, with headroom in front of it
+// so that lower layers can push() their headers without moving the payload around,
+// and upper layers can pull() them off again on the way in.
+//
+// Storage for Ethernet-sized packets comes out of a pool of page-backed chunks that
+// never straddle a page boundary, so they can be handed straight to a NIC for DMA.
+
+#include <AK/Assertions.h>
+#include <AK/IntrusiveList.h>
+#include <AK/NonnullRefPtr.h>
+#include <AK/OwnPtr.h>
+#include <AK/RefCounted.h>
+#include <AK/RefPtr.h>
+#include <AK/Types.h>
+#include <Kernel/VM/PhysicalAddress.h>
+
+class Region;
+
+// A physically contiguous piece of a packet.
+struct PhysicalRange {
+    PhysicalAddress address;
+    size_t length { 0 };
+};
+
+class PacketStorage : public RefCounted<PacketStorage> {
+public:
+    static constexpr size_t pool_chunk_size = 2048;
+    static constexpr size_t large_chunk_size = 72 * KB;
+
+    // Returns null if we're out of memory for packets.
+    static RefPtr<PacketStorage> create(size_t capacity);
+    ~PacketStorage();
+
+    u8* data() { return m_data; }
+    const u8* data() const { return m_data; }
+    size_t capacity() const { return m_capacity; }
+
+    // Returns the physical address of the byte at `offset`, or a null address if the
+    // storage isn't physically contiguous and thus can't be used for DMA.
+    PhysicalAddress physical_address(size_t offset = 0) const;
+
+    // Splits `length` bytes starting at `offset` into as few physically contiguous pieces as
+    // possible. Returns the number of pieces, or 0 if there are more than `max_ranges` of them.
+    size_t physical_ranges(size_t offset, size_t length, PhysicalRange*, size_t max_ranges) const;
+
+private:
+    PacketStorage(u8* data, size_t capacity, Region&, OwnPtr<Region>&&);
+
+    u8* m_data { nullptr };
+    size_t m_capacity { 0 };
+    Region& m_region;
+    OwnPtr<Region> m_owned_region;
+};
+
+class PacketBuffer : public RefCounted<PacketBuffer> {
+public:
+    // Enough room for Ethernet, IPv4 and a TCP header with options in front of the payload.
+    static constexpr size_t default_headroom = 128;
+
+    // Work that is left for the network adapter to do as the packet goes out.
+    // These are only ever asked for if the adapter has the matching NetworkAdapter::Capability.
+    enum Offload : u8 {
+        OffloadIPv4Checksum = 1 << 0,
+        OffloadTCPChecksum = 1 << 1,
+        OffloadUDPChecksum = 1 << 2,
+        OffloadTCPSegmentation = 1 << 3,
+    };
+
+    // These return null if we're out of memory for packets; the caller gets to decide what to drop.
+    static RefPtr<PacketBuffer> create(size_t size, size_t headroom = default_headroom, size_t tailroom = 0);
+    static RefPtr<PacketBuffer> copy(const void* data, size_t size, size_t headroom = default_headroom);
+
+    // A new PacketBuffer looking at the same bytes as this one.
+    NonnullRefPtr<PacketBuffer> clone();
+
+    // A new PacketBuffer with a private copy of the bytes (and headroom) of this one, or null.
+    RefPtr<PacketBuffer> copy() const;
+
+    // If true, someone else may be looking at our bytes, so they must not be modified in place.
+    bool is_shared() const { return m_storage->ref_count() > 1; }
+
+    u8* data() { return m_storage->data() + m_offset; }
+    const u8* data() const { return m_storage->data() + m_offset; }
+    size_t size() const { return m_size; }
+
+    size_t headroom() const { return m_offset; }
+    size_t tailroom() const { return m_storage->capacity() - m_offset - m_size; }
+
+    // Grow the packet at the front, returning the new start of the packet.
+    u8* push(size_t);
+    // Shrink the packet at the front.
+    void pull(size_t);
+    // Grow the packet at the back, returning a pointer to the new bytes.
+    u8* put(size_t);
+    // Shrink the packet at the back.
+    void trim(size_t new_size);
+
+    PhysicalAddress physical_address() const { return m_storage->physical_address(m_offset); }
+    size_t physical_ranges(PhysicalRange* ranges, size_t max_ranges) const { return m_storage->physical_ranges(m_offset, m_size, ranges, max_ranges); }
+
+    u8 offloads() const { return m_offloads; }
+    void request_offload(u8 offloads) { m_offloads |= offloads; }
+
+    // With OffloadTCPSegmentation, the adapter cuts the payload up into segments of this size.
+    u16 segment_size() const { return m_segment_size; }
+    void set_segment_size(u16 segment_size) { m_segment_size = segment_size; }
+
+    IntrusiveListNode m_queue_node;
+
+private:
+    PacketBuffer(NonnullRefPtr<PacketStorage>&&, size_t offset, size_t size);
+
+    NonnullRefPtr<PacketStorage> m_storage;
+    size_t m_offset { 0 };
+    size_t m_size { 0 };
+    u8 m_offloads { 0 };
+    u16 m_segment_size { 0 };
+};
+
+// A FIFO of packets that doesn't allocate; it links the packets through their m_queue_node.
+class PacketQueue {
+public:
+    PacketQueue() {}
+    ~PacketQueue() { clear(); }
+
+    bool is_empty() const { return m_packets.is_empty(); }
+    size_t size() const { return m_size; }
+
+    PacketBuffer* first() const { return m_packets.first(); }
+    PacketBuffer* last() const { return m_packets.last(); }
+
+    void enqueue(NonnullRefPtr<PacketBuffer>&&);
+    RefPtr<PacketBuffer> dequeue();
+    void clear();
+
+private:
+    IntrusiveList<PacketBuffer, &PacketBuffer::m_queue_node> m_packets;
+    size_t m_size { 0 };
+};
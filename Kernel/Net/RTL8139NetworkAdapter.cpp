@@ -140,9 +140,6 @@ RTL8139NetworkAdapter::RTL8139NetworkAdapter(PCI::Address pci_address, u8 irq)
         kprintf("RTL8139: TX buffer %d: P%p\n", i, m_tx_buffer_addr[i]);
     }
 
-    m_packet_buffer = (u32)kmalloc(PACKET_SIZE_MAX);
-    kprintf("RTL8139: Packet buffer: P%p\n", m_packet_buffer);
-
     reset();
 
     read_mac_address();
@@ -335,13 +332,15 @@ void RTL8139NetworkAdapter::receive()
     // we never have to worry about the packet wrapping around the buffer,
     // since we set RXCFG_WRAP_INHIBIT, which allows the rtl8139 to write data
     // past the end of the alloted space.
-    memcpy((u8*)m_packet_buffer, (const u8*)(start_of_packet + 4), length - 4);
+    // NOTE: The receive ring is shared by all packets, so this is the one copy we can't avoid.
+    auto packet = PacketBuffer::copy(start_of_packet + 4, length - 4, 0);
     // let the card know that we've read this data
     m_rx_buffer_offset = ((m_rx_buffer_offset + length + 4 + 3) & ~3) % RX_BUFFER_SIZE;
     out16(REG_CAPR, m_rx_buffer_offset - 0x10);
     m_rx_buffer_offset %= RX_BUFFER_SIZE;
 
-    did_receive((const u8*)m_packet_buffer, length - 4);
+    if (packet)
+        did_receive(packet.release_nonnull());
 }
 
 void RTL8139NetworkAdapter::out8(u16 address, u8 data)
@@ -41,6 +41,5 @@ private:
     u16 m_rx_buffer_offset { 0 };
     u32 m_tx_buffer_addr[RTL8139_TX_BUFFER_COUNT];
     u8 m_tx_next_buffer { 0 };
-    u32 m_packet_buffer { 0 };
     bool m_link_up { false };
 };
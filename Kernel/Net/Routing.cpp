@@ -1,48 +1,102 @@
+#include <Kernel/Net/EtherType.h>
 #include <Kernel/Net/LoopbackAdapter.h>
+#include <Kernel/Net/NetworkTask.h>
 #include <Kernel/Net/Routing.h>
-#include <Kernel/Thread.h>
+#include <Kernel/Scheduler.h>
+#include <Kernel/TimerQueue.h>
+#include <LibC/errno_numbers.h>
 
 //#define ROUTING_DEBUG
+//#define ARP_TABLE_DEBUG
 
-Lockable<HashMap<IPv4Address, MACAddress>>& arp_table()
+// How long an ARP answer is good for, in milliseconds.
+static constexpr u64 arp_reachable_time = 5 * 60 * 1000;
+// How long to wait for an answer before asking again, and how many times to ask.
+static constexpr u64 arp_request_interval = 1000;
+static constexpr u8 arp_max_requests = 3;
+// How long to drop packets for after nobody answered.
+static constexpr u64 arp_failed_time = 5000;
+// How many packets may wait on a single unresolved address. After that, the oldest get dropped.
+static constexpr size_t arp_max_pending_packets = 16;
+
+static Lockable<HashMap<IPv4Address, ARPTableEntry*>>& arp_table()
 {
-    static Lockable<HashMap<IPv4Address, MACAddress>>* the;
+    static Lockable<HashMap<IPv4Address, ARPTableEntry*>>* the;
     if (!the)
-        the = new Lockable<HashMap<IPv4Address, MACAddress>>;
+        the = new Lockable<HashMap<IPv4Address, ARPTableEntry*>>;
+    return *the;
+}
+
+static Lockable<Vector<Route>>& routing_table()
+{
+    static Lockable<Vector<Route>>* the;
+    if (!the)
+        the = new Lockable<Vector<Route>>;
     return *the;
 }
 
 bool RoutingDecision::is_zero() const
 {
-    return adapter.is_null() || next_hop.is_zero();
+    return adapter.is_null();
 }
 
-RoutingDecision route_to(const IPv4Address& target, const IPv4Address& source)
+static bool prefix_matches(const IPv4Address& address, const IPv4Address& destination, const IPv4Address& netmask)
 {
-    if (target[0] == 127)
-        return { LoopbackAdapter::the().make_weak_ptr(), {} };
+    return (address.to_u32() & netmask.to_u32()) == (destination.to_u32() & netmask.to_u32());
+}
+
+static int prefix_length(const IPv4Address& netmask)
+{
+    return __builtin_popcount(netmask.to_u32());
+}
 
-    auto target_addr = target.to_u32();
-    auto source_addr = source.to_u32();
+static bool is_valid_netmask(const IPv4Address& netmask)
+{
+    u32 mask = (netmask[0] << 24) | (netmask[1] << 16) | (netmask[2] << 8) | netmask[3];
+    u32 host_bits = ~mask;
+    return (host_bits & (host_bits + 1)) == 0;
+}
 
-    WeakPtr<NetworkAdapter> local_adapter = nullptr;
-    WeakPtr<NetworkAdapter> gateway_adapter = nullptr;
+RoutingDecision route_to(const IPv4Address& target, const IPv4Address& source)
+{
+    if (target[0] == 127)
+        return { LoopbackAdapter::the().make_weak_ptr(), target };
 
-    NetworkAdapter::for_each([source_addr, &target_addr, &local_adapter, &gateway_adapter](auto& adapter) {
-        auto adapter_addr = adapter.ipv4_address().to_u32();
-        auto adapter_mask = adapter.ipv4_netmask().to_u32();
+    int best_prefix_length = -1;
+    WeakPtr<NetworkAdapter> best_adapter;
+    IPv4Address best_gateway;
 
-        if (source_addr != 0 && source_addr != adapter_addr)
+    auto consider = [&](const IPv4Address& destination, const IPv4Address& netmask, const IPv4Address& gateway, NetworkAdapter& adapter) {
+        if (!source.is_zero() && source != adapter.ipv4_address())
             return;
+        if (!prefix_matches(target, destination, netmask))
+            return;
+        // NOTE: Ties go to whoever came first, which puts explicit routes ahead of the implicit ones.
+        int length = prefix_length(netmask);
+        if (length <= best_prefix_length)
+            return;
+        best_prefix_length = length;
+        best_adapter = adapter.make_weak_ptr();
+        best_gateway = gateway;
+    };
 
-        if ((target_addr & adapter_mask) == (adapter_addr & adapter_mask))
-            local_adapter = adapter.make_weak_ptr();
+    {
+        LOCKER(routing_table().lock());
+        for (auto& route : routing_table().resource()) {
+            if (route.adapter)
+                consider(route.destination, route.netmask, route.gateway, *route.adapter);
+        }
+    }
 
-        if (adapter.ipv4_gateway().to_u32() != 0)
-            gateway_adapter = adapter.make_weak_ptr();
+    NetworkAdapter::for_each([&](auto& adapter) {
+        if (adapter.ipv4_address().is_zero())
+            return;
+        consider(adapter.ipv4_address(), adapter.ipv4_netmask(), {}, adapter);
+        if (!adapter.ipv4_gateway().is_zero())
+            consider({}, {}, adapter.ipv4_gateway(), adapter);
     });
 
-    if (!local_adapter && !gateway_adapter) {
+    if (!best_adapter) {
 #ifdef ROUTING_DEBUG
         kprintf("Routing: Couldn't find a suitable adapter for route to %s\n",
             target.to_string().characters());
@@ -50,84 +104,323 @@ RoutingDecision route_to(const IPv4Address& target, const IPv4Address& source)
         return { nullptr, {} };
     }
 
-    WeakPtr<NetworkAdapter> adapter = nullptr;
-    IPv4Address next_hop_ip;
+    auto next_hop = best_gateway.is_zero() ? target : best_gateway;
 
-    if (local_adapter) {
-#ifdef ROUTING_DEBUG
-        kprintf("Routing: Got adapter for route (direct): %s (%s/%s) for %s\n",
-            local_adapter->name().characters(),
-            local_adapter->ipv4_address().to_string().characters(),
-            local_adapter->ipv4_netmask().to_string().characters(),
-            target.to_string().characters());
-#endif
-        adapter = local_adapter;
-        next_hop_ip = target;
-    } else if (gateway_adapter) {
 #ifdef ROUTING_DEBUG
-        kprintf("Routing: Got adapter for route (using gateway %s): %s (%s/%s) for %s\n",
-            gateway_adapter->ipv4_gateway().to_string().characters(),
-            gateway_adapter->name().characters(),
-            gateway_adapter->ipv4_address().to_string().characters(),
-            gateway_adapter->ipv4_netmask().to_string().characters(),
-            target.to_string().characters());
+    kprintf("Routing: Got adapter for route (/%d via %s): %s (%s/%s) for %s\n",
+        best_prefix_length,
+        next_hop.to_string().characters(),
+        best_adapter->name().characters(),
+        best_adapter->ipv4_address().to_string().characters(),
+        best_adapter->ipv4_netmask().to_string().characters(),
+        target.to_string().characters());
 #endif
-        adapter = gateway_adapter;
-        next_hop_ip = gateway_adapter->ipv4_gateway();
-    } else {
-        return { nullptr, {} };
+
+    return { best_adapter, next_hop };
+}
+
+KResult add_route(const IPv4Address& destination, const IPv4Address& netmask, const IPv4Address& gateway, WeakPtr<NetworkAdapter> adapter)
+{
+    if (!is_valid_netmask(netmask))
+        return KResult(-EINVAL);
+
+    if (!adapter) {
+        // Without an explicit adapter, use whichever one can reach the gateway directly.
+        if (gateway.is_zero())
+            return KResult(-EINVAL);
+        NetworkAdapter::for_each([&](auto& candidate) {
+            if (!adapter && !candidate.ipv4_address().is_zero() && prefix_matches(gateway, candidate.ipv4_address(), candidate.ipv4_netmask()))
+                adapter = candidate.make_weak_ptr();
+        });
+        if (!adapter)
+            return KResult(-ENETUNREACH);
     }
 
-    {
-        LOCKER(arp_table().lock());
-        auto addr = arp_table().resource().get(next_hop_ip);
-        if (addr.has_value()) {
-#ifdef ROUTING_DEBUG
-            kprintf("Routing: Using cached ARP entry for %s (%s)\n",
-                next_hop_ip.to_string().characters(),
-                addr.value().to_string().characters());
-#endif
-            return { adapter, addr.value() };
+    u32 masked = destination.to_u32() & netmask.to_u32();
+    IPv4Address network((const u8*)&masked);
+
+    LOCKER(routing_table().lock());
+    for (auto& route : routing_table().resource()) {
+        if (route.destination == network && route.netmask == netmask)
+            return KResult(-EEXIST);
+    }
+    routing_table().resource().append({ network, netmask, gateway, move(adapter) });
+    return KSuccess;
+}
+
+KResult delete_route(const IPv4Address& destination, const IPv4Address& netmask)
+{
+    u32 masked = destination.to_u32() & netmask.to_u32();
+    IPv4Address network((const u8*)&masked);
+
+    LOCKER(routing_table().lock());
+    auto& routes = routing_table().resource();
+    for (int i = 0; i < routes.size(); ++i) {
+        if (routes[i].destination == network && routes[i].netmask == netmask) {
+            routes.remove(i);
+            return KSuccess;
         }
     }
+    return KResult(-ESRCH);
+}
 
-#ifdef ROUTING_DEBUG
-    kprintf("Routing: Sending ARP request via adapter %s for IPv4 address %s\n",
-        adapter->name().characters(),
-        next_hop_ip.to_string().characters());
-#endif
+void for_each_route(Function<void(const Route&)> callback)
+{
+    LOCKER(routing_table().lock());
+    for (auto& route : routing_table().resource())
+        callback(route);
+}
+
+const char* to_string(ARPTableEntry::State state)
+{
+    switch (state) {
+    case ARPTableEntry::State::Incomplete:
+        return "Incomplete";
+    case ARPTableEntry::State::Reachable:
+        return "Reachable";
+    case ARPTableEntry::State::Stale:
+        return "Stale";
+    case ARPTableEntry::State::Failed:
+        return "Failed";
+    default:
+        return "Invalid";
+    }
+}
 
+static void send_arp_request(NetworkAdapter& adapter, const IPv4Address& address)
+{
+#ifdef ARP_TABLE_DEBUG
+    kprintf("ARP: Sending request via adapter %s for IPv4 address %s\n",
+        adapter.name().characters(),
+        address.to_string().characters());
+#endif
     ARPPacket request;
     request.set_operation(ARPOperation::Request);
     request.set_target_hardware_address({ 0xff, 0xff, 0xff, 0xff, 0xff, 0xff });
-    request.set_target_protocol_address(next_hop_ip);
-    request.set_sender_hardware_address(adapter->mac_address());
-    request.set_sender_protocol_address(adapter->ipv4_address());
-    adapter->send({ 0xff, 0xff, 0xff, 0xff, 0xff, 0xff }, request);
+    request.set_target_protocol_address(address);
+    request.set_sender_hardware_address(adapter.mac_address());
+    request.set_sender_protocol_address(adapter.ipv4_address());
+    adapter.send({ 0xff, 0xff, 0xff, 0xff, 0xff, 0xff }, request);
+}
+
+static u64 s_arp_sweep_timer_id;
+static bool s_arp_sweep_due;
 
-    (void)current->block_until("Routing (ARP)", [next_hop_ip] {
-        return arp_table().resource().get(next_hop_ip).has_value();
+static void start_arp_sweep_timer()
+{
+    InterruptDisabler disabler;
+    if (s_arp_sweep_timer_id || s_arp_sweep_due)
+        return;
+    s_arp_sweep_timer_id = TimerQueue::the().add_timer(arp_request_interval, TimeUnit::MS, [] {
+        // NOTE: We're in interrupt context here, so leave the real work to the NetworkTask.
+        s_arp_sweep_timer_id = 0;
+        s_arp_sweep_due = true;
+        NetworkTask_wake();
     });
+}
+
+bool arp_table_needs_sweep()
+{
+    return s_arp_sweep_due;
+}
+
+void sweep_arp_table()
+{
+    s_arp_sweep_due = false;
 
+    struct Request {
+        WeakPtr<NetworkAdapter> adapter;
+        IPv4Address address;
+    };
+    Vector<Request> requests;
+    Vector<IPv4Address> expired_addresses;
+    bool needs_another_sweep = false;
     {
         LOCKER(arp_table().lock());
-        auto addr = arp_table().resource().get(next_hop_ip);
-        if (addr.has_value()) {
-#ifdef ROUTING_DEBUG
-            kprintf("Routing: Got ARP response using adapter %s for %s (%s)\n",
-                adapter->name().characters(),
-                next_hop_ip.to_string().characters(),
-                addr.value().to_string().characters());
+        u64 now = g_uptime;
+        for (auto& it : arp_table().resource()) {
+            auto& entry = *it.value;
+            bool may_ask_again = now - entry.last_request_time >= arp_request_interval;
+            switch (entry.state) {
+            case ARPTableEntry::State::Reachable:
+                continue;
+            case ARPTableEntry::State::Incomplete:
+                if (!may_ask_again)
+                    break;
+                if (entry.requests_sent < arp_max_requests && entry.adapter) {
+                    requests.append({ entry.adapter, it.key });
+                    ++entry.requests_sent;
+                    entry.last_request_time = now;
+                    break;
+                }
+#ifdef ARP_TABLE_DEBUG
+                kprintf("ARP: No answer for %s, dropping %u pending packet(s)\n", it.key.to_string().characters(), entry.pending_packets.size());
 #endif
-            return { adapter, addr.value() };
+                entry.state = ARPTableEntry::State::Failed;
+                entry.expiration_time = now + arp_failed_time;
+                entry.pending_packets.clear();
+                break;
+            case ARPTableEntry::State::Stale:
+                // Stale entries are only asked about again when they're being used.
+                if (may_ask_again && entry.requests_sent >= arp_max_requests) {
+                    expired_addresses.append(it.key);
+                    continue;
+                }
+                break;
+            case ARPTableEntry::State::Failed:
+                if (now >= entry.expiration_time) {
+                    expired_addresses.append(it.key);
+                    continue;
+                }
+                break;
+            }
+            needs_another_sweep = true;
+        }
+
+        for (auto& address : expired_addresses) {
+            auto* entry = arp_table().resource().get(address).value();
+            arp_table().resource().remove(address);
+            delete entry;
         }
     }
 
-#ifdef ROUTING_DEBUG
-    kprintf("Routing: Couldn't find route using adapter %s for %s\n",
-        adapter->name().characters(),
-        target.to_string().characters());
+#ifdef ARP_TABLE_DEBUG
+    if (!expired_addresses.is_empty())
+        kprintf("ARP: Swept %u expired entries\n", expired_addresses.size());
 #endif
 
-    return { nullptr, {} };
+    // NOTE: We don't hold the ARP table lock while sending, since that may block on the adapter.
+    for (auto& request : requests) {
+        if (request.adapter)
+            send_arp_request(*request.adapter, request.address);
+    }
+
+    if (needs_another_sweep)
+        start_arp_sweep_timer();
+}
+
+static ARPTableEntry& ensure_arp_table_entry(const IPv4Address& address)
+{
+    ASSERT(arp_table().lock().is_locked());
+    auto& table = arp_table().resource();
+    auto existing = table.get(address);
+    if (existing.has_value())
+        return *existing.value();
+    auto* entry = new ARPTableEntry;
+    table.set(address, entry);
+    return *entry;
+}
+
+void send_via_arp_table(NetworkAdapter& adapter, const IPv4Address& next_hop, NonnullRefPtr<PacketBuffer> packet)
+{
+    bool should_send_request = false;
+    bool should_send_packet = false;
+    MACAddress destination;
+    {
+        LOCKER(arp_table().lock());
+        auto& entry = ensure_arp_table_entry(next_hop);
+        entry.adapter = adapter.make_weak_ptr();
+        u64 now = g_uptime;
+        bool may_ask_again = !entry.requests_sent || now - entry.last_request_time >= arp_request_interval;
+
+        if (entry.state == ARPTableEntry::State::Failed && now >= entry.expiration_time) {
+            // We've sulked for long enough; give it another go.
+            entry.state = ARPTableEntry::State::Incomplete;
+            entry.requests_sent = 0;
+            may_ask_again = true;
+        }
+
+        if (entry.state == ARPTableEntry::State::Reachable && now >= entry.expiration_time) {
+            entry.state = ARPTableEntry::State::Stale;
+            entry.requests_sent = 0;
+            may_ask_again = true;
+        }
+
+        switch (entry.state) {
+        case ARPTableEntry::State::Reachable:
+            should_send_packet = true;
+            destination = entry.mac_address;
+            break;
+        case ARPTableEntry::State::Stale:
+            should_send_packet = true;
+            destination = entry.mac_address;
+            if (may_ask_again) {
+                if (entry.requests_sent < arp_max_requests) {
+                    should_send_request = true;
+                    ++entry.requests_sent;
+                    entry.last_request_time = now;
+                } else {
+                    // Nobody has vouched for this address in a while, so forget about it.
+                    // The next packet will have to wait for a fresh answer.
+                    arp_table().resource().remove(next_hop);
+                    delete &entry;
+                }
+            }
+            break;
+        case ARPTableEntry::State::Incomplete:
+            if (may_ask_again && entry.requests_sent >= arp_max_requests) {
+#ifdef ARP_TABLE_DEBUG
+                kprintf("ARP: No answer for %s, dropping %u pending packet(s)\n", next_hop.to_string().characters(), entry.pending_packets.size());
+#endif
+                entry.state = ARPTableEntry::State::Failed;
+                entry.expiration_time = now + arp_failed_time;
+                entry.pending_packets.clear();
+                break;
+            }
+            if (entry.pending_packets.size() >= arp_max_pending_packets)
+                entry.pending_packets.dequeue();
+            entry.pending_packets.enqueue(move(packet));
+            if (may_ask_again) {
+                should_send_request = true;
+                ++entry.requests_sent;
+                entry.last_request_time = now;
+            }
+            break;
+        case ARPTableEntry::State::Failed:
+            break;
+        }
+    }
+
+    // NOTE: We don't hold the ARP table lock while sending, since that may block on the adapter.
+    if (should_send_request) {
+        send_arp_request(adapter, next_hop);
+        start_arp_sweep_timer();
+    }
+    if (should_send_packet)
+        adapter.send_ethernet(destination, EtherType::IPv4, move(packet));
+}
+
+void update_arp_table(const IPv4Address& address, const MACAddress& mac_address, ShouldCreateARPEntry should_create_entry)
+{
+    PacketQueue packets;
+    WeakPtr<NetworkAdapter> adapter;
+    {
+        LOCKER(arp_table().lock());
+        if (should_create_entry == ShouldCreateARPEntry::No && !arp_table().resource().contains(address))
+            return;
+        auto& entry = ensure_arp_table_entry(address);
+        entry.mac_address = mac_address;
+        entry.state = ARPTableEntry::State::Reachable;
+        entry.expiration_time = g_uptime + arp_reachable_time;
+        entry.requests_sent = 0;
+        adapter = entry.adapter;
+        while (auto packet = entry.pending_packets.dequeue())
+            packets.enqueue(packet.release_nonnull());
+    }
+
+#ifdef ARP_TABLE_DEBUG
+    kprintf("ARP: %s is at %s, sending %u pending packet(s)\n", address.to_string().characters(), mac_address.to_string().characters(), packets.size());
+#endif
+
+    if (!adapter)
+        return;
+    while (auto packet = packets.dequeue())
+        adapter->send_ethernet(mac_address, EtherType::IPv4, packet.release_nonnull());
+}
+
+void for_each_arp_table_entry(Function<void(const IPv4Address&, const ARPTableEntry&)> callback)
+{
+    LOCKER(arp_table().lock());
+    for (auto& it : arp_table().resource())
+        callback(it.key, *it.value);
 }
@@ -1,15 +1,73 @@
 #pragma once
 
+#include <AK/Function.h>
+#include <Kernel/KResult.h>
 #include <Kernel/Net/NetworkAdapter.h>
 
 struct RoutingDecision
 {
     WeakPtr<NetworkAdapter> adapter;
-    MACAddress next_hop;
+    // The IPv4 address to hand the packet to on `adapter`: either the target itself, or a gateway.
+    IPv4Address next_hop;
 
     bool is_zero() const;
 };
 
 RoutingDecision route_to(const IPv4Address& target, const IPv4Address& source);
 
-Lockable<HashMap<IPv4Address, MACAddress>>& arp_table();
+// Explicitly configured routes. Each adapter also has an implicit route to its own subnet,
+// and a default route via its gateway (if it has one.) The longest matching prefix wins.
+struct Route {
+    IPv4Address destination;
+    IPv4Address netmask;
+    // Zero for routes to directly connected hosts.
+    IPv4Address gateway;
+    WeakPtr<NetworkAdapter> adapter;
+};
+
+KResult add_route(const IPv4Address& destination, const IPv4Address& netmask, const IPv4Address& gateway, WeakPtr<NetworkAdapter>);
+KResult delete_route(const IPv4Address& destination, const IPv4Address& netmask);
+void for_each_route(Function<void(const Route&)>);
+
+struct ARPTableEntry {
+    enum class State {
+        // We've asked, but haven't heard back yet. Outgoing packets wait in pending_packets.
+        Incomplete,
+        Reachable,
+        // The entry has expired. We keep using it while asking again.
+        Stale,
+        // Nobody answered. Outgoing packets are dropped until we're willing to try again.
+        Failed,
+    };
+
+    MACAddress mac_address;
+    State state { State::Incomplete };
+    // Milliseconds of uptime at which the current state runs out.
+    u64 expiration_time { 0 };
+    u64 last_request_time { 0 };
+    u8 requests_sent { 0 };
+    WeakPtr<NetworkAdapter> adapter;
+    PacketQueue pending_packets;
+};
+
+const char* to_string(ARPTableEntry::State);
+
+// Sends an IPv4 packet (with its IPv4 header already in place) to `next_hop` on `adapter`.
+// If we don't know the next hop's hardware address yet, the packet is queued and sent once we do.
+void send_via_arp_table(NetworkAdapter&, const IPv4Address& next_hop, NonnullRefPtr<PacketBuffer>);
+
+enum class ShouldCreateARPEntry {
+    No,
+    Yes,
+};
+
+// Called when we learn someone's hardware address. Sends any packets that were waiting for it.
+// Unless asked to, this only updates addresses we were already interested in.
+void update_arp_table(const IPv4Address&, const MACAddress&, ShouldCreateARPEntry = ShouldCreateARPEntry::No);
+
+// While there are unanswered entries in the ARP table, a timer periodically asks the NetworkTask
+// to sweep it: resend requests that went unanswered, and throw out the entries that never will be.
+bool arp_table_needs_sweep();
+void sweep_arp_table();
+
+void for_each_arp_table_entry(Function<void(const IPv4Address&, const ARPTableEntry&)>);
@@ -42,6 +42,7 @@ void Socket::set_setup_state(SetupState new_setup_state)
 #endif
 
     m_setup_state = new_setup_state;
+    did_change_readiness();
 }
 
 RefPtr<Socket> Socket::accept()
@@ -58,6 +59,7 @@ RefPtr<Socket> Socket::accept()
     client->m_acceptor = { process.pid(), process.uid(), process.gid() };
     client->m_connected = true;
     client->m_role = Role::Accepted;
+    client->did_change_readiness();
     return client;
 }
 
@@ -70,6 +72,7 @@ KResult Socket::queue_connection_from(NonnullRefPtr<Socket> peer)
     if (m_pending.size() >= m_backlog)
         return KResult(-ECONNREFUSED);
     m_pending.append(peer);
+    did_change_readiness();
     return KSuccess;
 }
 
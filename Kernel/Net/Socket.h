@@ -59,7 +59,11 @@ public:
     virtual Role role(const FileDescription&) const { return m_role; }
 
     bool is_connected() const { return m_connected; }
-    void set_connected(bool connected) { m_connected = connected; }
+    void set_connected(bool connected)
+    {
+        m_connected = connected;
+        did_change_readiness();
+    }
 
     bool can_accept() const { return !m_pending.is_empty(); }
     RefPtr<Socket> accept();
@@ -92,6 +96,7 @@ public:
     Lock& lock() { return m_lock; }
 
     // ^File
+    virtual bool notifies_readiness() const override { return true; }
     virtual ssize_t read(FileDescription&, u8*, ssize_t) override final;
     virtual ssize_t write(FileDescription&, const u8*, ssize_t) override final;
     virtual String absolute_path(const FileDescription&) const override;
@@ -2,14 +2,23 @@
 #include <Kernel/Devices/RandomDevice.h>
 #include <Kernel/FileSystem/FileDescription.h>
 #include <Kernel/Net/NetworkAdapter.h>
+#include <Kernel/Net/NetworkTask.h>
 #include <Kernel/Net/Routing.h>
 #include <Kernel/Net/TCP.h>
 #include <Kernel/Net/TCPSocket.h>
 #include <Kernel/Process.h>
 #include <Kernel/Random.h>
+#include <Kernel/Scheduler.h>
+#include <Kernel/TimerQueue.h>
 
 //#define TCP_SOCKET_DEBUG
 
+// Sequence numbers wrap around, so compare them by their signed distance.
+static inline bool sequence_less_or_equal(u32 a, u32 b)
+{
+    return (i32)(a - b) <= 0;
+}
+
 void TCPSocket::for_each(Function<void(TCPSocket&)> callback)
 {
     LOCKER(sockets_by_tuple().lock());
@@ -29,6 +38,8 @@ void TCPSocket::set_state(State new_state)
 
     if (new_state == State::Established && m_direction == Direction::Outgoing)
         m_role = Role::Connected;
+
+    did_change_readiness();
 }
 
 Lockable<HashMap<IPv4SocketTuple, TCPSocket*>>& TCPSocket::sockets_by_tuple()
@@ -109,6 +120,9 @@ TCPSocket::TCPSocket(int protocol)
 
 TCPSocket::~TCPSocket()
 {
+    stop_timer(m_retransmission_timer_id);
+    stop_timer(m_delayed_ack_timer_id);
+
     LOCKER(sockets_by_tuple().lock());
     sockets_by_tuple().resource().remove(tuple());
 }
@@ -118,40 +132,242 @@ NonnullRefPtr<TCPSocket> TCPSocket::create(int protocol)
     return adopt(*new TCPSocket(protocol));
 }
 
-int TCPSocket::protocol_receive(const KBuffer& packet_buffer, void* buffer, size_t buffer_size, int flags)
+void TCPSocket::protocol_trim_to_payload(PacketBuffer& packet)
 {
-    (void)flags;
-    auto& ipv4_packet = *(const IPv4Packet*)(packet_buffer.data());
+    auto& ipv4_packet = *(const IPv4Packet*)(packet.data());
     auto& tcp_packet = *static_cast<const TCPPacket*>(ipv4_packet.payload());
-    size_t payload_size = packet_buffer.size() - sizeof(IPv4Packet) - tcp_packet.header_size();
 #ifdef TCP_SOCKET_DEBUG
-    kprintf("payload_size %u, will it fit in %u?\n", payload_size, buffer_size);
+    kprintf("TCPSocket{%p} received payload_size %u\n", this, packet.size() - sizeof(IPv4Packet) - tcp_packet.header_size());
 #endif
-    ASSERT(buffer_size >= payload_size);
-    memcpy(buffer, tcp_packet.payload(), payload_size);
-    return payload_size;
+    packet.pull(sizeof(IPv4Packet) + tcp_packet.header_size());
 }
 
 int TCPSocket::protocol_send(const void* data, int data_length)
 {
-    send_tcp_packet(TCPFlags::PUSH | TCPFlags::ACK, data, data_length);
-    return data_length;
+    LOCKER(m_send_lock);
+    size_t nqueued = min((size_t)data_length, send_buffer_space());
+    if (!nqueued)
+        return -EAGAIN;
+
+    // Copy the data straight into MSS-sized segments, so sending them later is just a matter of prepending headers.
+    auto* source = (const u8*)data;
+    size_t remaining = nqueued;
+    while (remaining) {
+        auto* last = m_send_queue.last();
+        if (!last || last->size() >= m_send_segment_size || !last->tailroom()) {
+            // Only make room for the data at hand, but give small writes a whole pool chunk so the next few can join them.
+            size_t tailroom = min((size_t)m_send_segment_size, max(remaining, PacketStorage::pool_chunk_size - PacketBuffer::default_headroom));
+            auto segment = PacketBuffer::create(0, PacketBuffer::default_headroom, tailroom);
+            if (!segment)
+                break;
+            m_send_queue.enqueue(segment.release_nonnull());
+            last = m_send_queue.last();
+        }
+        size_t nappended = min(remaining, min(m_send_segment_size - last->size(), last->tailroom()));
+        memcpy(last->put(nappended), source, nappended);
+        source += nappended;
+        remaining -= nappended;
+    }
+    nqueued -= remaining;
+    if (!nqueued)
+        return -ENOBUFS;
+    m_send_queue_size += nqueued;
+
+    send_pending_data();
+    return nqueued;
+}
+
+size_t TCPSocket::send_buffer_space() const
+{
+    // NOTE: Data that's in flight counts against the send buffer too, since we're holding on to it for retransmission.
+    size_t in_use = m_send_queue_size + (m_sequence_number - m_send_unacknowledged);
+    if (in_use >= send_buffer_capacity)
+        return 0;
+    return send_buffer_capacity - in_use;
+}
+
+bool TCPSocket::protocol_can_write() const
+{
+    return send_buffer_space() > 0;
+}
+
+void TCPSocket::send_pending_data(bool send_window_probe)
+{
+    ASSERT(m_send_lock.is_locked());
+    if (send_window_probe && !m_send_queue.is_empty()) {
+        auto& segment = *m_send_queue.first();
+        if (send_tcp_packet(TCPFlags::ACK, segment.data(), 1)) {
+            segment.pull(1);
+            --m_send_queue_size;
+            if (!segment.size())
+                m_send_queue.dequeue();
+        }
+    }
+
+    while (!m_send_queue.is_empty()) {
+        auto& segment = *m_send_queue.first();
+        u32 in_flight = m_sequence_number - m_send_unacknowledged;
+        u32 window = min(m_send_window, m_congestion_window);
+        if (in_flight >= window)
+            break;
+        size_t segment_size = min(segment.size(), (size_t)(window - in_flight));
+
+        // Don't dribble out a runt segment while there's still data in flight (RFC 1122, 4.2.3.4);
+        // the next ACK will open up the window again.
+        if (segment_size < m_send_mss && segment_size < m_send_queue_size && in_flight)
+            break;
+
+        u16 flags = TCPFlags::ACK;
+        if (segment_size == m_send_queue_size)
+            flags |= TCPFlags::PUSH;
+
+        if (segment_size < segment.size()) {
+            // The window only has room for part of this segment, so that part has to be copied out.
+            // If there's no memory for that, leave it queued; an ACK or the retransmission timer will get us back here.
+            if (!send_tcp_packet(flags, segment.data(), segment_size))
+                break;
+            m_send_queue_size -= segment_size;
+            segment.pull(segment_size);
+            continue;
+        }
+        m_send_queue_size -= segment_size;
+        send_tcp_segment(flags, m_send_queue.dequeue().release_nonnull());
+    }
+}
+
+u16 TCPSocket::local_mss() const
+{
+    auto routing_decision = route_to(peer_address(), local_address());
+    if (routing_decision.is_zero())
+        return 536;
+    size_t mss = routing_decision.adapter->mtu() - sizeof(IPv4Packet) - sizeof(TCPPacket);
+    return min(mss, (size_t)(0xffff - sizeof(IPv4Packet) - sizeof(TCPPacket)));
+}
+
+u16 TCPSocket::receive_window_to_advertise(bool is_syn)
+{
+    size_t window = receive_buffer_space();
+    // The window field of a SYN segment is never scaled.
+    u8 shift = is_syn ? 0 : m_receive_window_shift;
+    window = min(window >> shift, (size_t)0xffff);
+    m_last_advertised_window = window << shift;
+    return window;
 }
 
-void TCPSocket::send_tcp_packet(u16 flags, const void* payload, int payload_size)
+void TCPSocket::protocol_did_read(size_t)
 {
-    auto buffer = ByteBuffer::create_zeroed(sizeof(TCPPacket) + payload_size);
-    auto& tcp_packet = *(TCPPacket*)(buffer.data());
+    if (m_state != State::Established)
+        return;
+    // NOTE: We're called from recvfrom(), so this races with the network task over the send state.
+    LOCKER(m_send_lock);
+    // Only announce a reopened window once it has grown by a meaningful amount,
+    // so the peer doesn't start sending us tiny segments (RFC 1122, 4.2.3.3).
+    size_t window = receive_buffer_space();
+    if (window <= m_last_advertised_window)
+        return;
+    if (window - m_last_advertised_window < min(receive_buffer_capacity / 2, (size_t)local_mss()))
+        return;
+    send_tcp_packet(TCPFlags::ACK);
+}
+
+void TCPSocket::process_syn_options(const TCPPacket& packet)
+{
+    ASSERT(packet.has_syn());
+    u16 peer_mss = 536;
+    bool peer_wants_window_scaling = false;
+    u8 peer_window_shift = 0;
+
+    auto* options = packet.options();
+    size_t options_size = packet.options_size();
+    for (size_t i = 0; i < options_size;) {
+        u8 kind = options[i];
+        if (kind == TCPOption::End)
+            break;
+        if (kind == TCPOption::NOP) {
+            ++i;
+            continue;
+        }
+        if (i + 1 >= options_size)
+            break;
+        u8 length = options[i + 1];
+        if (length < 2 || i + length > options_size)
+            break;
+        if (kind == TCPOption::MSS && length == 4) {
+            peer_mss = (options[i + 2] << 8) | options[i + 3];
+        } else if (kind == TCPOption::WindowScale && length == 3) {
+            peer_wants_window_scaling = true;
+            peer_window_shift = min(options[i + 2], (u8)14);
+        }
+        i += length;
+    }
+
+    LOCKER(m_send_lock);
+    m_send_mss = max((u16)1, min(peer_mss, local_mss()));
+    m_send_segment_size = m_send_mss;
+    auto routing_decision = route_to(peer_address(), local_address());
+    if (!routing_decision.is_zero() && routing_decision.adapter->has_capability(NetworkAdapter::TCPSegmentation))
+        m_send_segment_size = max(max_offloaded_segment_size / m_send_mss, (size_t)1) * m_send_mss;
+    // Window scaling only happens if both sides asked for it.
+    m_window_scaling_enabled = peer_wants_window_scaling;
+    m_send_window_shift = peer_wants_window_scaling ? peer_window_shift : 0;
+    m_receive_window_shift = peer_wants_window_scaling ? desired_receive_window_shift : 0;
+    m_send_window = packet.window_size();
+    // Initial congestion window, as per RFC 3390.
+    m_congestion_window = min(4u * m_send_mss, max(2u * m_send_mss, 4380u));
+
+#ifdef TCP_SOCKET_DEBUG
+    kprintf("TCPSocket{%p} SYN options: mss=%u, window scaling %s (send shift %u, receive shift %u)\n",
+        this, m_send_mss, m_window_scaling_enabled ? "enabled" : "disabled", m_send_window_shift, m_receive_window_shift);
+#endif
+}
+
+bool TCPSocket::send_tcp_packet(u16 flags, const void* payload, int payload_size)
+{
+    auto segment = PacketBuffer::copy(payload, payload_size);
+    if (!segment)
+        return false;
+    send_tcp_segment(flags, segment.release_nonnull());
+    return true;
+}
+
+void TCPSocket::send_tcp_segment(u16 flags, NonnullRefPtr<PacketBuffer> segment)
+{
+    size_t payload_size = segment->size();
+    u8 options[8];
+    size_t options_size = 0;
+    if (flags & TCPFlags::SYN) {
+        u16 mss = local_mss();
+        options[options_size++] = TCPOption::MSS;
+        options[options_size++] = 4;
+        options[options_size++] = mss >> 8;
+        options[options_size++] = mss & 0xff;
+        // We always offer window scaling when connecting, but may only answer with it if the peer offered it first.
+        if (!(flags & TCPFlags::ACK) || m_window_scaling_enabled) {
+            options[options_size++] = TCPOption::NOP;
+            options[options_size++] = TCPOption::WindowScale;
+            options[options_size++] = 3;
+            options[options_size++] = desired_receive_window_shift;
+        }
+    }
+
+    size_t header_size = sizeof(TCPPacket) + options_size;
+    auto& tcp_packet = *(TCPPacket*)(segment->push(header_size));
+    memset(&tcp_packet, 0, header_size);
     ASSERT(local_port());
     tcp_packet.set_source_port(local_port());
     tcp_packet.set_destination_port(peer_port());
-    tcp_packet.set_window_size(1024);
+    tcp_packet.set_window_size(receive_window_to_advertise(flags & TCPFlags::SYN));
     tcp_packet.set_sequence_number(m_sequence_number);
-    tcp_packet.set_data_offset(sizeof(TCPPacket) / sizeof(u32));
+    tcp_packet.set_data_offset(header_size / sizeof(u32));
     tcp_packet.set_flags(flags);
+    memcpy(tcp_packet.options(), options, options_size);
 
-    if (flags & TCPFlags::ACK)
+    if (flags & TCPFlags::ACK) {
         tcp_packet.set_ack_number(m_ack_number);
+        // Whatever we were going to acknowledge later rides along with this segment.
+        m_segments_to_ack = 0;
+        stop_timer(m_delayed_ack_timer_id);
+    }
 
     if (flags & TCPFlags::SYN) {
         ++m_sequence_number;
@@ -159,143 +375,348 @@ void TCPSocket::send_tcp_packet(u16 flags, const void* payload, int payload_size
         m_sequence_number += payload_size;
     }
 
-    memcpy(tcp_packet.payload(), payload, payload_size);
-    tcp_packet.set_checksum(compute_tcp_checksum(local_address(), peer_address(), tcp_packet, payload_size));
-
     if (tcp_packet.has_syn() || payload_size > 0) {
-        LOCKER(m_not_acked_lock);
-        m_not_acked.append({ m_sequence_number, move(buffer), 0, {} });
-        send_outgoing_packets();
+        LOCKER(m_send_lock);
+        if (!m_rtt_timing) {
+            m_rtt_timing = true;
+            m_rtt_sequence_number = m_sequence_number;
+            m_rtt_start = g_uptime;
+        }
+        transmit(*segment);
+        m_not_acked.append({ m_sequence_number, move(segment), 1 });
+        if (!m_retransmission_timer_id)
+            start_timer(m_retransmission_timer_id, RetransmissionTimer, m_retransmission_timeout);
         return;
     }
 
+    transmit(*segment);
+}
+
+void TCPSocket::transmit(PacketBuffer& segment)
+{
     auto routing_decision = route_to(peer_address(), local_address());
     ASSERT(!routing_decision.is_zero());
 
-    routing_decision.adapter->send_ipv4(
-        routing_decision.next_hop, peer_address(), IPv4Protocol::TCP,
-        buffer.data(), buffer.size(), ttl());
+    auto& tcp_packet = *(TCPPacket*)(segment.data());
+#ifdef TCP_SOCKET_DEBUG
+    kprintf("sending tcp packet from %s:%u to %s:%u with (%s%s%s%s) seq_no=%u, ack_no=%u\n",
+        local_address().to_string().characters(),
+        local_port(),
+        peer_address().to_string().characters(),
+        peer_port(),
+        tcp_packet.has_syn() ? "SYN " : "",
+        tcp_packet.has_ack() ? "ACK " : "",
+        tcp_packet.has_fin() ? "FIN " : "",
+        tcp_packet.has_rst() ? "RST " : "",
+        tcp_packet.sequence_number(),
+        tcp_packet.ack_number());
+#endif
 
     m_packets_out++;
-    m_bytes_out += buffer.size();
+    m_bytes_out += segment.size();
+
+    auto& adapter = *routing_decision.adapter;
+    size_t header_size = tcp_packet.header_size();
+    size_t payload_size = segment.size() - header_size;
+    if (payload_size <= m_send_mss || adapter.has_capability(NetworkAdapter::TCPSegmentation))
+        return transmit_via(adapter, routing_decision.next_hop, segment);
+
+    // This segment was queued up for an adapter that could cut it down to size, but the route
+    // has changed since, so we have to do it ourselves.
+    for (size_t offset = 0; offset < payload_size; offset += m_send_mss) {
+        size_t piece_size = min((size_t)m_send_mss, payload_size - offset);
+        auto piece = PacketBuffer::create(header_size + piece_size);
+        // The whole segment is still waiting to be acknowledged, so whatever we fail to send here gets retransmitted.
+        if (!piece)
+            return;
+        memcpy(piece->data(), &tcp_packet, header_size);
+        memcpy(piece->data() + header_size, (const u8*)tcp_packet.payload() + offset, piece_size);
+        auto& piece_header = *(TCPPacket*)(piece->data());
+        piece_header.set_sequence_number(tcp_packet.sequence_number() + offset);
+        if (offset + piece_size < payload_size)
+            piece_header.set_flags(tcp_packet.flags() & ~(TCPFlags::PUSH | TCPFlags::FIN));
+        transmit_via(adapter, routing_decision.next_hop, *piece);
+    }
 }
 
-void TCPSocket::send_outgoing_packets()
+void TCPSocket::transmit_via(NetworkAdapter& adapter, const IPv4Address& next_hop, PacketBuffer& segment)
 {
-    auto routing_decision = route_to(peer_address(), local_address());
-    ASSERT(!routing_decision.is_zero());
+    auto& tcp_packet = *(TCPPacket*)(segment.data());
+    size_t payload_size = segment.size() - tcp_packet.header_size();
+
+    // NOTE: The adapter gets a clone, so we can hang on to the segment for retransmission without copying it.
+    auto packet = segment.clone();
+    tcp_packet.set_checksum(0);
+    if (payload_size > m_send_mss) {
+        // The adapter fills in the checksum of each segment it cuts out, starting from a pseudo-header sum without the length.
+        tcp_packet.set_checksum(ipv4_pseudo_header_checksum(local_address(), peer_address(), IPv4Protocol::TCP, 0));
+        packet->request_offload(PacketBuffer::OffloadTCPSegmentation | PacketBuffer::OffloadTCPChecksum);
+        packet->set_segment_size(m_send_mss);
+    } else if (adapter.has_capability(NetworkAdapter::TxTCPChecksum)) {
+        tcp_packet.set_checksum(ipv4_pseudo_header_checksum(local_address(), peer_address(), IPv4Protocol::TCP, segment.size()));
+        packet->request_offload(PacketBuffer::OffloadTCPChecksum);
+    } else {
+        tcp_packet.set_checksum(compute_tcp_checksum(local_address(), peer_address(), tcp_packet, payload_size));
+    }
+    adapter.send_ipv4(next_hop, peer_address(), IPv4Protocol::TCP, move(packet), ttl());
+}
 
-    auto now = kgettimeofday();
+void TCPSocket::retransmit_oldest_packet()
+{
+    ASSERT(m_send_lock.is_locked());
+    ASSERT(!m_not_acked.is_empty());
+    auto& packet = m_not_acked.first();
+
+    // Someone (say, the receiving end of a loopback connection) may still be looking at the
+    // previous transmission, so get a private copy before touching the header.
+    if (packet.segment->is_shared()) {
+        // If we can't get one right now, we'll try again when the retransmission timer fires next.
+        auto copy = packet.segment->copy();
+        if (!copy)
+            return;
+        packet.segment = copy.release_nonnull();
+    }
+    auto& tcp_packet = *(TCPPacket*)(packet.segment->data());
 
-    LOCKER(m_not_acked_lock);
-    for (auto& packet : m_not_acked) {
-        timeval diff;
-        timeval_sub(packet.tx_time, now, diff);
-        if (diff.tv_sec < 1 && diff.tv_usec <= 500000)
-            continue;
+    // The acknowledgement and window in the original segment are likely stale by now.
+    if (tcp_packet.has_ack())
+        tcp_packet.set_ack_number(m_ack_number);
+    tcp_packet.set_window_size(receive_window_to_advertise(tcp_packet.has_syn()));
 
-        packet.tx_time = now;
-        packet.tx_counter++;
+    // FIXME: If this is one of the oversized segments that an adapter cuts up for us, all of it goes
+    //        out again, even if only one of the pieces was lost.
 
-#ifdef TCP_SOCKET_DEBUG
-        auto& tcp_packet = *(TCPPacket*)(packet.buffer.data());
-        kprintf("sending tcp packet from %s:%u to %s:%u with (%s%s%s%s) seq_no=%u, ack_no=%u, tx_counter=%u\n",
-            local_address().to_string().characters(),
-            local_port(),
-            peer_address().to_string().characters(),
-            peer_port(),
-            tcp_packet.has_syn() ? "SYN " : "",
-            tcp_packet.has_ack() ? "ACK " : "",
-            tcp_packet.has_fin() ? "FIN " : "",
-            tcp_packet.has_rst() ? "RST " : "",
-            tcp_packet.sequence_number(),
-            tcp_packet.ack_number(),
-            packet.tx_counter);
-#endif
-        routing_decision.adapter->send_ipv4(
-            routing_decision.next_hop, peer_address(), IPv4Protocol::TCP,
-            packet.buffer.data(), packet.buffer.size(), ttl());
+    // Karn's algorithm: never take an RTT sample from a segment that was sent more than once.
+    m_rtt_timing = false;
+
+    packet.tx_counter++;
+    m_retransmissions++;
+    transmit(*packet.segment);
+}
 
-        m_packets_out++;
-        m_bytes_out += packet.buffer.size();
+void TCPSocket::take_rtt_sample(u32 rtt)
+{
+    if (!m_smoothed_rtt) {
+        m_smoothed_rtt = max(rtt, 1u);
+        m_rtt_variance = rtt / 2;
+    } else {
+        u32 delta = m_smoothed_rtt > rtt ? m_smoothed_rtt - rtt : rtt - m_smoothed_rtt;
+        m_rtt_variance = (3 * m_rtt_variance + delta) / 4;
+        m_smoothed_rtt = max((7 * m_smoothed_rtt + rtt) / 8, 1u);
     }
+    // The clock granularity is one tick, which is a millisecond.
+    u32 rto = m_smoothed_rtt + max(1u, 4 * m_rtt_variance);
+    m_retransmission_timeout = min(max(rto, minimum_retransmission_timeout), maximum_retransmission_timeout);
 }
 
-void TCPSocket::receive_tcp_packet(const TCPPacket& packet, u16 size)
+void TCPSocket::process_ack(u32 ack_number, u32 window, bool is_duplicate_candidate)
 {
-    if (packet.has_ack()) {
-        u32 ack_number = packet.ack_number();
+    ASSERT(m_send_lock.is_locked());
 
-#ifdef TCP_SOCKET_DEBUG
-        dbg() << "TCPSocket: receive_tcp_packet: " << ack_number;
-#endif
+    if (!sequence_less_or_equal(ack_number, m_sequence_number)) {
+        // This acknowledges something we haven't sent yet.
+        return;
+    }
+
+    if (ack_number == m_send_unacknowledged) {
+        bool is_duplicate = is_duplicate_candidate && window == m_send_window && !m_not_acked.is_empty();
+        if (window != m_send_window) {
+            m_send_window = window;
+            did_change_readiness();
+        }
+        if (!is_duplicate)
+            return;
+
+        ++m_duplicate_acks;
+        if (m_in_fast_recovery) {
+            // Every duplicate means another segment has left the network.
+            m_congestion_window += m_send_mss;
+            return;
+        }
+        if (m_duplicate_acks == 3 && sequence_less_or_equal(m_recover, ack_number)) {
+            u32 in_flight = m_sequence_number - m_send_unacknowledged;
+            m_slow_start_threshold = max(in_flight / 2, 2u * m_send_mss);
+            m_recover = m_sequence_number;
+            m_in_fast_recovery = true;
+            retransmit_oldest_packet();
+            m_congestion_window = m_slow_start_threshold + 3 * m_send_mss;
+            start_timer(m_retransmission_timer_id, RetransmissionTimer, m_retransmission_timeout);
+        }
+        return;
+    }
 
-        int removed = 0;
-        LOCKER(m_not_acked_lock);
-        while (!m_not_acked.is_empty()) {
-            auto& packet = m_not_acked.first();
+    if (!sequence_less_or_equal(m_send_unacknowledged, ack_number)) {
+        // An old acknowledgement that arrived out of order.
+        return;
+    }
+
+    u32 newly_acked = ack_number - m_send_unacknowledged;
+    m_send_unacknowledged = ack_number;
+    m_send_window = window;
+    m_duplicate_acks = 0;
+    did_change_readiness();
+
+    int removed = 0;
+    while (!m_not_acked.is_empty() && sequence_less_or_equal(m_not_acked.first().ack_number, ack_number)) {
+        m_not_acked.take_first();
+        removed++;
+    }
 
 #ifdef TCP_SOCKET_DEBUG
-            dbg() << "TCPSocket: iterate: " << packet.ack_number;
+    dbg() << "TCPSocket: process_ack acknowledged " << removed << " packets, send window is " << m_send_window;
 #endif
 
-            if (packet.ack_number <= ack_number) {
-                m_not_acked.take_first();
-                removed++;
-            } else {
-                break;
-            }
+    if (m_rtt_timing && sequence_less_or_equal(m_rtt_sequence_number, ack_number)) {
+        m_rtt_timing = false;
+        take_rtt_sample(g_uptime - m_rtt_start);
+    }
+
+    if (m_in_fast_recovery) {
+        if (sequence_less_or_equal(m_recover, ack_number)) {
+            // A full acknowledgement; everything outstanding when we entered recovery has arrived.
+            m_congestion_window = m_slow_start_threshold;
+            m_in_fast_recovery = false;
+        } else {
+            // A partial acknowledgement means the next segment was lost too (RFC 6582.)
+            retransmit_oldest_packet();
+            m_congestion_window = (m_congestion_window > newly_acked ? m_congestion_window - newly_acked : 0) + m_send_mss;
         }
+    } else if (m_congestion_window < m_slow_start_threshold) {
+        m_congestion_window += min(newly_acked, (u32)m_send_mss);
+    } else {
+        m_congestion_window += max(1u, (u32)m_send_mss * m_send_mss / m_congestion_window);
+    }
+
+    if (m_not_acked.is_empty())
+        stop_timer(m_retransmission_timer_id);
+    else
+        start_timer(m_retransmission_timer_id, RetransmissionTimer, m_retransmission_timeout);
+}
 
+void TCPSocket::receive_tcp_packet(const TCPPacket& packet, u16 size)
+{
+    if (packet.has_syn() && m_state == State::SynSent)
+        process_syn_options(packet);
+
+    if (packet.has_ack()) {
 #ifdef TCP_SOCKET_DEBUG
-        dbg() << "TCPSocket: receive_tcp_packet acknowledged " << removed << " packets";
+        dbg() << "TCPSocket: receive_tcp_packet: " << packet.ack_number();
 #endif
+        u32 window = packet.window_size();
+        if (!packet.has_syn())
+            window <<= m_send_window_shift;
+        size_t payload_size = size - packet.header_size();
+        bool is_duplicate_candidate = !payload_size && !packet.has_syn() && !packet.has_fin();
+
+        LOCKER(m_send_lock);
+        process_ack(packet.ack_number(), window, is_duplicate_candidate);
+        send_pending_data();
+
+        // If the peer has closed its window on us, keep the timer going so we can probe it.
+        if (!m_send_window && !m_send_queue.is_empty() && !m_retransmission_timer_id)
+            start_timer(m_retransmission_timer_id, RetransmissionTimer, m_retransmission_timeout);
     }
 
     m_packets_in++;
     m_bytes_in += packet.header_size() + size;
 }
 
-NetworkOrdered<u16> TCPSocket::compute_tcp_checksum(const IPv4Address& source, const IPv4Address& destination, const TCPPacket& packet, u16 payload_size)
+void TCPSocket::acknowledge_received_data()
 {
-    struct [[gnu::packed]] PseudoHeader
-    {
-        IPv4Address source;
-        IPv4Address destination;
-        u8 zero;
-        u8 protocol;
-        NetworkOrdered<u16> payload_size;
-    };
-
-    PseudoHeader pseudo_header { source, destination, 0, (u8)IPv4Protocol::TCP, sizeof(TCPPacket) + payload_size };
-
-    u32 checksum = 0;
-    auto* w = (const NetworkOrdered<u16>*)&pseudo_header;
-    for (size_t i = 0; i < sizeof(pseudo_header) / sizeof(u16); ++i) {
-        checksum += w[i];
-        if (checksum > 0xffff)
-            checksum = (checksum >> 16) + (checksum & 0xffff);
-    }
-    w = (const NetworkOrdered<u16>*)&packet;
-    for (size_t i = 0; i < sizeof(packet) / sizeof(u16); ++i) {
-        checksum += w[i];
-        if (checksum > 0xffff)
-            checksum = (checksum >> 16) + (checksum & 0xffff);
+    // Acknowledge every second segment right away, and let the delayed ACK timer
+    // pick up a lone one (RFC 1122, 4.2.3.2.)
+    if (++m_segments_to_ack >= 2) {
+        send_tcp_packet(TCPFlags::ACK);
+        return;
     }
-    ASSERT(packet.data_offset() * 4 == sizeof(TCPPacket));
-    w = (const NetworkOrdered<u16>*)packet.payload();
-    for (size_t i = 0; i < payload_size / sizeof(u16); ++i) {
-        checksum += w[i];
-        if (checksum > 0xffff)
-            checksum = (checksum >> 16) + (checksum & 0xffff);
+    if (!m_delayed_ack_timer_id)
+        start_timer(m_delayed_ack_timer_id, DelayedAckTimer, delayed_ack_timeout);
+}
+
+void TCPSocket::handle_retransmission_timeout()
+{
+    ASSERT(m_send_lock.is_locked());
+    m_retransmission_timeout = min(m_retransmission_timeout * 2, maximum_retransmission_timeout);
+
+    if (m_not_acked.is_empty()) {
+        // Nothing is in flight, so this is the persist timer: the peer's window is closed
+        // and we haven't heard about it opening again. Poke it with a byte of data.
+        if (!m_send_window && !m_send_queue.is_empty())
+            send_pending_data(true);
+        return;
     }
-    if (payload_size & 1) {
-        u16 expanded_byte = ((const u8*)packet.payload())[payload_size - 1] << 8;
-        checksum += expanded_byte;
-        if (checksum > 0xffff)
-            checksum = (checksum >> 16) + (checksum & 0xffff);
+
+#ifdef TCP_SOCKET_DEBUG
+    kprintf("TCPSocket{%p} retransmission timeout, next timeout in %u ms\n", this, m_retransmission_timeout);
+#endif
+
+    u32 in_flight = m_sequence_number - m_send_unacknowledged;
+    m_slow_start_threshold = max(in_flight / 2, 2u * m_send_mss);
+    m_congestion_window = m_send_mss;
+    m_recover = m_sequence_number;
+    m_in_fast_recovery = false;
+    m_duplicate_acks = 0;
+    retransmit_oldest_packet();
+    start_timer(m_retransmission_timer_id, RetransmissionTimer, m_retransmission_timeout);
+}
+
+bool TCPSocket::s_has_expired_timers;
+
+void TCPSocket::start_timer(u64& timer_id, TimerFlags flag, u32 ms)
+{
+    InterruptDisabler disabler;
+    if (timer_id)
+        TimerQueue::the().cancel_timer(timer_id);
+    u64* timer_id_ptr = &timer_id;
+    timer_id = TimerQueue::the().add_timer(ms, TimeUnit::MS, [this, timer_id_ptr, flag] {
+        // NOTE: We're in interrupt context here, so leave the real work to the NetworkTask.
+        *timer_id_ptr = 0;
+        m_expired_timers |= flag;
+        s_has_expired_timers = true;
+        NetworkTask_wake();
+    });
+}
+
+void TCPSocket::stop_timer(u64& timer_id)
+{
+    InterruptDisabler disabler;
+    if (!timer_id)
+        return;
+    TimerQueue::the().cancel_timer(timer_id);
+    timer_id = 0;
+}
+
+void TCPSocket::handle_expired_timers()
+{
+    s_has_expired_timers = false;
+    for_each([](auto& socket) {
+        socket.handle_timers();
+    });
+}
+
+void TCPSocket::handle_timers()
+{
+    u8 expired;
+    {
+        InterruptDisabler disabler;
+        expired = m_expired_timers;
+        m_expired_timers = 0;
     }
-    return ~(checksum & 0xffff);
+    if (!expired)
+        return;
+
+    LOCKER(m_send_lock);
+    if ((expired & DelayedAckTimer) && m_segments_to_ack)
+        send_tcp_packet(TCPFlags::ACK);
+    if (expired & RetransmissionTimer)
+        handle_retransmission_timeout();
+}
+
+NetworkOrdered<u16> TCPSocket::compute_tcp_checksum(const IPv4Address& source, const IPv4Address& destination, const TCPPacket& packet, u16 payload_size)
+{
+    size_t tcp_length = packet.header_size() + payload_size;
+    u32 sum = ipv4_pseudo_header_sum(source, destination, IPv4Protocol::TCP, tcp_length);
+    return internet_checksum_finish(internet_checksum_add(sum, &packet, tcp_length));
 }
 
 KResult TCPSocket::protocol_bind()
@@ -333,6 +754,8 @@ KResult TCPSocket::protocol_connect(FileDescription& description, ShouldBlock sh
 
     m_sequence_number = 0;
     m_ack_number = 0;
+    m_send_unacknowledged = 0;
+    m_recover = 0;
 
     set_setup_state(SetupState::InProgress);
     send_tcp_packet(TCPFlags::SYN);
@@ -113,17 +113,38 @@ public:
     void set_error(Error error) { m_error = error; }
 
     void set_ack_number(u32 n) { m_ack_number = n; }
-    void set_sequence_number(u32 n) { m_sequence_number = n; }
+    void set_sequence_number(u32 n)
+    {
+        m_sequence_number = n;
+        m_send_unacknowledged = n;
+        m_recover = n;
+    }
     u32 ack_number() const { return m_ack_number; }
     u32 sequence_number() const { return m_sequence_number; }
     u32 packets_in() const { return m_packets_in; }
     u32 bytes_in() const { return m_bytes_in; }
     u32 packets_out() const { return m_packets_out; }
     u32 bytes_out() const { return m_bytes_out; }
+    u32 send_window() const { return m_send_window; }
+    u16 send_mss() const { return m_send_mss; }
+    u32 congestion_window() const { return m_congestion_window; }
+    u32 slow_start_threshold() const { return m_slow_start_threshold; }
+    u32 smoothed_rtt() const { return m_smoothed_rtt; }
+    u32 retransmission_timeout() const { return m_retransmission_timeout; }
+    u32 retransmissions() const { return m_retransmissions; }
 
-    void send_tcp_packet(u16 flags, const void* = nullptr, int = 0);
-    void send_outgoing_packets();
+    // Returns false if we're out of packet memory, in which case nothing was sent.
+    bool send_tcp_packet(u16 flags, const void* = nullptr, int = 0);
+    // NOTE: The segment's data is the TCP payload; the TCP header gets pushed into its headroom.
+    void send_tcp_segment(u16 flags, NonnullRefPtr<PacketBuffer>);
     void receive_tcp_packet(const TCPPacket&, u16 size);
+    void process_syn_options(const TCPPacket&);
+    void acknowledge_received_data();
+
+    // Our timers fire in interrupt context, so they only flag the socket and wake up
+    // the NetworkTask, which then calls this to do the actual work.
+    static bool has_expired_timers() { return s_has_expired_timers; }
+    static void handle_expired_timers();
 
     static Lockable<HashMap<IPv4SocketTuple, TCPSocket*>>& sockets_by_tuple();
     static RefPtr<TCPSocket> from_tuple(const IPv4SocketTuple& tuple);
@@ -144,13 +165,53 @@ private:
 
     static NetworkOrdered<u16> compute_tcp_checksum(const IPv4Address& source, const IPv4Address& destination, const TCPPacket&, u16 payload_size);
 
-    virtual int protocol_receive(const KBuffer&, void* buffer, size_t buffer_size, int flags) override;
+    virtual void protocol_trim_to_payload(PacketBuffer&) override;
     virtual int protocol_send(const void*, int) override;
     virtual KResult protocol_connect(FileDescription&, ShouldBlock) override;
     virtual int protocol_allocate_local_port() override;
     virtual bool protocol_is_disconnected() const override;
     virtual KResult protocol_bind() override;
     virtual KResult protocol_listen() override;
+    virtual bool protocol_can_write() const override;
+    virtual size_t protocol_write_capacity() const override { return send_buffer_space(); }
+    virtual void protocol_did_read(size_t) override;
+
+    u16 local_mss() const;
+    u16 receive_window_to_advertise(bool is_syn);
+    size_t send_buffer_space() const;
+    void send_pending_data(bool send_window_probe = false);
+    void transmit(PacketBuffer&);
+    void transmit_via(NetworkAdapter&, const IPv4Address& next_hop, PacketBuffer&);
+    void retransmit_oldest_packet();
+    void process_ack(u32 ack_number, u32 window, bool is_duplicate_candidate);
+    void take_rtt_sample(u32 rtt);
+    void handle_retransmission_timeout();
+    void handle_timers();
+
+    enum TimerFlags : u8 {
+        RetransmissionTimer = 1 << 0,
+        DelayedAckTimer = 1 << 1,
+    };
+    void start_timer(u64& timer_id, TimerFlags, u32 ms);
+    void stop_timer(u64& timer_id);
+
+    static bool s_has_expired_timers;
+
+    // Unsent data waits in the send queue until the peer's window has room for it.
+    static constexpr size_t send_buffer_capacity = 64 * KB;
+
+    // How much payload we hand to an adapter that does TCP segmentation in one go.
+    static constexpr size_t max_offloaded_segment_size = 32 * KB;
+
+    // Scaling our 128 KB receive buffer down by 4 makes it fit in the 16-bit window field.
+    static constexpr u8 desired_receive_window_shift = 2;
+
+    // Retransmission timeout bounds and initial value, in milliseconds (RFC 6298.)
+    static constexpr u32 initial_retransmission_timeout = 1000;
+    static constexpr u32 minimum_retransmission_timeout = 200;
+    static constexpr u32 maximum_retransmission_timeout = 60000;
+
+    static constexpr u32 delayed_ack_timeout = 200;
 
     WeakPtr<TCPSocket> m_originator;
     HashMap<IPv4SocketTuple, NonnullRefPtr<TCPSocket>> m_pending_release_for_accept;
@@ -165,13 +226,48 @@ private:
     u32 m_packets_out { 0 };
     u32 m_bytes_out { 0 };
 
+    u32 m_send_unacknowledged { 0 };
+    u32 m_send_window { 0 };
+    u16 m_send_mss { 536 };
+    // The size of the segments we queue up; a multiple of the MSS if the adapter can cut them down to size.
+    u16 m_send_segment_size { 536 };
+    u8 m_send_window_shift { 0 };
+    u8 m_receive_window_shift { 0 };
+    bool m_window_scaling_enabled { false };
+    size_t m_last_advertised_window { 0 };
+
+    // NOTE: Each queued packet is (at most) m_send_segment_size bytes of payload, with room for the headers in front.
+    PacketQueue m_send_queue;
+    size_t m_send_queue_size { 0 };
+
+    // NewReno congestion control state (RFC 5681, RFC 6582.)
+    u32 m_congestion_window { 4380 };
+    u32 m_slow_start_threshold { 0xffffffff };
+    u32 m_recover { 0 };
+    u32 m_duplicate_acks { 0 };
+    bool m_in_fast_recovery { false };
+
+    // Round-trip time estimation, in milliseconds (RFC 6298.) Only one segment is timed at a time.
+    u32 m_smoothed_rtt { 0 };
+    u32 m_rtt_variance { 0 };
+    u32 m_retransmission_timeout { initial_retransmission_timeout };
+    bool m_rtt_timing { false };
+    u32 m_rtt_sequence_number { 0 };
+    u64 m_rtt_start { 0 };
+    u32 m_retransmissions { 0 };
+
+    u64 m_retransmission_timer_id { 0 };
+    u64 m_delayed_ack_timer_id { 0 };
+    u32 m_segments_to_ack { 0 };
+    volatile u8 m_expired_timers { 0 };
+
     struct OutgoingPacket {
         u32 ack_number;
-        ByteBuffer buffer;
+        NonnullRefPtr<PacketBuffer> segment;
         int tx_counter { 0 };
-        timeval tx_time;
     };
 
-    Lock m_not_acked_lock { "TCPSocket unacked packets" };
+    // NOTE: This guards the send queue, the send window and the congestion state as well as m_not_acked.
+    Lock m_send_lock { "TCPSocket send state" };
     SinglyLinkedList<OutgoingPacket> m_not_acked;
 };
@@ -6,30 +6,35 @@
 #include <Kernel/Process.h>
 #include <Kernel/Random.h>
 
+//#define UDP_SOCKET_DEBUG
+
 void UDPSocket::for_each(Function<void(UDPSocket&)> callback)
 {
-    LOCKER(sockets_by_port().lock());
-    for (auto it : sockets_by_port().resource())
+    LOCKER(sockets_by_endpoint().lock());
+    for (auto it : sockets_by_endpoint().resource())
         callback(*it.value);
 }
 
-Lockable<HashMap<u16, UDPSocket*>>& UDPSocket::sockets_by_port()
+Lockable<HashMap<IPv4SocketTuple, UDPSocket*>>& UDPSocket::sockets_by_endpoint()
 {
-    static Lockable<HashMap<u16, UDPSocket*>>* s_map;
+    static Lockable<HashMap<IPv4SocketTuple, UDPSocket*>>* s_map;
     if (!s_map)
-        s_map = new Lockable<HashMap<u16, UDPSocket*>>;
+        s_map = new Lockable<HashMap<IPv4SocketTuple, UDPSocket*>>;
     return *s_map;
 }
 
-SocketHandle<UDPSocket> UDPSocket::from_port(u16 port)
+SocketHandle<UDPSocket> UDPSocket::from_endpoint(const IPv4Address& local_address, u16 local_port)
 {
     RefPtr<UDPSocket> socket;
     {
-        LOCKER(sockets_by_port().lock());
-        auto it = sockets_by_port().resource().find(port);
-        if (it == sockets_by_port().resource().end())
+        LOCKER(sockets_by_endpoint().lock());
+        auto& map = sockets_by_endpoint().resource();
+        auto match = map.get(endpoint_tuple(local_address, local_port));
+        if (!match.has_value())
+            match = map.get(endpoint_tuple(IPv4Address(), local_port));
+        if (!match.has_value())
             return {};
-        socket = (*it).value;
+        socket = match.value();
         ASSERT(socket);
     }
     return { *socket };
@@ -42,8 +47,10 @@ UDPSocket::UDPSocket(int protocol)
 
 UDPSocket::~UDPSocket()
 {
-    LOCKER(sockets_by_port().lock());
-    sockets_by_port().resource().remove(local_port());
+    if (!m_registered)
+        return;
+    LOCKER(sockets_by_endpoint().lock());
+    sockets_by_endpoint().resource().remove(endpoint_tuple(m_registered_address, local_port()));
 }
 
 NonnullRefPtr<UDPSocket> UDPSocket::create(int protocol)
@@ -51,10 +58,10 @@ NonnullRefPtr<UDPSocket> UDPSocket::create(int protocol)
     return adopt(*new UDPSocket(protocol));
 }
 
-int UDPSocket::protocol_receive(const KBuffer& packet_buffer, void* buffer, size_t buffer_size, int flags)
+int UDPSocket::protocol_receive(const PacketBuffer& packet, void* buffer, size_t buffer_size, int flags)
 {
     (void)flags;
-    auto& ipv4_packet = *(const IPv4Packet*)(packet_buffer.data());
+    auto& ipv4_packet = *(const IPv4Packet*)(packet.data());
     auto& udp_packet = *static_cast<const UDPPacket*>(ipv4_packet.payload());
     ASSERT(udp_packet.length() >= sizeof(UDPPacket)); // FIXME: This should be rejected earlier.
     ASSERT(buffer_size >= (udp_packet.length() - sizeof(UDPPacket)));
@@ -67,18 +74,28 @@ int UDPSocket::protocol_send(const void* data, int data_length)
     auto routing_decision = route_to(peer_address(), local_address());
     if (routing_decision.is_zero())
         return -EHOSTUNREACH;
-    auto buffer = ByteBuffer::create_zeroed(sizeof(UDPPacket) + data_length);
-    auto& udp_packet = *(UDPPacket*)(buffer.data());
+    auto packet = PacketBuffer::create(sizeof(UDPPacket) + data_length);
+    if (!packet)
+        return -ENOBUFS;
+    memset(packet->data(), 0, sizeof(UDPPacket));
+    auto& udp_packet = *(UDPPacket*)(packet->data());
     udp_packet.set_source_port(local_port());
     udp_packet.set_destination_port(peer_port());
     udp_packet.set_length(sizeof(UDPPacket) + data_length);
     memcpy(udp_packet.payload(), data, data_length);
+    // NOTE: The checksum is optional over IPv4, so we only bother with it if the adapter does the work.
+    if (routing_decision.adapter->has_capability(NetworkAdapter::TxUDPChecksum)) {
+        udp_packet.set_checksum(ipv4_pseudo_header_checksum(routing_decision.adapter->ipv4_address(), peer_address(), IPv4Protocol::UDP, udp_packet.length()));
+        packet->request_offload(PacketBuffer::OffloadUDPChecksum);
+    }
+#ifdef UDP_SOCKET_DEBUG
     kprintf("sending as udp packet from %s:%u to %s:%u!\n",
         routing_decision.adapter->ipv4_address().to_string().characters(),
         local_port(),
         peer_address().to_string().characters(),
         peer_port());
-    routing_decision.adapter->send_ipv4(routing_decision.next_hop, peer_address(), IPv4Protocol::UDP, buffer.data(), buffer.size(), ttl());
+#endif
+    routing_decision.adapter->send_ipv4(routing_decision.next_hop, peer_address(), IPv4Protocol::UDP, packet.release_nonnull(), ttl());
     return data_length;
 }
 
@@ -95,12 +112,14 @@ int UDPSocket::protocol_allocate_local_port()
     static const u16 ephemeral_port_range_size = last_ephemeral_port - first_ephemeral_port;
     u16 first_scan_port = first_ephemeral_port + get_good_random<u16>() % ephemeral_port_range_size;
 
-    LOCKER(sockets_by_port().lock());
+    LOCKER(sockets_by_endpoint().lock());
     for (u16 port = first_scan_port;;) {
-        auto it = sockets_by_port().resource().find(port);
-        if (it == sockets_by_port().resource().end()) {
+        auto tuple = endpoint_tuple(local_address(), port);
+        if (!sockets_by_endpoint().resource().contains(tuple)) {
             set_local_port(port);
-            sockets_by_port().resource().set(port, this);
+            sockets_by_endpoint().resource().set(tuple, this);
+            m_registered_address = local_address();
+            m_registered = true;
             return port;
         }
         ++port;
@@ -114,9 +133,15 @@ int UDPSocket::protocol_allocate_local_port()
 
 KResult UDPSocket::protocol_bind()
 {
-    LOCKER(sockets_by_port().lock());
-    if (sockets_by_port().resource().contains(local_port()))
+    // Binding to port 0 means "any port", which we'll pick (and register) once we need one.
+    if (!local_port())
+        return KSuccess;
+    LOCKER(sockets_by_endpoint().lock());
+    auto tuple = endpoint_tuple(local_address(), local_port());
+    if (sockets_by_endpoint().resource().contains(tuple))
         return KResult(-EADDRINUSE);
-    sockets_by_port().resource().set(local_port(), this);
+    sockets_by_endpoint().resource().set(tuple, this);
+    m_registered_address = local_address();
+    m_registered = true;
     return KSuccess;
 }
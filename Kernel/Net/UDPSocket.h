@@ -7,17 +7,24 @@ public:
     static NonnullRefPtr<UDPSocket> create(int protocol);
     virtual ~UDPSocket() override;
 
-    static SocketHandle<UDPSocket> from_port(u16);
+    // Finds the socket bound to this address and port, falling back to one bound to the port on any address.
+    static SocketHandle<UDPSocket> from_endpoint(const IPv4Address& local_address, u16 local_port);
     static void for_each(Function<void(UDPSocket&)>);
 
 private:
     explicit UDPSocket(int protocol);
     virtual const char* class_name() const override { return "UDPSocket"; }
-    static Lockable<HashMap<u16, UDPSocket*>>& sockets_by_port();
+    // NOTE: UDP sockets are keyed by their local endpoint only; the peer half of the tuple is always zero.
+    static Lockable<HashMap<IPv4SocketTuple, UDPSocket*>>& sockets_by_endpoint();
+    static IPv4SocketTuple endpoint_tuple(const IPv4Address& address, u16 port) { return IPv4SocketTuple(address, port, IPv4Address(), 0); }
 
-    virtual int protocol_receive(const KBuffer&, void* buffer, size_t buffer_size, int flags) override;
+    virtual int protocol_receive(const PacketBuffer&, void* buffer, size_t buffer_size, int flags) override;
     virtual int protocol_send(const void*, int) override;
     virtual KResult protocol_connect(FileDescription&, ShouldBlock) override;
     virtual int protocol_allocate_local_port() override;
     virtual KResult protocol_bind() override;
+
+    // The local address we were registered under, which stays put even if local_address() is filled in later.
+    IPv4Address m_registered_address;
+    bool m_registered { false };
 };
@@ -1,4 +1,5 @@
 #include <AK/FileSystemPath.h>
+#include <AK/ScopeGuard.h>
 #include <AK/StdLibExtras.h>
 #include <AK/StringBuilder.h>
 #include <AK/Time.h>
@@ -6,12 +7,15 @@
 #include <Kernel/Arch/i386/CPU.h>
 #include <Kernel/Arch/i386/PIT.h>
 #include <Kernel/Console.h>
+#include <Kernel/Devices/DiskPartition.h>
 #include <Kernel/Devices/KeyboardDevice.h>
 #include <Kernel/Devices/NullDevice.h>
 #include <Kernel/Devices/PCSpeaker.h>
 #include <Kernel/Devices/RandomDevice.h>
+#include <Kernel/FileSystem/AnonymousFile.h>
 #include <Kernel/FileSystem/Custody.h>
 #include <Kernel/FileSystem/DevPtsFS.h>
+#include <Kernel/FileSystem/EventQueue.h>
 #include <Kernel/FileSystem/Ext2FileSystem.h>
 #include <Kernel/FileSystem/FIFO.h>
 #include <Kernel/FileSystem/FileDescription.h>
@@ -21,11 +25,13 @@
 #include <Kernel/FileSystem/VirtualFileSystem.h>
 #include <Kernel/Heap/kmalloc.h>
 #include <Kernel/IO.h>
+#include <Kernel/KBuffer.h>
 #include <Kernel/KBufferBuilder.h>
 #include <Kernel/KSyms.h>
 #include <Kernel/KernelInfoPage.h>
 #include <Kernel/Module.h>
 #include <Kernel/Multiboot.h>
+#include <Kernel/Net/LocalSocket.h>
 #include <Kernel/Net/Socket.h>
 #include <Kernel/Process.h>
 #include <Kernel/ProcessTracer.h>
@@ -40,6 +46,7 @@
 #include <Kernel/Thread.h>
 #include <Kernel/VM/InodeVMObject.h>
 #include <Kernel/VM/PurgeableVMObject.h>
+#include <Kernel/VM/SwapArea.h>
 #include <LibC/errno_numbers.h>
 #include <LibC/limits.h>
 #include <LibC/signal_numbers.h>
@@ -117,12 +124,12 @@ bool Process::in_group(gid_t gid) const
     return m_gid == gid || m_extra_gids.contains(gid);
 }
 
-Range Process::allocate_range(VirtualAddress vaddr, size_t size)
+Range Process::allocate_range(VirtualAddress vaddr, size_t size, size_t alignment)
 {
     vaddr.mask(PAGE_MASK);
     size = PAGE_ROUND_UP(size);
     if (vaddr.is_null())
-        return page_directory().range_allocator().allocate_anywhere(size);
+        return page_directory().range_allocator().allocate_anywhere(size, alignment);
     return page_directory().range_allocator().allocate_specific(vaddr, size);
 }
 
@@ -168,7 +175,11 @@ Region* Process::allocate_file_backed_region(VirtualAddress vaddr, size_t size,
 
 Region* Process::allocate_region_with_vmobject(VirtualAddress vaddr, size_t size, NonnullRefPtr<VMObject> vmobject, size_t offset_in_vmobject, const String& name, int prot)
 {
-    auto range = allocate_range(vaddr, size);
+    size_t alignment = PAGE_SIZE;
+    // Line big physical ranges (i.e framebuffers) up with large page boundaries so they can be mapped with large pages.
+    if (size >= LARGE_PAGE_SIZE && vmobject->is_anonymous() && static_cast<AnonymousVMObject&>(*vmobject).is_physical_range())
+        alignment = LARGE_PAGE_SIZE;
+    auto range = allocate_range(vaddr, size, alignment);
     if (!range.is_valid())
         return nullptr;
     offset_in_vmobject &= PAGE_MASK;
@@ -515,6 +526,32 @@ int Process::sys$purge(int mode)
     return purged_page_count;
 }
 
+int Process::sys$swapon(const char* user_path)
+{
+    if (!is_superuser())
+        return -EPERM;
+    String path;
+    {
+        SmapDisabler disabler;
+        if (!validate_read_str(user_path))
+            return -EFAULT;
+        path = user_path;
+    }
+    auto description_or_error = VFS::the().open(path, O_RDWR, 0, current_directory());
+    if (description_or_error.is_error())
+        return description_or_error.error();
+    auto& description = *description_or_error.value();
+    if (description.is_device()) {
+        auto& device = static_cast<Device&>(description.file());
+        if (!device.is_disk_device() || !static_cast<DiskDevice&>(device).is_disk_partition())
+            return -ENOTBLK;
+        return SwapArea::activate(static_cast<DiskPartition&>(device));
+    }
+    if (!description.inode())
+        return -EINVAL;
+    return SwapArea::activate(*description.inode());
+}
+
 int Process::sys$gethostname(char* buffer, ssize_t size)
 {
     if (size < 0)
@@ -694,8 +731,8 @@ int Process::do_exec(String path, Vector<String> arguments, Vector<String> envir
         if (!success || !loader->entry().get()) {
             m_page_directory = move(old_page_directory);
             // FIXME: RAII this somehow instead.
-            ASSERT(&current->process() == this);
-            MM.enter_process_paging_scope(*this);
+            if (&current->process() == this)
+                MM.enter_process_paging_scope(*this);
             executable_region = m_regions.take_first();
             m_regions = move(old_regions);
             kprintf("do_exec: Failure loading %s\n", path.characters());
@@ -725,10 +762,6 @@ int Process::do_exec(String path, Vector<String> arguments, Vector<String> envir
     if (metadata.is_setgid())
         m_egid = metadata.gid;
 
-    current->set_default_signal_dispositions();
-    current->m_signal_mask = 0;
-    current->m_pending_signals = 0;
-
     for (int i = 0; i < m_fds.size(); ++i) {
         auto& daf = m_fds[i];
         if (daf.description && daf.flags & FD_CLOEXEC) {
@@ -749,6 +782,12 @@ int Process::do_exec(String path, Vector<String> arguments, Vector<String> envir
     }
     ASSERT(new_main_thread);
 
+    // NOTE: When spawning, we're not running in the new process, so make sure
+    //       the signal state we reset is that of the new main thread.
+    new_main_thread->set_default_signal_dispositions();
+    new_main_thread->m_signal_mask = 0;
+    new_main_thread->m_pending_signals = 0;
+
     // NOTE: We create the new stack before disabling interrupts since it will zero-fault
     //       and we don't want to deal with faults after this point.
     u32 new_userspace_esp = new_main_thread->make_userspace_stack_for_main_thread(move(arguments), move(environment));
@@ -930,6 +969,195 @@ int Process::sys$execve(const char* filename, const char** argv, const char** en
     return rc;
 }
 
+static pid_t get_sid_from_pgid(pid_t pgid)
+{
+    InterruptDisabler disabler;
+    auto* group_leader = Process::from_pid(pgid);
+    if (!group_leader)
+        return -1;
+    return group_leader->sid();
+}
+
+KResult Process::apply_spawn_file_action(const Syscall::SC_spawn_file_action& action)
+{
+    switch (action.type) {
+    case Syscall::SpawnFileActionType::Open: {
+        if (action.fd < 0 || action.fd >= m_max_open_file_descriptors)
+            return KResult(-EBADF);
+        auto path = copy_string_from_user(action.path, action.path_length);
+        auto result = VFS::the().open(path, action.options, action.mode & ~umask(), current_directory());
+        if (result.is_error())
+            return result.error();
+        auto description = result.value();
+        description->set_rw_mode(action.options);
+        description->set_file_flags(action.options);
+        if (m_fds[action.fd])
+            m_fds[action.fd].description->close();
+        m_fds[action.fd].set(move(description), (action.options & O_CLOEXEC) ? FD_CLOEXEC : 0);
+        return KSuccess;
+    }
+    case Syscall::SpawnFileActionType::Close: {
+        auto* description = file_description(action.fd);
+        if (!description)
+            return KResult(-EBADF);
+        description->close();
+        m_fds[action.fd] = {};
+        return KSuccess;
+    }
+    case Syscall::SpawnFileActionType::Dup2: {
+        auto* description = file_description(action.fd);
+        if (!description)
+            return KResult(-EBADF);
+        if (action.new_fd < 0 || action.new_fd >= m_max_open_file_descriptors)
+            return KResult(-EBADF);
+        if (action.new_fd != action.fd)
+            m_fds[action.new_fd].set(*description);
+        return KSuccess;
+    }
+    case Syscall::SpawnFileActionType::Chdir: {
+        auto path = copy_string_from_user(action.path, action.path_length);
+        auto directory_or_error = VFS::the().open_directory(path, current_directory());
+        if (directory_or_error.is_error())
+            return directory_or_error.error();
+        m_cwd = *directory_or_error.value();
+        return KSuccess;
+    }
+    }
+    return KResult(-EINVAL);
+}
+
+pid_t Process::sys$spawn(const Syscall::SC_spawn_params* user_params)
+{
+    if (!validate_read_typed(user_params))
+        return -EFAULT;
+
+    Syscall::SC_spawn_params params;
+    copy_from_user(&params, user_params, sizeof(params));
+
+    auto path = get_syscall_path_argument(params.path, params.path_length);
+    if (path.is_error())
+        return path.error();
+    auto parts = path.value().split('/');
+    if (parts.is_empty())
+        return -ENOENT;
+
+    if (params.file_actions_count > (size_t)m_max_open_file_descriptors * 4)
+        return -E2BIG;
+    if (params.file_actions_count && !validate_read_typed(params.file_actions, params.file_actions_count))
+        return -EFAULT;
+
+    Vector<String> arguments;
+    Vector<String> environment;
+    Vector<Syscall::SC_spawn_file_action> file_actions;
+    {
+        SmapDisabler disabler;
+        if (params.argv) {
+            if (!validate_read_typed(params.argv))
+                return -EFAULT;
+            for (size_t i = 0; params.argv[i]; ++i) {
+                if (!validate_read_str(params.argv[i]))
+                    return -EFAULT;
+                arguments.append(params.argv[i]);
+            }
+        }
+        if (params.envp) {
+            if (!validate_read_typed(params.envp))
+                return -EFAULT;
+            for (size_t i = 0; params.envp[i]; ++i) {
+                if (!validate_read_str(params.envp[i]))
+                    return -EFAULT;
+                environment.append(params.envp[i]);
+            }
+        }
+        file_actions.ensure_capacity(params.file_actions_count);
+        for (size_t i = 0; i < params.file_actions_count; ++i) {
+            auto& action = params.file_actions[i];
+            if (action.type == Syscall::SpawnFileActionType::Open || action.type == Syscall::SpawnFileActionType::Chdir) {
+                if (action.path_length == 0)
+                    return -EINVAL;
+                if (action.path_length > PATH_MAX)
+                    return -ENAMETOOLONG;
+                if (!validate_read(action.path, action.path_length))
+                    return -EFAULT;
+            }
+            file_actions.append(action);
+        }
+    }
+
+    if (arguments.is_empty())
+        arguments.append(parts.last());
+
+    // NOTE: Unlike fork(), we don't clone any regions. The child starts out with an empty
+    //       address space and inherits only the parent's credentials and file descriptors.
+    Thread* child_first_thread = nullptr;
+    auto* child = new Process(child_first_thread, parts.take_last(), m_uid, m_gid, m_pid, Ring3, m_cwd, nullptr, m_tty);
+    child->m_euid = m_euid;
+    child->m_egid = m_egid;
+    child->m_extra_gids = m_extra_gids;
+    child->m_umask = m_umask;
+
+    if (params.flags & POSIX_SPAWN_RESETIDS) {
+        child->m_euid = m_uid;
+        child->m_egid = m_gid;
+    }
+
+    for (int i = 0; i < min(m_fds.size(), child->m_fds.size()); ++i)
+        child->m_fds[i] = m_fds[i];
+
+    auto fail = [&](int error) {
+        delete child_first_thread;
+        delete child;
+        return error;
+    };
+
+    if (params.flags & POSIX_SPAWN_SETSID) {
+        child->m_sid = child->m_pid;
+        child->m_pgid = child->m_pid;
+    } else if (params.flags & POSIX_SPAWN_SETPGROUP) {
+        if (params.pgroup < 0)
+            return fail(-EINVAL);
+        pid_t new_pgid = params.pgroup ? params.pgroup : child->m_pid;
+        if (params.pgroup && get_sid_from_pgid(new_pgid) != child->m_sid)
+            return fail(-EPERM);
+        child->m_pgid = new_pgid;
+    }
+
+    {
+        // The file actions happen on our thread, but on behalf of the child, with its credentials.
+        current->set_credentials_process(child);
+        ScopeGuard guard([] { current->set_credentials_process(nullptr); });
+        for (auto& action : file_actions) {
+            auto result = child->apply_spawn_file_action(action);
+            if (result.is_error())
+                return fail(result.error());
+        }
+    }
+
+    int rc = child->exec(path.value(), move(arguments), move(environment));
+    if (rc < 0)
+        return fail(rc);
+
+    // NOTE: exec() has already given every signal its default disposition, so this doesn't
+    //       change anything yet. It will once ignored signals are inherited across exec().
+    if (params.flags & POSIX_SPAWN_SETSIGDEF) {
+        for (u8 signal = 1; signal < 32; ++signal) {
+            if (params.sigdefault & (1 << (signal - 1)))
+                child_first_thread->set_default_signal_disposition(signal);
+        }
+    }
+    if (params.flags & POSIX_SPAWN_SETSIGMASK)
+        child_first_thread->m_signal_mask = params.sigmask;
+
+    {
+        InterruptDisabler disabler;
+        g_processes->prepend(child);
+    }
+#ifdef TASK_DEBUG
+    kprintf("Process %u (%s) spawned from %u @ %p\n", child->pid(), child->name().characters(), m_pid, child_first_thread->tss().eip);
+#endif
+    return child->pid();
+}
+
 Process* Process::create_user_process(Thread*& first_thread, const String& path, uid_t uid, gid_t gid, pid_t parent_pid, int& error, Vector<String>&& arguments, Vector<String>&& environment, TTY* tty)
 {
     // FIXME: Don't split() the path twice (sys$spawn also does it...)
@@ -1302,7 +1530,7 @@ ssize_t Process::sys$writev(int fd, const struct iovec* iov, int iov_count)
 
     u64 total_length = 0;
     Vector<iovec, 32> vecs;
-    vecs.ensure_capacity(iov_count);
+    vecs.resize(iov_count);
     copy_from_user(vecs.data(), iov, iov_count * sizeof(iovec));
     for (auto& vec : vecs) {
         if (!validate_read(vec.iov_base, vec.iov_len))
@@ -1311,6 +1539,8 @@ ssize_t Process::sys$writev(int fd, const struct iovec* iov, int iov_count)
         if (total_length > INT32_MAX)
             return -EINVAL;
     }
+    if (total_length == 0)
+        return 0;
 
     auto* description = file_description(fd);
     if (!description)
@@ -1319,20 +1549,82 @@ ssize_t Process::sys$writev(int fd, const struct iovec* iov, int iov_count)
     if (!description->is_writable())
         return -EBADF;
 
-    int nwritten = 0;
+    if (!description->is_blocking()) {
+        if (!description->can_write())
+            return -EAGAIN;
+    } else if (!description->can_write()) {
+        if (current->block<Thread::WriteBlocker>(*description) == Thread::BlockResult::InterruptedBySignal)
+            return -EINTR;
+    }
+
+    if (description->should_append())
+        description->seek(0, SEEK_END);
+
+    // Give the file a chance to take all the buffers at once, which is what keeps
+    // a message written with writev() in one piece on a socket.
+    int nwritten = description->writev(vecs.data(), vecs.size());
+    if (nwritten < 0 || (u64)nwritten == total_length)
+        return nwritten;
+
+    // Whatever didn't fit goes in one buffer at a time, blocking as necessary.
+    size_t skip = nwritten;
     for (auto& vec : vecs) {
-        int rc = do_write(*description, (const u8*)vec.iov_base, vec.iov_len);
-        if (rc < 0) {
-            if (nwritten == 0)
-                return rc;
-            return nwritten;
+        if (skip >= vec.iov_len) {
+            skip -= vec.iov_len;
+            continue;
         }
+        size_t length = vec.iov_len - skip;
+        int rc = do_write(*description, (const u8*)vec.iov_base + skip, length);
+        skip = 0;
+        if (rc <= 0)
+            break;
         nwritten += rc;
+        // A short write leaves a hole; writing the next buffer after it would scramble the data.
+        if ((size_t)rc < length)
+            break;
     }
 
     return nwritten;
 }
 
+ssize_t Process::sys$readv(int fd, const struct iovec* iov, int iov_count)
+{
+    if (iov_count < 0)
+        return -EINVAL;
+
+    if (!validate_read_typed(iov, iov_count))
+        return -EFAULT;
+
+    u64 total_length = 0;
+    Vector<iovec, 32> vecs;
+    vecs.resize(iov_count);
+    copy_from_user(vecs.data(), iov, iov_count * sizeof(iovec));
+    for (auto& vec : vecs) {
+        if (!validate_write(vec.iov_base, vec.iov_len))
+            return -EFAULT;
+        total_length += vec.iov_len;
+        if (total_length > INT32_MAX)
+            return -EINVAL;
+    }
+    if (total_length == 0)
+        return 0;
+
+    auto* description = file_description(fd);
+    if (!description)
+        return -EBADF;
+    if (!description->is_readable())
+        return -EBADF;
+    if (description->is_directory())
+        return -EISDIR;
+    if (description->is_blocking()) {
+        if (!description->can_read()) {
+            if (current->block<Thread::ReadBlocker>(*description) == Thread::BlockResult::InterruptedBySignal)
+                return -EINTR;
+        }
+    }
+    return description->readv(vecs.data(), vecs.size());
+}
+
 ssize_t Process::do_write(FileDescription& description, const u8* data, int data_size)
 {
     ssize_t nwritten = 0;
@@ -1353,6 +1645,9 @@ ssize_t Process::do_write(FileDescription& description, const u8* data, int data
         dbgprintf("while %u < %u\n", nwritten, size);
 #endif
         if (!description.can_write()) {
+            // A non-blocking write takes whatever fits and leaves it at that.
+            if (!description.is_blocking())
+                break;
 #ifdef IO_DEBUG
             dbgprintf("block write on %d\n", fd);
 #endif
@@ -1424,6 +1719,167 @@ ssize_t Process::sys$read(int fd, u8* buffer, ssize_t size)
     return description->read(buffer, size);
 }
 
+static bool is_seekable_for_transfer(FileDescription& description)
+{
+    return description.inode() && description.inode()->metadata().is_regular_file();
+}
+
+ssize_t Process::do_transfer(FileDescription& out_description, off_t* out_offset, FileDescription& in_description, off_t* in_offset, size_t count, bool nonblocking)
+{
+    // NOTE: Data moves from one file to the other through a kernel buffer, without ever visiting userspace.
+    auto& buffer = current->transfer_buffer();
+
+    // A stream can't take back what we've read from it, so if the output might not take all
+    // of a chunk, we only read as much as the output has room for.
+    bool input_is_stream = !in_offset && !in_description.file().is_seekable();
+    bool output_may_come_up_short = !out_offset && (nonblocking || !out_description.is_blocking());
+
+    ssize_t ntransferred = 0;
+    while ((size_t)ntransferred < count) {
+        size_t chunk_size = min(count - ntransferred, buffer.size());
+        if (input_is_stream && output_may_come_up_short) {
+            chunk_size = min(chunk_size, out_description.file().write_capacity(out_description));
+            if (!chunk_size)
+                return ntransferred ? ntransferred : -EAGAIN;
+        }
+
+        ssize_t nread;
+        if (in_offset) {
+            nread = in_description.inode()->read_bytes(*in_offset, chunk_size, buffer.data(), &in_description);
+        } else {
+            if (!in_description.can_read()) {
+                // Don't wait for more input if we already have something to show for ourselves.
+                if (ntransferred)
+                    break;
+                if (nonblocking || !in_description.is_blocking())
+                    return -EAGAIN;
+                if (current->block<Thread::ReadBlocker>(in_description) == Thread::BlockResult::InterruptedBySignal)
+                    return -EINTR;
+            }
+            nread = in_description.read(buffer.data(), chunk_size);
+        }
+        if (nread < 0)
+            return ntransferred ? ntransferred : nread;
+        if (nread == 0)
+            break;
+
+        ssize_t nwritten;
+        if (out_offset) {
+            nwritten = out_description.inode()->write_bytes(*out_offset, nread, buffer.data(), &out_description);
+        } else if (nonblocking && !out_description.can_write()) {
+            nwritten = -EAGAIN;
+        } else {
+            nwritten = do_write(out_description, buffer.data(), nread);
+        }
+
+        // Whatever didn't make it out of a seekable input gets read again next time.
+        // NOTE: A stream input only comes up short here if someone else filled up the output
+        //       in the meantime (or it failed), and then the rest of the chunk is lost.
+        ssize_t nconsumed = max(nwritten, (ssize_t)0);
+        if (!in_offset && !input_is_stream && nconsumed < nread)
+            in_description.seek(nconsumed - nread, SEEK_CUR);
+
+        if (nwritten < 0)
+            return ntransferred ? ntransferred : nwritten;
+
+        if (in_offset)
+            *in_offset += nwritten;
+        if (out_offset)
+            *out_offset += nwritten;
+        ntransferred += nwritten;
+        if (nwritten < nread)
+            break;
+    }
+    return ntransferred;
+}
+
+ssize_t Process::sys$sendfile(const Syscall::SC_sendfile_params* user_params)
+{
+    if (!validate_read_typed(user_params))
+        return -EFAULT;
+    Syscall::SC_sendfile_params params;
+    copy_from_user(&params, user_params, sizeof(params));
+
+    if (params.count > INT32_MAX)
+        return -EINVAL;
+    if (params.offset && !validate_write_typed(params.offset))
+        return -EFAULT;
+
+    auto* out_description = file_description(params.out_fd);
+    auto* in_description = file_description(params.in_fd);
+    if (!out_description || !in_description)
+        return -EBADF;
+    if (!out_description->is_writable() || !in_description->is_readable())
+        return -EBADF;
+    if (in_description->is_directory())
+        return -EISDIR;
+    if (!params.count)
+        return 0;
+
+    if (!params.offset)
+        return do_transfer(*out_description, nullptr, *in_description, nullptr, params.count, false);
+
+    // With an explicit offset, we read from there and leave the file offset of in_fd alone.
+    if (!is_seekable_for_transfer(*in_description))
+        return -ESPIPE;
+    off_t offset;
+    copy_from_user(&offset, params.offset, sizeof(offset));
+    if (offset < 0)
+        return -EINVAL;
+    auto rc = do_transfer(*out_description, nullptr, *in_description, &offset, params.count, false);
+    copy_to_user(params.offset, &offset, sizeof(offset));
+    return rc;
+}
+
+ssize_t Process::sys$splice(const Syscall::SC_splice_params* user_params)
+{
+    if (!validate_read_typed(user_params))
+        return -EFAULT;
+    Syscall::SC_splice_params params;
+    copy_from_user(&params, user_params, sizeof(params));
+
+    if (params.length > INT32_MAX)
+        return -EINVAL;
+    if (params.flags & ~(SPLICE_F_MOVE | SPLICE_F_NONBLOCK | SPLICE_F_MORE))
+        return -EINVAL;
+    if (params.off_in && !validate_write_typed(params.off_in))
+        return -EFAULT;
+    if (params.off_out && !validate_write_typed(params.off_out))
+        return -EFAULT;
+
+    auto* in_description = file_description(params.fd_in);
+    auto* out_description = file_description(params.fd_out);
+    if (!in_description || !out_description)
+        return -EBADF;
+    if (!in_description->is_readable() || !out_description->is_writable())
+        return -EBADF;
+    // One end of a splice has to be a pipe.
+    if (!in_description->is_fifo() && !out_description->is_fifo())
+        return -EINVAL;
+    if (in_description->is_directory())
+        return -EISDIR;
+    if ((params.off_in && !is_seekable_for_transfer(*in_description)) || (params.off_out && !is_seekable_for_transfer(*out_description)))
+        return -ESPIPE;
+    if (!params.length)
+        return 0;
+
+    off_t in_offset = 0;
+    off_t out_offset = 0;
+    if (params.off_in)
+        copy_from_user(&in_offset, params.off_in, sizeof(in_offset));
+    if (params.off_out)
+        copy_from_user(&out_offset, params.off_out, sizeof(out_offset));
+    if (in_offset < 0 || out_offset < 0)
+        return -EINVAL;
+
+    auto rc = do_transfer(*out_description, params.off_out ? &out_offset : nullptr, *in_description, params.off_in ? &in_offset : nullptr, params.length, params.flags & SPLICE_F_NONBLOCK);
+    if (params.off_in)
+        copy_to_user(params.off_in, &in_offset, sizeof(in_offset));
+    if (params.off_out)
+        copy_to_user(params.off_out, &out_offset, sizeof(out_offset));
+    return rc;
+}
+
 int Process::sys$close(int fd)
 {
     auto* description = file_description(fd);
@@ -2134,15 +2590,6 @@ pid_t Process::sys$getpgrp()
     return m_pgid;
 }
 
-static pid_t get_sid_from_pgid(pid_t pgid)
-{
-    InterruptDisabler disabler;
-    auto* group_leader = Process::from_pid(pgid);
-    if (!group_leader)
-        return -1;
-    return group_leader->sid();
-}
-
 int Process::sys$setpgid(pid_t specified_pid, pid_t specified_pgid)
 {
     InterruptDisabler disabler; // FIXME: Use a ProcessHandle
@@ -2511,6 +2958,107 @@ int Process::sys$poll(pollfd* fds, int nfds, int timeout)
     return fds_with_revents;
 }
 
+int Process::sys$epoll_create(int flags)
+{
+    if (flags & ~EPOLL_CLOEXEC)
+        return -EINVAL;
+
+    int fd = alloc_fd();
+    if (fd < 0)
+        return fd;
+
+    m_fds[fd].set(FileDescription::create(*EventQueue::create()), (flags & EPOLL_CLOEXEC) ? FD_CLOEXEC : 0);
+    m_fds[fd].description->set_readable(true);
+    return fd;
+}
+
+int Process::sys$epoll_ctl(const Syscall::SC_epoll_ctl_params* user_params)
+{
+    if (!validate_read_typed(user_params))
+        return -EFAULT;
+
+    Syscall::SC_epoll_ctl_params params;
+    copy_from_user(&params, user_params, sizeof(params));
+
+    RefPtr<FileDescription> queue_description = file_description(params.epfd);
+    if (!queue_description)
+        return -EBADF;
+    if (!queue_description->file().is_event_queue())
+        return -EINVAL;
+    auto& queue = static_cast<EventQueue&>(queue_description->file());
+
+    RefPtr<FileDescription> description = file_description(params.fd);
+    if (!description)
+        return -EBADF;
+
+    epoll_event event;
+    if (params.op != EPOLL_CTL_DEL) {
+        if (!validate_read_typed(params.event))
+            return -EFAULT;
+        copy_from_user(&event, params.event, sizeof(event));
+    }
+
+    switch (params.op) {
+    case EPOLL_CTL_ADD:
+        return queue.add(params.fd, *description, event);
+    case EPOLL_CTL_MOD:
+        return queue.modify(params.fd, *description, event);
+    case EPOLL_CTL_DEL:
+        return queue.remove(params.fd, *description);
+    default:
+        return -EINVAL;
+    }
+}
+
+int Process::sys$epoll_wait(const Syscall::SC_epoll_wait_params* user_params)
+{
+    if (!validate_read_typed(user_params))
+        return -EFAULT;
+
+    Syscall::SC_epoll_wait_params params;
+    copy_from_user(&params, user_params, sizeof(params));
+
+    if (params.max_events <= 0)
+        return -EINVAL;
+    if (!validate_write_typed(params.events, params.max_events))
+        return -EFAULT;
+
+    RefPtr<FileDescription> queue_description = file_description(params.epfd);
+    if (!queue_description)
+        return -EBADF;
+    if (!queue_description->file().is_event_queue())
+        return -EINVAL;
+    auto& queue = static_cast<EventQueue&>(queue_description->file());
+
+    timeval deadline { 0, 0 };
+    bool has_timeout = params.timeout >= 0;
+    if (has_timeout) {
+        timeval timeout { (time_t)(params.timeout / 1000), (params.timeout % 1000) * 1000 };
+        timeval_add(kgettimeofday(), timeout, deadline);
+    }
+
+    // NOTE: We collect into a kernel buffer, since collecting happens partly with interrupts disabled.
+    Vector<epoll_event, 32> events;
+    events.resize(min(params.max_events, 256));
+
+    for (;;) {
+        int count = queue.collect(events.data(), events.size());
+        if (count) {
+            copy_to_user(params.events, events.data(), count * sizeof(epoll_event));
+            return count;
+        }
+        if (has_timeout) {
+            auto now = kgettimeofday();
+            if (now.tv_sec > deadline.tv_sec || (now.tv_sec == deadline.tv_sec && now.tv_usec >= deadline.tv_usec))
+                return 0;
+        }
+        // NOTE: We may also wake up for level-triggered watches that have since gone quiet,
+        //       in which case we go back to sleep until something actually happens.
+        if (current->block<Thread::EventQueueBlocker>(queue, deadline, has_timeout) == Thread::BlockResult::InterruptedBySignal)
+            return -EINTR;
+    }
+}
+
 Custody& Process::current_directory()
 {
     if (!m_cwd)
@@ -2893,16 +3441,201 @@ ssize_t Process::sys$recvfrom(const Syscall::SC_recvfrom_params* params)
     if (!description->is_socket())
         return -ENOTSOCK;
     auto& socket = *description->socket();
+    return socket.recvfrom(*description, buffer, buffer_length, flags, addr, addr_length);
+}
 
-    bool original_blocking = description->is_blocking();
-    if (flags & MSG_DONTWAIT)
-        description->set_blocking(false);
+// Copies a message's iovecs in from userspace, and makes sure they can be accessed the way we want.
+static KResultOr<size_t> copy_message_iovecs_from_user(Process& process, const msghdr& message, Vector<iovec, 32>& vecs, bool for_writing)
+{
+    if (message.msg_iovlen < 0)
+        return KResult(-EINVAL);
+    if (!process.validate_read_typed(message.msg_iov, message.msg_iovlen))
+        return KResult(-EFAULT);
+    vecs.resize(message.msg_iovlen);
+    copy_from_user(vecs.data(), message.msg_iov, message.msg_iovlen * sizeof(iovec));
+    u64 total_length = 0;
+    for (auto& vec : vecs) {
+        if (for_writing ? !process.validate_write(vec.iov_base, vec.iov_len) : !process.validate_read(vec.iov_base, vec.iov_len))
+            return KResult(-EFAULT);
+        total_length += vec.iov_len;
+        if (total_length > INT32_MAX)
+            return KResult(-EINVAL);
+    }
+    return (size_t)total_length;
+}
+
+ssize_t Process::sys$sendmsg(int sockfd, const struct msghdr* user_message, int flags)
+{
+    if (!validate_read_typed(user_message))
+        return -EFAULT;
+    msghdr message;
+    copy_from_user(&message, user_message, sizeof(message));
+
+    Vector<iovec, 32> vecs;
+    auto total_length_or_error = copy_message_iovecs_from_user(*this, message, vecs, false);
+    if (total_length_or_error.is_error())
+        return total_length_or_error.error();
+
+    // FIXME: Support sending to an address.
+    if (message.msg_name)
+        return -EOPNOTSUPP;
+
+    auto* description = file_description(sockfd);
+    if (!description)
+        return -EBADF;
+    if (!description->is_socket())
+        return -ENOTSOCK;
+    auto& socket = *description->socket();
+
+    NonnullRefPtrVector<FileDescription> passed_descriptions;
+    if (message.msg_controllen) {
+        if (!socket.is_local())
+            return -EOPNOTSUPP;
+        // The descriptions travel with the data, so there has to be some.
+        if (!total_length_or_error.value())
+            return -EINVAL;
+        if (message.msg_controllen > PAGE_SIZE)
+            return -ENOBUFS;
+        if (!validate_read(message.msg_control, message.msg_controllen))
+            return -EFAULT;
+        auto control = ByteBuffer::create_uninitialized(message.msg_controllen);
+        copy_from_user(control.data(), message.msg_control, message.msg_controllen);
+
+        for (size_t offset = 0; offset + sizeof(cmsghdr) <= message.msg_controllen;) {
+            auto& header = *(const cmsghdr*)(control.data() + offset);
+            if (header.cmsg_len < CMSG_LEN(0) || header.cmsg_len > message.msg_controllen - offset)
+                return -EINVAL;
+            if (header.cmsg_level != SOL_SOCKET || header.cmsg_type != SCM_RIGHTS)
+                return -EINVAL;
+            auto* fds = (const int*)(control.data() + offset + CMSG_LEN(0));
+            for (size_t i = 0; i < (header.cmsg_len - CMSG_LEN(0)) / sizeof(int); ++i) {
+                auto* passed_description = file_description(fds[i]);
+                if (!passed_description)
+                    return -EBADF;
+                passed_descriptions.append(*passed_description);
+            }
+            offset += CMSG_ALIGN(header.cmsg_len);
+        }
+    }
+
+    // NOTE: MSG_DONTWAIT only applies to this call, so it's passed down rather than
+    //       flipping the blocking flag on a description that other processes may share.
+    if (socket.is_local()) {
+        bool nonblocking = !description->is_blocking() || (flags & MSG_DONTWAIT);
+        return static_cast<LocalSocket&>(socket).sendmsg(*description, vecs.data(), vecs.size(), passed_descriptions, nonblocking);
+    }
+
+    ssize_t nwritten = 0;
+    for (auto& vec : vecs) {
+        ssize_t rc = socket.sendto(*description, vec.iov_base, vec.iov_len, flags, nullptr, 0);
+        if (rc < 0) {
+            if (nwritten == 0)
+                return rc;
+            return nwritten;
+        }
+        nwritten += rc;
+        if ((size_t)rc < vec.iov_len)
+            break;
+    }
+    return nwritten;
+}
+
+ssize_t Process::sys$recvmsg(int sockfd, struct msghdr* user_message, int flags)
+{
+    if (!validate_write_typed(user_message))
+        return -EFAULT;
+    msghdr message;
+    copy_from_user(&message, user_message, sizeof(message));
+
+    Vector<iovec, 32> vecs;
+    auto total_length_or_error = copy_message_iovecs_from_user(*this, message, vecs, true);
+    if (total_length_or_error.is_error())
+        return total_length_or_error.error();
+    if (message.msg_controllen && !validate_write(message.msg_control, message.msg_controllen))
+        return -EFAULT;
+
+    auto* description = file_description(sockfd);
+    if (!description)
+        return -EBADF;
+    if (!description->is_socket())
+        return -ENOTSOCK;
+    auto& socket = *description->socket();
+
+    int message_flags = 0;
+    socklen_t control_length = 0;
+    ssize_t nread = 0;
+    if (socket.is_local()) {
+        int max_count = message.msg_controllen >= CMSG_LEN(0) ? (message.msg_controllen - CMSG_LEN(0)) / sizeof(int) : 0;
+        bool nonblocking = !description->is_blocking() || (flags & MSG_DONTWAIT);
+        bool truncated = false;
+        NonnullRefPtrVector<FileDescription> passed_descriptions;
+        nread = static_cast<LocalSocket&>(socket).recvmsg(*description, vecs.data(), vecs.size(), passed_descriptions, max_count, truncated, nonblocking);
+        if (nread < 0)
+            return nread;
+        if (truncated)
+            message_flags |= MSG_CTRUNC;
+
+        Vector<int> fds;
+        for (auto& passed_description : passed_descriptions) {
+            int fd = alloc_fd();
+            if (fd < 0) {
+                // We're out of file descriptors, so the rest are lost.
+                message_flags |= MSG_CTRUNC;
+                break;
+            }
+            m_fds[fd].set(passed_description);
+            fds.append(fd);
+        }
+
+        if (!fds.is_empty()) {
+            cmsghdr header;
+            header.cmsg_len = CMSG_LEN(fds.size() * sizeof(int));
+            header.cmsg_level = SOL_SOCKET;
+            header.cmsg_type = SCM_RIGHTS;
+            copy_to_user(message.msg_control, &header, sizeof(header));
+            copy_to_user((u8*)message.msg_control + CMSG_LEN(0), fds.data(), fds.size() * sizeof(int));
+            control_length = header.cmsg_len;
+        }
+    } else {
+        for (auto& vec : vecs) {
+            ssize_t rc = socket.recvfrom(*description, vec.iov_base, vec.iov_len, flags, nullptr, nullptr);
+            if (rc < 0) {
+                if (nread == 0)
+                    return rc;
+                break;
+            }
+            nread += rc;
+            if ((size_t)rc < vec.iov_len)
+                break;
+        }
+    }
+
+    copy_to_user(&user_message->msg_controllen, &control_length, sizeof(control_length));
+    copy_to_user(&user_message->msg_flags, &message_flags, sizeof(message_flags));
+    if (message.msg_name) {
+        socklen_t name_length = 0;
+        copy_to_user(&user_message->msg_namelen, &name_length, sizeof(name_length));
+    }
+    return nread;
+}
 
-    auto nrecv = socket.recvfrom(*description, buffer, buffer_length, flags, addr, addr_length);
-    if (flags & MSG_DONTWAIT)
-        description->set_blocking(original_blocking);
+int Process::sys$memfd_create(const char* user_name, size_t name_length, unsigned flags)
+{
+    if (flags & ~MFD_CLOEXEC)
+        return -EINVAL;
+    if (!validate_read(user_name, name_length))
+        return -EFAULT;
+    auto name = copy_string_from_user(user_name, name_length);
 
-    return nrecv;
+    int fd = alloc_fd();
+    if (fd < 0)
+        return fd;
+
+    auto description = FileDescription::create(*AnonymousFile::create(name));
+    description->set_readable(true);
+    description->set_writable(true);
+    m_fds[fd].set(move(description), (flags & MFD_CLOEXEC) ? FD_CLOEXEC : 0);
+    return fd;
 }
 
 int Process::sys$getsockname(int sockfd, sockaddr* addr, socklen_t* addrlen)
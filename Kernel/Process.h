@@ -126,6 +126,9 @@ public:
     ssize_t sys$read(int fd, u8*, ssize_t);
     ssize_t sys$write(int fd, const u8*, ssize_t);
     ssize_t sys$writev(int fd, const struct iovec* iov, int iov_count);
+    ssize_t sys$readv(int fd, const struct iovec* iov, int iov_count);
+    ssize_t sys$sendfile(const Syscall::SC_sendfile_params*);
+    ssize_t sys$splice(const Syscall::SC_splice_params*);
     int sys$fstat(int fd, stat*);
     int sys$lstat(const char*, size_t, stat*);
     int sys$stat(const char*, size_t, stat*);
@@ -140,8 +143,13 @@ public:
     int sys$mprotect(void*, size_t, int prot);
     int sys$madvise(void*, size_t, int advice);
     int sys$purge(int mode);
+    int sys$swapon(const char* path);
     int sys$select(const Syscall::SC_select_params*);
     int sys$poll(pollfd*, int nfds, int timeout);
+    int sys$epoll_create(int flags);
+    int sys$epoll_ctl(const Syscall::SC_epoll_ctl_params*);
+    int sys$epoll_wait(const Syscall::SC_epoll_wait_params*);
+    int sys$memfd_create(const char* name, size_t name_length, unsigned flags);
     ssize_t sys$get_dir_entries(int fd, void*, ssize_t);
     int sys$getcwd(char*, ssize_t);
     int sys$chdir(const char*, size_t);
@@ -158,6 +166,7 @@ public:
     int sys$ptsname_r(int fd, char*, ssize_t);
     pid_t sys$fork(RegisterDump&);
     int sys$execve(const char* filename, const char** argv, const char** envp);
+    pid_t sys$spawn(const Syscall::SC_spawn_params*);
     int sys$getdtablesize();
     int sys$dup(int oldfd);
     int sys$dup2(int oldfd, int newfd);
@@ -194,6 +203,8 @@ public:
     int sys$connect(int sockfd, const sockaddr*, socklen_t);
     ssize_t sys$sendto(const Syscall::SC_sendto_params*);
     ssize_t sys$recvfrom(const Syscall::SC_recvfrom_params*);
+    ssize_t sys$sendmsg(int sockfd, const struct msghdr*, int flags);
+    ssize_t sys$recvmsg(int sockfd, struct msghdr*, int flags);
     int sys$getsockopt(const Syscall::SC_getsockopt_params*);
     int sys$setsockopt(const Syscall::SC_setsockopt_params*);
     int sys$getsockname(int sockfd, sockaddr* addr, socklen_t* addrlen);
@@ -316,12 +327,14 @@ private:
     Process(Thread*& first_thread, const String& name, uid_t, gid_t, pid_t ppid, RingLevel, RefPtr<Custody> cwd = nullptr, RefPtr<Custody> executable = nullptr, TTY* = nullptr, Process* fork_parent = nullptr);
     static pid_t allocate_pid();
 
-    Range allocate_range(VirtualAddress, size_t);
+    Range allocate_range(VirtualAddress, size_t, size_t alignment = PAGE_SIZE);
 
     int do_exec(String path, Vector<String> arguments, Vector<String> environment);
     ssize_t do_write(FileDescription&, const u8*, int data_size);
+    ssize_t do_transfer(FileDescription& out_description, off_t* out_offset, FileDescription& in_description, off_t* in_offset, size_t count, bool nonblocking);
 
     int alloc_fd(int first_candidate_fd = 0);
+    KResult apply_spawn_file_action(const Syscall::SC_spawn_file_action&);
     void disown_all_shared_buffers();
 
     KResultOr<Vector<String>> find_shebang_interpreter_for_executable(const String& executable_path);
@@ -0,0 +1,87 @@
+#include <AK/StdLibExtras.h>
+#include <Kernel/RingBuffer.h>
+
+RingBuffer::RingBuffer(size_t capacity)
+    : m_storage(KBuffer::create_with_size(capacity))
+    , m_capacity(capacity)
+{
+    ASSERT(capacity && !(capacity & (capacity - 1)));
+}
+
+ssize_t RingBuffer::write(const iovec* vecs, int iov_count, size_t offset, bool allow_partial, u32* out_position)
+{
+    LOCKER(m_write_lock);
+    // NOTE: Only writers move the tail, and we're the only writer right now.
+    u32 tail = m_tail.load(AK::memory_order_relaxed);
+    u32 head = m_head.load(AK::memory_order_acquire);
+    size_t available = m_capacity - (tail - head);
+
+    size_t wanted = total_length(vecs, iov_count) - offset;
+    if (wanted > available && !allow_partial)
+        return 0;
+    size_t remaining = min(wanted, available);
+    size_t nwritten = 0;
+
+    for (int i = 0; i < iov_count && remaining; ++i) {
+        auto* data = (const u8*)vecs[i].iov_base;
+        size_t length = vecs[i].iov_len;
+        if (offset >= length) {
+            offset -= length;
+            continue;
+        }
+        data += offset;
+        length = min(length - offset, remaining);
+        offset = 0;
+
+        size_t index = (tail + nwritten) & (m_capacity - 1);
+        size_t first_chunk = min(length, m_capacity - index);
+        memcpy(m_storage.data() + index, data, first_chunk);
+        memcpy(m_storage.data(), data + first_chunk, length - first_chunk);
+        nwritten += length;
+        remaining -= length;
+    }
+
+    // Publish the data only once it's all in place.
+    m_tail.store(tail + nwritten, AK::memory_order_release);
+    if (out_position)
+        *out_position = tail;
+    return nwritten;
+}
+
+ssize_t RingBuffer::write(const u8* data, ssize_t size)
+{
+    iovec vec { const_cast<u8*>(data), (size_t)size };
+    return write(&vec, 1);
+}
+
+ssize_t RingBuffer::read(const iovec* vecs, int iov_count, size_t max_length)
+{
+    LOCKER(m_read_lock);
+    // NOTE: Only readers move the head, and we're the only reader right now.
+    u32 head = m_head.load(AK::memory_order_relaxed);
+    u32 tail = m_tail.load(AK::memory_order_acquire);
+    size_t remaining = min((size_t)(tail - head), max_length);
+    size_t nread = 0;
+
+    for (int i = 0; i < iov_count && remaining; ++i) {
+        auto* data = (u8*)vecs[i].iov_base;
+        size_t length = min(vecs[i].iov_len, remaining);
+
+        size_t index = (head + nread) & (m_capacity - 1);
+        size_t first_chunk = min(length, m_capacity - index);
+        memcpy(data, m_storage.data() + index, first_chunk);
+        memcpy(data + first_chunk, m_storage.data(), length - first_chunk);
+        nread += length;
+        remaining -= length;
+    }
+
+    // Hand the space back to the writers only once we're done copying out of it.
+    m_head.store(head + nread, AK::memory_order_release);
+    return nread;
+}
+
+ssize_t RingBuffer::read(u8* data, ssize_t size)
+{
+    iovec vec { data, (size_t)size };
+    return read(&vec, 1);
+}
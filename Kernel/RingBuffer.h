@@ -0,0 +1,66 @@
+#pragma once
+
+// RingBuffer: Fixed-capacity byte queue between a producer and a consumer.
+//
+// The storage is a single KBuffer that is allocated up front and never grows.
+// Writers only ever move the tail and readers only ever move the head, so a writer
+// and a reader can copy data in and out at the same time without waiting for each
+// other. Several writers (or several readers) on the same buffer are serialized
+// by a lock on their own side.
+//
+// When the buffer is full, write() copies in whatever fits and reports how much
+// that was; it is up to the caller to block until there is room for the rest.
+
+#include <AK/Atomic.h>
+#include <AK/Types.h>
+#include <Kernel/KBuffer.h>
+#include <Kernel/Lock.h>
+#include <Kernel/UnixTypes.h>
+
+class RingBuffer {
+public:
+    // NOTE: The capacity must be a power of two.
+    explicit RingBuffer(size_t capacity);
+
+    size_t capacity() const { return m_capacity; }
+    size_t used_bytes() const { return m_tail.load(AK::memory_order_acquire) - m_head.load(AK::memory_order_acquire); }
+    size_t free_bytes() const { return m_capacity - used_bytes(); }
+    bool is_empty() const { return used_bytes() == 0; }
+    bool is_full() const { return used_bytes() == m_capacity; }
+
+    // The free-running stream positions of the next byte to be read and written.
+    // They wrap around, so only ever compare them by subtracting one from the other.
+    u32 read_position() const { return m_head.load(AK::memory_order_acquire); }
+    u32 write_position() const { return m_tail.load(AK::memory_order_acquire); }
+
+    // Copies the contents of `vecs`, minus the first `offset` bytes, into the buffer.
+    // Copies as much as fits if `allow_partial` is set, and nothing at all if the whole
+    // thing doesn't fit otherwise. Returns the number of bytes copied, and if asked,
+    // the stream position they were copied to.
+    ssize_t write(const iovec* vecs, int iov_count, size_t offset = 0, bool allow_partial = true, u32* out_position = nullptr);
+    ssize_t write(const u8*, ssize_t);
+
+    // Fills `vecs` in order with as much as is available, but no more than `max_length`.
+    // Returns the number of bytes copied.
+    ssize_t read(const iovec* vecs, int iov_count, size_t max_length = 0xffffffff);
+    ssize_t read(u8*, ssize_t);
+
+private:
+    KBuffer m_storage;
+    size_t m_capacity { 0 };
+
+    // Free-running positions; they are only ever masked when indexing into the storage.
+    Atomic<u32> m_head { 0 };
+    Atomic<u32> m_tail { 0 };
+
+    Lock m_write_lock { "RingBuffer::write" };
+    Lock m_read_lock { "RingBuffer::read" };
+};
+
+inline size_t total_length(const iovec* vecs, int iov_count)
+{
+    size_t length = 0;
+    for (int i = 0; i < iov_count; ++i)
+        length += vecs[i].iov_len;
+    return length;
+}
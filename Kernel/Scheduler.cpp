@@ -1,6 +1,7 @@
 #include <AK/QuickSort.h>
 #include <AK/TemporaryChange.h>
 #include <Kernel/Arch/i386/PIT.h>
+#include <Kernel/FileSystem/EventQueue.h>
 #include <Kernel/FileSystem/FileDescription.h>
 #include <Kernel/Process.h>
 #include <Kernel/Profiling.h>
@@ -190,6 +191,25 @@ bool Thread::SelectBlocker::should_unblock(Thread& thread, time_t now_sec, long
     return false;
 }
 
+Thread::EventQueueBlocker::EventQueueBlocker(EventQueue& queue, const timeval& timeout, bool has_timeout)
+    : m_queue(queue)
+    , m_timeout(timeout)
+    , m_has_timeout(has_timeout)
+{
+}
+
+bool Thread::EventQueueBlocker::should_unblock(Thread&, time_t now_sec, long now_usec)
+{
+    if (m_has_timeout) {
+        if (now_sec > m_timeout.tv_sec || (now_sec == m_timeout.tv_sec && now_usec >= m_timeout.tv_usec))
+            return true;
+    }
+    // NOTE: This is cheap for files that tell the queue when they become ready;
+    //       only the ones that don't need to be looked at each time.
+    m_queue.poll_unnotified_watches();
+    return m_queue.has_queued_watches();
+}
+
 Thread::WaitBlocker::WaitBlocker(int wait_options, pid_t& waitee_pid)
     : m_wait_options(wait_options)
     , m_waitee_pid(waitee_pid)
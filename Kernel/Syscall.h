@@ -7,6 +7,7 @@
 #endif
 
 extern "C" {
+struct epoll_event;
 struct timeval;
 struct timespec;
 struct sockaddr;
@@ -153,7 +154,18 @@ typedef u32 socklen_t;
     __ENUMERATE_SYSCALL(get_kernel_info_page)       \
     __ENUMERATE_SYSCALL(futex)                      \
     __ENUMERATE_SYSCALL(set_thread_boost)           \
-    __ENUMERATE_SYSCALL(set_process_boost)
+    __ENUMERATE_SYSCALL(set_process_boost)          \
+    __ENUMERATE_SYSCALL(spawn)                      \
+    __ENUMERATE_SYSCALL(swapon)                     \
+    __ENUMERATE_SYSCALL(sendfile)                   \
+    __ENUMERATE_SYSCALL(splice)                     \
+    __ENUMERATE_SYSCALL(epoll_create)               \
+    __ENUMERATE_SYSCALL(epoll_ctl)                  \
+    __ENUMERATE_SYSCALL(epoll_wait)                 \
+    __ENUMERATE_SYSCALL(readv)                      \
+    __ENUMERATE_SYSCALL(sendmsg)                    \
+    __ENUMERATE_SYSCALL(recvmsg)                    \
+    __ENUMERATE_SYSCALL(memfd_create)
 
 namespace Syscall {
 
@@ -223,6 +235,20 @@ struct SC_select_params {
     struct timeval* timeout;
 };
 
+struct SC_epoll_ctl_params {
+    int epfd;
+    int op;
+    int fd;
+    struct epoll_event* event;
+};
+
+struct SC_epoll_wait_params {
+    int epfd;
+    struct epoll_event* events;
+    int max_events;
+    int timeout;
+};
+
 struct SC_clock_nanosleep_params {
     int clock_id;
     int flags;
@@ -306,6 +332,52 @@ struct SC_set_mmap_name_params {
     size_t name_length;
 };
 
+enum class SpawnFileActionType : u32 {
+    Open,
+    Close,
+    Dup2,
+    Chdir,
+};
+
+struct SC_spawn_file_action {
+    SpawnFileActionType type;
+    int fd;
+    int new_fd;
+    int options;
+    u16 mode;
+    const char* path;
+    size_t path_length;
+};
+
+struct SC_spawn_params {
+    const char* path;
+    size_t path_length;
+    const char** argv;
+    const char** envp;
+    const SC_spawn_file_action* file_actions;
+    size_t file_actions_count;
+    int flags;
+    i32 pgroup;
+    u32 sigdefault;
+    u32 sigmask;
+};
+
+struct SC_sendfile_params {
+    int out_fd;
+    int in_fd;
+    i32* offset;
+    size_t count;
+};
+
+struct SC_splice_params {
+    int fd_in;
+    i32* off_in;
+    int fd_out;
+    i32* off_out;
+    size_t length;
+    unsigned flags;
+};
+
 void initialize();
 int sync();
 
@@ -2,6 +2,7 @@
 #include <AK/StringBuilder.h>
 #include <Kernel/Arch/i386/CPU.h>
 #include <Kernel/FileSystem/FileDescription.h>
+#include <Kernel/KBuffer.h>
 #include <Kernel/Process.h>
 #include <Kernel/Scheduler.h>
 #include <Kernel/Thread.h>
@@ -573,10 +574,17 @@ ShouldUnblockThread Thread::dispatch_signal(u8 signal)
 
 void Thread::set_default_signal_dispositions()
 {
+    for (u8 signal = 0; signal < 32; ++signal)
+        set_default_signal_disposition(signal);
+}
+
+void Thread::set_default_signal_disposition(u8 signal)
+{
+    ASSERT(signal < 32);
     // FIXME: Set up all the right default actions. See signal(7).
-    memset(&m_signal_action_data, 0, sizeof(m_signal_action_data));
-    m_signal_action_data[SIGCHLD].handler_or_sigaction = VirtualAddress((u32)SIG_IGN);
-    m_signal_action_data[SIGWINCH].handler_or_sigaction = VirtualAddress((u32)SIG_IGN);
+    m_signal_action_data[signal] = {};
+    if (signal == SIGCHLD || signal == SIGWINCH)
+        m_signal_action_data[signal].handler_or_sigaction = VirtualAddress((u32)SIG_IGN);
 }
 
 void Thread::push_value_on_stack(u32 value)
@@ -797,6 +805,13 @@ void Thread::wake_from_queue()
     set_state(State::Runnable);
 }
 
+KBuffer& Thread::transfer_buffer()
+{
+    if (!m_transfer_buffer)
+        m_transfer_buffer = make<KBuffer>(KBuffer::create_with_size(64 * KB));
+    return *m_transfer_buffer;
+}
+
 Thread* Thread::from_tid(int tid)
 {
     InterruptDisabler disabler;
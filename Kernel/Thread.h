@@ -14,7 +14,9 @@
 #include <LibC/fd_set.h>
 
 class Alarm;
+class EventQueue;
 class FileDescription;
+class KBuffer;
 class Process;
 class ProcessInspectionHandle;
 class Region;
@@ -73,6 +75,11 @@ public:
     Process& process() { return m_process; }
     const Process& process() const { return m_process; }
 
+    // The VFS checks permissions against (and hands new files to) the credentials of this process.
+    // That's our own process, except while sys$spawn is setting up a child on its behalf.
+    Process& credentials_process() { return m_credentials_process ? *m_credentials_process : m_process; }
+    void set_credentials_process(Process* process) { m_credentials_process = process; }
+
     String backtrace(ProcessInspectionHandle&) const;
     Vector<u32> raw_backtrace(u32 ebp) const;
 
@@ -201,6 +208,18 @@ public:
         const FDVector& m_select_exceptional_fds;
     };
 
+    class EventQueueBlocker final : public Blocker {
+    public:
+        EventQueueBlocker(EventQueue&, const timeval& timeout, bool has_timeout);
+        virtual bool should_unblock(Thread&, time_t, long) override;
+        virtual const char* state_string() const override { return "Waiting for events"; }
+
+    private:
+        EventQueue& m_queue;
+        timeval m_timeout;
+        bool m_has_timeout { false };
+    };
+
     class WaitBlocker final : public Blocker {
     public:
         WaitBlocker(int wait_options, pid_t& waitee_pid);
@@ -330,7 +349,11 @@ public:
 
     FPUState& fpu_state() { return *m_fpu_state; }
 
+    // Scratch space for sendfile() and splice(), kept around between calls.
+    KBuffer& transfer_buffer();
+
     void set_default_signal_dispositions();
+    void set_default_signal_disposition(u8 signal);
     void push_value_on_stack(u32);
 
     u32 make_userspace_stack_for_main_thread(Vector<String> arguments, Vector<String> environment);
@@ -345,6 +368,8 @@ public:
     void did_zero_fault() { ++m_zero_faults; }
     unsigned cow_faults() const { return m_cow_faults; }
     void did_cow_fault() { ++m_cow_faults; }
+    unsigned swap_faults() const { return m_swap_faults; }
+    void did_swap_fault() { ++m_swap_faults; }
 
     unsigned file_read_bytes() const { return m_file_read_bytes; }
     unsigned file_write_bytes() const { return m_file_write_bytes; }
@@ -414,6 +439,7 @@ private:
 
     String backtrace_impl() const;
     Process& m_process;
+    Process* m_credentials_process { nullptr };
     int m_tid { -1 };
     TSS32 m_tss;
     FarPtr m_far_ptr;
@@ -439,6 +465,7 @@ private:
     unsigned m_inode_faults { 0 };
     unsigned m_zero_faults { 0 };
     unsigned m_cow_faults { 0 };
+    unsigned m_swap_faults { 0 };
 
     unsigned m_file_read_bytes { 0 };
     unsigned m_file_write_bytes { 0 };
@@ -450,6 +477,7 @@ private:
     unsigned m_ipv4_socket_write_bytes { 0 };
 
     FPUState* m_fpu_state { nullptr };
+    OwnPtr<KBuffer> m_transfer_buffer;
     State m_state { Invalid };
     String m_name;
     u32 m_priority { THREAD_PRIORITY_NORMAL };
@@ -15,6 +15,8 @@ TimerQueue& TimerQueue::the()
 
 u64 TimerQueue::add_timer(NonnullOwnPtr<Timer>&& timer)
 {
+    // NOTE: The queue is also walked by the timer interrupt.
+    InterruptDisabler disabler;
     ASSERT(timer->expires > g_uptime);
 
     timer->id = ++m_timer_id_count;
@@ -40,6 +42,7 @@ u64 TimerQueue::add_timer(u64 duration, TimeUnit unit, Function<void()>&& callba
 
 bool TimerQueue::cancel_timer(u64 id)
 {
+    InterruptDisabler disabler;
     auto it = m_timer_queue.find([id](auto& timer) { return timer->id == id; });
     if (it.is_end())
         return false;
@@ -1,5 +1,7 @@
 #include <Kernel/VM/AnonymousVMObject.h>
+#include <Kernel/VM/MemoryManager.h>
 #include <Kernel/VM/PhysicalPage.h>
+#include <Kernel/VM/SwapArea.h>
 
 NonnullRefPtr<AnonymousVMObject> AnonymousVMObject::create_with_size(size_t size)
 {
@@ -18,6 +20,7 @@ AnonymousVMObject::AnonymousVMObject(size_t size)
 
 AnonymousVMObject::AnonymousVMObject(PhysicalAddress paddr, size_t size)
     : VMObject(size)
+    , m_physical_range(true)
 {
     ASSERT(paddr.page_base() == paddr.get());
     for (size_t i = 0; i < page_count(); ++i)
@@ -26,14 +29,104 @@ AnonymousVMObject::AnonymousVMObject(PhysicalAddress paddr, size_t size)
 
 AnonymousVMObject::AnonymousVMObject(const AnonymousVMObject& other)
     : VMObject(other)
+    , m_physical_range(other.m_physical_range)
 {
+    // The clone shares swapped-out pages with the original until one of them faults them back in.
+    if (!other.m_swap_slots.size())
+        return;
+    m_swap_slots.resize(other.m_swap_slots.size());
+    for (size_t i = 0; i < m_swap_slots.size(); ++i) {
+        m_swap_slots[i] = other.m_swap_slots[i];
+        if (m_swap_slots[i])
+            SwapArea::the()->ref_slot(m_swap_slots[i]);
+    }
 }
 
 AnonymousVMObject::~AnonymousVMObject()
 {
+    for (size_t i = 0; i < m_swap_slots.size(); ++i) {
+        if (m_swap_slots[i])
+            SwapArea::the()->unref_slot(m_swap_slots[i]);
+    }
 }
 
 NonnullRefPtr<VMObject> AnonymousVMObject::clone()
 {
     return adopt(*new AnonymousVMObject(*this));
 }
+
+bool AnonymousVMObject::swap_out_page(size_t page_index)
+{
+    ASSERT_INTERRUPTS_ENABLED();
+    auto* swap_area = SwapArea::the();
+    if (!swap_area)
+        return false;
+
+    // NOTE: We hold the paging lock until the page has hit the disk,
+    //       so anyone faulting on it will wait for us in handle_zero_fault().
+    LOCKER(m_paging_lock);
+    Locker swap_locker(swap_area->lock());
+
+    u8* page_buffer = swap_area->bounce_page();
+    RefPtr<PhysicalPage> physical_page;
+    u32 slot = 0;
+    {
+        InterruptDisabler disabler;
+        auto& entry = m_physical_pages[page_index];
+        // Pages shared with another VMObject (i.e COW after fork) stay resident.
+        if (m_physical_range || entry.is_null() || entry->ref_count() != 1)
+            return false;
+        slot = swap_area->allocate_slot();
+        if (!slot)
+            return false;
+        if (!m_swap_slots.size())
+            m_swap_slots.resize(page_count());
+        physical_page = move(entry);
+        m_swap_slots[page_index] = slot;
+        for_each_region([page_index](auto& region) {
+            region.remap_vmobject_page(page_index);
+        });
+        memcpy(page_buffer, MM.quickmap_page(*physical_page), PAGE_SIZE);
+        MM.unquickmap_page();
+    }
+
+    if (!swap_area->write_page(slot, page_buffer)) {
+        kprintf("AnonymousVMObject: Failed to write page to swap slot %u\n", slot);
+        InterruptDisabler disabler;
+        m_physical_pages[page_index] = move(physical_page);
+        m_swap_slots[page_index] = 0;
+        swap_area->unref_slot(slot);
+        for_each_region([page_index](auto& region) {
+            region.remap_vmobject_page(page_index);
+        });
+        return false;
+    }
+    return true;
+}
+
+bool AnonymousVMObject::swap_in_page(size_t page_index)
+{
+    ASSERT_INTERRUPTS_ENABLED();
+    ASSERT(m_paging_lock.is_locked());
+    u32 slot = swap_slot(page_index);
+    ASSERT(slot);
+
+    auto& swap_area = *SwapArea::the();
+    Locker swap_locker(swap_area.lock());
+    u8* page_buffer = swap_area.bounce_page();
+    if (!swap_area.read_page(slot, page_buffer)) {
+        kprintf("AnonymousVMObject: Failed to read page from swap slot %u\n", slot);
+        return false;
+    }
+
+    InterruptDisabler disabler;
+    auto physical_page = MM.allocate_user_physical_page(MemoryManager::ShouldZeroFill::No);
+    if (physical_page.is_null())
+        return false;
+    memcpy(MM.quickmap_page(*physical_page), page_buffer, PAGE_SIZE);
+    MM.unquickmap_page();
+    m_physical_pages[page_index] = move(physical_page);
+    m_swap_slots[page_index] = 0;
+    swap_area.unref_slot(slot);
+    return true;
+}
@@ -11,6 +11,15 @@ public:
     static NonnullRefPtr<AnonymousVMObject> create_for_physical_range(PhysicalAddress, size_t);
     virtual NonnullRefPtr<VMObject> clone() override;
 
+    // True if this VMObject is a fixed window onto physical memory, e.g a framebuffer.
+    bool is_physical_range() const { return m_physical_range; }
+
+    // Returns the SwapArea slot holding the contents of this page, or 0 if it's not swapped out.
+    u32 swap_slot(size_t page_index) const { return m_swap_slots.size() ? m_swap_slots[page_index] : 0; }
+
+    bool swap_out_page(size_t page_index);
+    bool swap_in_page(size_t page_index);
+
 protected:
     explicit AnonymousVMObject(size_t);
     explicit AnonymousVMObject(const AnonymousVMObject&);
@@ -23,4 +32,7 @@ private:
     AnonymousVMObject(AnonymousVMObject&&) = delete;
 
     virtual bool is_anonymous() const override { return true; }
+
+    FixedArray<u32> m_swap_slots;
+    bool m_physical_range { false };
 };
@@ -134,6 +134,14 @@ int InodeVMObject::release_all_clean_pages()
     return release_all_clean_pages_impl();
 }
 
+int InodeVMObject::release_all_clean_pages_with_interrupts_disabled(Badge<MemoryManager>)
+{
+    ASSERT_INTERRUPTS_DISABLED();
+    if (m_paging_lock.is_locked())
+        return 0;
+    return release_all_clean_pages_impl();
+}
+
 int InodeVMObject::release_all_clean_pages_impl()
 {
     int count = 0;
@@ -20,6 +20,7 @@ public:
     size_t amount_clean() const;
 
     int release_all_clean_pages();
+    int release_all_clean_pages_with_interrupts_disabled(Badge<MemoryManager>);
 
 private:
     explicit InodeVMObject(Inode&, size_t);
@@ -2,17 +2,22 @@
 #include "Process.h"
 #include "StdLib.h"
 #include <AK/Assertions.h>
+#include <AK/QuickSort.h>
 #include <AK/kstdio.h>
 #include <Kernel/Arch/i386/CPU.h>
+#include <Kernel/FileSystem/FileSystem.h>
 #include <Kernel/FileSystem/Inode.h>
 #include <Kernel/Multiboot.h>
+#include <Kernel/WaitQueue.h>
 #include <Kernel/VM/AnonymousVMObject.h>
 #include <Kernel/VM/InodeVMObject.h>
 #include <Kernel/VM/MemoryManager.h>
 #include <Kernel/VM/PurgeableVMObject.h>
+#include <Kernel/VM/SwapArea.h>
 
 //#define MM_DEBUG
 //#define PAGE_FAULT_DEBUG
+//#define RECLAIM_DEBUG
 
 static MemoryManager* s_the;
 
@@ -60,7 +65,10 @@ void MemoryManager::initialize_paging()
 #endif
     // The bottom 8 MB (except for the null page) are identity mapped & supervisor only.
     // Every process shares these mappings.
-    create_identity_mapping(kernel_page_directory(), VirtualAddress(PAGE_SIZE), (8 * MB) - PAGE_SIZE);
+    // The first 2 MB use small pages, since we need page granularity for the null page,
+    // the kernel image and quickmap. The rest is all kmalloc and friends, so we use large pages there.
+    create_identity_mapping(kernel_page_directory(), VirtualAddress(PAGE_SIZE), (2 * MB) - PAGE_SIZE);
+    create_large_identity_mapping(kernel_page_directory(), VirtualAddress(2 * MB), 6 * MB);
 
     // Disable execution from 0MB through 1MB (BIOS data, legacy things, ...)
     if (g_cpu_supports_nx) {
@@ -187,6 +195,11 @@ void MemoryManager::initialize_paging()
     for (auto& region : m_user_physical_regions)
         m_user_physical_pages += region.finalize_capacity();
 
+    m_critical_watermark = max(m_user_physical_pages / 64, 16u);
+    m_low_watermark = max(m_user_physical_pages / 16, 64u);
+    m_high_watermark = m_low_watermark * 2;
+    m_reclaim_wait_queue = new WaitQueue;
+
 #ifdef MM_DEBUG
     dbgprintf("MM: Installing page directory\n");
 #endif
@@ -254,6 +267,13 @@ void MemoryManager::initialize_paging()
 #endif
 }
 
+PageDirectoryEntry& MemoryManager::pde(PageDirectory& page_directory, VirtualAddress vaddr)
+{
+    u32 page_directory_table_index = (vaddr.get() >> 30) & 0x3;
+    u32 page_directory_index = (vaddr.get() >> 21) & 0x1ff;
+    return page_directory.table().directory(page_directory_table_index)[page_directory_index];
+}
+
 PageTableEntry& MemoryManager::ensure_pte(PageDirectory& page_directory, VirtualAddress vaddr)
 {
     ASSERT_INTERRUPTS_DISABLED();
@@ -261,8 +281,10 @@ PageTableEntry& MemoryManager::ensure_pte(PageDirectory& page_directory, Virtual
     u32 page_directory_index = (vaddr.get() >> 21) & 0x1ff;
     u32 page_table_index = (vaddr.get() >> 12) & 0x1ff;
 
-    PageDirectoryEntry& pde = page_directory.table().directory(page_directory_table_index)[page_directory_index];
-    if (!pde.is_present()) {
+    PageDirectoryEntry& pde = this->pde(page_directory, vaddr);
+    if (pde.is_huge()) {
+        split_large_page(page_directory, pde, vaddr);
+    } else if (!pde.is_present()) {
 #ifdef MM_DEBUG
         dbgprintf("MM: PDE %u not present (requested for V%p), allocating\n", page_directory_index, vaddr.get());
 #endif
@@ -295,6 +317,66 @@ PageTableEntry& MemoryManager::ensure_pte(PageDirectory& page_directory, Virtual
     return pde.page_table_base()[page_table_index];
 }
 
+void MemoryManager::split_large_page(PageDirectory& page_directory, PageDirectoryEntry& pde, VirtualAddress vaddr)
+{
+    ASSERT_INTERRUPTS_DISABLED();
+    ASSERT(pde.is_huge());
+    u32 page_directory_table_index = (vaddr.get() >> 30) & 0x3;
+    u32 page_directory_index = (vaddr.get() >> 21) & 0x1ff;
+
+    PageTableEntry* page_table;
+    RefPtr<PhysicalPage> physical_page;
+    bool is_low_kernel_pde = page_directory_table_index == 0 && page_directory_index < 4;
+    if (is_low_kernel_pde) {
+        ASSERT(&page_directory == m_kernel_page_directory);
+        page_table = m_low_page_tables[page_directory_index];
+    } else {
+        physical_page = allocate_supervisor_physical_page();
+        page_table = (PageTableEntry*)physical_page->paddr().as_ptr();
+    }
+
+#ifdef MM_DEBUG
+    dbgprintf("MM: Splitting large page V%p => P%p into a page table\n", vaddr.get() & LARGE_PAGE_MASK, pde.large_page_base());
+#endif
+
+    // Give every 4 KB page the same mapping and permissions the large page had.
+    u32 large_page_base = pde.large_page_base();
+    for (size_t i = 0; i < LARGE_PAGE_SIZE / PAGE_SIZE; ++i) {
+        auto& pte = page_table[i];
+        pte.clear();
+        pte.set_physical_page_base(large_page_base + i * PAGE_SIZE);
+        pte.set_user_allowed(pde.is_user_allowed());
+        pte.set_writable(pde.is_writable());
+        pte.set_write_through(pde.is_write_through());
+        pte.set_cache_disabled(pde.is_cache_disabled());
+        pte.set_global(pde.is_global());
+        pte.set_execute_disabled(pde.is_execute_disabled());
+        pte.set_present(true);
+    }
+
+    // The PTEs carry the permissions now, so the PDE itself only needs to allow everything.
+    bool is_global = pde.is_global();
+    bool is_user_allowed = pde.is_user_allowed();
+    pde.clear();
+    pde.set_page_table_base((u32)page_table);
+    pde.set_user_allowed(is_user_allowed);
+    pde.set_present(true);
+    pde.set_writable(true);
+    pde.set_global(is_global);
+    if (physical_page)
+        page_directory.m_physical_pages.set(page_directory_index, move(physical_page));
+
+    // Every process has its own copy of the low kernel PDEs. Point them all at the shared
+    // page table, so later permission changes in there reach every process too.
+    if (is_low_kernel_pde)
+        PageDirectory::sync_low_kernel_pde(page_directory_index);
+
+    // Large page translations may be cached with global bits set, so invlpg each page of it.
+    auto large_page_vaddr = VirtualAddress(vaddr.get() & LARGE_PAGE_MASK);
+    for (size_t offset = 0; offset < LARGE_PAGE_SIZE; offset += PAGE_SIZE)
+        page_directory.flush(large_page_vaddr.offset(offset));
+}
+
 void MemoryManager::map_protected(VirtualAddress vaddr, size_t length)
 {
     InterruptDisabler disabler;
@@ -325,6 +407,25 @@ void MemoryManager::create_identity_mapping(PageDirectory& page_directory, Virtu
     }
 }
 
+void MemoryManager::create_large_identity_mapping(PageDirectory& page_directory, VirtualAddress vaddr, size_t size)
+{
+    InterruptDisabler disabler;
+    ASSERT((vaddr.get() & ~LARGE_PAGE_MASK) == 0);
+    ASSERT((size & ~LARGE_PAGE_MASK) == 0);
+    for (u32 offset = 0; offset < size; offset += LARGE_PAGE_SIZE) {
+        auto large_page_address = vaddr.offset(offset);
+        auto& pde = this->pde(page_directory, large_page_address);
+        ASSERT(!pde.is_present());
+        pde.set_large_page_base(large_page_address.get());
+        pde.set_huge(true);
+        pde.set_user_allowed(false);
+        pde.set_present(true);
+        pde.set_writable(true);
+        pde.set_global(true);
+        page_directory.flush(large_page_address);
+    }
+}
+
 void MemoryManager::initialize(u32 physical_address_for_kernel_page_tables)
 {
     s_the = new MemoryManager(physical_address_for_kernel_page_tables);
@@ -440,6 +541,7 @@ void MemoryManager::deallocate_user_physical_page(PhysicalPage&& page)
 
         region.return_page(move(page));
         --m_user_physical_pages_used;
+        update_memory_pressure();
 
         return;
     }
@@ -469,19 +571,11 @@ RefPtr<PhysicalPage> MemoryManager::allocate_user_physical_page(ShouldZeroFill s
             kprintf("MM: no user physical regions available (?)\n");
         }
 
-        for_each_vmobject([&](auto& vmobject) {
-            if (vmobject.is_purgeable()) {
-                auto& purgeable_vmobject = static_cast<PurgeableVMObject&>(vmobject);
-                int purged_page_count = purgeable_vmobject.purge_with_interrupts_disabled({});
-                if (purged_page_count) {
-                    kprintf("MM: Purge saved the day! Purged %d pages from PurgeableVMObject{%p}\n", purged_page_count, &purgeable_vmobject);
-                    page = find_free_user_physical_page();
-                    ASSERT(page);
-                    return IterationDecision::Break;
-                }
-            }
-            return IterationDecision::Continue;
-        });
+        // The reclaimer thread didn't keep up, so we have to make room right here.
+        if (size_t reclaimed_page_count = reclaim_with_interrupts_disabled()) {
+            kprintf("MM: Emergency reclaim saved the day! Reclaimed %u pages\n", reclaimed_page_count);
+            page = find_free_user_physical_page();
+        }
 
         if (!page) {
             kprintf("MM: no user physical pages available\n");
@@ -501,9 +595,184 @@ RefPtr<PhysicalPage> MemoryManager::allocate_user_physical_page(ShouldZeroFill s
     }
 
     ++m_user_physical_pages_used;
+    update_memory_pressure();
     return page;
 }
 
+void MemoryManager::update_memory_pressure()
+{
+    ASSERT_INTERRUPTS_DISABLED();
+    auto free_pages = user_physical_pages_free();
+
+    MemoryPressure pressure;
+    if (free_pages <= m_critical_watermark)
+        pressure = MemoryPressure::Critical;
+    else if (free_pages <= m_low_watermark)
+        pressure = MemoryPressure::Low;
+    else if (free_pages < m_high_watermark && m_memory_pressure != MemoryPressure::None)
+        pressure = MemoryPressure::Low;
+    else
+        pressure = MemoryPressure::None;
+
+    if (pressure != m_memory_pressure) {
+#ifdef RECLAIM_DEBUG
+        dbgprintf("MM: Memory pressure changed from %u to %u (%u pages free)\n", m_memory_pressure, pressure, free_pages);
+#endif
+        m_memory_pressure = pressure;
+        ++m_memory_pressure_generation;
+    }
+
+    if (pressure != MemoryPressure::None && m_reclaim_wait_queue)
+        m_reclaim_wait_queue->wake_one();
+}
+
+Vector<RefPtr<PurgeableVMObject>> MemoryManager::volatile_vmobjects_in_lru_order()
+{
+    Vector<RefPtr<PurgeableVMObject>> vmobjects;
+    {
+        InterruptDisabler disabler;
+        for_each_vmobject([&](auto& vmobject) {
+            if (vmobject.is_purgeable() && static_cast<PurgeableVMObject&>(vmobject).is_volatile())
+                vmobjects.append(static_cast<PurgeableVMObject&>(vmobject));
+            return IterationDecision::Continue;
+        });
+    }
+    quick_sort(vmobjects.begin(), vmobjects.end(), [](auto& a, auto& b) {
+        return a->volatile_timestamp() < b->volatile_timestamp();
+    });
+    return vmobjects;
+}
+
+size_t MemoryManager::reclaim_with_interrupts_disabled()
+{
+    ASSERT_INTERRUPTS_DISABLED();
+    size_t reclaimed_page_count = 0;
+
+    for (auto& vmobject : volatile_vmobjects_in_lru_order()) {
+        reclaimed_page_count += vmobject->purge_with_interrupts_disabled({});
+        if (reclaimed_page_count)
+            return reclaimed_page_count;
+    }
+
+    for_each_vmobject([&](auto& vmobject) {
+        if (vmobject.is_inode())
+            reclaimed_page_count += static_cast<InodeVMObject&>(vmobject).release_all_clean_pages_with_interrupts_disabled({});
+        return reclaimed_page_count ? IterationDecision::Break : IterationDecision::Continue;
+    });
+    return reclaimed_page_count;
+}
+
+size_t MemoryManager::reclaim_until_above_high_watermark()
+{
+    ASSERT_INTERRUPTS_ENABLED();
+    size_t reclaimed_page_count = 0;
+    auto done = [&] { return user_physical_pages_free() >= m_high_watermark; };
+
+    // 1. Purge volatile memory, starting with whatever has been volatile the longest.
+    for (auto& vmobject : volatile_vmobjects_in_lru_order()) {
+        if (done())
+            break;
+        reclaimed_page_count += vmobject->purge();
+    }
+
+    // 2. Evict clean pages from the page cache. They can be paged back in from disk.
+    if (!done()) {
+        NonnullRefPtrVector<InodeVMObject> vmobjects;
+        {
+            InterruptDisabler disabler;
+            for_each_vmobject([&](auto& vmobject) {
+                if (vmobject.is_inode())
+                    vmobjects.append(static_cast<InodeVMObject&>(vmobject));
+                return IterationDecision::Continue;
+            });
+        }
+        for (auto& vmobject : vmobjects) {
+            if (done())
+                break;
+            reclaimed_page_count += vmobject.release_all_clean_pages();
+        }
+    }
+
+    // 3. Push cold anonymous memory out to swap, if we have any.
+    if (!done())
+        reclaimed_page_count += swap_out_cold_pages(m_high_watermark - user_physical_pages_free());
+
+    // 4. When things are really dire, drop the file system block caches as well.
+    if (!done() && m_memory_pressure == MemoryPressure::Critical)
+        reclaimed_page_count += FS::shrink_caches();
+
+#ifdef RECLAIM_DEBUG
+    dbgprintf("MM: Reclaimed %u pages, %u pages free\n", reclaimed_page_count, user_physical_pages_free());
+#endif
+    return reclaimed_page_count;
+}
+
+size_t MemoryManager::swap_out_cold_pages(size_t max_page_count)
+{
+    ASSERT_INTERRUPTS_ENABLED();
+    if (!SwapArea::the())
+        return 0;
+
+    struct ColdPage {
+        NonnullRefPtr<AnonymousVMObject> vmobject;
+        size_t page_index;
+    };
+    Vector<ColdPage> cold_pages;
+    {
+        // This is a clock sweep over user regions: a page the CPU has touched since the last
+        // sweep gets its accessed bit cleared and another chance, the rest are considered cold.
+        InterruptDisabler disabler;
+        size_t region_count = m_user_regions.size_slow();
+        if (!region_count)
+            return 0;
+        size_t region_index = 0;
+        size_t first_region_index = m_swap_clock_hand % region_count;
+        for (auto& region : m_user_regions) {
+            if (region_index++ < first_region_index)
+                continue;
+            ++m_swap_clock_hand;
+            if (!region.m_page_directory || region.is_shared())
+                continue;
+            auto& vmobject = region.vmobject();
+            // Purgeable memory is dealt with by purging, and memory shared between regions would need all its mappings swept.
+            if (!vmobject.is_anonymous() || vmobject.is_purgeable() || vmobject.ref_count() != 1)
+                continue;
+            // Physical ranges (framebuffers and such) are not ours to page out.
+            if (static_cast<AnonymousVMObject&>(vmobject).is_physical_range())
+                continue;
+            for (size_t i = 0; i < region.page_count(); ++i) {
+                auto& physical_page = vmobject.physical_pages()[region.first_page_index() + i];
+                if (!physical_page || physical_page->ref_count() != 1)
+                    continue;
+                auto page_vaddr = region.vaddr().offset(i * PAGE_SIZE);
+                auto& pte = ensure_pte(*region.m_page_directory, page_vaddr);
+                if (pte.is_accessed()) {
+                    pte.set_accessed(false);
+                    region.m_page_directory->flush(page_vaddr);
+                    continue;
+                }
+                cold_pages.append({ static_cast<AnonymousVMObject&>(vmobject), region.first_page_index() + i });
+            }
+            if ((size_t)cold_pages.size() >= max_page_count)
+                break;
+        }
+        if (region_index >= region_count)
+            m_swap_clock_hand = 0;
+    }
+
+    size_t swapped_out_page_count = 0;
+    for (auto& cold_page : cold_pages) {
+        if (swapped_out_page_count >= max_page_count)
+            break;
+        if (cold_page.vmobject->swap_out_page(cold_page.page_index))
+            ++swapped_out_page_count;
+    }
+#ifdef RECLAIM_DEBUG
+    dbgprintf("MM: Swapped out %u of %u cold pages\n", swapped_out_page_count, cold_pages.size());
+#endif
+    return swapped_out_page_count;
+}
+
 void MemoryManager::deallocate_supervisor_physical_page(PhysicalPage&& page)
 {
     for (auto& region : m_super_physical_regions) {
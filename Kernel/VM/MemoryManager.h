@@ -21,12 +21,15 @@
 #define PAGE_ROUND_UP(x) ((((u32)(x)) + PAGE_SIZE - 1) & (~(PAGE_SIZE - 1)))
 
 class KBuffer;
+class PurgeableVMObject;
 class SynthFSInode;
+class WaitQueue;
 
 #define MM MemoryManager::the()
 
 class MemoryManager {
     AK_MAKE_ETERNAL
+    friend class AnonymousVMObject;
     friend class PageDirectory;
     friend class PhysicalPage;
     friend class PhysicalRegion;
@@ -70,6 +73,25 @@ public:
     unsigned user_physical_pages_used() const { return m_user_physical_pages_used; }
     unsigned super_physical_pages() const { return m_super_physical_pages; }
     unsigned super_physical_pages_used() const { return m_super_physical_pages_used; }
+    unsigned user_physical_pages_free() const { return m_user_physical_pages - m_user_physical_pages_used; }
+
+    enum class MemoryPressure {
+        None,
+        Low,
+        Critical,
+    };
+
+    // The memory pressure level is derived from the number of free user physical pages.
+    // Falling below the low watermark wakes the reclaimer thread, and the pressure level
+    // only returns to None once the high watermark has been reached again.
+    MemoryPressure memory_pressure() const { return m_memory_pressure; }
+    u32 memory_pressure_generation() const { return m_memory_pressure_generation; }
+    unsigned low_watermark() const { return m_low_watermark; }
+    unsigned high_watermark() const { return m_high_watermark; }
+    unsigned critical_watermark() const { return m_critical_watermark; }
+
+    WaitQueue& reclaim_wait_queue() { return *m_reclaim_wait_queue; }
+    size_t reclaim_until_above_high_watermark();
 
     template<typename Callback>
     static void for_each_vmobject(Callback callback)
@@ -105,6 +127,7 @@ private:
     void map_protected(VirtualAddress, size_t length);
 
     void create_identity_mapping(PageDirectory&, VirtualAddress, size_t length);
+    void create_large_identity_mapping(PageDirectory&, VirtualAddress, size_t length);
 
     static Region* user_region_from_vaddr(Process&, VirtualAddress);
     static Region* kernel_region_from_vaddr(VirtualAddress);
@@ -112,12 +135,18 @@ private:
     static Region* region_from_vaddr(VirtualAddress);
 
     RefPtr<PhysicalPage> find_free_user_physical_page();
+    size_t reclaim_with_interrupts_disabled();
+    size_t swap_out_cold_pages(size_t max_page_count);
+    void update_memory_pressure();
+    Vector<RefPtr<PurgeableVMObject>> volatile_vmobjects_in_lru_order();
     u8* quickmap_page(PhysicalPage&);
     void unquickmap_page();
 
     PageDirectory& kernel_page_directory() { return *m_kernel_page_directory; }
 
+    PageDirectoryEntry& pde(PageDirectory&, VirtualAddress);
     PageTableEntry& ensure_pte(PageDirectory&, VirtualAddress);
+    void split_large_page(PageDirectory&, PageDirectoryEntry&, VirtualAddress);
 
     RefPtr<PageDirectory> m_kernel_page_directory;
     PageTableEntry* m_low_page_tables[4] { nullptr };
@@ -129,6 +158,14 @@ private:
     unsigned m_super_physical_pages { 0 };
     unsigned m_super_physical_pages_used { 0 };
 
+    unsigned m_critical_watermark { 0 };
+    unsigned m_low_watermark { 0 };
+    unsigned m_high_watermark { 0 };
+    MemoryPressure m_memory_pressure { MemoryPressure::None };
+    u32 m_memory_pressure_generation { 0 };
+    WaitQueue* m_reclaim_wait_queue { nullptr };
+    size_t m_swap_clock_hand { 0 };
+
     NonnullRefPtrVector<PhysicalRegion> m_user_physical_regions;
     NonnullRefPtrVector<PhysicalRegion> m_super_physical_regions;
 
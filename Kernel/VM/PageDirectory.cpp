@@ -21,6 +21,19 @@ RefPtr<PageDirectory> PageDirectory::find_by_cr3(u32 cr3)
     return cr3_map().get(cr3).value_or({});
 }
 
+void PageDirectory::sync_low_kernel_pde(size_t page_directory_index)
+{
+    ASSERT_INTERRUPTS_DISABLED();
+    ASSERT(page_directory_index < 4);
+    auto& kernel_page_directory = MM.kernel_page_directory();
+    auto& kernel_pde = kernel_page_directory.table().directory(0)[page_directory_index];
+    for (auto& it : cr3_map()) {
+        auto& page_directory = *it.value;
+        if (&page_directory != &kernel_page_directory)
+            page_directory.table().directory(0)[page_directory_index].copy_from({}, kernel_pde);
+    }
+}
+
 PageDirectory::PageDirectory(PhysicalAddress paddr)
     : m_range_allocator(VirtualAddress(0xc0000000), 0x3f000000)
 {
@@ -19,6 +19,10 @@ public:
     static NonnullRefPtr<PageDirectory> create_at_fixed_address(PhysicalAddress paddr) { return adopt(*new PageDirectory(paddr)); }
     static RefPtr<PageDirectory> find_by_cr3(u32);
 
+    // Every page directory has its own copy of the PDEs for the bottom 8 MB. When the kernel
+    // changes one of them, this hands the change out to all the others.
+    static void sync_low_kernel_pde(size_t page_directory_index);
+
     ~PageDirectory();
 
     u32 cr3() const { return m_directory_table->paddr().get(); }
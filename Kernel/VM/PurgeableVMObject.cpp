@@ -1,3 +1,4 @@
+#include <Kernel/Scheduler.h>
 #include <Kernel/VM/MemoryManager.h>
 #include <Kernel/VM/PhysicalPage.h>
 #include <Kernel/VM/PurgeableVMObject.h>
@@ -26,6 +27,13 @@ NonnullRefPtr<VMObject> PurgeableVMObject::clone()
     return adopt(*new PurgeableVMObject(*this));
 }
 
+void PurgeableVMObject::set_volatile(bool is_volatile)
+{
+    if (is_volatile && !m_volatile)
+        m_volatile_timestamp = g_uptime;
+    m_volatile = is_volatile;
+}
+
 int PurgeableVMObject::purge()
 {
     LOCKER(m_paging_lock);
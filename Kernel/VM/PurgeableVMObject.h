@@ -16,7 +16,10 @@ public:
     void set_was_purged(bool b) { m_was_purged = b; }
 
     bool is_volatile() const { return m_volatile; }
-    void set_volatile(bool b) { m_volatile = b; }
+    void set_volatile(bool);
+
+    // Uptime (in ticks) at which this object last became volatile, used to purge in LRU order.
+    u64 volatile_timestamp() const { return m_volatile_timestamp; }
 
 private:
     explicit PurgeableVMObject(size_t);
@@ -32,4 +35,5 @@ private:
 
     bool m_was_purged { false };
     bool m_volatile { false };
+    u64 m_volatile_timestamp { 0 };
 };
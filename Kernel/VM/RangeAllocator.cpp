@@ -58,7 +58,7 @@ void RangeAllocator::carve_at_index(int index, const Range& range)
         m_available_ranges.insert(index + 1, move(remaining_parts[1]));
 }
 
-Range RangeAllocator::allocate_anywhere(size_t size)
+Range RangeAllocator::allocate_anywhere(size_t size, size_t alignment)
 {
 #ifdef VM_GUARD_PAGES
     // NOTE: We pad VM allocations with a guard page on each side.
@@ -70,9 +70,12 @@ Range RangeAllocator::allocate_anywhere(size_t size)
 #endif
     for (int i = 0; i < m_available_ranges.size(); ++i) {
         auto& available_range = m_available_ranges[i];
-        if (available_range.size() < effective_size)
+        // NOTE: Aligning the base may push us a bit into the available range.
+        u32 initial_base = available_range.base().offset(offset_from_effective_base).get();
+        u32 aligned_base = round_up_to_power_of_two(initial_base, alignment);
+        if (available_range.size() < (effective_size + (aligned_base - initial_base)))
             continue;
-        Range allocated_range(available_range.base().offset(offset_from_effective_base), size);
+        Range allocated_range(VirtualAddress(aligned_base), size);
         if (available_range.size() == effective_size) {
 #ifdef VRA_DEBUG
             dbgprintf("VRA: Allocated perfect-fit anywhere(%u): %x\n", size, allocated_range.base().get());
@@ -51,7 +51,7 @@ public:
     RangeAllocator(const RangeAllocator&);
     ~RangeAllocator();
 
-    Range allocate_anywhere(size_t);
+    Range allocate_anywhere(size_t, size_t alignment = PAGE_SIZE);
     Range allocate_specific(VirtualAddress, size_t);
     void deallocate(Range);
 
@@ -215,9 +215,13 @@ void Region::map_individual_page_impl(size_t page_index)
     auto& pte = MM.ensure_pte(*m_page_directory, page_vaddr);
     auto& physical_page = vmobject().physical_pages()[first_page_index() + page_index];
     if (!physical_page) {
-        pte.set_physical_page_base(0);
+        if (vmobject().is_anonymous())
+            pte.set_swap_slot(static_cast<const AnonymousVMObject&>(vmobject()).swap_slot(first_page_index() + page_index));
+        else
+            pte.set_physical_page_base(0);
         pte.set_present(false);
     } else {
+        pte.set_swap_slot(0);
         pte.set_physical_page_base(physical_page->paddr().get());
         pte.set_present(is_readable());
         if (should_cow(page_index))
@@ -242,12 +246,29 @@ void Region::remap_page(size_t page_index)
     map_individual_page_impl(page_index);
 }
 
+void Region::remap_vmobject_page(size_t vmobject_page_index)
+{
+    if (!m_page_directory)
+        return;
+    if (vmobject_page_index < first_page_index() || vmobject_page_index > last_page_index())
+        return;
+    InterruptDisabler disabler;
+    map_individual_page_impl(vmobject_page_index - first_page_index());
+}
+
 void Region::unmap(ShouldDeallocateVirtualMemoryRange deallocate_range)
 {
     InterruptDisabler disabler;
     ASSERT(m_page_directory);
     for (size_t i = 0; i < page_count(); ++i) {
         auto vaddr = this->vaddr().offset(i * PAGE_SIZE);
+        auto& pde = MM.pde(*m_page_directory, vaddr);
+        if (pde.is_huge()) {
+            pde.clear();
+            m_page_directory->flush(vaddr);
+            i += (LARGE_PAGE_SIZE / PAGE_SIZE) - 1;
+            continue;
+        }
         auto& pte = MM.ensure_pte(*m_page_directory, vaddr);
         pte.set_physical_page_base(0);
         pte.set_present(false);
@@ -272,8 +293,63 @@ void Region::map(PageDirectory& page_directory)
 #ifdef MM_DEBUG
     dbgprintf("MM: Region::map() will map VMO pages %u - %u (VMO page count: %u)\n", first_page_index(), last_page_index(), vmobject().page_count());
 #endif
-    for (size_t page_index = 0; page_index < page_count(); ++page_index)
+    for (size_t page_index = 0; page_index < page_count();) {
+        auto page_vaddr = vaddr().offset(page_index * PAGE_SIZE);
+        if ((page_vaddr.get() & ~LARGE_PAGE_MASK) == 0) {
+            auto& pde = MM.pde(page_directory, page_vaddr);
+            if (can_map_large_page(page_index) && (!pde.is_present() || pde.is_huge())) {
+                map_large_page_impl(page_index);
+                page_index += LARGE_PAGE_SIZE / PAGE_SIZE;
+                continue;
+            }
+            // We may have been mapped with a large page here before (e.g before becoming COW.)
+            if (pde.is_huge()) {
+                pde.clear();
+                m_page_directory->flush(page_vaddr);
+            }
+        }
         map_individual_page_impl(page_index);
+        ++page_index;
+    }
+}
+
+bool Region::can_map_large_page(size_t page_index) const
+{
+    // Only physical ranges are eligible, since their pages never get swapped, purged or replaced.
+    if (!vmobject().is_anonymous() || !static_cast<const AnonymousVMObject&>(vmobject()).is_physical_range())
+        return false;
+    if (!is_readable() || page_index + (LARGE_PAGE_SIZE / PAGE_SIZE) > page_count())
+        return false;
+    auto& first_page = vmobject().physical_pages()[first_page_index() + page_index];
+    if (!first_page || (first_page->paddr().get() & ~LARGE_PAGE_MASK))
+        return false;
+    for (size_t i = 0; i < LARGE_PAGE_SIZE / PAGE_SIZE; ++i) {
+        auto& physical_page = vmobject().physical_pages()[first_page_index() + page_index + i];
+        if (!physical_page || physical_page->paddr() != first_page->paddr().offset(i * PAGE_SIZE))
+            return false;
+        if (should_cow(page_index + i))
+            return false;
+    }
+    return true;
+}
+
+void Region::map_large_page_impl(size_t page_index)
+{
+    auto page_vaddr = vaddr().offset(page_index * PAGE_SIZE);
+    auto& pde = MM.pde(*m_page_directory, page_vaddr);
+    auto& physical_page = vmobject().physical_pages()[first_page_index() + page_index];
+    pde.set_large_page_base(physical_page->paddr().get());
+    pde.set_huge(true);
+    pde.set_present(true);
+    pde.set_writable(is_writable());
+    if (g_cpu_supports_nx)
+        pde.set_execute_disabled(!is_executable());
+    pde.set_user_allowed(is_user_accessible());
+    pde.set_global(false);
+    m_page_directory->flush(page_vaddr);
+#ifdef MM_DEBUG
+    dbg() << "MM: >> region map large (PD=" << m_page_directory->cr3() << ") " << name() << " " << page_vaddr << " => " << physical_page->paddr();
+#endif
 }
 
 void Region::remap()
@@ -332,6 +408,9 @@ PageFaultResponse Region::handle_zero_fault(size_t page_index_in_region)
         return PageFaultResponse::Continue;
     }
 
+    if (static_cast<AnonymousVMObject&>(vmobject()).swap_slot(first_page_index() + page_index_in_region))
+        return handle_swap_fault(page_index_in_region);
+
     if (current)
         current->did_zero_fault();
 
@@ -349,6 +428,28 @@ PageFaultResponse Region::handle_zero_fault(size_t page_index_in_region)
     return PageFaultResponse::Continue;
 }
 
+PageFaultResponse Region::handle_swap_fault(size_t page_index_in_region)
+{
+    ASSERT_INTERRUPTS_DISABLED();
+    ASSERT(vmobject().m_paging_lock.is_locked());
+
+    if (current)
+        current->did_swap_fault();
+
+#ifdef PAGE_FAULT_DEBUG
+    dbgprintf("      >> SWAP IN slot %u\n", static_cast<AnonymousVMObject&>(vmobject()).swap_slot(first_page_index() + page_index_in_region));
+#endif
+    sti();
+    bool success = static_cast<AnonymousVMObject&>(vmobject()).swap_in_page(first_page_index() + page_index_in_region);
+    cli();
+    if (!success) {
+        kprintf("MM: handle_swap_fault was unable to page in from swap\n");
+        return PageFaultResponse::ShouldCrash;
+    }
+    remap_page(page_index_in_region);
+    return PageFaultResponse::Continue;
+}
+
 PageFaultResponse Region::handle_cow_fault(size_t page_index_in_region)
 {
     ASSERT_INTERRUPTS_DISABLED();
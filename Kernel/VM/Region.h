@@ -123,6 +123,7 @@ public:
 
     void remap();
     void remap_page(size_t index);
+    void remap_vmobject_page(size_t vmobject_page_index);
 
     // For InlineLinkedListNode
     Region* m_next { nullptr };
@@ -147,8 +148,11 @@ private:
     PageFaultResponse handle_cow_fault(size_t page_index);
     PageFaultResponse handle_inode_fault(size_t page_index);
     PageFaultResponse handle_zero_fault(size_t page_index);
+    PageFaultResponse handle_swap_fault(size_t page_index);
 
     void map_individual_page_impl(size_t page_index);
+    bool can_map_large_page(size_t page_index) const;
+    void map_large_page_impl(size_t page_index);
 
     RefPtr<PageDirectory> m_page_directory;
     Range m_range;
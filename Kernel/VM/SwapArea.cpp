@@ -0,0 +1,167 @@
+#include <Kernel/Devices/DiskPartition.h>
+#include <Kernel/FileSystem/DiskBackedFileSystem.h>
+#include <Kernel/FileSystem/Inode.h>
+#include <Kernel/VM/MemoryManager.h>
+#include <Kernel/VM/SwapArea.h>
+
+//#define SWAP_DEBUG
+
+static SwapArea* s_the;
+
+SwapArea* SwapArea::the()
+{
+    return s_the;
+}
+
+KResult SwapArea::activate(DiskPartition& partition)
+{
+    InterruptDisabler disabler;
+    if (s_the)
+        return KResult(-EBUSY);
+    size_t slot_count = ((size_t)partition.block_count() * partition.block_size()) / PAGE_SIZE;
+    if (slot_count < 2)
+        return KResult(-EINVAL);
+    s_the = new SwapArea(partition, nullptr, {}, 0, slot_count);
+    return KSuccess;
+}
+
+KResult SwapArea::activate(Inode& inode)
+{
+    if (!inode.metadata().is_regular_file())
+        return KResult(-EINVAL);
+    if (!inode.fs().is_disk_backed())
+        return KResult(-EINVAL);
+    auto& fs = static_cast<DiskBackedFS&>(inode.fs());
+    size_t block_size = fs.block_size();
+    if (!block_size || block_size > PAGE_SIZE || (PAGE_SIZE % block_size) || (block_size % fs.device().block_size()))
+        return KResult(-EINVAL);
+
+    {
+        InterruptDisabler disabler;
+        if (s_the || inode.is_swap_file())
+            return KResult(-EBUSY);
+        // Pin the file's blocks before we look them up, and until swap goes away.
+        inode.set_swap_file({}, true);
+    }
+    auto fail = [&](int error) {
+        inode.set_swap_file({}, false);
+        return KResult(error);
+    };
+
+    auto block_list = inode.data_block_list();
+    size_t slot_count = min(inode.size(), block_list.size() * block_size) / PAGE_SIZE;
+    if (slot_count < 2)
+        return fail(-EINVAL);
+    // A swap file with holes in it can't be written without going through the file system.
+    for (size_t i = 0; i < slot_count * (PAGE_SIZE / block_size); ++i) {
+        if (!block_list[i])
+            return fail(-EINVAL);
+    }
+
+    // We'll write straight to the device from now on, so make sure nothing
+    // for these blocks is still sitting dirty in the block cache.
+    fs.flush_writes();
+
+    InterruptDisabler disabler;
+    if (s_the)
+        return fail(-EBUSY);
+    s_the = new SwapArea(fs.device(), inode, move(block_list), block_size, slot_count);
+    return KSuccess;
+}
+
+SwapArea::SwapArea(NonnullRefPtr<DiskDevice> device, RefPtr<Inode> inode, Vector<unsigned>&& block_list, size_t block_size, size_t slot_count)
+    : m_device(move(device))
+    , m_inode(move(inode))
+    , m_block_list(move(block_list))
+    , m_block_size(block_size)
+    , m_bounce_page(KBuffer::create_with_size(PAGE_SIZE))
+    , m_slot_refs(slot_count)
+{
+    // Slot 0 is reserved so that it can mean "no slot".
+    m_slot_refs[0] = 1;
+    kprintf("SwapArea: Activated with %u slots (%u KB)\n", slot_count - 1, ((slot_count - 1) * PAGE_SIZE) / KB);
+}
+
+SwapArea::~SwapArea()
+{
+}
+
+u32 SwapArea::allocate_slot()
+{
+    InterruptDisabler disabler;
+    for (size_t i = 0; i < slot_count(); ++i) {
+        size_t slot = (m_next_slot_hint + i) % slot_count();
+        if (m_slot_refs[slot])
+            continue;
+        m_slot_refs[slot] = 1;
+        m_next_slot_hint = slot + 1;
+        ++m_used_slot_count;
+        return slot;
+    }
+    return 0;
+}
+
+void SwapArea::ref_slot(u32 slot)
+{
+    InterruptDisabler disabler;
+    ASSERT(slot && slot < slot_count());
+    ASSERT(m_slot_refs[slot] && m_slot_refs[slot] < 0xffff);
+    ++m_slot_refs[slot];
+}
+
+void SwapArea::unref_slot(u32 slot)
+{
+    InterruptDisabler disabler;
+    ASSERT(slot && slot < slot_count());
+    ASSERT(m_slot_refs[slot]);
+    if (--m_slot_refs[slot])
+        return;
+    --m_used_slot_count;
+    if (slot < m_next_slot_hint)
+        m_next_slot_hint = slot;
+}
+
+bool SwapArea::transfer_page(u32 slot, u8* buffer, bool is_write)
+{
+    if (m_block_list.is_empty()) {
+        if (is_write)
+            return m_device->write(slot * PAGE_SIZE, PAGE_SIZE, buffer);
+        return m_device->read(slot * PAGE_SIZE, PAGE_SIZE, buffer);
+    }
+
+    // Transfer each run of physically contiguous file blocks in one go.
+    size_t blocks_per_page = PAGE_SIZE / m_block_size;
+    size_t first = slot * blocks_per_page;
+    for (size_t i = 0; i < blocks_per_page;) {
+        size_t run_length = 1;
+        while (i + run_length < blocks_per_page && m_block_list[first + i + run_length] == m_block_list[first + i] + run_length)
+            ++run_length;
+        DiskOffset offset = m_block_list[first + i] * m_block_size;
+        u8* data = buffer + i * m_block_size;
+        bool success = is_write ? m_device->write(offset, run_length * m_block_size, data) : m_device->read(offset, run_length * m_block_size, data);
+        if (!success)
+            return false;
+        i += run_length;
+    }
+    return true;
+}
+
+bool SwapArea::read_page(u32 slot, u8* buffer)
+{
+    ASSERT_INTERRUPTS_ENABLED();
+    LOCKER(m_lock);
+#ifdef SWAP_DEBUG
+    dbgprintf("SwapArea: Reading slot %u\n", slot);
+#endif
+    return transfer_page(slot, buffer, false);
+}
+
+bool SwapArea::write_page(u32 slot, const u8* buffer)
+{
+    ASSERT_INTERRUPTS_ENABLED();
+    LOCKER(m_lock);
+#ifdef SWAP_DEBUG
+    dbgprintf("SwapArea: Writing slot %u\n", slot);
+#endif
+    return transfer_page(slot, const_cast<u8*>(buffer), true);
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <AK/FixedArray.h>
+#include <AK/RefPtr.h>
+#include <AK/Types.h>
+#include <AK/Vector.h>
+#include <Kernel/KBuffer.h>
+#include <Kernel/KResult.h>
+#include <Kernel/Lock.h>
+
+class DiskDevice;
+class DiskPartition;
+class Inode;
+
+// A SwapArea is where anonymous memory goes when physical memory runs low.
+// It's either a whole disk partition or a regular file, carved into page-sized slots.
+// Either way, pages go straight to the disk device and bypass the block cache;
+// for a swap file, the blocks backing it are looked up once at activation time.
+// Slot 0 is never handed out, so a slot number of 0 means "not swapped".
+class SwapArea {
+public:
+    static SwapArea* the();
+    static KResult activate(DiskPartition&);
+    static KResult activate(Inode&);
+
+    ~SwapArea();
+
+    size_t slot_count() const { return m_slot_refs.size(); }
+    size_t used_slot_count() const { return m_used_slot_count; }
+
+    // Returns a slot with a single reference, or 0 if the swap area is full.
+    u32 allocate_slot();
+    void ref_slot(u32 slot);
+    void unref_slot(u32 slot);
+
+    // NOTE: Page I/O is serialized by this lock. Holding it across handing out a slot
+    //       and writing it guarantees that nobody reads the slot before it's been written.
+    Lock& lock() { return m_lock; }
+
+    // A page to stage swapped pages in, so they don't have to take up the kernel stack.
+    // It may only be used while holding lock().
+    u8* bounce_page()
+    {
+        ASSERT(m_lock.is_locked());
+        return m_bounce_page.data();
+    }
+
+    bool read_page(u32 slot, u8* buffer);
+    bool write_page(u32 slot, const u8* buffer);
+
+private:
+    SwapArea(NonnullRefPtr<DiskDevice>, RefPtr<Inode>, Vector<unsigned>&& block_list, size_t block_size, size_t slot_count);
+
+    bool transfer_page(u32 slot, u8* buffer, bool is_write);
+
+    NonnullRefPtr<DiskDevice> m_device;
+    RefPtr<Inode> m_inode;
+    Vector<unsigned> m_block_list;
+    size_t m_block_size { 0 };
+    Lock m_lock { "SwapArea" };
+    KBuffer m_bounce_page;
+    FixedArray<u16> m_slot_refs;
+    size_t m_used_slot_count { 0 };
+    size_t m_next_slot_hint { 1 };
+};
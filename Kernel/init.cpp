@@ -22,6 +22,7 @@
 #include <Kernel/Devices/KeyboardDevice.h>
 #include <Kernel/Devices/MBRPartitionTable.h>
 #include <Kernel/Devices/MBVGADevice.h>
+#include <Kernel/Devices/MemoryPressureDevice.h>
 #include <Kernel/Devices/NullDevice.h>
 #include <Kernel/Devices/PATAChannel.h>
 #include <Kernel/Devices/PS2MouseDevice.h>
@@ -70,6 +71,7 @@ VFS* vfs;
     auto dev_full = make<FullDevice>();
     auto dev_random = make<RandomDevice>();
     auto dev_ptmx = make<PTYMultiplexer>();
+    auto dev_mempressure = make<MemoryPressureDevice>();
 
     bool text_debug = KParams::the().has("text_debug");
     bool force_pio = KParams::the().has("force_pio");
@@ -390,6 +392,22 @@ extern "C" [[noreturn]] void init(u32 physical_address_for_kernel_page_tables)
         }
     });
 
+    Thread* reclaimer_thread = nullptr;
+    Process::create_kernel_process(reclaimer_thread, "MemoryReclaimer", [] {
+        for (;;) {
+            {
+                // Check and enqueue with interrupts disabled, so a wake-up from the
+                // page allocator can't slip in between them and get lost.
+                InterruptDisabler disabler;
+                if (MM.memory_pressure() == MemoryManager::MemoryPressure::None)
+                    current->wait_on(MM.reclaim_wait_queue());
+            }
+            // Don't spin if there was nothing left to reclaim; allocations will wake us up again.
+            if (!MM.reclaim_until_above_high_watermark())
+                current->sleep(1 * TICKS_PER_SECOND);
+        }
+    });
+
     Process::create_kernel_process(g_finalizer, "Finalizer", [] {
         current->set_priority(THREAD_PRIORITY_LOW);
         for (;;) {
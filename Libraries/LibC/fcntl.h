@@ -66,6 +66,12 @@ int openat_with_path_length(int dirfd, const char* path, size_t path_length, int
 int fcntl(int fd, int cmd, ...);
 int watch_file(const char* path, size_t path_length);
 
+#define SPLICE_F_MOVE 0x01
+#define SPLICE_F_NONBLOCK 0x02
+#define SPLICE_F_MORE 0x04
+
+ssize_t splice(int fd_in, off_t* off_in, int fd_out, off_t* off_out, size_t length, unsigned flags);
+
 #define F_RDLCK 0
 #define F_WRLCK 1
 #define F_UNLCK 2
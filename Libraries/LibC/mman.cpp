@@ -50,4 +50,14 @@ int madvise(void* address, size_t size, int advice)
     int rc = syscall(SC_madvise, address, size, advice);
     __RETURN_WITH_ERRNO(rc, rc, -1);
 }
+
+int memfd_create(const char* name, unsigned flags)
+{
+    if (!name) {
+        errno = EFAULT;
+        return -1;
+    }
+    int rc = syscall(SC_memfd_create, name, strlen(name), flags);
+    __RETURN_WITH_ERRNO(rc, rc, -1);
+}
 }
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <sys/cdefs.h>
+#include <sys/socket.h>
+
+__BEGIN_DECLS
+
+struct rtentry {
+    struct sockaddr rt_dst;
+    struct sockaddr rt_gateway;
+    struct sockaddr rt_genmask;
+    unsigned short rt_flags;
+    char* rt_dev; // optional, inferred from the gateway if null
+};
+
+#define RTF_UP 0x1      // route usable
+#define RTF_GATEWAY 0x2 // destination is a gateway
+#define RTF_HOST 0x4    // host entry (net otherwise)
+
+__END_DECLS
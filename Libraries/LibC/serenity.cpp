@@ -53,4 +53,10 @@ int purge(int mode)
     __RETURN_WITH_ERRNO(rc, rc, -1);
 }
 
+int swapon(const char* path)
+{
+    int rc = syscall(SC_swapon, path);
+    __RETURN_WITH_ERRNO(rc, rc, -1);
+}
+
 }
@@ -30,4 +30,6 @@ int futex(int32_t* userspace_address, int futex_op, int32_t value, const struct
 
 int purge(int mode);
 
+int swapon(const char* path);
+
 __END_DECLS
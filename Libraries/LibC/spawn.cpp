@@ -0,0 +1,213 @@
+#include <AK/String.h>
+#include <AK/Vector.h>
+#include <Kernel/Syscall.h>
+#include <errno.h>
+#include <spawn.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+struct SpawnFileActions {
+    Vector<Syscall::SC_spawn_file_action> actions;
+    Vector<String> paths;
+};
+
+static SpawnFileActions& state_of(posix_spawn_file_actions_t* file_actions)
+{
+    return *reinterpret_cast<SpawnFileActions*>(file_actions->state);
+}
+
+static int append_action(posix_spawn_file_actions_t* file_actions, Syscall::SpawnFileActionType type, int fd, int new_fd, const char* path, int options, mode_t mode)
+{
+    if (!file_actions || !file_actions->state)
+        return EINVAL;
+    auto& state = state_of(file_actions);
+    Syscall::SC_spawn_file_action action;
+    action.type = type;
+    action.fd = fd;
+    action.new_fd = new_fd;
+    action.options = options;
+    action.mode = mode;
+    action.path = nullptr;
+    action.path_length = 0;
+    if (path) {
+        state.paths.append(path);
+        action.path = state.paths.last().characters();
+        action.path_length = state.paths.last().length();
+    }
+    state.actions.append(action);
+    return 0;
+}
+
+extern "C" {
+
+int posix_spawn(pid_t* pid, const char* path, const posix_spawn_file_actions_t* file_actions, const posix_spawnattr_t* attr, char* const argv[], char* const envp[])
+{
+    if (!path)
+        return EFAULT;
+
+    Syscall::SC_spawn_params params;
+    params.path = path;
+    params.path_length = strlen(path);
+    params.argv = const_cast<const char**>(argv);
+    params.envp = const_cast<const char**>(envp);
+    params.file_actions = nullptr;
+    params.file_actions_count = 0;
+    params.flags = 0;
+    params.pgroup = 0;
+    params.sigdefault = 0;
+    params.sigmask = 0;
+
+    if (file_actions && file_actions->state) {
+        auto& state = *reinterpret_cast<const SpawnFileActions*>(file_actions->state);
+        params.file_actions = state.actions.data();
+        params.file_actions_count = state.actions.size();
+    }
+
+    if (attr) {
+        params.flags = attr->flags;
+        params.pgroup = attr->pgroup;
+        params.sigdefault = attr->sigdefault;
+        params.sigmask = attr->sigmask;
+    }
+
+    int rc = syscall(SC_spawn, &params);
+    if (rc < 0)
+        return -rc;
+    if (pid)
+        *pid = rc;
+    return 0;
+}
+
+int posix_spawnp(pid_t* pid, const char* file, const posix_spawn_file_actions_t* file_actions, const posix_spawnattr_t* attr, char* const argv[], char* const envp[])
+{
+    if (!file)
+        return EFAULT;
+    if (strchr(file, '/'))
+        return posix_spawn(pid, file, file_actions, attr, argv, envp);
+
+    String path = getenv("PATH");
+    if (path.is_empty())
+        path = "/bin:/usr/bin";
+    // Like execvp(), keep looking if a candidate isn't there or we're not allowed to run it,
+    // and only report EACCES if nothing further down the PATH worked out either.
+    bool saw_eacces = false;
+    auto parts = path.split(':');
+    for (auto& part : parts) {
+        auto candidate = String::format("%s/%s", part.characters(), file);
+        int rc = posix_spawn(pid, candidate.characters(), file_actions, attr, argv, envp);
+        if (rc == EACCES) {
+            saw_eacces = true;
+            continue;
+        }
+        if (rc != ENOENT && rc != ENOTDIR)
+            return rc;
+    }
+    return saw_eacces ? EACCES : ENOENT;
+}
+
+int posix_spawn_file_actions_init(posix_spawn_file_actions_t* file_actions)
+{
+    file_actions->state = new SpawnFileActions;
+    return 0;
+}
+
+int posix_spawn_file_actions_destroy(posix_spawn_file_actions_t* file_actions)
+{
+    delete reinterpret_cast<SpawnFileActions*>(file_actions->state);
+    file_actions->state = nullptr;
+    return 0;
+}
+
+int posix_spawn_file_actions_addopen(posix_spawn_file_actions_t* file_actions, int fd, const char* path, int flags, mode_t mode)
+{
+    if (fd < 0 || !path)
+        return EBADF;
+    return append_action(file_actions, Syscall::SpawnFileActionType::Open, fd, -1, path, flags, mode);
+}
+
+int posix_spawn_file_actions_addclose(posix_spawn_file_actions_t* file_actions, int fd)
+{
+    if (fd < 0)
+        return EBADF;
+    return append_action(file_actions, Syscall::SpawnFileActionType::Close, fd, -1, nullptr, 0, 0);
+}
+
+int posix_spawn_file_actions_adddup2(posix_spawn_file_actions_t* file_actions, int old_fd, int new_fd)
+{
+    if (old_fd < 0 || new_fd < 0)
+        return EBADF;
+    return append_action(file_actions, Syscall::SpawnFileActionType::Dup2, old_fd, new_fd, nullptr, 0, 0);
+}
+
+int posix_spawn_file_actions_addchdir(posix_spawn_file_actions_t* file_actions, const char* path)
+{
+    if (!path)
+        return EINVAL;
+    return append_action(file_actions, Syscall::SpawnFileActionType::Chdir, -1, -1, path, 0, 0);
+}
+
+int posix_spawnattr_init(posix_spawnattr_t* attr)
+{
+    attr->flags = 0;
+    attr->pgroup = 0;
+    attr->sigdefault = 0;
+    attr->sigmask = 0;
+    return 0;
+}
+
+int posix_spawnattr_destroy(posix_spawnattr_t*)
+{
+    return 0;
+}
+
+int posix_spawnattr_getflags(const posix_spawnattr_t* attr, short* flags)
+{
+    *flags = attr->flags;
+    return 0;
+}
+
+int posix_spawnattr_setflags(posix_spawnattr_t* attr, short flags)
+{
+    if (flags & ~(POSIX_SPAWN_RESETIDS | POSIX_SPAWN_SETPGROUP | POSIX_SPAWN_SETSIGDEF | POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSID))
+        return EINVAL;
+    attr->flags = flags;
+    return 0;
+}
+
+int posix_spawnattr_getpgroup(const posix_spawnattr_t* attr, pid_t* pgroup)
+{
+    *pgroup = attr->pgroup;
+    return 0;
+}
+
+int posix_spawnattr_setpgroup(posix_spawnattr_t* attr, pid_t pgroup)
+{
+    attr->pgroup = pgroup;
+    return 0;
+}
+
+int posix_spawnattr_getsigdefault(const posix_spawnattr_t* attr, sigset_t* sigdefault)
+{
+    *sigdefault = attr->sigdefault;
+    return 0;
+}
+
+int posix_spawnattr_setsigdefault(posix_spawnattr_t* attr, const sigset_t* sigdefault)
+{
+    attr->sigdefault = *sigdefault;
+    return 0;
+}
+
+int posix_spawnattr_getsigmask(const posix_spawnattr_t* attr, sigset_t* sigmask)
+{
+    *sigmask = attr->sigmask;
+    return 0;
+}
+
+int posix_spawnattr_setsigmask(posix_spawnattr_t* attr, const sigset_t* sigmask)
+{
+    attr->sigmask = *sigmask;
+    return 0;
+}
+}
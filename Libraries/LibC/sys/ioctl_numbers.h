@@ -36,4 +36,6 @@ enum IOCtlNumber {
     SIOCSIFADDR,
     SIOCGIFADDR,
     SIOCGIFHWADDR,
+    SIOCADDRT,
+    SIOCDELRT,
 };
@@ -3,6 +3,7 @@
 #include <bits/stdint.h>
 #include <sys/cdefs.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <sys/un.h>
 
 __BEGIN_DECLS
@@ -28,6 +29,7 @@ __BEGIN_DECLS
 #define IPPROTO_TCP 6
 #define IPPROTO_UDP 17
 
+#define MSG_CTRUNC 0x8
 #define MSG_DONTWAIT 0x40
 
 struct sockaddr {
@@ -50,6 +52,45 @@ struct ucred {
 #define SO_ERROR 4
 #define SO_PEERCRED 5
 
+#define SCM_RIGHTS 1
+
+struct msghdr {
+    void* msg_name;
+    socklen_t msg_namelen;
+    struct iovec* msg_iov;
+    int msg_iovlen;
+    void* msg_control;
+    socklen_t msg_controllen;
+    int msg_flags;
+};
+
+struct cmsghdr {
+    socklen_t cmsg_len;
+    int cmsg_level;
+    int cmsg_type;
+};
+
+#define CMSG_ALIGN(x) (((x) + sizeof(size_t) - 1) & ~(sizeof(size_t) - 1))
+#define CMSG_SPACE(x) (CMSG_ALIGN(sizeof(struct cmsghdr)) + CMSG_ALIGN(x))
+#define CMSG_LEN(x) (CMSG_ALIGN(sizeof(struct cmsghdr)) + (x))
+#define CMSG_DATA(cmsg) ((unsigned char*)(cmsg) + CMSG_ALIGN(sizeof(struct cmsghdr)))
+
+static inline struct cmsghdr* CMSG_FIRSTHDR(const struct msghdr* message)
+{
+    if (message->msg_controllen < sizeof(struct cmsghdr))
+        return (struct cmsghdr*)0;
+    return (struct cmsghdr*)message->msg_control;
+}
+
+static inline struct cmsghdr* CMSG_NXTHDR(const struct msghdr* message, const struct cmsghdr* header)
+{
+    char* next = (char*)header + CMSG_ALIGN(header->cmsg_len);
+    char* end = (char*)message->msg_control + message->msg_controllen;
+    if (next + sizeof(struct cmsghdr) > end)
+        return (struct cmsghdr*)0;
+    return (struct cmsghdr*)next;
+}
+
 int socket(int domain, int type, int protocol);
 int bind(int sockfd, const struct sockaddr* addr, socklen_t);
 int listen(int sockfd, int backlog);
@@ -59,6 +100,8 @@ ssize_t send(int sockfd, const void*, size_t, int flags);
 ssize_t sendto(int sockfd, const void*, size_t, int flags, const struct sockaddr*, socklen_t);
 ssize_t recv(int sockfd, void*, size_t, int flags);
 ssize_t recvfrom(int sockfd, void*, size_t, int flags, struct sockaddr*, socklen_t*);
+ssize_t sendmsg(int sockfd, const struct msghdr*, int flags);
+ssize_t recvmsg(int sockfd, struct msghdr*, int flags);
 int getsockopt(int sockfd, int level, int option, void*, socklen_t*);
 int setsockopt(int sockfd, int level, int option, const void*, socklen_t);
 int getsockname(int sockfd, struct sockaddr*, socklen_t*);
@@ -4,6 +4,12 @@
 
 extern "C" {
 
+ssize_t readv(int fd, const struct iovec* iov, int iov_count)
+{
+    int rc = syscall(SC_readv, fd, iov, iov_count);
+    __RETURN_WITH_ERRNO(rc, rc, -1);
+}
+
 ssize_t writev(int fd, const struct iovec* iov, int iov_count)
 {
     int rc = syscall(SC_writev, fd, iov, iov_count);
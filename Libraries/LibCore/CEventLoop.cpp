@@ -14,7 +14,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <sys/select.h>
+#include <sys/epoll.h>
 #include <sys/socket.h>
 #include <sys/time.h>
 #include <time.h>
@@ -29,8 +29,9 @@ static CEventLoop* s_main_event_loop;
 static Vector<CEventLoop*>* s_event_loop_stack;
 static IDAllocator s_id_allocator;
 HashMap<int, NonnullOwnPtr<CEventLoop::EventLoopTimer>>* CEventLoop::s_timers;
-HashTable<CNotifier*>* CEventLoop::s_notifiers;
+HashMap<int, Vector<CNotifier*, 1>>* CEventLoop::s_notifiers;
 int CEventLoop::s_wake_pipe_fds[2];
+int CEventLoop::s_epoll_fd = -1;
 RefPtr<CLocalServer> CEventLoop::s_rpc_server;
 HashMap<int, RefPtr<RPCClient>> s_rpc_clients;
 
@@ -137,7 +138,7 @@ CEventLoop::CEventLoop()
     if (!s_event_loop_stack) {
         s_event_loop_stack = new Vector<CEventLoop*>;
         s_timers = new HashMap<int, NonnullOwnPtr<CEventLoop::EventLoopTimer>>;
-        s_notifiers = new HashTable<CNotifier*>;
+        s_notifiers = new HashMap<int, Vector<CNotifier*, 1>>;
     }
 
     if (!s_main_event_loop) {
@@ -151,6 +152,19 @@ CEventLoop::CEventLoop()
 
 #endif
         ASSERT(rc == 0);
+
+        s_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        if (s_epoll_fd < 0) {
+            perror("epoll_create1");
+            ASSERT_NOT_REACHED();
+        }
+        epoll_event event;
+        memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN;
+        event.data.fd = s_wake_pipe_fds[0];
+        rc = epoll_ctl(s_epoll_fd, EPOLL_CTL_ADD, s_wake_pipe_fds[0], &event);
+        ASSERT(rc == 0);
+
         s_event_loop_stack->append(this);
 
         auto rpc_path = String::format("/tmp/rpc.%d", getpid());
@@ -305,30 +319,6 @@ void CEventLoop::post_event(CObject& receiver, NonnullOwnPtr<CEvent>&& event)
 
 void CEventLoop::wait_for_event(WaitMode mode)
 {
-    fd_set rfds;
-    fd_set wfds;
-    FD_ZERO(&rfds);
-    FD_ZERO(&wfds);
-
-    int max_fd = 0;
-    auto add_fd_to_set = [&max_fd](int fd, fd_set& set) {
-        FD_SET(fd, &set);
-        if (fd > max_fd)
-            max_fd = fd;
-    };
-
-    int max_fd_added = -1;
-    add_fd_to_set(s_wake_pipe_fds[0], rfds);
-    max_fd = max(max_fd, max_fd_added);
-    for (auto& notifier : *s_notifiers) {
-        if (notifier->event_mask() & CNotifier::Read)
-            add_fd_to_set(notifier->fd(), rfds);
-        if (notifier->event_mask() & CNotifier::Write)
-            add_fd_to_set(notifier->fd(), wfds);
-        if (notifier->event_mask() & CNotifier::Exceptional)
-            ASSERT_NOT_REACHED();
-    }
-
     bool queued_events_is_empty;
     {
         LOCKER(m_lock);
@@ -336,22 +326,30 @@ void CEventLoop::wait_for_event(WaitMode mode)
     }
 
     timeval now;
-    struct timeval timeout = { 0, 0 };
-    bool should_wait_forever = false;
+    int timeout_ms = 0;
     if (mode == WaitMode::WaitForEvents) {
         if (!s_timers->is_empty() && queued_events_is_empty) {
+            struct timeval timeout;
             gettimeofday(&now, nullptr);
             get_next_timer_expiration(timeout);
             timeval_sub(timeout, now, timeout);
+            if (timeout.tv_sec < 0)
+                timeout_ms = 0;
+            else
+                timeout_ms = timeout.tv_sec * 1000 + (timeout.tv_usec + 999) / 1000;
         } else {
-            should_wait_forever = true;
+            timeout_ms = -1;
         }
-    } else {
-        should_wait_forever = false;
     }
 
-    int marked_fd_count = CSyscallUtils::safe_syscall(select, max_fd + 1, &rfds, &wfds, nullptr, should_wait_forever ? nullptr : &timeout);
-    if (FD_ISSET(s_wake_pipe_fds[0], &rfds)) {
+    // NOTE: The kernel only hands us the fds that are actually ready, so this doesn't
+    //       get any slower as the number of notifiers goes up.
+    epoll_event events[64];
+    int ready_count = CSyscallUtils::safe_syscall(epoll_wait, s_epoll_fd, events, (int)(sizeof(events) / sizeof(events[0])), timeout_ms);
+
+    for (int i = 0; i < ready_count; ++i) {
+        if (events[i].data.fd != s_wake_pipe_fds[0])
+            continue;
         char buffer[32];
         auto nread = read(s_wake_pipe_fds[0], buffer, sizeof(buffer));
         if (nread < 0) {
@@ -386,17 +384,19 @@ void CEventLoop::wait_for_event(WaitMode mode)
         }
     }
 
-    if (!marked_fd_count)
-        return;
-
-    for (auto& notifier : *s_notifiers) {
-        if (FD_ISSET(notifier->fd(), &rfds)) {
-            if (notifier->on_ready_to_read)
-                post_event(*notifier, make<CNotifierReadEvent>(notifier->fd()));
-        }
-        if (FD_ISSET(notifier->fd(), &wfds)) {
-            if (notifier->on_ready_to_write)
-                post_event(*notifier, make<CNotifierWriteEvent>(notifier->fd()));
+    for (int i = 0; i < ready_count; ++i) {
+        auto it = s_notifiers->find(events[i].data.fd);
+        if (it == s_notifiers->end())
+            continue;
+        for (auto* notifier : (*it).value) {
+            if ((events[i].events & EPOLLIN) && (notifier->event_mask() & CNotifier::Read)) {
+                if (notifier->on_ready_to_read)
+                    post_event(*notifier, make<CNotifierReadEvent>(notifier->fd()));
+            }
+            if ((events[i].events & EPOLLOUT) && (notifier->event_mask() & CNotifier::Write)) {
+                if (notifier->on_ready_to_write)
+                    post_event(*notifier, make<CNotifierWriteEvent>(notifier->fd()));
+            }
         }
     }
 }
@@ -457,14 +457,64 @@ bool CEventLoop::unregister_timer(int timer_id)
     return true;
 }
 
+void CEventLoop::update_interest(int fd)
+{
+    unsigned event_mask = 0;
+    auto it = s_notifiers->find(fd);
+    if (it != s_notifiers->end()) {
+        for (auto* notifier : (*it).value)
+            event_mask |= notifier->event_mask();
+    }
+    ASSERT(!(event_mask & CNotifier::Exceptional));
+
+    if (!event_mask) {
+        // NOTE: This fails if the fd has already been closed, which is fine.
+        epoll_ctl(s_epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+        return;
+    }
+
+    epoll_event event;
+    memset(&event, 0, sizeof(event));
+    if (event_mask & CNotifier::Read)
+        event.events |= EPOLLIN;
+    if (event_mask & CNotifier::Write)
+        event.events |= EPOLLOUT;
+    event.data.fd = fd;
+    int rc = epoll_ctl(s_epoll_fd, EPOLL_CTL_MOD, fd, &event);
+    if (rc < 0 && errno == ENOENT)
+        rc = epoll_ctl(s_epoll_fd, EPOLL_CTL_ADD, fd, &event);
+    if (rc < 0)
+        perror("CEventLoop: epoll_ctl");
+}
+
 void CEventLoop::register_notifier(Badge<CNotifier>, CNotifier& notifier)
 {
-    s_notifiers->set(&notifier);
+    if (!s_notifiers->contains(notifier.fd()))
+        s_notifiers->set(notifier.fd(), {});
+    auto& notifiers = (*s_notifiers->find(notifier.fd())).value;
+    if (!notifiers.contains_slow(&notifier))
+        notifiers.append(&notifier);
+    update_interest(notifier.fd());
 }
 
 void CEventLoop::unregister_notifier(Badge<CNotifier>, CNotifier& notifier)
 {
-    s_notifiers->remove(&notifier);
+    auto it = s_notifiers->find(notifier.fd());
+    if (it == s_notifiers->end())
+        return;
+    auto& notifiers = (*it).value;
+    notifiers.remove_first_matching([&](auto* entry) { return entry == &notifier; });
+    if (notifiers.is_empty())
+        s_notifiers->remove(it);
+    update_interest(notifier.fd());
+}
+
+void CEventLoop::update_notifier(Badge<CNotifier>, CNotifier& notifier)
+{
+    auto it = s_notifiers->find(notifier.fd());
+    if (it == s_notifiers->end() || !(*it).value.contains_slow(&notifier))
+        return;
+    update_interest(notifier.fd());
 }
 
 void CEventLoop::wake()
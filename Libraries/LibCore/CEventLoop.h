@@ -8,7 +8,6 @@
 #include <LibCore/CEvent.h>
 #include <LibCore/CLocalServer.h>
 #include <LibThread/Lock.h>
-#include <sys/select.h>
 #include <sys/time.h>
 #include <time.h>
 
@@ -43,6 +42,7 @@ public:
 
     static void register_notifier(Badge<CNotifier>, CNotifier&);
     static void unregister_notifier(Badge<CNotifier>, CNotifier&);
+    static void update_notifier(Badge<CNotifier>, CNotifier&);
 
     void quit(int);
     void unquit();
@@ -57,6 +57,7 @@ public:
 private:
     void wait_for_event(WaitMode);
     void get_next_timer_expiration(timeval&);
+    static void update_interest(int fd);
 
     struct QueuedEvent {
         WeakPtr<CObject> receiver;
@@ -69,6 +70,7 @@ private:
     int m_exit_code { 0 };
 
     static int s_wake_pipe_fds[2];
+    static int s_epoll_fd;
 
     LibThread::Lock m_lock;
 
@@ -86,7 +88,8 @@ private:
 
     static HashMap<int, NonnullOwnPtr<EventLoopTimer>>* s_timers;
 
-    static HashTable<CNotifier*>* s_notifiers;
+    // All notifiers, by the fd they're watching. There may be more than one per fd.
+    static HashMap<int, Vector<CNotifier*, 1>>* s_notifiers;
 
     static RefPtr<CLocalServer> s_rpc_server;
 };
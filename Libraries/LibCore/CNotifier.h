@@ -22,7 +22,7 @@ public:
 
     int fd() const { return m_fd; }
     unsigned event_mask() const { return m_event_mask; }
-    void set_event_mask(unsigned event_mask) { m_event_mask = event_mask; }
+    void set_event_mask(unsigned event_mask);
 
     void event(CEvent&) override;
 
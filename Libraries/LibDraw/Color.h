@@ -102,6 +102,11 @@ public:
         return Color(r, g, b, a);
     }
 
+    // Premultiplied pixels have their red, green and blue already multiplied by alpha,
+    // which turns drawing one pixel over another into a multiply and an add.
+    RGBA32 to_premultiplied() const;
+    static Color from_premultiplied(RGBA32);
+
     Color to_grayscale() const
     {
         int gray = (red() + green() + blue()) / 3;
@@ -147,6 +152,40 @@ private:
     RGBA32 m_value { 0 };
 };
 
+// Multiplies all four channels of `pixel` by factor / 255, rounding to nearest, without dividing.
+inline RGBA32 scale_pixel(RGBA32 pixel, u32 factor)
+{
+    u32 red_and_blue = (pixel & 0x00ff00ff) * factor + 0x00800080;
+    u32 alpha_and_green = ((pixel >> 8) & 0x00ff00ff) * factor + 0x00800080;
+    red_and_blue = ((red_and_blue + ((red_and_blue >> 8) & 0x00ff00ff)) >> 8) & 0x00ff00ff;
+    alpha_and_green = (alpha_and_green + ((alpha_and_green >> 8) & 0x00ff00ff)) & 0xff00ff00;
+    return red_and_blue | alpha_and_green;
+}
+
+// Draws the premultiplied pixel `src` over the premultiplied pixel `dst`.
+inline RGBA32 premultiplied_over(RGBA32 dst, RGBA32 src)
+{
+    return src + scale_pixel(dst, 255 - (src >> 24));
+}
+
+inline RGBA32 Color::to_premultiplied() const
+{
+    return (scale_pixel(m_value, alpha()) & 0x00ffffff) | (m_value & 0xff000000);
+}
+
+inline Color Color::from_premultiplied(RGBA32 pixel)
+{
+    u32 alpha = pixel >> 24;
+    if (alpha == 0xff)
+        return Color(pixel);
+    if (!alpha)
+        return Color(0);
+    auto unscale = [&](u32 channel) -> u8 {
+        return min(255u, (channel * 255 + alpha / 2) / alpha);
+    };
+    return Color(unscale((pixel >> 16) & 0xff), unscale((pixel >> 8) & 0xff), unscale(pixel & 0xff), alpha);
+}
+
 inline const LogStream& operator<<(const LogStream& stream, Color value)
 {
     return stream << value.to_string();
@@ -1,45 +1,240 @@
 #include <LibDraw/DisjointRectSet.h>
 
-void DisjointRectSet::add(const Rect& new_rect)
+// Returns the index just past the end of the band that starts at `start`.
+static int end_of_band(const Vector<Rect, 32>& rects, int start)
 {
-    for (auto& rect : m_rects) {
-        if (rect.contains(new_rect))
+    int end = start + 1;
+    while (end < rects.size() && rects[end].y() == rects[start].y())
+        ++end;
+    return end;
+}
+
+// Adds the span [left, right) to the band being built at the end of `output`,
+// merging it with the previous span if they touch.
+static void append_span(Vector<Rect, 32>& output, int band_start, int left, int right, int top, int bottom)
+{
+    if (output.size() > band_start) {
+        auto& last = output.last();
+        if (last.x() + last.width() == left) {
+            last.set_width(right - last.x());
             return;
+        }
     }
+    output.append({ left, top, right - left, bottom - top });
+}
 
-    m_rects.append(new_rect);
-    if (m_rects.size() > 1)
-        shatter();
+// Merges the band that was just added at `band_start` into the one above it, if they touch
+// and have exactly the same spans.
+static void coalesce_band(Vector<Rect, 32>& output, int& previous_band_start, int band_start)
+{
+    int band_size = output.size() - band_start;
+    if (!band_size)
+        return;
+    if (previous_band_start < 0
+        || band_start - previous_band_start != band_size
+        || output[previous_band_start].y() + output[previous_band_start].height() != output[band_start].y()) {
+        previous_band_start = band_start;
+        return;
+    }
+    for (int i = 0; i < band_size; ++i) {
+        auto& above = output[previous_band_start + i];
+        auto& below = output[band_start + i];
+        if (above.x() != below.x() || above.width() != below.width()) {
+            previous_band_start = band_start;
+            return;
+        }
+    }
+    int height = output[band_start].height();
+    for (int i = previous_band_start; i < band_start; ++i)
+        output[i].set_height(output[i].height() + height);
+    output.shrink(band_start);
 }
 
-void DisjointRectSet::shatter()
+void DisjointRectSet::combine(const Vector<Rect, 32>& other, Operation operation)
 {
+    auto& a = m_rects;
+    auto& b = other;
+    auto should_include = [operation](bool in_a, bool in_b) {
+        switch (operation) {
+        case Operation::Union:
+            return in_a || in_b;
+        case Operation::Intersection:
+            return in_a && in_b;
+        case Operation::Difference:
+            return in_a && !in_b;
+        }
+        ASSERT_NOT_REACHED();
+    };
+
     Vector<Rect, 32> output;
-    output.ensure_capacity(m_rects.size());
-    bool pass_had_intersections = false;
-    do {
-        pass_had_intersections = false;
-        output.clear_with_capacity();
-        for (int i = 0; i < m_rects.size(); ++i) {
-            auto& r1 = m_rects[i];
-            for (int j = 0; j < m_rects.size(); ++j) {
-                if (i == j)
-                    continue;
-                auto& r2 = m_rects[j];
-                if (!r1.intersects(r2))
-                    continue;
-                pass_had_intersections = true;
-                auto pieces = r1.shatter(r2);
-                for (auto& piece : pieces)
-                    output.append(piece);
-                m_rects.remove(i);
-                for (; i < m_rects.size(); ++i)
-                    output.append(m_rects[i]);
-                goto next_pass;
+    output.ensure_capacity(a.size() + b.size());
+    int previous_band_start = -1;
+
+    // Sweep down the plane, stopping wherever a band of either set starts or ends.
+    int a_band = 0;
+    int b_band = 0;
+    int y = 0;
+    if (!a.is_empty() && !b.is_empty())
+        y = min(a.first().y(), b.first().y());
+    else if (!a.is_empty())
+        y = a.first().y();
+    else if (!b.is_empty())
+        y = b.first().y();
+
+    for (;;) {
+        while (a_band < a.size() && a[a_band].y() + a[a_band].height() <= y)
+            a_band = end_of_band(a, a_band);
+        while (b_band < b.size() && b[b_band].y() + b[b_band].height() <= y)
+            b_band = end_of_band(b, b_band);
+        bool a_done = a_band == a.size();
+        bool b_done = b_band == b.size();
+        if (a_done && b_done)
+            break;
+        if (a_done && !should_include(false, true))
+            break;
+        if (b_done && !should_include(true, false))
+            break;
+
+        bool in_a = !a_done && a[a_band].y() <= y;
+        bool in_b = !b_done && b[b_band].y() <= y;
+        int next_y = 0;
+        bool have_next_y = false;
+        auto consider_next_y = [&](int candidate) {
+            if (!have_next_y || candidate < next_y)
+                next_y = candidate;
+            have_next_y = true;
+        };
+        if (!a_done)
+            consider_next_y(in_a ? a[a_band].y() + a[a_band].height() : a[a_band].y());
+        if (!b_done)
+            consider_next_y(in_b ? b[b_band].y() + b[b_band].height() : b[b_band].y());
+
+        if (in_a || in_b) {
+            int band_start = output.size();
+            int ia = in_a ? a_band : 0;
+            int a_end = in_a ? end_of_band(a, a_band) : 0;
+            int ib = in_b ? b_band : 0;
+            int b_end = in_b ? end_of_band(b, b_band) : 0;
+
+            // Same thing again, left to right within the band.
+            int x = 0;
+            if (ia < a_end && ib < b_end)
+                x = min(a[ia].x(), b[ib].x());
+            else if (ia < a_end)
+                x = a[ia].x();
+            else if (ib < b_end)
+                x = b[ib].x();
+            for (;;) {
+                while (ia < a_end && a[ia].x() + a[ia].width() <= x)
+                    ++ia;
+                while (ib < b_end && b[ib].x() + b[ib].width() <= x)
+                    ++ib;
+                if (ia == a_end && ib == b_end)
+                    break;
+                bool in_a_span = ia < a_end && a[ia].x() <= x;
+                bool in_b_span = ib < b_end && b[ib].x() <= x;
+                int next_x;
+                if (ia < a_end && ib < b_end)
+                    next_x = min(in_a_span ? a[ia].x() + a[ia].width() : a[ia].x(), in_b_span ? b[ib].x() + b[ib].width() : b[ib].x());
+                else if (ia < a_end)
+                    next_x = in_a_span ? a[ia].x() + a[ia].width() : a[ia].x();
+                else
+                    next_x = in_b_span ? b[ib].x() + b[ib].width() : b[ib].x();
+                if (should_include(in_a_span, in_b_span))
+                    append_span(output, band_start, x, next_x, y, next_y);
+                x = next_x;
             }
-            output.append(r1);
+            coalesce_band(output, previous_band_start, band_start);
         }
-    next_pass:
-        swap(output, m_rects);
-    } while (pass_had_intersections);
+        y = next_y;
+    }
+
+    swap(m_rects, output);
+
+    if (m_max_rect_count && m_rects.size() > m_max_rect_count) {
+        auto bounds = bounding_rect();
+        m_rects.clear_with_capacity();
+        m_rects.append(bounds);
+    }
+}
+
+void DisjointRectSet::add(const Rect& new_rect)
+{
+    if (new_rect.is_empty())
+        return;
+    if (m_rects.is_empty()) {
+        m_rects.append(new_rect);
+        return;
+    }
+    for (auto& rect : m_rects) {
+        if (rect.contains(new_rect))
+            return;
+    }
+    Vector<Rect, 32> rects;
+    rects.append(new_rect);
+    combine(rects, Operation::Union);
+}
+
+void DisjointRectSet::add(const DisjointRectSet& other)
+{
+    if (other.is_empty())
+        return;
+    combine(other.m_rects, Operation::Union);
+}
+
+void DisjointRectSet::subtract(const Rect& hammer)
+{
+    if (hammer.is_empty() || !intersects(hammer))
+        return;
+    Vector<Rect, 32> rects;
+    rects.append(hammer);
+    combine(rects, Operation::Difference);
+}
+
+void DisjointRectSet::subtract(const DisjointRectSet& other)
+{
+    if (other.is_empty() || is_empty())
+        return;
+    combine(other.m_rects, Operation::Difference);
+}
+
+void DisjointRectSet::intersect(const Rect& rect)
+{
+    if (is_empty())
+        return;
+    Vector<Rect, 32> rects;
+    if (!rect.is_empty())
+        rects.append(rect);
+    combine(rects, Operation::Intersection);
+}
+
+void DisjointRectSet::intersect(const DisjointRectSet& other)
+{
+    if (is_empty())
+        return;
+    combine(other.m_rects, Operation::Intersection);
+}
+
+bool DisjointRectSet::intersects(const Rect& other) const
+{
+    for (auto& rect : m_rects) {
+        if (rect.intersects(other))
+            return true;
+    }
+    return false;
+}
+
+Rect DisjointRectSet::bounding_rect() const
+{
+    if (m_rects.is_empty())
+        return {};
+    int left = m_rects.first().x();
+    int right = m_rects.first().right();
+    for (auto& rect : m_rects) {
+        left = min(left, rect.x());
+        right = max(right, rect.right());
+    }
+    int top = m_rects.first().y();
+    int bottom = m_rects.last().bottom();
+    return { left, top, right - left + 1, bottom - top + 1 };
 }
@@ -3,16 +3,46 @@
 #include <AK/Vector.h>
 #include <LibDraw/Rect.h>
 
+// A region of the plane, stored as a list of rects that don't overlap.
+//
+// The rects are kept in bands: horizontal strips of rects that all have the same y and height,
+// sorted from top to bottom. Within a band the rects are sorted from left to right and never
+// touch each other. Bands that are directly on top of each other and contain the same spans
+// are merged into one, so a region always has the same (and the smallest) set of rects
+// no matter in which order it was built.
 class DisjointRectSet {
 public:
     DisjointRectSet() {}
+    // A set that would grow past `max_rect_count` rects turns into its bounding rect instead.
+    // This is meant for dirty rects, where painting a bit too much is fine.
+    explicit DisjointRectSet(int max_rect_count)
+        : m_max_rect_count(max_rect_count)
+    {
+    }
     ~DisjointRectSet() {}
     DisjointRectSet(DisjointRectSet&& other)
         : m_rects(move(other.m_rects))
+        , m_max_rect_count(other.m_max_rect_count)
     {
     }
+    DisjointRectSet& operator=(DisjointRectSet&& other)
+    {
+        m_rects = move(other.m_rects);
+        m_max_rect_count = other.m_max_rect_count;
+        return *this;
+    }
 
     void add(const Rect&);
+    void add(const DisjointRectSet&);
+    // Removes the parts of the set that are inside `hammer`.
+    void subtract(const Rect& hammer);
+    void subtract(const DisjointRectSet&);
+    // Removes the parts of the set that are outside of the given rect(s).
+    void intersect(const Rect&);
+    void intersect(const DisjointRectSet&);
+
+    bool intersects(const Rect&) const;
+    Rect bounding_rect() const;
 
     bool is_empty() const { return m_rects.is_empty(); }
     int size() const { return m_rects.size(); }
@@ -22,7 +52,13 @@ public:
     const Vector<Rect, 32>& rects() const { return m_rects; }
 
 private:
-    void shatter();
+    enum class Operation {
+        Union,
+        Intersection,
+        Difference,
+    };
+    void combine(const Vector<Rect, 32>&, Operation);
 
     Vector<Rect, 32> m_rects;
+    int m_max_rect_count { 0 };
 };
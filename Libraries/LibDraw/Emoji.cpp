@@ -13,7 +13,7 @@ const GraphicsBitmap* Emoji::emoji_for_codepoint(u32 codepoint)
 
     String path = String::format("/res/emoji/U+%X.png", codepoint);
 
-    auto bitmap = GraphicsBitmap::load_from_file(path);
+    auto bitmap = GraphicsBitmap::load_from_file(path, GraphicsBitmap::PremultiplyAlpha::Yes);
     if (!bitmap) {
         s_emojis.set(codepoint, nullptr);
         return nullptr;
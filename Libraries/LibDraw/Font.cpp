@@ -198,6 +198,21 @@ int Font::width(const StringView& string) const
 
 int Font::width(const Utf8View& utf8) const
 {
+    // Most text is plain ASCII, which we can measure without decoding it.
+    auto& string = utf8.as_string();
+    int ascii_width = 0;
+    bool is_ascii = true;
+    for (size_t i = 0; i < string.length(); ++i) {
+        u8 ch = string.characters_without_null_termination()[i];
+        if (ch >= 0x80) {
+            is_ascii = false;
+            break;
+        }
+        ascii_width += glyph_width(ch);
+    }
+    if (is_ascii)
+        return string.is_empty() ? 0 : ascii_width + ((int)string.length() - 1) * glyph_spacing();
+
     bool first = true;
     int width = 0;
 
@@ -210,3 +225,59 @@ int Font::width(const Utf8View& utf8) const
 
     return width;
 }
+
+int Font::elided_byte_length(const Utf8View& text, int max_width) const
+{
+    auto& string = text.as_string();
+    if (m_elision_cache.is_empty())
+        m_elision_cache.resize(elision_cache_size);
+    auto& entry = m_elision_cache[(string_hash(string.characters_without_null_termination(), string.length()) + max_width) % elision_cache_size];
+    if (entry.max_width == max_width && entry.text == string)
+        return entry.byte_length;
+
+    int byte_length = -1;
+    int text_width = width(text);
+    int new_width = width("...");
+    if (text_width > max_width && new_width < text_width) {
+        int spacing = glyph_spacing();
+        byte_length = 0;
+        for (auto it = text.begin(); it != text.end(); ++it) {
+            int this_glyph_width = glyph_or_emoji_width(*it);
+            // NOTE: Glyph spacing should not be added after the last glyph on the line,
+            //       but since we are here because the last glyph does not actually fit on the line,
+            //       we don't have to worry about spacing.
+            int width_with_this_glyph_included = new_width + this_glyph_width + spacing;
+            if (width_with_this_glyph_included > max_width)
+                break;
+            byte_length = text.byte_offset_of(it);
+            new_width += this_glyph_width + spacing;
+        }
+    }
+
+    entry.text = string;
+    entry.max_width = max_width;
+    entry.byte_length = byte_length;
+    return byte_length;
+}
+
+GlyphAtlas::GlyphAtlas(const Font& font)
+{
+    for (int ch = 0; ch < 256; ++ch) {
+        m_first_span[ch] = m_spans.size();
+        auto bitmap = font.glyph_bitmap((char)ch);
+        for (int y = 0; y < bitmap.height(); ++y) {
+            int x = 0;
+            while (x < bitmap.width()) {
+                if (!bitmap.bit_at(x, y)) {
+                    ++x;
+                    continue;
+                }
+                int start = x;
+                while (x < bitmap.width() && bitmap.bit_at(x, y))
+                    ++x;
+                m_spans.append({ (u8)start, (u8)y, (u8)(x - start) });
+            }
+        }
+    }
+    m_first_span[256] = m_spans.size();
+}
@@ -2,9 +2,11 @@
 
 #include <AK/String.h>
 #include <AK/MappedFile.h>
+#include <AK/OwnPtr.h>
 #include <AK/RefPtr.h>
 #include <AK/RefCounted.h>
 #include <AK/Types.h>
+#include <AK/Vector.h>
 #include <LibDraw/Rect.h>
 #include <AK/Utf8View.h>
 
@@ -41,6 +43,30 @@ private:
     Size m_size;
 };
 
+class Font;
+
+// A horizontal run of lit pixels on one row of a glyph.
+struct GlyphSpan {
+    u8 x;
+    u8 y;
+    u8 width;
+};
+
+// All the glyphs of a font, expanded once into spans. Drawing a glyph from here is a few
+// fills per row instead of testing every bit of the row.
+class GlyphAtlas {
+public:
+    explicit GlyphAtlas(const Font&);
+
+    // The spans of a glyph, from top to bottom and left to right within each row.
+    const GlyphSpan* spans(char ch) const { return m_spans.data() + m_first_span[(u8)ch]; }
+    int span_count(char ch) const { return m_first_span[(u8)ch + 1] - m_first_span[(u8)ch]; }
+
+private:
+    Vector<GlyphSpan> m_spans;
+    int m_first_span[257];
+};
+
 class Font : public RefCounted<Font> {
 public:
     static Font& default_font();
@@ -58,6 +84,19 @@ public:
 
     GlyphBitmap glyph_bitmap(char ch) const { return GlyphBitmap(&m_rows[(u8)ch * m_glyph_height], { glyph_width(ch), m_glyph_height }); }
 
+    const GlyphAtlas& glyph_atlas() const
+    {
+        if (!m_glyph_atlas)
+            m_glyph_atlas = make<GlyphAtlas>(*this);
+        return *m_glyph_atlas;
+    }
+    // Call this after changing a glyph through its GlyphBitmap.
+    void did_change_glyphs()
+    {
+        m_glyph_atlas = nullptr;
+        m_elision_cache.clear();
+    }
+
     u8 glyph_width(char ch) const { return m_fixed_width ? m_glyph_width : m_glyph_widths[(u8)ch]; }
     int glyph_or_emoji_width(u32 codepoint) const;
     u8 glyph_height() const { return m_glyph_height; }
@@ -66,19 +105,33 @@ public:
     int width(const StringView&) const;
     int width(const Utf8View&) const;
 
+    // Returns how many bytes of `text` fit within `max_width` when followed by "...", or -1 if
+    // the text should be drawn as-is. The results are cached, since the same titles and labels
+    // tend to get elided over and over again on every repaint.
+    int elided_byte_length(const Utf8View& text, int max_width) const;
+
     String name() const { return m_name; }
     void set_name(const StringView& name) { m_name = name; }
 
     bool is_fixed_width() const { return m_fixed_width; }
-    void set_fixed_width(bool b) { m_fixed_width = b; }
+    void set_fixed_width(bool b)
+    {
+        m_fixed_width = b;
+        did_change_glyphs();
+    }
 
     u8 glyph_spacing() const { return m_glyph_spacing; }
-    void set_glyph_spacing(u8 spacing) { m_glyph_spacing = spacing; }
+    void set_glyph_spacing(u8 spacing)
+    {
+        m_glyph_spacing = spacing;
+        m_elision_cache.clear();
+    }
 
     void set_glyph_width(char ch, u8 width)
     {
         ASSERT(m_glyph_widths);
         m_glyph_widths[(u8)ch] = width;
+        did_change_glyphs();
     }
 
 private:
@@ -99,4 +152,14 @@ private:
     u8 m_glyph_spacing { 0 };
 
     bool m_fixed_width { false };
+
+    mutable OwnPtr<GlyphAtlas> m_glyph_atlas;
+
+    struct ElisionCacheEntry {
+        String text;
+        int max_width { 0 };
+        int byte_length { -1 };
+    };
+    static const int elision_cache_size = 32;
+    mutable Vector<ElisionCacheEntry> m_elision_cache;
 };
@@ -36,9 +36,9 @@ NonnullRefPtr<GraphicsBitmap> GraphicsBitmap::create_wrapper(Format format, cons
     return adopt(*new GraphicsBitmap(format, size, pitch, data));
 }
 
-RefPtr<GraphicsBitmap> GraphicsBitmap::load_from_file(const StringView& path)
+RefPtr<GraphicsBitmap> GraphicsBitmap::load_from_file(const StringView& path, PremultiplyAlpha premultiply_alpha)
 {
-    return load_png(path);
+    return load_png(path, premultiply_alpha);
 }
 
 RefPtr<GraphicsBitmap> GraphicsBitmap::load_from_file(Format format, const StringView& path, const Size& size)
@@ -112,13 +112,25 @@ void GraphicsBitmap::set_mmap_name(const StringView& name)
 
 void GraphicsBitmap::fill(Color color)
 {
-    ASSERT(m_format == GraphicsBitmap::Format::RGB32 || m_format == GraphicsBitmap::Format::RGBA32);
+    ASSERT(bpp() == 32);
+    RGBA32 value = value_for(color);
     for (int y = 0; y < height(); ++y) {
         auto* scanline = this->scanline(y);
-        fast_u32_fill(scanline, color.value(), width());
+        fast_u32_fill(scanline, value, width());
     }
 }
 
+void GraphicsBitmap::premultiply_alpha()
+{
+    ASSERT(m_format == Format::RGBA32);
+    for (int y = 0; y < height(); ++y) {
+        auto* scanline = this->scanline(y);
+        for (int x = 0; x < width(); ++x)
+            scanline[x] = Color::from_rgba(scanline[x]).to_premultiplied();
+    }
+    m_format = Format::RGBA32Premultiplied;
+}
+
 void GraphicsBitmap::set_volatile()
 {
     ASSERT(m_purgeable);
@@ -16,13 +16,19 @@ public:
         Invalid,
         RGB32,
         RGBA32,
+        RGBA32Premultiplied,
         Indexed8
     };
 
+    enum class PremultiplyAlpha {
+        No,
+        Yes
+    };
+
     static NonnullRefPtr<GraphicsBitmap> create(Format, const Size&);
     static NonnullRefPtr<GraphicsBitmap> create_purgeable(Format, const Size&);
     static NonnullRefPtr<GraphicsBitmap> create_wrapper(Format, const Size&, size_t pitch, RGBA32*);
-    static RefPtr<GraphicsBitmap> load_from_file(const StringView& path);
+    static RefPtr<GraphicsBitmap> load_from_file(const StringView& path, PremultiplyAlpha = PremultiplyAlpha::No);
     static RefPtr<GraphicsBitmap> load_from_file(Format, const StringView& path, const Size&);
     static NonnullRefPtr<GraphicsBitmap> create_with_shared_buffer(Format, NonnullRefPtr<SharedBuffer>&&, const Size&);
 
@@ -53,6 +59,7 @@ public:
             return 8;
         case Format::RGB32:
         case Format::RGBA32:
+        case Format::RGBA32Premultiplied:
             return 32;
         default:
             ASSERT_NOT_REACHED();
@@ -63,9 +70,16 @@ public:
 
     void fill(Color);
 
-    bool has_alpha_channel() const { return m_format == Format::RGBA32; }
+    bool has_alpha_channel() const { return m_format == Format::RGBA32 || m_format == Format::RGBA32Premultiplied; }
+    bool has_premultiplied_alpha() const { return m_format == Format::RGBA32Premultiplied; }
     Format format() const { return m_format; }
 
+    // Turns an RGBA32 bitmap into an RGBA32Premultiplied one, in place.
+    void premultiply_alpha();
+
+    // The value to store in this bitmap for a pixel of the given color.
+    RGBA32 value_for(Color color) const { return has_premultiplied_alpha() ? color.to_premultiplied() : color.value(); }
+
     void set_mmap_name(const StringView&);
 
     size_t size_in_bytes() const { return m_pitch * m_size.height(); }
@@ -156,6 +170,12 @@ inline Color GraphicsBitmap::get_pixel<GraphicsBitmap::Format::RGBA32>(int x, in
     return Color::from_rgba(scanline(y)[x]);
 }
 
+template<>
+inline Color GraphicsBitmap::get_pixel<GraphicsBitmap::Format::RGBA32Premultiplied>(int x, int y) const
+{
+    return Color::from_premultiplied(scanline(y)[x]);
+}
+
 template<>
 inline Color GraphicsBitmap::get_pixel<GraphicsBitmap::Format::Indexed8>(int x, int y) const
 {
@@ -169,6 +189,8 @@ inline Color GraphicsBitmap::get_pixel(int x, int y) const
         return get_pixel<Format::RGB32>(x, y);
     case Format::RGBA32:
         return get_pixel<Format::RGBA32>(x, y);
+    case Format::RGBA32Premultiplied:
+        return get_pixel<Format::RGBA32Premultiplied>(x, y);
     case Format::Indexed8:
         return get_pixel<Format::Indexed8>(x, y);
     default:
@@ -189,6 +211,12 @@ inline void GraphicsBitmap::set_pixel<GraphicsBitmap::Format::RGBA32>(int x, int
     scanline(y)[x] = color.value();
 }
 
+template<>
+inline void GraphicsBitmap::set_pixel<GraphicsBitmap::Format::RGBA32Premultiplied>(int x, int y, Color color)
+{
+    scanline(y)[x] = color.to_premultiplied();
+}
+
 inline void GraphicsBitmap::set_pixel(int x, int y, Color color)
 {
     switch (m_format) {
@@ -198,6 +226,9 @@ inline void GraphicsBitmap::set_pixel(int x, int y, Color color)
     case Format::RGBA32:
         set_pixel<Format::RGBA32>(x, y, color);
         break;
+    case Format::RGBA32Premultiplied:
+        set_pixel<Format::RGBA32Premultiplied>(x, y, color);
+        break;
     case Format::Indexed8:
         ASSERT_NOT_REACHED();
     default:
@@ -83,6 +83,7 @@ struct PNGLoadingContext {
     u8 interlace_method { 0 };
     u8 bytes_per_pixel { 0 };
     bool has_seen_zlib_header { false };
+    bool premultiply_alpha { false };
     bool has_alpha() const { return color_type & 4 || palette_transparency_data.size() > 0; }
     Vector<Scanline> scanlines;
     RefPtr<GraphicsBitmap> bitmap;
@@ -143,23 +144,23 @@ private:
     int m_size_remaining;
 };
 
-static RefPtr<GraphicsBitmap> load_png_impl(const u8*, int);
+static RefPtr<GraphicsBitmap> load_png_impl(const u8*, int, GraphicsBitmap::PremultiplyAlpha);
 static bool process_chunk(Streamer&, PNGLoadingContext& context, bool decode_size_only);
 
-RefPtr<GraphicsBitmap> load_png(const StringView& path)
+RefPtr<GraphicsBitmap> load_png(const StringView& path, GraphicsBitmap::PremultiplyAlpha premultiply_alpha)
 {
     MappedFile mapped_file(path);
     if (!mapped_file.is_valid())
         return nullptr;
-    auto bitmap = load_png_impl((const u8*)mapped_file.data(), mapped_file.size());
+    auto bitmap = load_png_impl((const u8*)mapped_file.data(), mapped_file.size(), premultiply_alpha);
     if (bitmap)
         bitmap->set_mmap_name(String::format("GraphicsBitmap [%dx%d] - Decoded PNG: %s", bitmap->width(), bitmap->height(), canonicalized_path(path).characters()));
     return bitmap;
 }
 
-RefPtr<GraphicsBitmap> load_png_from_memory(const u8* data, size_t length)
+RefPtr<GraphicsBitmap> load_png_from_memory(const u8* data, size_t length, GraphicsBitmap::PremultiplyAlpha premultiply_alpha)
 {
-    auto bitmap = load_png_impl(data, length);
+    auto bitmap = load_png_impl(data, length, premultiply_alpha);
     if (bitmap)
         bitmap->set_mmap_name(String::format("GraphicsBitmap [%dx%d] - Decoded PNG: <memory>", bitmap->width(), bitmap->height()));
     return bitmap;
@@ -520,6 +521,13 @@ static bool decode_png_bitmap(PNGLoadingContext& context)
 
     unfilter(context);
 
+    if (context.premultiply_alpha && context.has_alpha()) {
+#ifdef PNG_STOPWATCH_DEBUG
+        Stopwatch sw("load_png_impl: premultiply alpha");
+#endif
+        context.bitmap->premultiply_alpha();
+    }
+
     munmap(context.decompression_buffer, context.decompression_buffer_size);
     context.decompression_buffer = nullptr;
     context.decompression_buffer_size = 0;
@@ -528,11 +536,12 @@ static bool decode_png_bitmap(PNGLoadingContext& context)
     return true;
 }
 
-static RefPtr<GraphicsBitmap> load_png_impl(const u8* data, int data_size)
+static RefPtr<GraphicsBitmap> load_png_impl(const u8* data, int data_size, GraphicsBitmap::PremultiplyAlpha premultiply_alpha)
 {
     PNGLoadingContext context;
     context.data = data;
     context.data_size = data_size;
+    context.premultiply_alpha = premultiply_alpha == GraphicsBitmap::PremultiplyAlpha::Yes;
 
     if (!decode_png_chunks(context))
         return nullptr;
@@ -3,8 +3,8 @@
 #include <LibDraw/GraphicsBitmap.h>
 #include <LibDraw/ImageDecoder.h>
 
-RefPtr<GraphicsBitmap> load_png(const StringView& path);
-RefPtr<GraphicsBitmap> load_png_from_memory(const u8*, size_t);
+RefPtr<GraphicsBitmap> load_png(const StringView& path, GraphicsBitmap::PremultiplyAlpha = GraphicsBitmap::PremultiplyAlpha::No);
+RefPtr<GraphicsBitmap> load_png_from_memory(const u8*, size_t, GraphicsBitmap::PremultiplyAlpha = GraphicsBitmap::PremultiplyAlpha::No);
 
 struct PNGLoadingContext;
 
@@ -2,6 +2,7 @@
 #include "Emoji.h"
 #include "Font.h"
 #include "GraphicsBitmap.h"
+#include "PaintingKernels.h"
 #include <AK/Assertions.h>
 #include <AK/StdLibExtras.h>
 #include <AK/StringBuilder.h>
@@ -13,16 +14,23 @@
 
 #pragma GCC optimize("O3")
 
-template<GraphicsBitmap::Format format = GraphicsBitmap::Format::Invalid>
-static ALWAYS_INLINE Color get_pixel(const GraphicsBitmap& bitmap, int x, int y)
+// Draws a straight alpha color over a pixel of `target`, whichever kind of alpha it has.
+static ALWAYS_INLINE void blend_pixel(const GraphicsBitmap& target, RGBA32& pixel, Color color)
 {
-    if constexpr (format == GraphicsBitmap::Format::Indexed8)
-        return bitmap.palette_color(bitmap.bits(y)[x]);
-    if constexpr (format == GraphicsBitmap::Format::RGB32)
-        return Color::from_rgb(bitmap.scanline(y)[x]);
-    if constexpr (format == GraphicsBitmap::Format::RGBA32)
-        return Color::from_rgba(bitmap.scanline(y)[x]);
-    return bitmap.get_pixel(x, y);
+    if (target.has_premultiplied_alpha())
+        pixel = premultiplied_over(pixel, color.to_premultiplied());
+    else
+        pixel = Color::from_rgba(pixel).blend(color).value();
+}
+
+// Converts a pixel of `source` to the value `target` stores for the same color.
+static ALWAYS_INLINE RGBA32 convert_pixel(const GraphicsBitmap& source, const GraphicsBitmap& target, RGBA32 pixel)
+{
+    if (source.format() == target.format())
+        return pixel;
+    if (source.has_premultiplied_alpha())
+        return target.value_for(Color::from_premultiplied(pixel));
+    return target.value_for(source.has_alpha_channel() ? Color::from_rgba(pixel) : Color::from_rgb(pixel));
 }
 
 Painter::Painter(GraphicsBitmap& bitmap)
@@ -65,8 +73,10 @@ void Painter::clear_rect(const Rect& a_rect, Color color)
     RGBA32* dst = m_target->scanline(rect.top()) + rect.left();
     const size_t dst_skip = m_target->pitch() / sizeof(RGBA32);
 
+    RGBA32 value = m_target->value_for(color);
+    auto& kernels = PaintingKernels::the();
     for (int i = rect.height() - 1; i >= 0; --i) {
-        fast_u32_fill(dst, color.value(), rect.width());
+        kernels.fill(dst, value, rect.width());
         dst += dst_skip;
     }
 }
@@ -95,6 +105,25 @@ void Painter::fill_rect(const Rect& a_rect, Color color)
     RGBA32* dst = m_target->scanline(rect.top()) + rect.left();
     const size_t dst_skip = m_target->pitch() / sizeof(RGBA32);
 
+    if (!m_target->has_alpha_channel()) {
+        auto& kernels = PaintingKernels::the();
+        for (int i = rect.height() - 1; i >= 0; --i) {
+            kernels.blend_color(dst, color, rect.width());
+            dst += dst_skip;
+        }
+        return;
+    }
+
+    if (m_target->has_premultiplied_alpha()) {
+        RGBA32 value = color.to_premultiplied();
+        for (int i = rect.height() - 1; i >= 0; --i) {
+            for (int j = 0; j < rect.width(); ++j)
+                dst[j] = premultiplied_over(dst[j], value);
+            dst += dst_skip;
+        }
+        return;
+    }
+
     for (int i = rect.height() - 1; i >= 0; --i) {
         for (int j = 0; j < rect.width(); ++j)
             dst[j] = Color::from_rgba(dst[j]).blend(color).value();
@@ -165,19 +194,20 @@ void Painter::draw_rect(const Rect& a_rect, Color color, bool rough)
     if (clipped_rect.is_empty())
         return;
 
+    RGBA32 value = m_target->value_for(color);
     int min_y = clipped_rect.top();
     int max_y = clipped_rect.bottom();
 
     if (rect.top() >= clipped_rect.top() && rect.top() <= clipped_rect.bottom()) {
         int start_x = rough ? max(rect.x() + 1, clipped_rect.x()) : clipped_rect.x();
         int width = rough ? min(rect.width() - 2, clipped_rect.width()) : clipped_rect.width();
-        fast_u32_fill(m_target->scanline(rect.top()) + start_x, color.value(), width);
+        fast_u32_fill(m_target->scanline(rect.top()) + start_x, value, width);
         ++min_y;
     }
     if (rect.bottom() >= clipped_rect.top() && rect.bottom() <= clipped_rect.bottom()) {
         int start_x = rough ? max(rect.x() + 1, clipped_rect.x()) : clipped_rect.x();
         int width = rough ? min(rect.width() - 2, clipped_rect.width()) : clipped_rect.width();
-        fast_u32_fill(m_target->scanline(rect.bottom()) + start_x, color.value(), width);
+        fast_u32_fill(m_target->scanline(rect.bottom()) + start_x, value, width);
         --max_y;
     }
 
@@ -188,16 +218,16 @@ void Painter::draw_rect(const Rect& a_rect, Color color, bool rough)
         // Specialized loop when drawing both sides.
         for (int y = min_y; y <= max_y; ++y) {
             auto* bits = m_target->scanline(y);
-            bits[rect.left()] = color.value();
-            bits[rect.right()] = color.value();
+            bits[rect.left()] = value;
+            bits[rect.right()] = value;
         }
     } else {
         for (int y = min_y; y <= max_y; ++y) {
             auto* bits = m_target->scanline(y);
             if (draw_left_side)
-                bits[rect.left()] = color.value();
+                bits[rect.left()] = value;
             if (draw_right_side)
-                bits[rect.right()] = color.value();
+                bits[rect.right()] = value;
         }
     }
 }
@@ -216,12 +246,13 @@ void Painter::draw_bitmap(const Point& p, const CharacterBitmap& bitmap, Color c
     const size_t dst_skip = m_target->pitch() / sizeof(RGBA32);
     const char* bitmap_row = &bitmap.bits()[first_row * bitmap.width() + first_column];
     const size_t bitmap_skip = bitmap.width();
+    RGBA32 value = m_target->value_for(color);
 
     for (int row = first_row; row <= last_row; ++row) {
         for (int j = 0; j <= (last_column - first_column); ++j) {
             char fc = bitmap_row[j];
             if (fc == '#')
-                dst[j] = color.value();
+                dst[j] = value;
         }
         bitmap_row += bitmap_skip;
         dst += dst_skip;
@@ -240,44 +271,15 @@ void Painter::draw_bitmap(const Point& p, const GlyphBitmap& bitmap, Color color
     const int last_column = clipped_rect.right() - dst_rect.left();
     RGBA32* dst = m_target->scanline(clipped_rect.y()) + clipped_rect.x();
     const size_t dst_skip = m_target->pitch() / sizeof(RGBA32);
+    RGBA32 value = m_target->value_for(color);
 
     for (int row = first_row; row <= last_row; ++row) {
         for (int j = 0; j <= (last_column - first_column); ++j) {
             if (bitmap.bit_at(j + first_column, row))
-                dst[j] = color.value();
-        }
-        dst += dst_skip;
-    }
-}
-
-void Painter::blit_scaled(const Rect& dst_rect_raw, const GraphicsBitmap& source, const Rect& src_rect, float hscale, float vscale)
-{
-    auto dst_rect = Rect(dst_rect_raw.location(), dst_rect_raw.size()).translated(translation());
-    auto clipped_rect = dst_rect.intersected(clip_rect());
-    if (clipped_rect.is_empty())
-        return;
-    const int first_row = (clipped_rect.top() - dst_rect.top());
-    const int last_row = (clipped_rect.bottom() - dst_rect.top());
-    const int first_column = (clipped_rect.left() - dst_rect.left());
-    RGBA32* dst = m_target->scanline(clipped_rect.y()) + clipped_rect.x();
-    const size_t dst_skip = m_target->pitch() / sizeof(RGBA32);
-
-    int x_start = first_column + src_rect.left();
-    for (int row = first_row; row <= last_row; ++row) {
-        int sr = (row + src_rect.top()) * vscale;
-        if (sr >= source.size().height() || sr < 0) {
-            dst += dst_skip;
-            continue;
-        }
-        const RGBA32* sl = source.scanline(sr);
-        for (int x = x_start; x < clipped_rect.width() + x_start; ++x) {
-            int sx = x * hscale;
-            if (sx < source.size().width() && sx >= 0)
-                dst[x - x_start] = sl[sx];
+                dst[j] = value;
         }
         dst += dst_skip;
     }
-    return;
 }
 
 void Painter::blit_with_opacity(const Point& position, const GraphicsBitmap& source, const Rect& src_rect, float opacity)
@@ -306,13 +308,10 @@ void Painter::blit_with_opacity(const Point& position, const GraphicsBitmap& sou
     const size_t dst_skip = m_target->pitch() / sizeof(RGBA32);
     const unsigned src_skip = source.pitch() / sizeof(RGBA32);
 
+    auto& kernels = PaintingKernels::the();
+    auto* blend = source.has_premultiplied_alpha() ? kernels.blend_premultiplied_with_opacity : kernels.blend_with_opacity;
     for (int row = first_row; row <= last_row; ++row) {
-        for (int x = 0; x <= (last_column - first_column); ++x) {
-            Color src_color_with_alpha = Color::from_rgb(src[x]);
-            src_color_with_alpha.set_alpha(alpha);
-            Color dst_color = Color::from_rgb(dst[x]);
-            dst[x] = dst_color.blend(src_color_with_alpha).value();
-        }
+        blend(dst, src, alpha, last_column - first_column + 1);
         dst += dst_skip;
         src += src_skip;
     }
@@ -334,15 +333,26 @@ void Painter::blit_dimmed(const Point& position, const GraphicsBitmap& source, c
     const size_t dst_skip = m_target->pitch() / sizeof(RGBA32);
     const size_t src_skip = source.pitch() / sizeof(RGBA32);
 
+    if (!m_target->has_alpha_channel() && !source.has_premultiplied_alpha()) {
+        auto& kernels = PaintingKernels::the();
+        for (int row = first_row; row <= last_row; ++row) {
+            kernels.blend_dimmed(dst, src, last_column - first_column + 1);
+            dst += dst_skip;
+            src += src_skip;
+        }
+        return;
+    }
+
     for (int row = first_row; row <= last_row; ++row) {
         for (int x = 0; x <= (last_column - first_column); ++x) {
-            u8 alpha = Color::from_rgba(src[x]).alpha();
+            auto src_color = source.has_premultiplied_alpha() ? Color::from_premultiplied(src[x]) : Color::from_rgba(src[x]);
+            u8 alpha = src_color.alpha();
             if (alpha == 0xff)
-                dst[x] = Color::from_rgba(src[x]).to_grayscale().lightened().value();
+                dst[x] = src_color.to_grayscale().lightened().value();
             else if (!alpha)
                 continue;
             else
-                dst[x] = Color::from_rgba(dst[x]).blend(Color::from_rgba(src[x]).to_grayscale().lightened()).value();
+                blend_pixel(*m_target, dst[x], src_color.to_grayscale().lightened());
         }
         dst += dst_skip;
         src += src_skip;
@@ -361,13 +371,13 @@ void Painter::draw_tiled_bitmap(const Rect& a_dst_rect, const GraphicsBitmap& so
     RGBA32* dst = m_target->scanline(clipped_rect.y()) + clipped_rect.x();
     const size_t dst_skip = m_target->pitch() / sizeof(RGBA32);
 
-    if (source.format() == GraphicsBitmap::Format::RGB32 || source.format() == GraphicsBitmap::Format::RGBA32) {
+    if (source.bpp() == 32) {
         int x_start = first_column + a_dst_rect.left();
         for (int row = first_row; row <= last_row; ++row) {
             const RGBA32* sl = source.scanline((row + a_dst_rect.top())
                 % source.size().height());
             for (int x = x_start; x < clipped_rect.width() + x_start; ++x) {
-                dst[x - x_start] = sl[x % source.size().width()];
+                dst[x - x_start] = convert_pixel(source, *m_target, sl[x % source.size().width()]);
             }
             dst += dst_skip;
         }
@@ -392,7 +402,7 @@ void Painter::blit_offset(const Point& position,
     RGBA32* dst = m_target->scanline(clipped_rect.y()) + clipped_rect.x();
     const size_t dst_skip = m_target->pitch() / sizeof(RGBA32);
 
-    if (source.format() == GraphicsBitmap::Format::RGB32 || source.format() == GraphicsBitmap::Format::RGBA32) {
+    if (source.bpp() == 32) {
         int x_start = first_column + src_rect.left();
         for (int row = first_row; row <= last_row; ++row) {
             int sr = row - offset.y() + src_rect.top();
@@ -404,7 +414,7 @@ void Painter::blit_offset(const Point& position,
             for (int x = x_start; x < clipped_rect.width() + x_start; ++x) {
                 int sx = x - offset.x();
                 if (sx < source.size().width() && sx >= 0)
-                    dst[x - x_start] = sl[sx];
+                    dst[x - x_start] = convert_pixel(source, *m_target, sl[sx]);
             }
             dst += dst_skip;
         }
@@ -431,15 +441,30 @@ void Painter::blit_with_alpha(const Point& position, const GraphicsBitmap& sourc
     const size_t dst_skip = m_target->pitch() / sizeof(RGBA32);
     const size_t src_skip = source.pitch() / sizeof(RGBA32);
 
+    // NOTE: The kernels write their results in the source's kind of alpha (or none at all),
+    //       so they're only usable when that's what the target has.
+    bool target_matches = !m_target->has_alpha_channel() || (source.has_premultiplied_alpha() && m_target->has_premultiplied_alpha());
+    if (target_matches) {
+        auto& kernels = PaintingKernels::the();
+        auto* blend = source.has_premultiplied_alpha() ? kernels.blend_premultiplied : kernels.blend_with_alpha;
+        for (int row = first_row; row <= last_row; ++row) {
+            blend(dst, src, last_column - first_column + 1);
+            dst += dst_skip;
+            src += src_skip;
+        }
+        return;
+    }
+
     for (int row = first_row; row <= last_row; ++row) {
         for (int x = 0; x <= (last_column - first_column); ++x) {
-            u8 alpha = Color::from_rgba(src[x]).alpha();
+            auto color = source.has_premultiplied_alpha() ? Color::from_premultiplied(src[x]) : Color::from_rgba(src[x]);
+            u8 alpha = color.alpha();
             if (alpha == 0xff)
-                dst[x] = src[x];
+                dst[x] = m_target->value_for(color);
             else if (!alpha)
                 continue;
             else
-                dst[x] = Color::from_rgba(dst[x]).blend(Color::from_rgba(src[x])).value();
+                blend_pixel(*m_target, dst[x], color);
         }
         dst += dst_skip;
         src += src_skip;
@@ -464,11 +489,22 @@ void Painter::blit(const Point& position, const GraphicsBitmap& source, const Re
     RGBA32* dst = m_target->scanline(clipped_rect.y()) + clipped_rect.x();
     const size_t dst_skip = m_target->pitch() / sizeof(RGBA32);
 
-    if (source.format() == GraphicsBitmap::Format::RGB32 || source.format() == GraphicsBitmap::Format::RGBA32) {
+    if (source.bpp() == 32) {
         const RGBA32* src = source.scanline(src_rect.top() + first_row) + src_rect.left() + first_column;
         const size_t src_skip = source.pitch() / sizeof(RGBA32);
+        if (m_target->has_alpha_channel()) {
+            // The source has no alpha, so every pixel needs to be made opaque.
+            for (int row = first_row; row <= last_row; ++row) {
+                for (int i = 0; i < clipped_rect.width(); ++i)
+                    dst[i] = convert_pixel(source, *m_target, src[i]);
+                dst += dst_skip;
+                src += src_skip;
+            }
+            return;
+        }
+        auto& kernels = PaintingKernels::the();
         for (int row = first_row; row <= last_row; ++row) {
-            fast_u32_copy(dst, src, clipped_rect.width());
+            kernels.copy(dst, src, clipped_rect.width());
             dst += dst_skip;
             src += src_skip;
         }
@@ -480,7 +516,7 @@ void Painter::blit(const Point& position, const GraphicsBitmap& source, const Re
         const size_t src_skip = source.pitch();
         for (int row = first_row; row <= last_row; ++row) {
             for (int i = 0; i < clipped_rect.width(); ++i)
-                dst[i] = source.palette_color(src[i]).value();
+                dst[i] = m_target->value_for(source.palette_color(src[i]));
             dst += dst_skip;
             src += src_skip;
         }
@@ -490,103 +526,249 @@ void Painter::blit(const Point& position, const GraphicsBitmap& source, const Re
     ASSERT_NOT_REACHED();
 }
 
-template<bool has_alpha_channel, typename GetPixel>
-ALWAYS_INLINE static void do_draw_integer_scaled_bitmap(GraphicsBitmap& target, const Rect& dst_rect, const GraphicsBitmap& source, int hfactor, int vfactor, GetPixel get_pixel)
-{
-    for (int y = source.rect().top(); y <= source.rect().bottom(); ++y) {
-        int dst_y = dst_rect.y() + y * vfactor;
-        for (int x = source.rect().left(); x <= source.rect().right(); ++x) {
-            auto src_pixel = get_pixel(source, x, y);
-            for (int yo = 0; yo < vfactor; ++yo) {
-                auto* scanline = (Color*)target.scanline(dst_y + yo);
-                int dst_x = dst_rect.x() + x * hfactor;
-                for (int xo = 0; xo < hfactor; ++xo) {
-                    if constexpr (has_alpha_channel)
-                        scanline[dst_x + xo] = scanline[dst_x + xo].blend(src_pixel);
-                    else
-                        scanline[dst_x + xo] = src_pixel;
-                }
-            }
+// Scaled drawing produces one destination row at a time. Source rows are converted to
+// premultiplied pixels once each, the sampling positions are worked out up front in 16.16
+// fixed point, and destination rows that would come out the same are only computed once.
+
+static void load_premultiplied_row(const GraphicsBitmap& source, int y, int x, int width, RGBA32* row)
+{
+    switch (source.format()) {
+    case GraphicsBitmap::Format::RGB32: {
+        auto* src = source.scanline(y) + x;
+        for (int i = 0; i < width; ++i)
+            row[i] = src[i] | 0xff000000;
+        break;
+    }
+    case GraphicsBitmap::Format::RGBA32: {
+        auto* src = source.scanline(y) + x;
+        for (int i = 0; i < width; ++i)
+            row[i] = Color::from_rgba(src[i]).to_premultiplied();
+        break;
+    }
+    case GraphicsBitmap::Format::RGBA32Premultiplied:
+        fast_u32_copy(row, source.scanline(y) + x, width);
+        break;
+    case GraphicsBitmap::Format::Indexed8: {
+        auto* src = source.bits(y) + x;
+        for (int i = 0; i < width; ++i)
+            row[i] = source.palette_color(src[i]).to_premultiplied();
+        break;
+    }
+    default:
+        ASSERT_NOT_REACHED();
+    }
+}
+
+static void put_scaled_row(GraphicsBitmap& target, int y, int x, const RGBA32* row, int width, bool has_alpha_channel)
+{
+    auto* dst = target.scanline(y) + x;
+    if (!has_alpha_channel) {
+        fast_u32_copy(dst, row, width);
+        return;
+    }
+    if (!target.has_alpha_channel() || target.has_premultiplied_alpha()) {
+        PaintingKernels::the().blend_premultiplied(dst, row, width);
+        return;
+    }
+    for (int i = 0; i < width; ++i) {
+        auto color = Color::from_premultiplied(row[i]);
+        if (color.alpha() == 0xff)
+            dst[i] = color.value();
+        else if (color.alpha())
+            blend_pixel(target, dst[i], color);
+    }
+}
+
+// Mixes two premultiplied pixels, giving `b` a weight of `weight` / 256.
+static ALWAYS_INLINE RGBA32 interpolate(RGBA32 a, RGBA32 b, u32 weight)
+{
+    u32 inverse = 256 - weight;
+    u32 red_and_blue = ((a & 0x00ff00ff) * inverse + (b & 0x00ff00ff) * weight) >> 8;
+    u32 alpha_and_green = ((a >> 8) & 0x00ff00ff) * inverse + ((b >> 8) & 0x00ff00ff) * weight;
+    return (red_and_blue & 0x00ff00ff) | (alpha_and_green & 0xff00ff00);
+}
+
+// Where the center of destination pixel `index` lands in the source, in 16.16 fixed point,
+// measured from the center of the first source pixel and kept inside the source.
+static ALWAYS_INLINE int bilinear_position(int index, int step, int source_length)
+{
+    int position = index * step + step / 2 - 0x8000;
+    return max(0, min(position, (source_length - 1) << 16));
+}
+
+static void draw_scaled_nearest_neighbor(GraphicsBitmap& target, const Rect& dst_rect, const Rect& clipped_rect, const GraphicsBitmap& source, const Rect& src_rect)
+{
+    int hstep = (src_rect.width() << 16) / dst_rect.width();
+    int vstep = (src_rect.height() << 16) / dst_rect.height();
+
+    Vector<int> columns;
+    columns.resize(clipped_rect.width());
+    for (int x = 0; x < clipped_rect.width(); ++x)
+        columns[x] = ((clipped_rect.left() - dst_rect.left() + x) * hstep + hstep / 2) >> 16;
+
+    Vector<RGBA32> source_row;
+    source_row.resize(src_rect.width());
+    Vector<RGBA32> scaled_row;
+    scaled_row.resize(clipped_rect.width());
+    int cached_source_y = -1;
+
+    for (int y = clipped_rect.top(); y <= clipped_rect.bottom(); ++y) {
+        int source_y = src_rect.top() + (((y - dst_rect.top()) * vstep + vstep / 2) >> 16);
+        if (source_y != cached_source_y) {
+            load_premultiplied_row(source, source_y, src_rect.left(), src_rect.width(), source_row.data());
+            for (int x = 0; x < clipped_rect.width(); ++x)
+                scaled_row[x] = source_row[columns[x]];
+            cached_source_y = source_y;
         }
+        put_scaled_row(target, y, clipped_rect.left(), scaled_row.data(), clipped_rect.width(), source.has_alpha_channel());
     }
 }
 
-template<bool has_alpha_channel, typename GetPixel>
-ALWAYS_INLINE static void do_draw_scaled_bitmap(GraphicsBitmap& target, const Rect& dst_rect, const Rect& clipped_rect, const GraphicsBitmap& source, const Rect& src_rect, int hscale, int vscale, GetPixel get_pixel)
+static void draw_scaled_bilinear(GraphicsBitmap& target, const Rect& dst_rect, const Rect& clipped_rect, const GraphicsBitmap& source, const Rect& src_rect)
 {
-    if (dst_rect == clipped_rect && !(dst_rect.width() % src_rect.width()) && !(dst_rect.height() % src_rect.height())) {
-        int hfactor = dst_rect.width() / src_rect.width();
-        int vfactor = dst_rect.height() / src_rect.height();
-        if (hfactor == 2 && vfactor == 2)
-            return do_draw_integer_scaled_bitmap<has_alpha_channel>(target, dst_rect, source, 2, 2, get_pixel);
-        if (hfactor == 3 && vfactor == 3)
-            return do_draw_integer_scaled_bitmap<has_alpha_channel>(target, dst_rect, source, 3, 3, get_pixel);
-        if (hfactor == 4 && vfactor == 4)
-            return do_draw_integer_scaled_bitmap<has_alpha_channel>(target, dst_rect, source, 4, 4, get_pixel);
-        return do_draw_integer_scaled_bitmap<has_alpha_channel>(target, dst_rect, source, hfactor, vfactor, get_pixel);
+    int hstep = (src_rect.width() << 16) / dst_rect.width();
+    int vstep = (src_rect.height() << 16) / dst_rect.height();
+    int width = clipped_rect.width();
+
+    Vector<int> columns;
+    columns.resize(width);
+    Vector<u8> column_weights;
+    column_weights.resize(width);
+    for (int x = 0; x < width; ++x) {
+        int position = bilinear_position(clipped_rect.left() - dst_rect.left() + x, hstep, src_rect.width());
+        columns[x] = position >> 16;
+        column_weights[x] = (position >> 8) & 0xff;
     }
 
+    Vector<RGBA32> source_row;
+    source_row.resize(src_rect.width() + 1);
+    Vector<RGBA32> row_buffers;
+    row_buffers.resize(width * 3);
+    RGBA32* upper_row = row_buffers.data();
+    RGBA32* lower_row = upper_row + width;
+    RGBA32* scaled_row = lower_row + width;
+    int upper_y = -1;
+    int lower_y = -1;
+
+    // Scales a source row horizontally. These get reused for as long as they're needed.
+    auto load_row = [&](int source_y, RGBA32* row) {
+        load_premultiplied_row(source, src_rect.top() + source_y, src_rect.left(), src_rect.width(), source_row.data());
+        source_row[src_rect.width()] = source_row[src_rect.width() - 1];
+        for (int x = 0; x < width; ++x)
+            row[x] = interpolate(source_row[columns[x]], source_row[columns[x] + 1], column_weights[x]);
+    };
+
     for (int y = clipped_rect.top(); y <= clipped_rect.bottom(); ++y) {
-        auto* scanline = (Color*)target.scanline(y);
-        for (int x = clipped_rect.left(); x <= clipped_rect.right(); ++x) {
-            auto scaled_x = ((x - dst_rect.x()) * hscale) >> 16;
-            auto scaled_y = ((y - dst_rect.y()) * vscale) >> 16;
-            auto src_pixel = get_pixel(source, scaled_x, scaled_y);
-
-            if constexpr (has_alpha_channel) {
-                scanline[x] = scanline[x].blend(src_pixel);
-            } else
-                scanline[x] = src_pixel;
+        int position = bilinear_position(y - dst_rect.top(), vstep, src_rect.height());
+        int y0 = position >> 16;
+        int y1 = min(y0 + 1, src_rect.height() - 1);
+        u32 weight = (position >> 8) & 0xff;
+
+        if (y0 != upper_y) {
+            if (y0 == lower_y) {
+                swap(upper_row, lower_row);
+                swap(upper_y, lower_y);
+            } else {
+                load_row(y0, upper_row);
+                upper_y = y0;
+            }
         }
+        if (!weight) {
+            put_scaled_row(target, y, clipped_rect.left(), upper_row, width, source.has_alpha_channel());
+            continue;
+        }
+        if (y1 != lower_y) {
+            load_row(y1, lower_row);
+            lower_y = y1;
+        }
+        for (int x = 0; x < width; ++x)
+            scaled_row[x] = interpolate(upper_row[x], lower_row[x], weight);
+        put_scaled_row(target, y, clipped_rect.left(), scaled_row, width, source.has_alpha_channel());
     }
 }
 
-void Painter::draw_scaled_bitmap(const Rect& a_dst_rect, const GraphicsBitmap& source, const Rect& src_rect)
+// Averages all of the source pixels that fall inside each destination pixel.
+static void draw_scaled_box_filtered(GraphicsBitmap& target, const Rect& dst_rect, const Rect& clipped_rect, const GraphicsBitmap& source, const Rect& src_rect)
+{
+    int width = clipped_rect.width();
+
+    Vector<int> column_starts;
+    column_starts.resize(width + 1);
+    for (int x = 0; x <= width; ++x)
+        column_starts[x] = (clipped_rect.left() - dst_rect.left() + x) * src_rect.width() / dst_rect.width();
+
+    Vector<RGBA32> source_row;
+    source_row.resize(src_rect.width());
+    Vector<u32> sums;
+    sums.resize(src_rect.width() * 4);
+    Vector<RGBA32> scaled_row;
+    scaled_row.resize(width);
+
+    for (int y = clipped_rect.top(); y <= clipped_rect.bottom(); ++y) {
+        int first_row = (y - dst_rect.top()) * src_rect.height() / dst_rect.height();
+        int end_row = max(first_row + 1, (y - dst_rect.top() + 1) * src_rect.height() / dst_rect.height());
+
+        // Add up each column of the box, one channel at a time.
+        for (int i = 0; i < sums.size(); ++i)
+            sums[i] = 0;
+        for (int source_y = first_row; source_y < end_row; ++source_y) {
+            load_premultiplied_row(source, src_rect.top() + source_y, src_rect.left(), src_rect.width(), source_row.data());
+            for (int i = 0; i < src_rect.width(); ++i) {
+                RGBA32 pixel = source_row[i];
+                sums[i * 4] += pixel & 0xff;
+                sums[i * 4 + 1] += (pixel >> 8) & 0xff;
+                sums[i * 4 + 2] += (pixel >> 16) & 0xff;
+                sums[i * 4 + 3] += pixel >> 24;
+            }
+        }
+
+        for (int x = 0; x < width; ++x) {
+            int first_column = column_starts[x];
+            int end_column = max(first_column + 1, column_starts[x + 1]);
+            u32 total[4] = { 0, 0, 0, 0 };
+            for (int i = first_column; i < end_column; ++i) {
+                for (int channel = 0; channel < 4; ++channel)
+                    total[channel] += sums[i * 4 + channel];
+            }
+            // Dividing by the pixel count is a multiplication by its 8.24 fixed point reciprocal.
+            u32 reciprocal = (1 << 24) / ((end_column - first_column) * (end_row - first_row));
+            RGBA32 pixel = 0;
+            for (int channel = 0; channel < 4; ++channel)
+                pixel |= ((total[channel] * reciprocal + (1 << 23)) >> 24) << (channel * 8);
+            scaled_row[x] = pixel;
+        }
+        put_scaled_row(target, y, clipped_rect.left(), scaled_row.data(), width, source.has_alpha_channel());
+    }
+}
+
+void Painter::draw_scaled_bitmap(const Rect& a_dst_rect, const GraphicsBitmap& source, const Rect& src_rect, ScalingMode scaling_mode)
 {
     auto dst_rect = a_dst_rect;
     if (dst_rect.size() == src_rect.size())
         return blit(dst_rect.location(), source, src_rect);
 
     auto safe_src_rect = src_rect.intersected(source.rect());
-    ASSERT(source.rect().contains(safe_src_rect));
+    if (safe_src_rect.is_empty())
+        return;
     dst_rect.move_by(state().translation);
     auto clipped_rect = dst_rect.intersected(clip_rect());
     if (clipped_rect.is_empty())
         return;
 
-    int hscale = (src_rect.width() << 16) / dst_rect.width();
-    int vscale = (src_rect.height() << 16) / dst_rect.height();
-
-    if (source.has_alpha_channel()) {
-        switch (source.format()) {
-        case GraphicsBitmap::Format::RGB32:
-            do_draw_scaled_bitmap<true>(*m_target, dst_rect, clipped_rect, source, src_rect, hscale, vscale, get_pixel<GraphicsBitmap::Format::RGB32>);
-            break;
-        case GraphicsBitmap::Format::RGBA32:
-            do_draw_scaled_bitmap<true>(*m_target, dst_rect, clipped_rect, source, src_rect, hscale, vscale, get_pixel<GraphicsBitmap::Format::RGBA32>);
-            break;
-        case GraphicsBitmap::Format::Indexed8:
-            do_draw_scaled_bitmap<true>(*m_target, dst_rect, clipped_rect, source, src_rect, hscale, vscale, get_pixel<GraphicsBitmap::Format::Indexed8>);
-            break;
-        default:
-            do_draw_scaled_bitmap<true>(*m_target, dst_rect, clipped_rect, source, src_rect, hscale, vscale, get_pixel<GraphicsBitmap::Format::Invalid>);
-            break;
-        }
-    } else {
-        switch (source.format()) {
-        case GraphicsBitmap::Format::RGB32:
-            do_draw_scaled_bitmap<false>(*m_target, dst_rect, clipped_rect, source, src_rect, hscale, vscale, get_pixel<GraphicsBitmap::Format::RGB32>);
-            break;
-        case GraphicsBitmap::Format::RGBA32:
-            do_draw_scaled_bitmap<false>(*m_target, dst_rect, clipped_rect, source, src_rect, hscale, vscale, get_pixel<GraphicsBitmap::Format::RGBA32>);
-            break;
-        case GraphicsBitmap::Format::Indexed8:
-            do_draw_scaled_bitmap<false>(*m_target, dst_rect, clipped_rect, source, src_rect, hscale, vscale, get_pixel<GraphicsBitmap::Format::Indexed8>);
-            break;
-        default:
-            do_draw_scaled_bitmap<false>(*m_target, dst_rect, clipped_rect, source, src_rect, hscale, vscale, get_pixel<GraphicsBitmap::Format::Invalid>);
-            break;
-        }
+    switch (scaling_mode) {
+    case ScalingMode::NearestNeighbor:
+        draw_scaled_nearest_neighbor(*m_target, dst_rect, clipped_rect, source, safe_src_rect);
+        break;
+    case ScalingMode::Bilinear:
+        draw_scaled_bilinear(*m_target, dst_rect, clipped_rect, source, safe_src_rect);
+        break;
+    case ScalingMode::BoxFilter:
+        // Boxes only make sense for shrinking, when there are several source pixels per destination pixel.
+        if (dst_rect.width() > safe_src_rect.width() || dst_rect.height() > safe_src_rect.height())
+            draw_scaled_bilinear(*m_target, dst_rect, clipped_rect, source, safe_src_rect);
+        else
+            draw_scaled_box_filtered(*m_target, dst_rect, clipped_rect, source, safe_src_rect);
+        break;
     }
 }
 
@@ -595,9 +777,63 @@ void Painter::draw_scaled_bitmap(const Rect& a_dst_rect, const GraphicsBitmap& s
     draw_glyph(point, ch, font(), color);
 }
 
+// Fills the spans of a glyph whose top left corner is at `origin` (already translated), clipped to `clip`.
+static void fill_glyph_spans(GraphicsBitmap& target, const Point& origin, const Rect& clip, const GlyphAtlas& atlas, char ch, RGBA32 value)
+{
+    const GlyphSpan* spans = atlas.spans(ch);
+    int span_count = atlas.span_count(ch);
+    for (int i = 0; i < span_count; ++i) {
+        auto& span = spans[i];
+        int y = origin.y() + span.y;
+        if (y < clip.top())
+            continue;
+        if (y > clip.bottom())
+            break;
+        int left = max(origin.x() + span.x, clip.left());
+        int right = min(origin.x() + span.x + span.width - 1, clip.right());
+        if (left > right)
+            continue;
+        fast_u32_fill(target.scanline(y) + left, value, right - left + 1);
+    }
+}
+
 [[gnu::flatten]] void Painter::draw_glyph(const Point& point, char ch, const Font& font, Color color)
 {
-    draw_bitmap(point, font.glyph_bitmap(ch), color);
+    auto origin = point.translated(translation());
+    Rect glyph_rect { origin, { font.glyph_width(ch), font.glyph_height() } };
+    if (!glyph_rect.intersects(clip_rect()))
+        return;
+    fill_glyph_spans(*m_target, origin, clip_rect(), font.glyph_atlas(), ch, m_target->value_for(color));
+}
+
+void Painter::draw_glyph_run(const Point& point, const Utf8View& text, const Font& font, Color color)
+{
+    auto clip = clip_rect();
+    auto origin = point.translated(translation());
+    if (origin.y() > clip.bottom() || origin.y() + font.glyph_height() <= clip.top())
+        return;
+
+    auto& atlas = font.glyph_atlas();
+    RGBA32 value = m_target->value_for(color);
+    int spacing = font.glyph_spacing();
+    int space_width = font.glyph_width(' ') + spacing;
+
+    for (u32 codepoint : text) {
+        if (origin.x() > clip.right())
+            break;
+        if (codepoint == ' ') {
+            origin.move_by(space_width, 0);
+            continue;
+        }
+        int glyph_width = font.glyph_or_emoji_width(codepoint);
+        if (origin.x() + glyph_width > clip.left()) {
+            if (codepoint < 256)
+                fill_glyph_spans(*m_target, origin, clip, atlas, (char)codepoint, value);
+            else
+                draw_glyph_or_emoji(origin.translated(-translation()), codepoint, font, color);
+        }
+        origin.move_by(glyph_width + spacing, 0);
+    }
 }
 
 void Painter::draw_emoji(const Point& point, const GraphicsBitmap& emoji, const Font& font)
@@ -639,47 +875,31 @@ void Painter::draw_glyph_or_emoji(const Point& point, u32 codepoint, const Font&
 void Painter::draw_text_line(const Rect& a_rect, const Utf8View& text, const Font& font, TextAlignment alignment, Color color, TextElision elision)
 {
     auto rect = a_rect;
-    Utf8View final_text(text);
-    String elided_text;
+    Utf8View visible_text(text);
+    bool is_elided = false;
     if (elision == TextElision::Right) {
-        int text_width = font.width(final_text);
-        if (font.width(final_text) > rect.width()) {
-            int glyph_spacing = font.glyph_spacing();
-            int byte_offset = 0;
-            int new_width = font.width("...");
-            if (new_width < text_width) {
-                for (auto it = final_text.begin(); it != final_text.end(); ++it) {
-                    u32 codepoint = *it;
-                    int glyph_width = font.glyph_or_emoji_width(codepoint);
-                    // NOTE: Glyph spacing should not be added after the last glyph on the line,
-                    //       but since we are here because the last glyph does not actually fit on the line,
-                    //       we don't have to worry about spacing.
-                    int width_with_this_glyph_included = new_width + glyph_width + glyph_spacing;
-                    if (width_with_this_glyph_included > rect.width())
-                        break;
-                    byte_offset = final_text.byte_offset_of(it);
-                    new_width += glyph_width + glyph_spacing;
-                }
-                StringBuilder builder;
-                builder.append(final_text.substring_view(0, byte_offset).as_string());
-                builder.append("...");
-                elided_text = builder.to_string();
-                final_text = Utf8View { elided_text };
-            }
+        int elided_length = font.elided_byte_length(text, rect.width());
+        if (elided_length >= 0) {
+            visible_text = text.substring_view(0, elided_length);
+            is_elided = true;
         }
     }
 
+    int line_width = font.width(visible_text);
+    if (is_elided)
+        line_width += font.width("...") + (visible_text.is_empty() ? 0 : font.glyph_spacing());
+
     switch (alignment) {
     case TextAlignment::TopLeft:
     case TextAlignment::CenterLeft:
         break;
     case TextAlignment::TopRight:
     case TextAlignment::CenterRight:
-        rect.set_x(rect.right() - font.width(final_text));
+        rect.set_x(rect.right() - line_width);
         break;
     case TextAlignment::Center: {
         auto shrunken_rect = rect;
-        shrunken_rect.set_width(font.width(final_text));
+        shrunken_rect.set_width(line_width);
         shrunken_rect.center_within(rect);
         rect = shrunken_rect;
         break;
@@ -688,16 +908,11 @@ void Painter::draw_text_line(const Rect& a_rect, const Utf8View& text, const Fon
         ASSERT_NOT_REACHED();
     }
 
-    auto point = rect.location();
-    int space_width = font.glyph_width(' ') + font.glyph_spacing();
-
-    for (u32 codepoint : final_text) {
-        if (codepoint == ' ') {
-            point.move_by(space_width, 0);
-            continue;
-        }
-        draw_glyph_or_emoji(point, codepoint, font, color);
-        point.move_by(font.glyph_or_emoji_width(codepoint) + font.glyph_spacing(), 0);
+    // Draw the text and the ellipsis as two runs rather than building an elided copy of the string.
+    draw_glyph_run(rect.location(), visible_text, font, color);
+    if (is_elided) {
+        int prefix_width = visible_text.is_empty() ? 0 : font.width(visible_text) + font.glyph_spacing();
+        draw_glyph_run(rect.location().translated(prefix_width, 0), Utf8View("..."), font, color);
     }
 }
 
@@ -771,13 +986,13 @@ void Painter::set_pixel(const Point& p, Color color)
     point.move_by(state().translation);
     if (!clip_rect().contains(point))
         return;
-    m_target->scanline(point.y())[point.x()] = color.value();
+    m_target->scanline(point.y())[point.x()] = m_target->value_for(color);
 }
 
 [[gnu::always_inline]] inline void Painter::set_pixel_with_draw_op(u32& pixel, const Color& color)
 {
     if (draw_op() == DrawOp::Copy)
-        pixel = color.value();
+        pixel = m_target->value_for(color);
     else if (draw_op() == DrawOp::Xor)
         pixel ^= color.value();
 }
@@ -19,6 +19,13 @@ class Painter {
 public:
     explicit Painter(GraphicsBitmap&);
     ~Painter();
+
+    enum class ScalingMode {
+        NearestNeighbor,
+        Bilinear,
+        BoxFilter
+    };
+
     void clear_rect(const Rect&, Color);
     void fill_rect(const Rect&, Color);
     void fill_rect_with_gradient(const Rect&, Color gradient_start, Color gradient_end);
@@ -28,18 +35,19 @@ public:
     void draw_ellipse_intersecting(const Rect&, Color, int thickness = 1);
     void set_pixel(const Point&, Color);
     void draw_line(const Point&, const Point&, Color, int thickness = 1, bool dotted = false);
-    void draw_scaled_bitmap(const Rect& dst_rect, const GraphicsBitmap&, const Rect& src_rect);
+    void draw_scaled_bitmap(const Rect& dst_rect, const GraphicsBitmap&, const Rect& src_rect, ScalingMode = ScalingMode::NearestNeighbor);
     void blit(const Point&, const GraphicsBitmap&, const Rect& src_rect, float opacity = 1.0f);
     void blit_dimmed(const Point&, const GraphicsBitmap&, const Rect& src_rect);
     void draw_tiled_bitmap(const Rect& dst_rect, const GraphicsBitmap&);
     void blit_offset(const Point&, const GraphicsBitmap&, const Rect& src_rect, const Point&);
-    void blit_scaled(const Rect&, const GraphicsBitmap&, const Rect&, float, float);
     void draw_text(const Rect&, const StringView&, const Font&, TextAlignment = TextAlignment::TopLeft, Color = Color::Black, TextElision = TextElision::None);
     void draw_text(const Rect&, const StringView&, TextAlignment = TextAlignment::TopLeft, Color = Color::Black, TextElision = TextElision::None);
     void draw_glyph(const Point&, char, Color);
     void draw_glyph(const Point&, char, const Font&, Color);
     void draw_emoji(const Point&, const GraphicsBitmap&, const Font&);
     void draw_glyph_or_emoji(const Point&, u32 codepoint, const Font&, Color);
+    // Draws a line of text starting at the given point, without any alignment or elision.
+    void draw_glyph_run(const Point&, const Utf8View&, const Font&, Color);
 
     const Font& font() const { return *state().font; }
     void set_font(const Font& font) { state().font = &font; }
@@ -0,0 +1,315 @@
+#include "PaintingKernels.h"
+#include <AK/Platform.h>
+#include <AK/StdLibExtras.h>
+
+#if ARCH(I386) || ARCH(X86_64)
+#    include <cpuid.h>
+#    include <emmintrin.h>
+#    define HAS_SSE2_KERNELS
+#endif
+
+#pragma GCC optimize("O3")
+
+// Divides both 16-bit halves of `x` by 255, rounding down. Exact for values up to 255 * 255.
+[[gnu::always_inline]] static inline u32 divide_halves_by_255(u32 x)
+{
+    return ((x + 0x00010001 + ((x >> 8) & 0x00ff00ff)) >> 8) & 0x00ff00ff;
+}
+
+// (src * alpha + dst * (255 - alpha)) / 255 for each color channel, with an opaque result.
+[[gnu::always_inline]] static inline RGBA32 lerp(RGBA32 src, RGBA32 dst, u32 alpha)
+{
+    u32 inverse = 255 - alpha;
+    u32 red_and_blue = (src & 0xff00ff) * alpha + (dst & 0xff00ff) * inverse;
+    u32 green = ((src >> 8) & 0xff) * alpha + ((dst >> 8) & 0xff) * inverse;
+    return 0xff000000 | divide_halves_by_255(red_and_blue) | (divide_halves_by_255(green) << 8);
+}
+
+// The gray that Color::to_grayscale().lightened() would give us.
+[[gnu::always_inline]] static inline RGBA32 lightened_gray(RGBA32 color)
+{
+    u32 gray = (((color >> 16) & 0xff) + ((color >> 8) & 0xff) + (color & 0xff)) / 3;
+    gray = min(gray * 6 / 5, 255u);
+    return 0xff000000 | (gray * 0x010101);
+}
+
+static void fill_scalar(RGBA32* dst, RGBA32 color, int count)
+{
+    fast_u32_fill(dst, color, count);
+}
+
+static void copy_scalar(RGBA32* dst, const RGBA32* src, int count)
+{
+    fast_u32_copy(dst, src, count);
+}
+
+static void blend_color_scalar(RGBA32* dst, Color color, int count)
+{
+    RGBA32 value = color.value();
+    u8 alpha = color.alpha();
+    for (int i = 0; i < count; ++i)
+        dst[i] = lerp(value, dst[i], alpha);
+}
+
+static void blend_with_opacity_scalar(RGBA32* dst, const RGBA32* src, u8 alpha, int count)
+{
+    for (int i = 0; i < count; ++i)
+        dst[i] = lerp(src[i], dst[i], alpha);
+}
+
+static void blend_with_alpha_scalar(RGBA32* dst, const RGBA32* src, int count)
+{
+    for (int i = 0; i < count; ++i) {
+        u32 alpha = src[i] >> 24;
+        if (alpha == 0xff)
+            dst[i] = src[i];
+        else if (alpha)
+            dst[i] = lerp(src[i], dst[i], alpha);
+    }
+}
+
+static void blend_dimmed_scalar(RGBA32* dst, const RGBA32* src, int count)
+{
+    for (int i = 0; i < count; ++i) {
+        u32 alpha = src[i] >> 24;
+        if (alpha == 0xff)
+            dst[i] = lightened_gray(src[i]);
+        else if (alpha)
+            dst[i] = lerp(lightened_gray(src[i]), dst[i], alpha);
+    }
+}
+
+static void blend_premultiplied_scalar(RGBA32* dst, const RGBA32* src, int count)
+{
+    for (int i = 0; i < count; ++i) {
+        u32 alpha = src[i] >> 24;
+        if (alpha == 0xff)
+            dst[i] = src[i];
+        else if (alpha)
+            dst[i] = premultiplied_over(dst[i], src[i]);
+    }
+}
+
+static void blend_premultiplied_with_opacity_scalar(RGBA32* dst, const RGBA32* src, u8 opacity, int count)
+{
+    for (int i = 0; i < count; ++i) {
+        if (src[i] >> 24)
+            dst[i] = premultiplied_over(dst[i], scale_pixel(src[i], opacity));
+    }
+}
+
+static const PaintingKernels s_scalar_kernels {
+    "scalar",
+    fill_scalar,
+    copy_scalar,
+    blend_color_scalar,
+    blend_with_opacity_scalar,
+    blend_with_alpha_scalar,
+    blend_dimmed_scalar,
+    blend_premultiplied_scalar,
+    blend_premultiplied_with_opacity_scalar,
+};
+
+#ifdef HAS_SSE2_KERNELS
+
+// NOTE: The rest of LibDraw is built for CPUs without SSE2, so only these functions may use it.
+#    define SSE2_FUNCTION [[gnu::target("sse2")]]
+#    define SSE2_HELPER [[gnu::target("sse2"), gnu::always_inline]] inline
+
+// The SSE2 kernels work on four pixels at a time. To multiply, they spread two pixels
+// out over a register with 16 bits per channel, in memory order: B, G, R, A, B, G, R, A.
+
+SSE2_HELPER static __m128i divide_by_255(__m128i x)
+{
+    auto rounding = _mm_add_epi16(_mm_srli_epi16(x, 8), _mm_set1_epi16(1));
+    return _mm_srli_epi16(_mm_add_epi16(x, rounding), 8);
+}
+
+SSE2_HELPER static __m128i lerp_unpacked(__m128i src, __m128i dst, __m128i alpha)
+{
+    auto inverse = _mm_sub_epi16(_mm_set1_epi16(255), alpha);
+    return divide_by_255(_mm_add_epi16(_mm_mullo_epi16(src, alpha), _mm_mullo_epi16(dst, inverse)));
+}
+
+template<int pattern>
+SSE2_HELPER static __m128i shuffle_channels(__m128i unpacked)
+{
+    return _mm_shufflehi_epi16(_mm_shufflelo_epi16(unpacked, pattern), pattern);
+}
+
+// Copies the alpha of each of the two pixels into all of its channels.
+SSE2_HELPER static __m128i broadcast_alpha(__m128i unpacked)
+{
+    return shuffle_channels<0xff>(unpacked);
+}
+
+SSE2_HELPER static __m128i lightened_gray_unpacked(__m128i unpacked)
+{
+    // Add up blue, green and red into each of the color channels.
+    auto sum = _mm_add_epi16(shuffle_channels<0xc0>(unpacked), shuffle_channels<0xd5>(unpacked));
+    sum = _mm_add_epi16(sum, shuffle_channels<0xea>(unpacked));
+    // x * 21846 >> 16 is x / 3, and x * 13108 >> 16 is x / 5, for the values we have here.
+    auto gray = _mm_mulhi_epu16(sum, _mm_set1_epi16(21846));
+    auto lightened = _mm_mulhi_epu16(_mm_mullo_epi16(gray, _mm_set1_epi16(6)), _mm_set1_epi16(13108));
+    return _mm_min_epi16(lightened, _mm_set1_epi16(255));
+}
+
+SSE2_HELPER static __m128i opaque_mask()
+{
+    return _mm_set1_epi32((int)0xff000000);
+}
+
+SSE2_FUNCTION static void blend_color_sse2(RGBA32* dst, Color color, int count)
+{
+    auto zero = _mm_setzero_si128();
+    auto color_unpacked = _mm_unpacklo_epi8(_mm_set1_epi32((int)color.value()), zero);
+    auto alpha = _mm_set1_epi16(color.alpha());
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        auto d = _mm_loadu_si128((const __m128i*)(dst + i));
+        auto lo = lerp_unpacked(color_unpacked, _mm_unpacklo_epi8(d, zero), alpha);
+        auto hi = lerp_unpacked(color_unpacked, _mm_unpackhi_epi8(d, zero), alpha);
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_or_si128(_mm_packus_epi16(lo, hi), opaque_mask()));
+    }
+    blend_color_scalar(dst + i, color, count - i);
+}
+
+SSE2_FUNCTION static void blend_with_opacity_sse2(RGBA32* dst, const RGBA32* src, u8 opacity, int count)
+{
+    auto zero = _mm_setzero_si128();
+    auto alpha = _mm_set1_epi16(opacity);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        auto s = _mm_loadu_si128((const __m128i*)(src + i));
+        auto d = _mm_loadu_si128((const __m128i*)(dst + i));
+        auto lo = lerp_unpacked(_mm_unpacklo_epi8(s, zero), _mm_unpacklo_epi8(d, zero), alpha);
+        auto hi = lerp_unpacked(_mm_unpackhi_epi8(s, zero), _mm_unpackhi_epi8(d, zero), alpha);
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_or_si128(_mm_packus_epi16(lo, hi), opaque_mask()));
+    }
+    blend_with_opacity_scalar(dst + i, src + i, opacity, count - i);
+}
+
+SSE2_FUNCTION static void blend_with_alpha_sse2(RGBA32* dst, const RGBA32* src, int count)
+{
+    auto zero = _mm_setzero_si128();
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        auto s = _mm_loadu_si128((const __m128i*)(src + i));
+        auto alphas = _mm_srli_epi32(s, 24);
+        auto transparent = _mm_cmpeq_epi32(alphas, zero);
+        // Large parts of most bitmaps are either fully transparent or fully opaque.
+        if (_mm_movemask_epi8(transparent) == 0xffff)
+            continue;
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(alphas, _mm_set1_epi32(0xff))) == 0xffff) {
+            _mm_storeu_si128((__m128i*)(dst + i), s);
+            continue;
+        }
+        auto d = _mm_loadu_si128((const __m128i*)(dst + i));
+        auto s_lo = _mm_unpacklo_epi8(s, zero);
+        auto s_hi = _mm_unpackhi_epi8(s, zero);
+        auto lo = lerp_unpacked(s_lo, _mm_unpacklo_epi8(d, zero), broadcast_alpha(s_lo));
+        auto hi = lerp_unpacked(s_hi, _mm_unpackhi_epi8(d, zero), broadcast_alpha(s_hi));
+        auto blended = _mm_or_si128(_mm_packus_epi16(lo, hi), opaque_mask());
+        // Fully transparent pixels leave the destination alone, alpha and all.
+        blended = _mm_or_si128(_mm_and_si128(transparent, d), _mm_andnot_si128(transparent, blended));
+        _mm_storeu_si128((__m128i*)(dst + i), blended);
+    }
+    blend_with_alpha_scalar(dst + i, src + i, count - i);
+}
+
+SSE2_FUNCTION static void blend_dimmed_sse2(RGBA32* dst, const RGBA32* src, int count)
+{
+    auto zero = _mm_setzero_si128();
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        auto s = _mm_loadu_si128((const __m128i*)(src + i));
+        auto transparent = _mm_cmpeq_epi32(_mm_srli_epi32(s, 24), zero);
+        if (_mm_movemask_epi8(transparent) == 0xffff)
+            continue;
+        auto d = _mm_loadu_si128((const __m128i*)(dst + i));
+        auto s_lo = _mm_unpacklo_epi8(s, zero);
+        auto s_hi = _mm_unpackhi_epi8(s, zero);
+        auto lo = lerp_unpacked(lightened_gray_unpacked(s_lo), _mm_unpacklo_epi8(d, zero), broadcast_alpha(s_lo));
+        auto hi = lerp_unpacked(lightened_gray_unpacked(s_hi), _mm_unpackhi_epi8(d, zero), broadcast_alpha(s_hi));
+        auto blended = _mm_or_si128(_mm_packus_epi16(lo, hi), opaque_mask());
+        blended = _mm_or_si128(_mm_and_si128(transparent, d), _mm_andnot_si128(transparent, blended));
+        _mm_storeu_si128((__m128i*)(dst + i), blended);
+    }
+    blend_dimmed_scalar(dst + i, src + i, count - i);
+}
+
+// dst * (255 - alpha of src) / 255, rounded to nearest like scale_pixel() does.
+SSE2_HELPER static __m128i scale_by_inverse_alpha(__m128i dst, __m128i src)
+{
+    auto inverse = _mm_sub_epi16(_mm_set1_epi16(255), broadcast_alpha(src));
+    auto x = _mm_add_epi16(_mm_mullo_epi16(dst, inverse), _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+}
+
+SSE2_FUNCTION static void blend_premultiplied_sse2(RGBA32* dst, const RGBA32* src, int count)
+{
+    auto zero = _mm_setzero_si128();
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        auto s = _mm_loadu_si128((const __m128i*)(src + i));
+        auto alphas = _mm_srli_epi32(s, 24);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(alphas, zero)) == 0xffff)
+            continue;
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(alphas, _mm_set1_epi32(0xff))) == 0xffff) {
+            _mm_storeu_si128((__m128i*)(dst + i), s);
+            continue;
+        }
+        // No division and no select: a fully transparent pixel scales the destination by 255 / 255.
+        auto d = _mm_loadu_si128((const __m128i*)(dst + i));
+        auto lo = scale_by_inverse_alpha(_mm_unpacklo_epi8(d, zero), _mm_unpacklo_epi8(s, zero));
+        auto hi = scale_by_inverse_alpha(_mm_unpackhi_epi8(d, zero), _mm_unpackhi_epi8(s, zero));
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_add_epi8(_mm_packus_epi16(lo, hi), s));
+    }
+    blend_premultiplied_scalar(dst + i, src + i, count - i);
+}
+
+static const PaintingKernels s_sse2_kernels {
+    "sse2",
+    // NOTE: Filling and copying are bound by memory bandwidth, and fast_u32_fill() and
+    //       fast_u32_copy() already saturate it. SSE2 stores measured no faster.
+    fill_scalar,
+    copy_scalar,
+    blend_color_sse2,
+    blend_with_opacity_sse2,
+    blend_with_alpha_sse2,
+    blend_dimmed_sse2,
+    blend_premultiplied_sse2,
+    blend_premultiplied_with_opacity_scalar,
+};
+
+#endif
+
+const PaintingKernels& PaintingKernels::scalar()
+{
+    return s_scalar_kernels;
+}
+
+const PaintingKernels* PaintingKernels::sse2()
+{
+#ifdef HAS_SSE2_KERNELS
+    static int has_sse2 = -1;
+    if (has_sse2 < 0) {
+        unsigned eax, ebx, ecx, edx;
+        has_sse2 = __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (edx & bit_SSE2);
+    }
+    if (has_sse2)
+        return &s_sse2_kernels;
+#endif
+    return nullptr;
+}
+
+const PaintingKernels& PaintingKernels::the()
+{
+    static const PaintingKernels* kernels;
+    if (!kernels) {
+        kernels = sse2();
+        if (!kernels)
+            kernels = &scalar();
+    }
+    return *kernels;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "Color.h"
+
+// The inner loops of the Painter, one scanline at a time.
+//
+// Every kernel exists in a plain C++ version, and the ones that matter for compositing
+// also exist in an SSE2 version. Which set gets used is decided once, the first time
+// PaintingKernels::the() is called, based on what the CPU supports.
+//
+// The straight alpha blending kernels treat the destination as opaque (its alpha is ignored
+// and comes out as 255), which is what a Painter drawing into an RGB32 bitmap wants. The
+// results are exactly the same as with Color::blend() against an opaque color.
+//
+// The premultiplied ones take an RGBA32Premultiplied source and work for both opaque and
+// premultiplied destinations, since "over" is the same operation for either.
+struct PaintingKernels {
+    const char* name;
+
+    void (*fill)(RGBA32* dst, RGBA32 color, int count);
+    void (*copy)(RGBA32* dst, const RGBA32* src, int count);
+
+    // Draws a translucent color over `dst`.
+    void (*blend_color)(RGBA32* dst, Color color, int count);
+
+    // Draws `src` over `dst` with the same alpha for every pixel, ignoring the alpha in `src`.
+    void (*blend_with_opacity)(RGBA32* dst, const RGBA32* src, u8 alpha, int count);
+
+    // Draws `src` over `dst` using the alpha of each `src` pixel.
+    void (*blend_with_alpha)(RGBA32* dst, const RGBA32* src, int count);
+
+    // Like blend_with_alpha(), but with `src` turned gray and lightened first, for disabled things.
+    void (*blend_dimmed)(RGBA32* dst, const RGBA32* src, int count);
+
+    // Draws the premultiplied `src` over `dst`.
+    void (*blend_premultiplied)(RGBA32* dst, const RGBA32* src, int count);
+
+    // Like blend_premultiplied(), but with `src` made more transparent by `opacity` first.
+    void (*blend_premultiplied_with_opacity)(RGBA32* dst, const RGBA32* src, u8 opacity, int count);
+
+    static const PaintingKernels& the();
+
+    static const PaintingKernels& scalar();
+    // Returns nullptr if the CPU doesn't support SSE2.
+    static const PaintingKernels* sse2();
+};
@@ -20,7 +20,7 @@ static RefPtr<GraphicsBitmap> render_thumbnail(const StringView& path)
         return nullptr;
     auto thumbnail = GraphicsBitmap::create(png_bitmap->format(), { 32, 32 });
     Painter painter(*thumbnail);
-    painter.draw_scaled_bitmap(thumbnail->rect(), *png_bitmap, png_bitmap->rect());
+    painter.draw_scaled_bitmap(thumbnail->rect(), *png_bitmap, png_bitmap->rect(), Painter::ScalingMode::BoxFilter);
     return thumbnail;
 }
 
@@ -87,8 +87,7 @@ void GWindow::hide()
     GWindowServerConnection::the().send_sync<WindowServer::DestroyWindow>(m_window_id);
     m_window_id = 0;
     m_pending_paint_event_rects.clear();
-    m_back_bitmap = nullptr;
-    m_front_bitmap = nullptr;
+    discard_swapchain();
 
     bool app_has_visible_windows = false;
     for (auto& window : *all_windows) {
@@ -132,10 +131,8 @@ void GWindow::set_rect(const Rect& a_rect)
         return;
     }
     GWindowServerConnection::the().send_sync<WindowServer::SetWindowRect>(m_window_id, a_rect);
-    if (m_back_bitmap && m_back_bitmap->size() != a_rect.size())
-        m_back_bitmap = nullptr;
-    if (m_front_bitmap && m_front_bitmap->size() != a_rect.size())
-        m_front_bitmap = nullptr;
+    if (!m_swapchain.is_empty() && m_swapchain.first().bitmap->size() != a_rect.size())
+        discard_swapchain();
     if (m_main_widget)
         m_main_widget->resize(a_rect.size());
 }
@@ -201,45 +198,39 @@ void GWindow::event(CEvent& event)
         if (!m_main_widget)
             return;
         auto& paint_event = static_cast<GMultiPaintEvent&>(event);
-        auto rects = paint_event.rects();
-        ASSERT(!rects.is_empty());
-        if (m_back_bitmap && m_back_bitmap->size() != paint_event.window_size()) {
-            // Eagerly discard the backing store if we learn from this paint event that it needs to be bigger.
+        auto window_rect = Rect { {}, paint_event.window_size() };
+        ASSERT(!paint_event.rects().is_empty());
+        if (!m_swapchain.is_empty() && m_swapchain.first().bitmap->size() != paint_event.window_size()) {
+            // Eagerly discard the swapchain if we learn from this paint event that it needs to be bigger.
             // Otherwise we would have to wait for a resize event to tell us. This way we don't waste the
-            // effort on painting into an undersized bitmap that will be thrown away anyway.
-            m_back_bitmap = nullptr;
+            // effort on painting into undersized bitmaps that will be thrown away anyway.
+            discard_swapchain();
         }
-        bool created_new_backing_store = !m_back_bitmap;
-        if (!m_back_bitmap) {
-            m_back_bitmap = create_backing_bitmap(paint_event.window_size());
-        } else if (m_double_buffering_enabled) {
-            bool still_has_pixels = m_back_bitmap->shared_buffer()->set_nonvolatile();
-            if (!still_has_pixels) {
-                m_back_bitmap = create_backing_bitmap(paint_event.window_size());
-                created_new_backing_store = true;
-            }
-        }
-
-        auto rect = rects.first();
-        if (rect.is_empty() || created_new_backing_store) {
-            rects.clear();
-            rects.append({ {}, paint_event.window_size() });
+        if (m_swapchain.is_empty())
+            create_swapchain(paint_event.window_size());
+
+        DisjointRectSet dirty_rects;
+        dirty_rects.add(m_rects_waiting_for_buffer);
+        for (auto& rect : paint_event.rects())
+            dirty_rects.add(rect.is_empty() ? window_rect : rect.intersected(window_rect));
+
+        int buffer_index = acquire_buffer();
+        if (buffer_index < 0) {
+            // The WindowServer still has all of our buffers. We'll paint when it gives one back.
+            m_rects_waiting_for_buffer.add(dirty_rects);
+            return;
         }
+        m_rects_waiting_for_buffer.clear_with_capacity();
+        m_back_buffer_index = buffer_index;
 
-        for (auto& rect : rects)
+        DisjointRectSet rects_to_paint;
+        rects_to_paint.add(dirty_rects);
+        rects_to_paint.add(m_swapchain[buffer_index].stale_rects);
+        for (auto& rect : rects_to_paint.rects())
             m_main_widget->dispatch_event(*make<GPaintEvent>(rect), this);
 
-        if (m_double_buffering_enabled)
-            flip(rects);
-        else if (created_new_backing_store)
-            set_current_backing_bitmap(*m_back_bitmap, true);
-
-        if (m_window_id) {
-            Vector<Rect> rects_to_send;
-            for (auto& r : rects)
-                rects_to_send.append(r);
-            GWindowServerConnection::the().post_message(WindowServer::DidFinishPainting(m_window_id, rects_to_send));
-        }
+        if (m_window_id)
+            present_buffer(buffer_index, dirty_rects);
         return;
     }
 
@@ -276,11 +267,11 @@ void GWindow::event(CEvent& event)
 
     if (event.type() == GEvent::Resize) {
         auto new_size = static_cast<GResizeEvent&>(event).size();
-        if (m_back_bitmap && m_back_bitmap->size() != new_size)
-            m_back_bitmap = nullptr;
+        if (!m_swapchain.is_empty() && m_swapchain.first().bitmap->size() != new_size)
+            discard_swapchain();
         if (!m_pending_paint_event_rects.is_empty()) {
             m_pending_paint_event_rects.clear_with_capacity();
-            m_pending_paint_event_rects.append({ {}, new_size });
+            m_pending_paint_event_rects.add({ {}, new_size });
         }
         m_rect_when_windowless = { {}, new_size };
         m_main_widget->set_relative_rect({ {}, new_size });
@@ -308,27 +299,21 @@ void GWindow::update(const Rect& a_rect)
     if (!m_window_id)
         return;
 
-    for (auto& pending_rect : m_pending_paint_event_rects) {
-        if (pending_rect.contains(a_rect)) {
-#ifdef UPDATE_COALESCING_DEBUG
-            dbgprintf("Ignoring %s since it's contained by pending rect %s\n", a_rect.to_string().characters(), pending_rect.to_string().characters());
-#endif
-            return;
-        }
-    }
-
     if (m_pending_paint_event_rects.is_empty()) {
         deferred_invoke([this](auto&) {
             auto rects = move(m_pending_paint_event_rects);
             if (rects.is_empty())
                 return;
+#ifdef UPDATE_COALESCING_DEBUG
+            dbgprintf("Sending %d coalesced update rects, bounding rect %s\n", rects.size(), rects.bounding_rect().to_string().characters());
+#endif
             Vector<Rect> rects_to_send;
-            for (auto& r : rects)
+            for (auto& r : rects.rects())
                 rects_to_send.append(r);
             GWindowServerConnection::the().post_message(WindowServer::InvalidateRect(m_window_id, rects_to_send));
         });
     }
-    m_pending_paint_event_rects.append(a_rect);
+    m_pending_paint_event_rects.add(a_rect);
 }
 
 void GWindow::set_main_widget(GWidget* widget)
@@ -392,8 +377,7 @@ void GWindow::set_has_alpha_channel(bool value)
         return;
 
     m_pending_paint_event_rects.clear();
-    m_back_bitmap = nullptr;
-    m_front_bitmap = nullptr;
+    discard_swapchain();
 
     GWindowServerConnection::the().send_sync<WindowServer::SetWindowHasAlphaChannel>(m_window_id, value);
     update();
@@ -427,30 +411,103 @@ void GWindow::set_hovered_widget(GWidget* widget)
         CEventLoop::current().post_event(*m_hovered_widget, make<GEvent>(GEvent::Enter));
 }
 
-void GWindow::set_current_backing_bitmap(GraphicsBitmap& bitmap, bool flush_immediately)
+void GWindow::create_swapchain(const Size& size)
 {
-    GWindowServerConnection::the().send_sync<WindowServer::SetWindowBackingStore>(m_window_id, 32, bitmap.pitch(), bitmap.shared_buffer_id(), bitmap.has_alpha_channel(), bitmap.size(), flush_immediately);
+    ASSERT(m_swapchain.is_empty());
+    int buffer_count = m_double_buffering_enabled ? 3 : 1;
+    int buffer_ids[3] = { -1, -1, -1 };
+    for (int i = 0; i < buffer_count; ++i) {
+        SwapchainBuffer buffer;
+        buffer.bitmap = create_backing_bitmap(size);
+        buffer.stale_rects.add({ {}, size });
+        buffer_ids[i] = buffer.bitmap->shared_buffer_id();
+        m_swapchain.append(move(buffer));
+    }
+    ++m_swapchain_id;
+    // NOTE: This doesn't wait for a response. The WindowServer will have the new buffers by the time we present one.
+    GWindowServerConnection::the().post_message(WindowServer::SetWindowSwapchain(m_window_id, m_swapchain_id, size, m_has_alpha_channel, buffer_count, buffer_ids[0], buffer_ids[1], buffer_ids[2]));
 }
 
-void GWindow::flip(const Vector<Rect, 32>& dirty_rects)
+void GWindow::discard_swapchain()
 {
-    swap(m_front_bitmap, m_back_bitmap);
+    // NOTE: The WindowServer keeps showing whatever we presented last until we present a buffer from the next swapchain.
+    m_swapchain.clear();
+    m_back_buffer_index = -1;
+    m_front_buffer_index = -1;
+    m_rects_waiting_for_buffer.clear();
+}
 
-    set_current_backing_bitmap(*m_front_bitmap);
+GraphicsBitmap* GWindow::back_bitmap()
+{
+    if (m_swapchain.is_empty())
+        return nullptr;
+    if (m_back_buffer_index < 0) {
+        // Someone wants to paint outside of a paint event. The WindowServer hands buffers back
+        // right after we present another one, so we'll hardly ever have to wait here.
+        while ((m_back_buffer_index = acquire_buffer()) < 0)
+            GWindowServerConnection::the().wait_for_buffer_release();
+    }
+    return m_swapchain[m_back_buffer_index].bitmap.ptr();
+}
+
+int GWindow::acquire_buffer()
+{
+    // Without double buffering, we paint into the one buffer even while it's being shown.
+    if (m_swapchain.size() == 1)
+        return 0;
+    for (int i = 0; i < m_swapchain.size(); ++i) {
+        auto& buffer = m_swapchain[i];
+        if (buffer.is_with_server)
+            continue;
+        if (!buffer.bitmap->shared_buffer()->set_nonvolatile()) {
+            // The kernel took away the pixels while the buffer was sitting around unused.
+            buffer.stale_rects.clear();
+            buffer.stale_rects.add(buffer.bitmap->rect());
+        }
+        return i;
+    }
+    return -1;
+}
 
-    if (!m_back_bitmap || m_back_bitmap->size() != m_front_bitmap->size()) {
-        m_back_bitmap = create_backing_bitmap(m_front_bitmap->size());
-        memcpy(m_back_bitmap->scanline(0), m_front_bitmap->scanline(0), m_front_bitmap->size_in_bytes());
-        m_back_bitmap->shared_buffer()->set_volatile();
-        return;
+void GWindow::present_buffer(int buffer_index, const DisjointRectSet& dirty_rects)
+{
+    for (int i = 0; i < m_swapchain.size(); ++i) {
+        if (i == buffer_index)
+            m_swapchain[i].stale_rects.clear_with_capacity();
+        else
+            m_swapchain[i].stale_rects.add(dirty_rects);
+    }
+    if (m_swapchain.size() > 1) {
+        // The WindowServer owns the buffer now, so it's no longer ours to paint into.
+        m_swapchain[buffer_index].is_with_server = true;
+        m_back_buffer_index = -1;
+    }
+    // The first buffer presented from a new swapchain replaces the old backing store entirely,
+    // so the WindowServer has to redraw all of it, not just the parts we happened to repaint.
+    bool is_first_present = m_front_buffer_index < 0;
+    m_front_buffer_index = buffer_index;
+
+    Vector<Rect> rects_to_send;
+    if (is_first_present) {
+        rects_to_send.append({ {}, m_swapchain[buffer_index].bitmap->size() });
+    } else {
+        for (auto& rect : dirty_rects.rects())
+            rects_to_send.append(rect);
     }
+    GWindowServerConnection::the().post_message(WindowServer::PresentWindowBuffer(m_window_id, m_swapchain_id, buffer_index, rects_to_send));
+}
 
-    // Copy whatever was painted from the front to the back.
-    Painter painter(*m_back_bitmap);
-    for (auto& dirty_rect : dirty_rects)
-        painter.blit(dirty_rect.location(), *m_front_bitmap, dirty_rect);
+void GWindow::notify_buffer_released(Badge<GWindowServerConnection>, int swapchain_id, int buffer_index)
+{
+    // Releases of buffers from a swapchain we've since thrown away don't matter.
+    if (swapchain_id != m_swapchain_id || buffer_index < 0 || buffer_index >= m_swapchain.size())
+        return;
+    auto& buffer = m_swapchain[buffer_index];
+    buffer.is_with_server = false;
+    buffer.bitmap->shared_buffer()->set_volatile();
 
-    m_back_bitmap->shared_buffer()->set_volatile();
+    if (!m_rects_waiting_for_buffer.is_empty())
+        CEventLoop::current().post_event(*this, make<GMultiPaintEvent>(m_rects_waiting_for_buffer.rects(), buffer.bitmap->size()));
 }
 
 NonnullRefPtr<GraphicsBitmap> GWindow::create_shared_bitmap(GraphicsBitmap::Format format, const Size& size)
@@ -467,7 +524,8 @@ NonnullRefPtr<GraphicsBitmap> GWindow::create_shared_bitmap(GraphicsBitmap::Form
 
 NonnullRefPtr<GraphicsBitmap> GWindow::create_backing_bitmap(const Size& size)
 {
-    auto format = m_has_alpha_channel ? GraphicsBitmap::Format::RGBA32 : GraphicsBitmap::Format::RGB32;
+    // NOTE: Premultiplied alpha lets the WindowServer composite us without any divisions.
+    auto format = m_has_alpha_channel ? GraphicsBitmap::Format::RGBA32Premultiplied : GraphicsBitmap::Format::RGB32;
     return create_shared_bitmap(format, size);
 }
 
@@ -593,16 +651,16 @@ void GWindow::notify_state_changed(Badge<GWindowServerConnection>, bool minimize
 {
     m_visible_for_timer_purposes = !minimized && !occluded;
 
-    // When double buffering is enabled, minimization/occlusion means we can mark the front bitmap volatile (in addition to the back bitmap.)
-    // When double buffering is disabled, there is only the back bitmap (which we can now mark volatile!)
-    RefPtr<GraphicsBitmap>& bitmap = m_double_buffering_enabled ? m_front_bitmap : m_back_bitmap;
-    if (!bitmap)
+    // While minimized or occluded, nobody is looking at the buffer we presented last, so the kernel may as well
+    // take its pixels if it needs them. The other buffers are already volatile whenever they're not being painted.
+    if (m_front_buffer_index < 0)
         return;
+    auto& buffer = m_swapchain[m_front_buffer_index];
     if (minimized || occluded) {
-        bitmap->shared_buffer()->set_volatile();
+        buffer.bitmap->shared_buffer()->set_volatile();
     } else {
-        if (!bitmap->shared_buffer()->set_nonvolatile()) {
-            bitmap = nullptr;
+        if (!buffer.bitmap->shared_buffer()->set_nonvolatile()) {
+            buffer.stale_rects.add(buffer.bitmap->rect());
             update();
         }
     }
@@ -5,6 +5,7 @@
 #include <AK/String.h>
 #include <AK/WeakPtr.h>
 #include <LibCore/CObject.h>
+#include <LibDraw/DisjointRectSet.h>
 #include <LibDraw/GraphicsBitmap.h>
 #include <LibDraw/Rect.h>
 #include <LibGUI/GWindowType.h>
@@ -119,8 +120,8 @@ public:
     const GWidget* hovered_widget() const { return m_hovered_widget.ptr(); }
     void set_hovered_widget(GWidget*);
 
-    GraphicsBitmap* front_bitmap() { return m_front_bitmap.ptr(); }
-    GraphicsBitmap* back_bitmap() { return m_back_bitmap.ptr(); }
+    // The buffer to paint into. Never one that the WindowServer is still holding on to.
+    GraphicsBitmap* back_bitmap();
 
     Size size_increment() const { return m_size_increment; }
     void set_size_increment(const Size& increment) { m_size_increment = increment; }
@@ -141,6 +142,7 @@ public:
 
     static void update_all_windows(Badge<GWindowServerConnection>);
     void notify_state_changed(Badge<GWindowServerConnection>, bool minimized, bool occluded);
+    void notify_buffer_released(Badge<GWindowServerConnection>, int swapchain_id, int buffer_index);
 
     virtual bool is_visible_for_timer_purposes() const override { return m_visible_for_timer_purposes; }
 
@@ -153,11 +155,27 @@ private:
 
     NonnullRefPtr<GraphicsBitmap> create_backing_bitmap(const Size&);
     NonnullRefPtr<GraphicsBitmap> create_shared_bitmap(GraphicsBitmap::Format, const Size&);
-    void set_current_backing_bitmap(GraphicsBitmap&, bool flush_immediately = false);
-    void flip(const Vector<Rect, 32>& dirty_rects);
-
-    RefPtr<GraphicsBitmap> m_front_bitmap;
-    RefPtr<GraphicsBitmap> m_back_bitmap;
+    void create_swapchain(const Size&);
+    void discard_swapchain();
+    int acquire_buffer();
+    void present_buffer(int buffer_index, const DisjointRectSet& dirty_rects);
+
+    // The buffers we paint into and hand over to the WindowServer. With double buffering there are three
+    // of them, so there's usually one free to paint the next frame into while the WindowServer still has
+    // the other two. Without double buffering there's just the one, and we paint straight into it.
+    struct SwapchainBuffer {
+        RefPtr<GraphicsBitmap> bitmap;
+        bool is_with_server { false };
+        // What has been painted into the other buffers since this one was last presented.
+        // Instead of copying it over, it is painted again the next time this buffer is used.
+        DisjointRectSet stale_rects { 64 };
+    };
+    Vector<SwapchainBuffer, 3> m_swapchain;
+    int m_swapchain_id { 0 };
+    int m_back_buffer_index { -1 };
+    int m_front_buffer_index { -1 };
+    // Rects we were asked to paint while every buffer was with the WindowServer.
+    DisjointRectSet m_rects_waiting_for_buffer { 64 };
     RefPtr<GraphicsBitmap> m_icon;
     int m_window_id { 0 };
     float m_opacity_when_windowless { 1.0f };
@@ -168,7 +186,7 @@ private:
     WeakPtr<GWidget> m_hovered_widget;
     Rect m_rect_when_windowless;
     String m_title_when_windowless;
-    Vector<Rect, 32> m_pending_paint_event_rects;
+    DisjointRectSet m_pending_paint_event_rects { 64 };
     Size m_size_increment;
     Size m_base_size;
     Color m_background_color { Color::WarmGray };
@@ -296,3 +296,15 @@ void GWindowServerConnection::handle(const WindowClient::WindowStateChanged& mes
     if (auto* window = GWindow::from_window_id(message.window_id()))
         window->notify_state_changed({}, message.minimized(), message.occluded());
 }
+
+void GWindowServerConnection::wait_for_buffer_release()
+{
+    auto message = wait_for_specific_message<WindowClient::WindowBufferReleased>();
+    handle(*message);
+}
+
+void GWindowServerConnection::handle(const WindowClient::WindowBufferReleased& message)
+{
+    if (auto* window = GWindow::from_window_id(message.window_id()))
+        window->notify_buffer_released({}, message.swapchain_id(), message.buffer_index());
+}
@@ -18,6 +18,9 @@ public:
     virtual void handshake() override;
     static GWindowServerConnection& the();
 
+    // Blocks until the WindowServer gives one of our window buffers back.
+    void wait_for_buffer_release();
+
 private:
     virtual void handle(const WindowClient::Paint&) override;
     virtual void handle(const WindowClient::MouseMove&) override;
@@ -46,4 +49,5 @@ private:
     virtual void handle(const WindowClient::DragCancelled&) override;
     virtual void handle(const WindowClient::UpdateSystemTheme&) override;
     virtual void handle(const WindowClient::WindowStateChanged&) override;
+    virtual void handle(const WindowClient::WindowBufferReleased&) override;
 };
@@ -74,7 +74,7 @@ public:
     {
         auto buffer = message.encode();
 
-        int nwritten = write(m_socket->fd(), buffer.data(), (size_t)buffer.size());
+        int nwritten = send_message_buffer(m_socket->fd(), buffer);
         if (nwritten < 0) {
             switch (errno) {
             case EPIPE:
@@ -91,7 +91,7 @@ public:
             }
         }
 
-        ASSERT(nwritten == buffer.size());
+        ASSERT(nwritten == buffer.data.size());
     }
 
     void drain_messages_from_client()
@@ -99,7 +99,7 @@ public:
         Vector<u8> bytes;
         for (;;) {
             u8 buffer[4096];
-            ssize_t nread = recv(m_socket->fd(), buffer, sizeof(buffer), MSG_DONTWAIT);
+            ssize_t nread = receive_with_attached_files(m_socket->fd(), buffer, sizeof(buffer), MSG_DONTWAIT, m_received_fds);
             if (nread == 0 || (nread == -1 && errno == EAGAIN)) {
                 if (bytes.is_empty()) {
                     CEventLoop::current().post_event(*this, make<IDisconnectedEvent>(client_id()));
@@ -117,7 +117,7 @@ public:
         size_t decoded_bytes = 0;
         for (size_t index = 0; index < (size_t)bytes.size(); index += decoded_bytes) {
             auto remaining_bytes = ByteBuffer::wrap(bytes.data() + index, bytes.size() - index);
-            auto message = Endpoint::decode_message(remaining_bytes, decoded_bytes);
+            auto message = Endpoint::decode_message(remaining_bytes, m_received_fds, decoded_bytes);
             if (!message) {
                 dbg() << "drain_messages_from_client: Endpoint didn't recognize message";
                 did_misbehave();
@@ -168,6 +168,7 @@ protected:
 private:
     Endpoint& m_endpoint;
     RefPtr<CLocalSocket> m_socket;
+    Queue<int> m_received_fds;
     int m_client_id { -1 };
     int m_client_pid { -1 };
 };
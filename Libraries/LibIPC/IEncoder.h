@@ -1,5 +1,6 @@
 #pragma once
 
+#include <LibIPC/IFile.h>
 #include <LibIPC/IMessage.h>
 
 class IEncoder {
@@ -16,49 +17,49 @@ public:
 
     IEncoder& operator<<(u8 value)
     {
-        m_buffer.append(value);
+        m_buffer.data.append(value);
         return *this;
     }
 
     IEncoder& operator<<(u16 value)
     {
-        m_buffer.ensure_capacity(m_buffer.size() + 2);
-        m_buffer.unchecked_append((u8)value);
-        m_buffer.unchecked_append((u8)(value >> 8));
+        m_buffer.data.ensure_capacity(m_buffer.data.size() + 2);
+        m_buffer.data.unchecked_append((u8)value);
+        m_buffer.data.unchecked_append((u8)(value >> 8));
         return *this;
     }
 
     IEncoder& operator<<(u32 value)
     {
-        m_buffer.ensure_capacity(m_buffer.size() + 4);
-        m_buffer.unchecked_append((u8)value);
-        m_buffer.unchecked_append((u8)(value >> 8));
-        m_buffer.unchecked_append((u8)(value >> 16));
-        m_buffer.unchecked_append((u8)(value >> 24));
+        m_buffer.data.ensure_capacity(m_buffer.data.size() + 4);
+        m_buffer.data.unchecked_append((u8)value);
+        m_buffer.data.unchecked_append((u8)(value >> 8));
+        m_buffer.data.unchecked_append((u8)(value >> 16));
+        m_buffer.data.unchecked_append((u8)(value >> 24));
         return *this;
     }
 
     IEncoder& operator<<(i8 value)
     {
-        m_buffer.append((u8)value);
+        m_buffer.data.append((u8)value);
         return *this;
     }
 
     IEncoder& operator<<(i16 value)
     {
-        m_buffer.ensure_capacity(m_buffer.size() + 2);
-        m_buffer.unchecked_append((u8)value);
-        m_buffer.unchecked_append((u8)(value >> 8));
+        m_buffer.data.ensure_capacity(m_buffer.data.size() + 2);
+        m_buffer.data.unchecked_append((u8)value);
+        m_buffer.data.unchecked_append((u8)(value >> 8));
         return *this;
     }
 
     IEncoder& operator<<(i32 value)
     {
-        m_buffer.ensure_capacity(m_buffer.size() + 4);
-        m_buffer.unchecked_append((u8)value);
-        m_buffer.unchecked_append((u8)(value >> 8));
-        m_buffer.unchecked_append((u8)(value >> 16));
-        m_buffer.unchecked_append((u8)(value >> 24));
+        m_buffer.data.ensure_capacity(m_buffer.data.size() + 4);
+        m_buffer.data.unchecked_append((u8)value);
+        m_buffer.data.unchecked_append((u8)(value >> 8));
+        m_buffer.data.unchecked_append((u8)(value >> 16));
+        m_buffer.data.unchecked_append((u8)(value >> 24));
         return *this;
     }
 
@@ -86,7 +87,16 @@ public:
 
     IEncoder& operator<<(const StringView& value)
     {
-        m_buffer.append((const u8*)value.characters_without_null_termination(), value.length());
+        m_buffer.data.append((const u8*)value.characters_without_null_termination(), value.length());
+        return *this;
+    }
+
+    IEncoder& operator<<(const IFile& file)
+    {
+        // The file descriptor itself goes alongside the bytes; the bytes only say whether there is one.
+        *this << file.is_valid();
+        if (file.is_valid())
+            m_buffer.fds.append(file.fd());
         return *this;
     }
 
@@ -0,0 +1,24 @@
+#pragma once
+
+// IFile is a file descriptor attached to an IPC message.
+//
+// It travels next to the message bytes (as SCM_RIGHTS), so the receiver gets its own
+// file descriptor for the same open file, typically a memfd holding a large payload.
+// That way big data moves as a capability, rather than as an ID that both sides have
+// to look up somewhere.
+//
+// NOTE: The receiver owns the file descriptor it gets, and has to close() it.
+class IFile {
+public:
+    IFile() {}
+    explicit IFile(int fd)
+        : m_fd(fd)
+    {
+    }
+
+    bool is_valid() const { return m_fd >= 0; }
+    int fd() const { return m_fd; }
+
+private:
+    int m_fd { -1 };
+};
@@ -1,4 +1,11 @@
 #include <LibIPC/IMessage.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// The kernel won't queue up more than this many passed file descriptors anyway,
+// so we always have room for everything that's waiting.
+static constexpr int max_received_fds = 64;
 
 IMessage::IMessage()
 {
@@ -7,3 +14,59 @@ IMessage::IMessage()
 IMessage::~IMessage()
 {
 }
+
+ssize_t send_message_buffer(int socket_fd, const IMessageBuffer& buffer)
+{
+    if (buffer.fds.is_empty())
+        return write(socket_fd, buffer.data.data(), (size_t)buffer.data.size());
+
+    iovec vec { const_cast<u8*>(buffer.data.data()), (size_t)buffer.data.size() };
+    size_t fds_size = buffer.fds.size() * sizeof(int);
+    Vector<u8, CMSG_SPACE(sizeof(int))> control;
+    control.resize(CMSG_SPACE(fds_size));
+    memset(control.data(), 0, control.size());
+
+    msghdr message;
+    memset(&message, 0, sizeof(message));
+    message.msg_iov = &vec;
+    message.msg_iovlen = 1;
+    message.msg_control = control.data();
+    message.msg_controllen = control.size();
+
+    auto* header = CMSG_FIRSTHDR(&message);
+    header->cmsg_len = CMSG_LEN(fds_size);
+    header->cmsg_level = SOL_SOCKET;
+    header->cmsg_type = SCM_RIGHTS;
+    memcpy(CMSG_DATA(header), buffer.fds.data(), fds_size);
+
+    return sendmsg(socket_fd, &message, 0);
+}
+
+ssize_t receive_with_attached_files(int socket_fd, void* buffer, size_t buffer_size, int flags, Queue<int>& received_fds)
+{
+    iovec vec { buffer, buffer_size };
+    u8 control[CMSG_SPACE(max_received_fds * sizeof(int))];
+
+    msghdr message;
+    memset(&message, 0, sizeof(message));
+    message.msg_iov = &vec;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+
+    ssize_t nread = recvmsg(socket_fd, &message, flags);
+    if (nread < 0)
+        return nread;
+
+    for (auto* header = CMSG_FIRSTHDR(&message); header; header = CMSG_NXTHDR(&message, header)) {
+        if (header->cmsg_level != SOL_SOCKET || header->cmsg_type != SCM_RIGHTS)
+            continue;
+        size_t count = (header->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        for (size_t i = 0; i < count; ++i) {
+            int fd;
+            memcpy(&fd, CMSG_DATA(header) + i * sizeof(int), sizeof(int));
+            received_fds.enqueue(fd);
+        }
+    }
+    return nread;
+}
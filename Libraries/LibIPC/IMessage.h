@@ -1,8 +1,14 @@
 #pragma once
 
+#include <AK/Queue.h>
 #include <AK/String.h>
+#include <sys/types.h>
 
-typedef Vector<u8, 1024> IMessageBuffer;
+struct IMessageBuffer {
+    Vector<u8, 1024> data;
+    // File descriptors attached with IFile, in the order they were encoded.
+    Vector<int, 1> fds;
+};
 
 class IMessage {
 public:
@@ -16,3 +22,10 @@ public:
 protected:
     IMessage();
 };
+
+// Sends an encoded message over a local socket, along with any file descriptors attached to it.
+// Returns the number of bytes written, or -1 with errno set, just like write().
+ssize_t send_message_buffer(int socket_fd, const IMessageBuffer&);
+
+// Like recv(), but also picks up the file descriptors that came along, in the order they were sent.
+ssize_t receive_with_attached_files(int socket_fd, void* buffer, size_t, int flags, Queue<int>& received_fds);
@@ -93,13 +93,13 @@ public:
     bool post_message(const IMessage& message)
     {
         auto buffer = message.encode();
-        int nwritten = write(m_connection->fd(), buffer.data(), (size_t)buffer.size());
+        int nwritten = send_message_buffer(m_connection->fd(), buffer);
         if (nwritten < 0) {
             perror("write");
             ASSERT_NOT_REACHED();
             return false;
         }
-        ASSERT(nwritten == buffer.size());
+        ASSERT(nwritten == buffer.data.size());
         return true;
     }
 
@@ -119,7 +119,7 @@ private:
         Vector<u8> bytes;
         for (;;) {
             u8 buffer[4096];
-            ssize_t nread = recv(m_connection->fd(), buffer, sizeof(buffer), MSG_DONTWAIT);
+            ssize_t nread = receive_with_attached_files(m_connection->fd(), buffer, sizeof(buffer), MSG_DONTWAIT, m_received_fds);
             if (nread < 0) {
                 if (errno == EAGAIN)
                     break;
@@ -139,9 +139,9 @@ private:
         size_t decoded_bytes = 0;
         for (size_t index = 0; index < (size_t)bytes.size(); index += decoded_bytes) {
             auto remaining_bytes = ByteBuffer::wrap(bytes.data() + index, bytes.size() - index);
-            if (auto message = LocalEndpoint::decode_message(remaining_bytes, decoded_bytes)) {
+            if (auto message = LocalEndpoint::decode_message(remaining_bytes, m_received_fds, decoded_bytes)) {
                 m_unprocessed_messages.append(move(message));
-            } else if (auto message = PeerEndpoint::decode_message(remaining_bytes, decoded_bytes)) {
+            } else if (auto message = PeerEndpoint::decode_message(remaining_bytes, m_received_fds, decoded_bytes)) {
                 m_unprocessed_messages.append(move(message));
             } else {
                 ASSERT_NOT_REACHED();
@@ -170,6 +170,7 @@ private:
     RefPtr<CLocalSocket> m_connection;
     RefPtr<CNotifier> m_notifier;
     Vector<OwnPtr<IMessage>> m_unprocessed_messages;
+    Queue<int> m_received_fds;
     int m_server_pid { -1 };
     int m_my_client_id { -1 };
 };
@@ -0,0 +1,183 @@
+#include <AK/Types.h>
+#include <LibDraw/PaintingKernels.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+// Runs each of the Painter's row kernels over a screenful of pixels, once with the scalar
+// kernels and once with the SIMD ones, checks that they agree, and prints how fast they went.
+
+static const int width = 1024;
+static const int height = 768;
+static const int iterations = 20;
+
+static u64 now_in_usec()
+{
+    timeval now;
+    gettimeofday(&now, nullptr);
+    return (u64)now.tv_sec * 1000000 + now.tv_usec;
+}
+
+// Random pixels with the kind of alpha that icons and window shadows have:
+// mostly fully transparent or fully opaque, with translucent edges.
+static void fill_with_random_pixels(RGBA32* pixels, size_t count)
+{
+    for (size_t i = 0; i < count; ++i) {
+        u32 color = (u32)rand() & 0xffffff;
+        u32 alpha;
+        switch (rand() % 4) {
+        case 0:
+            alpha = 0;
+            break;
+        case 1:
+            alpha = rand() & 0xff;
+            break;
+        default:
+            alpha = 0xff;
+            break;
+        }
+        pixels[i] = (alpha << 24) | color;
+    }
+}
+
+// Checks the scalar kernels against Color::blend(), which is what the Painter used to do.
+static bool check_against_color_blend(const RGBA32* src, const RGBA32* dst)
+{
+    RGBA32 result[256];
+    memcpy(result, dst, sizeof(result));
+    PaintingKernels::scalar().blend_with_alpha(result, src, 256);
+    for (int i = 0; i < 256; ++i) {
+        Color expected = Color::from_rgb(dst[i]).blend(Color::from_rgba(src[i]));
+        if (!Color::from_rgba(src[i]).alpha())
+            expected = Color::from_rgba(dst[i]);
+        if (Color::from_rgba(src[i]).alpha() == 0xff)
+            expected = Color::from_rgba(src[i]);
+        if (result[i] != expected.value()) {
+            fprintf(stderr, "blend_with_alpha: %08x over %08x gave %08x, expected %08x\n", src[i], dst[i], result[i], expected.value());
+            return false;
+        }
+    }
+    return true;
+}
+
+// Premultiplied blending rounds differently, but it should never be more than one step off.
+static bool check_premultiplied_against_color_blend(const RGBA32* src, const RGBA32* dst)
+{
+    for (int i = 0; i < 256; ++i) {
+        RGBA32 premultiplied_src = Color::from_rgba(src[i]).to_premultiplied();
+        RGBA32 result = dst[i] | 0xff000000;
+        PaintingKernels::scalar().blend_premultiplied(&result, &premultiplied_src, 1);
+        Color expected = Color::from_rgb(dst[i]).blend(Color::from_rgba(src[i]));
+        if (!Color::from_rgba(src[i]).alpha())
+            expected = Color::from_rgb(dst[i]);
+        for (int shift = 0; shift < 32; shift += 8) {
+            int difference = (int)((result >> shift) & 0xff) - (int)((expected.value() >> shift) & 0xff);
+            if (difference < -1 || difference > 1) {
+                fprintf(stderr, "blend_premultiplied: %08x over %08x gave %08x, expected %08x\n", src[i], dst[i], result, expected.value());
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+template<typename Callback>
+static u64 run(const char* name, const PaintingKernels& kernels, RGBA32* dst, const RGBA32* initial_dst, Callback callback)
+{
+    u64 best = 0;
+    for (int i = 0; i < iterations; ++i) {
+        memcpy(dst, initial_dst, width * height * sizeof(RGBA32));
+        u64 start = now_in_usec();
+        for (int y = 0; y < height; ++y)
+            callback(kernels, dst + y * width, y * width);
+        u64 elapsed = now_in_usec() - start;
+        if (!best || elapsed < best)
+            best = elapsed;
+    }
+    best = best ? best : 1;
+    printf("  %-20s %-8s %6llu us/frame  %7.1f Mpixels/s\n", name, kernels.name, (unsigned long long)best, (double)width * height / best);
+    return best;
+}
+
+int main(int, char**)
+{
+    srand(1234);
+    size_t pixel_count = width * height;
+    auto* src = (RGBA32*)malloc(pixel_count * sizeof(RGBA32));
+    auto* premultiplied_src = (RGBA32*)malloc(pixel_count * sizeof(RGBA32));
+    auto* initial_dst = (RGBA32*)malloc(pixel_count * sizeof(RGBA32));
+    auto* scalar_dst = (RGBA32*)malloc(pixel_count * sizeof(RGBA32));
+    auto* simd_dst = (RGBA32*)malloc(pixel_count * sizeof(RGBA32));
+    fill_with_random_pixels(src, pixel_count);
+    fill_with_random_pixels(initial_dst, pixel_count);
+    for (size_t i = 0; i < pixel_count; ++i)
+        premultiplied_src[i] = Color::from_rgba(src[i]).to_premultiplied();
+
+    if (!check_against_color_blend(src, initial_dst) || !check_premultiplied_against_color_blend(src, initial_dst))
+        return 1;
+
+    auto& scalar = PaintingKernels::scalar();
+    auto* simd = PaintingKernels::sse2();
+    printf("Painting %dx%d pixels, best of %d runs:\n", width, height, iterations);
+    if (!simd)
+        printf("  (This CPU doesn't have SSE2, so there is only the scalar version.)\n");
+
+    // For comparison, this is how the Painter used to blend, one Color::blend() per pixel.
+    PaintingKernels color_blend = scalar;
+    color_blend.name = "Color";
+    color_blend.blend_with_alpha = [](RGBA32* dst, const RGBA32* src, int count) {
+        for (int i = 0; i < count; ++i) {
+            u8 alpha = Color::from_rgba(src[i]).alpha();
+            if (alpha == 0xff)
+                dst[i] = src[i];
+            else if (alpha)
+                dst[i] = Color::from_rgba(dst[i]).blend(Color::from_rgba(src[i])).value();
+        }
+    };
+    run("blend_with_alpha", color_blend, scalar_dst, initial_dst, [&](auto& kernels, RGBA32* row, size_t offset) {
+        kernels.blend_with_alpha(row, src + offset, width);
+    });
+
+    bool ok = true;
+    auto benchmark = [&](const char* name, auto callback) {
+        u64 scalar_time = run(name, scalar, scalar_dst, initial_dst, callback);
+        if (!simd)
+            return;
+        u64 simd_time = run(name, *simd, simd_dst, initial_dst, callback);
+        printf("  %-20s speedup  %.2fx\n", name, (double)scalar_time / simd_time);
+        if (memcmp(scalar_dst, simd_dst, pixel_count * sizeof(RGBA32))) {
+            fprintf(stderr, "%s: The %s and %s kernels disagree!\n", name, scalar.name, simd->name);
+            ok = false;
+        }
+    };
+
+    benchmark("fill", [&](auto& kernels, RGBA32* row, size_t) {
+        kernels.fill(row, 0xff336699, width);
+    });
+    benchmark("copy", [&](auto& kernels, RGBA32* row, size_t offset) {
+        kernels.copy(row, src + offset, width);
+    });
+    benchmark("blend_color", [&](auto& kernels, RGBA32* row, size_t) {
+        kernels.blend_color(row, Color(0x33, 0x66, 0x99, 0x80), width);
+    });
+    benchmark("blend_with_opacity", [&](auto& kernels, RGBA32* row, size_t offset) {
+        kernels.blend_with_opacity(row, src + offset, 0xc0, width);
+    });
+    benchmark("blend_with_alpha", [&](auto& kernels, RGBA32* row, size_t offset) {
+        kernels.blend_with_alpha(row, src + offset, width);
+    });
+    benchmark("blend_dimmed", [&](auto& kernels, RGBA32* row, size_t offset) {
+        kernels.blend_dimmed(row, src + offset, width);
+    });
+    benchmark("blend_premultiplied", [&](auto& kernels, RGBA32* row, size_t offset) {
+        kernels.blend_premultiplied(row, premultiplied_src + offset, width);
+    });
+
+    free(src);
+    free(premultiplied_src);
+    free(initial_dst);
+    free(scalar_dst);
+    free(simd_dst);
+    return ok ? 0 : 1;
+}
@@ -5,6 +5,7 @@
 #include <LibCore/CFile.h>
 #include <errno.h>
 #include <signal.h>
+#include <spawn.h>
 #include <stdio.h>
 #include <sys/types.h>
 #include <sys/wait.h>
@@ -49,8 +50,10 @@ static void check_for_test_mode()
         dbg() << "Waiting for testmode shutdown...";
         sleep(5);
         dbg() << "Shutting down due to testmode...";
-        if (fork() == 0) {
-            execl("/bin/shutdown", "/bin/shutdown", "-n", nullptr);
+        const char* argv[] = { "/bin/shutdown", "-n", nullptr };
+        pid_t pid;
+        if ((errno = posix_spawn(&pid, "/bin/shutdown", nullptr, nullptr, const_cast<char**>(argv), environ))) {
+            perror("posix_spawn");
             ASSERT_NOT_REACHED();
         }
     } else {
@@ -61,18 +64,13 @@ static void check_for_test_mode()
 static void mount_all_filesystems()
 {
     dbg() << "Spawning mount -a to mount all filesystems.";
-    pid_t pid = fork();
-
-    if (pid < 0) {
-        perror("fork");
-        ASSERT_NOT_REACHED();
-    } else if (pid == 0) {
-        execl("/bin/mount", "mount", "-a", nullptr);
-        perror("exec");
+    const char* argv[] = { "mount", "-a", nullptr };
+    pid_t pid;
+    if ((errno = posix_spawn(&pid, "/bin/mount", nullptr, nullptr, const_cast<char**>(argv), environ))) {
+        perror("posix_spawn");
         ASSERT_NOT_REACHED();
-    } else {
-        wait(nullptr);
     }
+    waitpid(pid, nullptr, 0);
 }
 
 int main(int, char**)
@@ -451,47 +451,61 @@ void WSClientConnection::handle(const WindowServer::InvalidateRect& message)
         window.request_update(message.rects()[i].intersected({ {}, window.size() }));
 }
 
-void WSClientConnection::handle(const WindowServer::DidFinishPainting& message)
+void WSClientConnection::handle(const WindowServer::SetWindowSwapchain& message)
 {
     int window_id = message.window_id();
     auto it = m_windows.find(window_id);
     if (it == m_windows.end()) {
-        did_misbehave("DidFinishPainting: Bad window ID");
+        did_misbehave("SetWindowSwapchain: Bad window ID");
         return;
     }
     auto& window = *(*it).value;
-    for (auto& rect : message.rects())
-        WSWindowManager::the().invalidate(window, rect);
+    if (message.buffer_count() < 1 || message.buffer_count() > 3) {
+        did_misbehave("SetWindowSwapchain: Bad buffer count");
+        return;
+    }
 
-    WSWindowSwitcher::the().refresh_if_needed();
+    int buffer_ids[] = { message.buffer_id_0(), message.buffer_id_1(), message.buffer_id_2() };
+    NonnullRefPtrVector<GraphicsBitmap> buffers;
+    for (int i = 0; i < message.buffer_count(); ++i) {
+        auto shared_buffer = SharedBuffer::create_from_shared_buffer_id(buffer_ids[i]);
+        if (!shared_buffer) {
+            did_misbehave("SetWindowSwapchain: Bad shared buffer ID");
+            return;
+        }
+        // NOTE: Clients draw their translucent windows with premultiplied alpha, see GWindow::create_backing_bitmap().
+        buffers.append(GraphicsBitmap::create_with_shared_buffer(
+            message.has_alpha_channel() ? GraphicsBitmap::Format::RGBA32Premultiplied : GraphicsBitmap::Format::RGB32,
+            *shared_buffer,
+            message.size()));
+    }
+    window.set_swapchain(message.swapchain_id(), move(buffers));
 }
 
-OwnPtr<WindowServer::SetWindowBackingStoreResponse> WSClientConnection::handle(const WindowServer::SetWindowBackingStore& message)
+void WSClientConnection::handle(const WindowServer::PresentWindowBuffer& message)
 {
     int window_id = message.window_id();
     auto it = m_windows.find(window_id);
     if (it == m_windows.end()) {
-        did_misbehave("SetWindowBackingStore: Bad window ID");
-        return nullptr;
+        did_misbehave("PresentWindowBuffer: Bad window ID");
+        return;
     }
     auto& window = *(*it).value;
-    if (window.last_backing_store() && window.last_backing_store()->shared_buffer_id() == message.shared_buffer_id()) {
-        window.swap_backing_stores();
-    } else {
-        auto shared_buffer = SharedBuffer::create_from_shared_buffer_id(message.shared_buffer_id());
-        if (!shared_buffer)
-            return make<WindowServer::SetWindowBackingStoreResponse>();
-        auto backing_store = GraphicsBitmap::create_with_shared_buffer(
-            message.has_alpha_channel() ? GraphicsBitmap::Format::RGBA32 : GraphicsBitmap::Format::RGB32,
-            *shared_buffer,
-            message.size());
-        window.set_backing_store(move(backing_store));
+    if (message.swapchain_id() != window.swapchain_id() || message.buffer_index() < 0 || message.buffer_index() >= window.swapchain_size()) {
+        did_misbehave("PresentWindowBuffer: Bad buffer");
+        return;
     }
 
-    if (message.flush_immediately())
-        window.invalidate();
+    // The compositor only ever looks at a window's backing store while composing, so the buffer
+    // this one replaces is free for the client to paint into again right away.
+    int released_buffer_index = window.present_swapchain_buffer(message.buffer_index());
+    if (released_buffer_index >= 0)
+        post_message(WindowClient::WindowBufferReleased(window_id, window.swapchain_id(), released_buffer_index));
 
-    return make<WindowServer::SetWindowBackingStoreResponse>();
+    for (auto& rect : message.dirty_rects())
+        WSWindowManager::the().invalidate(window, rect);
+
+    WSWindowSwitcher::the().refresh_if_needed();
 }
 
 OwnPtr<WindowServer::SetGlobalCursorTrackingResponse> WSClientConnection::handle(const WindowServer::SetGlobalCursorTracking& message)
@@ -64,10 +64,10 @@ private:
     virtual OwnPtr<WindowServer::SetWindowRectResponse> handle(const WindowServer::SetWindowRect&) override;
     virtual OwnPtr<WindowServer::GetWindowRectResponse> handle(const WindowServer::GetWindowRect&) override;
     virtual void handle(const WindowServer::InvalidateRect&) override;
-    virtual void handle(const WindowServer::DidFinishPainting&) override;
+    virtual void handle(const WindowServer::SetWindowSwapchain&) override;
+    virtual void handle(const WindowServer::PresentWindowBuffer&) override;
     virtual OwnPtr<WindowServer::SetGlobalCursorTrackingResponse> handle(const WindowServer::SetGlobalCursorTracking&) override;
     virtual OwnPtr<WindowServer::SetWindowOpacityResponse> handle(const WindowServer::SetWindowOpacity&) override;
-    virtual OwnPtr<WindowServer::SetWindowBackingStoreResponse> handle(const WindowServer::SetWindowBackingStore&) override;
     virtual OwnPtr<WindowServer::GetClipboardContentsResponse> handle(const WindowServer::GetClipboardContents&) override;
     virtual OwnPtr<WindowServer::SetClipboardContentsResponse> handle(const WindowServer::SetClipboardContents&) override;
     virtual void handle(const WindowServer::WM_SetActiveWindow&) override;
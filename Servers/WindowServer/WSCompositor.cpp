@@ -1,7 +1,9 @@
 #include "WSCompositor.h"
+#include "WSCursorPlane.h"
 #include "WSEvent.h"
 #include "WSEventLoop.h"
 #include "WSScreen.h"
+#include "WSTileWorkerPool.h"
 #include "WSWindow.h"
 #include "WSWindowManager.h"
 #include <LibDraw/Font.h>
@@ -11,6 +13,12 @@
 
 // #define COMPOSITOR_DEBUG
 
+// We don't get told about vertical retrace, so we pace ourselves to a 60 Hz display instead.
+static const int frame_interval_ms = 1000 / 60;
+
+// With worker threads, the dirty rects are cut up into tiles of at most this many pixels square.
+static const int tile_size = 256;
+
 WSCompositor& WSCompositor::the()
 {
     static WSCompositor s_the;
@@ -32,29 +40,19 @@ WallpaperMode mode_to_enum(const String& name)
 
 WSCompositor::WSCompositor()
 {
-    m_compose_timer = CTimer::construct(this);
-    m_immediate_compose_timer = CTimer::construct(this);
+    m_frame_timer = CTimer::construct(this);
 
     m_screen_can_set_buffer = WSScreen::the().can_set_buffer();
 
     init_bitmaps();
 
-    m_compose_timer->on_timeout = [&]() {
+    m_frame_timer->on_timeout = [&]() {
 #if defined(COMPOSITOR_DEBUG)
-        dbgprintf("WSCompositor: delayed frame callback: %d rects\n", m_dirty_rects.size());
+        dbgprintf("WSCompositor: frame callback: %d rects\n", m_dirty_rects.size());
 #endif
         compose();
     };
-    m_compose_timer->set_single_shot(true);
-    m_compose_timer->set_interval(1000 / 60);
-    m_immediate_compose_timer->on_timeout = [=]() {
-#if defined(COMPOSITOR_DEBUG)
-        dbgprintf("WSCompositor: immediate frame callback: %d rects\n", m_dirty_rects.size());
-#endif
-        compose();
-    };
-    m_immediate_compose_timer->set_single_shot(true);
-    m_immediate_compose_timer->set_interval(0);
+    m_frame_timer->set_single_shot(true);
 }
 
 void WSCompositor::init_bitmaps()
@@ -71,8 +69,21 @@ void WSCompositor::init_bitmaps()
 
     m_front_painter = make<Painter>(*m_front_bitmap);
     m_back_painter = make<Painter>(*m_back_bitmap);
+    if (m_tile_worker_pool)
+        create_tile_painters();
+
+    // When flipping, each buffer gets a cursor plane of its own. Otherwise the cursor
+    // only ever shows up on the screen, never in the back buffer.
+    m_front_cursor_plane = screen.create_cursor_plane(*m_front_bitmap);
+    if (m_screen_can_set_buffer)
+        m_back_cursor_plane = screen.create_cursor_plane(*m_back_bitmap);
+    else
+        m_back_cursor_plane = nullptr;
 
     m_buffers_are_flipped = false;
+    m_last_frame_dirty_rects.clear();
+    // The new cursor planes haven't drawn anything yet, so make sure the cursor gets shown.
+    m_cursor_changed = true;
 
     invalidate();
 }
@@ -82,189 +93,321 @@ void WSCompositor::compose()
     auto& wm = WSWindowManager::the();
     if (m_wallpaper_mode == WallpaperMode::Unchecked)
         m_wallpaper_mode = mode_to_enum(wm.wm_config()->read_entry("Background", "Mode", "simple"));
+    if (!m_tile_worker_pool) {
+        // FIXME: Pick a default based on the number of CPUs once we have SMP.
+        int thread_count = wm.wm_config()->read_num_entry("Compositor", "WorkerThreads", 0);
+        m_tile_worker_pool = make<WSTileWorkerPool>(max(0, thread_count), [this](int thread_index, int tile_index) {
+            paint_tile(m_tile_back_painters[thread_index], m_tiles[tile_index]);
+        });
+        create_tile_painters();
+    }
     auto& ws = WSScreen::the();
 
+    m_last_frame_time.start();
+
     auto dirty_rects = move(m_dirty_rects);
+    bool cursor_changed = m_cursor_changed;
+    m_cursor_changed = false;
 
     if (dirty_rects.size() == 0) {
-        // nothing dirtied since the last compose pass.
-        return;
+        if (!cursor_changed) {
+            // nothing dirtied since the last compose pass.
+            return;
+        }
+        // Nothing but the cursor has changed since the last compose pass, so we can move it
+        // around on the screen without painting anything else. If there was a drag-and-drop
+        // overlay next to it, that has to be painted over the normal way though.
+        if (m_last_dnd_rect.is_empty()) {
+            m_front_cursor_plane->show(wm.active_cursor(), ws.cursor_location());
+            return;
+        }
     }
 
     dirty_rects.add(Rect::intersection(m_last_geometry_label_rect, WSScreen::the().rect()));
-    dirty_rects.add(Rect::intersection(m_last_cursor_rect, WSScreen::the().rect()));
     dirty_rects.add(Rect::intersection(m_last_dnd_rect, WSScreen::the().rect()));
-    dirty_rects.add(Rect::intersection(current_cursor_rect(), WSScreen::the().rect()));
+    bool will_paint_over_cursor = false;
+    if (m_screen_can_set_buffer) {
+        m_back_cursor_plane->hide();
+        catch_up_back_buffer(dirty_rects);
+    } else if (dirty_rects.intersects(m_front_cursor_plane->painted_rect())) {
+        // Flushing will copy over part of the cursor on the screen, so copy over all of it
+        // and show it again afterwards.
+        dirty_rects.add(m_front_cursor_plane->painted_rect());
+        will_paint_over_cursor = true;
+    }
 #ifdef DEBUG_COUNTERS
     dbgprintf("[WM] compose #%u (%u rects)\n", ++m_compose_count, dirty_rects.rects().size());
 #endif
 
-    auto any_dirty_rect_intersects_window = [&dirty_rects](const WSWindow& window) {
-        auto window_frame_rect = window.frame().rect();
-        for (auto& dirty_rect : dirty_rects.rects()) {
-            if (dirty_rect.intersects(window_frame_rect))
-                return true;
-        }
-        return false;
-    };
+    prepare_tiles(dirty_rects);
+    m_tile_worker_pool->paint_tiles(m_tiles.size());
 
-    // Paint the wallpaper.
-    for (auto& dirty_rect : dirty_rects.rects()) {
-        if (wm.any_opaque_window_contains_rect(dirty_rect))
-            continue;
-        // FIXME: If the wallpaper is opaque, no need to fill with color!
-        m_back_painter->fill_rect(dirty_rect, wm.palette().desktop_background());
-        if (m_wallpaper) {
-            if (m_wallpaper_mode == WallpaperMode::Simple) {
-                m_back_painter->blit(dirty_rect.location(), *m_wallpaper, dirty_rect);
-            } else if (m_wallpaper_mode == WallpaperMode::Center) {
-                Point offset { ws.size().width() / 2 - m_wallpaper->size().width() / 2,
-                    ws.size().height() / 2 - m_wallpaper->size().height() / 2 };
-                m_back_painter->blit_offset(dirty_rect.location(), *m_wallpaper,
-                    dirty_rect, offset);
-            } else if (m_wallpaper_mode == WallpaperMode::Tile) {
-                m_back_painter->draw_tiled_bitmap(dirty_rect, *m_wallpaper);
-            } else if (m_wallpaper_mode == WallpaperMode::Scaled) {
-                float hscale = (float)m_wallpaper->size().width() / (float)ws.size().width();
-                float vscale = (float)m_wallpaper->size().height() / (float)ws.size().height();
-
-                m_back_painter->blit_scaled(dirty_rect, *m_wallpaper, dirty_rect, hscale, vscale);
-            } else {
-                ASSERT_NOT_REACHED();
-            }
-        }
+    if (!wm.active_fullscreen_window())
+        draw_geometry_label();
+
+    run_animations();
+
+    draw_dnd_overlay();
+
+    if (m_flash_flush) {
+        for (auto& rect : dirty_rects.rects())
+            m_front_painter->fill_rect(rect, Color::Yellow);
     }
 
-    auto compose_window = [&](WSWindow& window) -> IterationDecision {
-        if (!any_dirty_rect_intersects_window(window))
-            return IterationDecision::Continue;
-        PainterStateSaver saver(*m_back_painter);
-        m_back_painter->add_clip_rect(window.frame().rect());
-        RefPtr<GraphicsBitmap> backing_store = window.backing_store();
-        for (auto& dirty_rect : dirty_rects.rects()) {
-            if (wm.any_opaque_window_above_this_one_contains_rect(window, dirty_rect))
-                continue;
-            PainterStateSaver saver(*m_back_painter);
-            m_back_painter->add_clip_rect(dirty_rect);
-            if (!backing_store)
-                m_back_painter->fill_rect(dirty_rect, wm.palette().window());
-            if (!window.is_fullscreen())
-                window.frame().paint(*m_back_painter);
-            if (!backing_store)
-                continue;
-
-            // Decide where we would paint this window's backing store.
-            // This is subtly different from widow.rect(), because window
-            // size may be different from its backing store size. This
-            // happens when the window has been resized and the client
-            // has not yet attached a new backing store. In this case,
-            // we want to try to blit the backing store at the same place
-            // it was previously, and fill the rest of the window with its
-            // background color.
-            Rect backing_rect;
-            backing_rect.set_size(backing_store->size());
-            switch (WSWindowManager::the().resize_direction_of_window(window)) {
-            case ResizeDirection::None:
-            case ResizeDirection::Right:
-            case ResizeDirection::Down:
-            case ResizeDirection::DownRight:
-                backing_rect.set_location(window.rect().location());
-                break;
-            case ResizeDirection::Left:
-            case ResizeDirection::Up:
-            case ResizeDirection::UpLeft:
-                backing_rect.set_right_without_resize(window.rect().right());
-                backing_rect.set_bottom_without_resize(window.rect().bottom());
-                break;
-            case ResizeDirection::UpRight:
-                backing_rect.set_left(window.rect().left());
-                backing_rect.set_bottom_without_resize(window.rect().bottom());
-                break;
-            case ResizeDirection::DownLeft:
-                backing_rect.set_right_without_resize(window.rect().right());
-                backing_rect.set_top(window.rect().top());
-                break;
-            }
+    if (m_screen_can_set_buffer) {
+        m_back_cursor_plane->show(wm.active_cursor(), ws.cursor_location());
+        flip_buffers();
+        // The buffer we just flipped away from is now a frame behind. Instead of copying
+        // everything over right away, we remember what it's missing and catch up on it when
+        // composing the next frame, since most of it tends to get painted over again anyway.
+        m_last_frame_dirty_rects = move(dirty_rects);
+    } else {
+        for (auto& r : dirty_rects.rects())
+            flush(r);
+        if (will_paint_over_cursor)
+            m_front_cursor_plane->did_paint_over_cursor();
+        if (will_paint_over_cursor || cursor_changed)
+            m_front_cursor_plane->show(wm.active_cursor(), ws.cursor_location());
+    }
+}
 
-            Rect dirty_rect_in_backing_coordinates = dirty_rect
-                                                         .intersected(window.rect())
-                                                         .intersected(backing_rect)
-                                                         .translated(-backing_rect.location());
+void WSCompositor::create_tile_painters()
+{
+    m_tile_back_painters.clear();
+    m_tile_front_painters.clear();
+    // The calling thread paints tiles too, so it needs painters of its own as well.
+    for (int i = 0; i <= m_tile_worker_pool->thread_count(); ++i) {
+        m_tile_back_painters.append(make<Painter>(*m_back_bitmap));
+        m_tile_front_painters.append(make<Painter>(*m_front_bitmap));
+    }
+}
 
-            if (dirty_rect_in_backing_coordinates.is_empty())
-                continue;
-            auto dst = backing_rect.location().translated(dirty_rect_in_backing_coordinates.location());
+void WSCompositor::prepare_tiles(const DisjointRectSet& dirty_rects)
+{
+    auto& wm = WSWindowManager::the();
 
-            m_back_painter->blit(dst, *backing_store, dirty_rect_in_backing_coordinates, window.opacity());
-            for (auto background_rect : window.rect().shatter(backing_rect))
-                m_back_painter->fill_rect(background_rect, wm.palette().window());
-        }
+    // Everything the tiles need from the rest of the WindowServer is looked up here, on the main thread,
+    // so that the workers only ever read pixels and rects.
+    m_desktop_background_color = wm.palette().desktop_background();
+    m_window_background_color = wm.palette().window();
+    if (m_wallpaper && m_wallpaper_mode == WallpaperMode::Scaled)
+        scaled_wallpaper();
+
+    m_windows_to_compose.clear_with_capacity();
+    auto add_window = [&](WSWindow& window) {
+        auto frame_rect = window.frame().rect();
+        if (!dirty_rects.intersects(frame_rect))
+            return IterationDecision::Continue;
+        WindowToCompose item;
+        item.window = &window;
+        item.frame_rect = frame_rect;
+        item.backing_store = window.backing_store();
+        // The active fullscreen window is the only thing we paint, so all of it is visible no matter what's in front of it.
+        item.is_fully_visible = &window == wm.active_fullscreen_window();
+        if (item.backing_store)
+            item.backing_rect = backing_rect_for_window(window, *item.backing_store);
+        m_windows_to_compose.append(item);
         return IterationDecision::Continue;
     };
+    if (auto* fullscreen_window = wm.active_fullscreen_window())
+        add_window(*fullscreen_window);
+    else
+        wm.for_each_visible_window_from_back_to_front(add_window);
 
-    // Paint the window stack.
-    if (auto* fullscreen_window = wm.active_fullscreen_window()) {
-        compose_window(*fullscreen_window);
-    } else {
-        wm.for_each_visible_window_from_back_to_front([&](WSWindow& window) {
-            return compose_window(window);
-        });
+    m_tiles.clear_with_capacity();
+    if (!m_tile_worker_pool->thread_count()) {
+        for (auto& rect : dirty_rects.rects())
+            m_tiles.append(rect);
+        return;
+    }
+    // Cut the dirty rects up along a grid, so that a big one doesn't end up on a single thread.
+    for (auto& rect : dirty_rects.rects()) {
+        for (int y = rect.top() - rect.top() % tile_size; y <= rect.bottom(); y += tile_size) {
+            for (int x = rect.left() - rect.left() % tile_size; x <= rect.right(); x += tile_size)
+                m_tiles.append(rect.intersected({ x, y, tile_size, tile_size }));
+        }
+    }
+}
 
-        draw_geometry_label();
+Rect WSCompositor::backing_rect_for_window(WSWindow& window, const GraphicsBitmap& backing_store)
+{
+    // Decide where we would paint this window's backing store.
+    // This is subtly different from widow.rect(), because window
+    // size may be different from its backing store size. This
+    // happens when the window has been resized and the client
+    // has not yet attached a new backing store. In this case,
+    // we want to try to blit the backing store at the same place
+    // it was previously, and fill the rest of the window with its
+    // background color.
+    Rect backing_rect;
+    backing_rect.set_size(backing_store.size());
+    switch (WSWindowManager::the().resize_direction_of_window(window)) {
+    case ResizeDirection::None:
+    case ResizeDirection::Right:
+    case ResizeDirection::Down:
+    case ResizeDirection::DownRight:
+        backing_rect.set_location(window.rect().location());
+        break;
+    case ResizeDirection::Left:
+    case ResizeDirection::Up:
+    case ResizeDirection::UpLeft:
+        backing_rect.set_right_without_resize(window.rect().right());
+        backing_rect.set_bottom_without_resize(window.rect().bottom());
+        break;
+    case ResizeDirection::UpRight:
+        backing_rect.set_left(window.rect().left());
+        backing_rect.set_bottom_without_resize(window.rect().bottom());
+        break;
+    case ResizeDirection::DownLeft:
+        backing_rect.set_right_without_resize(window.rect().right());
+        backing_rect.set_top(window.rect().top());
+        break;
     }
+    return backing_rect;
+}
 
-    run_animations();
+// NOTE: This runs on the compositor worker threads, so it must not touch anything
+//       that prepare_tiles() didn't set up for it.
+void WSCompositor::paint_tile(Painter& painter, const Rect& tile_rect)
+{
+    // The painter is reused from tile to tile, so put its clip rect and translation back afterwards.
+    PainterStateSaver saver(painter);
+    painter.add_clip_rect(tile_rect);
+
+    // Paint the wallpaper, but only where it isn't hidden behind an opaque window.
+    for (auto& desktop_rect : WSWindowManager::the().visible_desktop_rects().rects()) {
+        auto rect = desktop_rect.intersected(tile_rect);
+        if (!rect.is_empty())
+            paint_wallpaper(painter, rect);
+    }
 
-    draw_cursor();
+    for (auto& item : m_windows_to_compose) {
+        if (!item.frame_rect.intersects(tile_rect))
+            continue;
+        if (item.is_fully_visible) {
+            paint_window(painter, item, tile_rect);
+            continue;
+        }
+        // Only paint the parts of the window that nothing opaque is covering.
+        for (auto& visible_rect : item.window->visible_rects().rects()) {
+            auto rect = visible_rect.intersected(tile_rect);
+            if (!rect.is_empty())
+                paint_window(painter, item, rect);
+        }
+    }
+}
 
-    if (m_flash_flush) {
-        for (auto& rect : dirty_rects.rects())
-            m_front_painter->fill_rect(rect, Color::Yellow);
+void WSCompositor::paint_wallpaper(Painter& painter, const Rect& rect)
+{
+    // FIXME: If the wallpaper is opaque, no need to fill with color!
+    painter.fill_rect(rect, m_desktop_background_color);
+    if (!m_wallpaper)
+        return;
+    if (m_wallpaper_mode == WallpaperMode::Simple) {
+        painter.blit(rect.location(), *m_wallpaper, rect);
+    } else if (m_wallpaper_mode == WallpaperMode::Center) {
+        auto& screen = WSScreen::the();
+        Point offset { screen.size().width() / 2 - m_wallpaper->size().width() / 2,
+            screen.size().height() / 2 - m_wallpaper->size().height() / 2 };
+        painter.blit_offset(rect.location(), *m_wallpaper,
+            rect, offset);
+    } else if (m_wallpaper_mode == WallpaperMode::Tile) {
+        painter.draw_tiled_bitmap(rect, *m_wallpaper);
+    } else if (m_wallpaper_mode == WallpaperMode::Scaled) {
+        painter.blit(rect.location(), *m_scaled_wallpaper, rect);
+    } else {
+        ASSERT_NOT_REACHED();
     }
+}
 
-    if (m_screen_can_set_buffer)
-        flip_buffers();
+void WSCompositor::paint_window(Painter& painter, const WindowToCompose& item, const Rect& dirty_rect)
+{
+    auto& window = *item.window;
+    PainterStateSaver saver(painter);
+    painter.add_clip_rect(item.frame_rect);
+    painter.add_clip_rect(dirty_rect);
+    if (!item.backing_store)
+        painter.fill_rect(dirty_rect, m_window_background_color);
+    if (!window.is_fullscreen()) {
+        // Frames draw text and look at the window manager's state, none of which is thread safe.
+        LOCKER(m_frame_paint_lock);
+        window.frame().paint(painter);
+    }
+    if (!item.backing_store)
+        return;
+
+    auto& backing_rect = item.backing_rect;
+    Rect dirty_rect_in_backing_coordinates = dirty_rect
+                                                 .intersected(window.rect())
+                                                 .intersected(backing_rect)
+                                                 .translated(-backing_rect.location());
+
+    if (dirty_rect_in_backing_coordinates.is_empty())
+        return;
+    auto dst = backing_rect.location().translated(dirty_rect_in_backing_coordinates.location());
 
-    for (auto& r : dirty_rects.rects())
-        flush(r);
+    painter.blit(dst, *item.backing_store, dirty_rect_in_backing_coordinates, window.opacity());
+    for (auto background_rect : window.rect().shatter(backing_rect))
+        painter.fill_rect(background_rect, m_window_background_color);
+}
+
+// Copies `from_rect` of `from` to `to_location` in `to`.
+static void copy_pixels(GraphicsBitmap& to, const Point& to_location, const GraphicsBitmap& from, const Rect& from_rect)
+{
+    RGBA32* to_ptr = to.scanline(to_location.y()) + to_location.x();
+    const RGBA32* from_ptr = from.scanline(from_rect.y()) + from_rect.x();
+
+    // Rects that span whole scanlines are one contiguous block of memory.
+    size_t row_size = from_rect.width() * sizeof(RGBA32);
+    if (row_size == from.pitch() && row_size == to.pitch()) {
+        fast_u32_copy(to_ptr, from_ptr, from_rect.width() * from_rect.height());
+        return;
+    }
+
+    for (int y = 0; y < from_rect.height(); ++y) {
+        fast_u32_copy(to_ptr, from_ptr, from_rect.width());
+        from_ptr = (const RGBA32*)((const u8*)from_ptr + from.pitch());
+        to_ptr = (RGBA32*)((u8*)to_ptr + to.pitch());
+    }
 }
 
 void WSCompositor::flush(const Rect& a_rect)
 {
+    // NOTE: This is only used when we can't flip buffers. Flushing copies the changed
+    //       rects from the back buffer to the display framebuffer.
+    ASSERT(!m_screen_can_set_buffer);
     auto rect = Rect::intersection(a_rect, WSScreen::the().rect());
 
 #ifdef DEBUG_COUNTERS
     dbgprintf("[WM] flush #%u (%d,%d %dx%d)\n", ++m_flush_count, rect.x(), rect.y(), rect.width(), rect.height());
 #endif
 
-    RGBA32* front_ptr = m_front_bitmap->scanline(rect.y()) + rect.x();
-    RGBA32* back_ptr = m_back_bitmap->scanline(rect.y()) + rect.x();
-    size_t pitch = m_back_bitmap->pitch();
-
-    // NOTE: The meaning of a flush depends on whether we can flip buffers or not.
-    //
-    //       If flipping is supported, flushing means that we've flipped, and now we
-    //       copy the changed bits from the front buffer to the back buffer, to keep
-    //       them in sync.
-    //
-    //       If flipping is not supported, flushing means that we copy the changed
-    //       rects from the backing bitmap to the display framebuffer.
+    copy_pixels(*m_front_bitmap, rect.location(), *m_back_bitmap, rect);
+}
 
-    RGBA32* to_ptr;
-    const RGBA32* from_ptr;
+void WSCompositor::catch_up_back_buffer(DisjointRectSet& dirty_rects)
+{
+    ASSERT(m_screen_can_set_buffer);
 
-    if (m_screen_can_set_buffer) {
-        to_ptr = back_ptr;
-        from_ptr = front_ptr;
-    } else {
-        to_ptr = front_ptr;
-        from_ptr = back_ptr;
+    // The back buffer is missing what we painted into the front buffer last frame. Whatever
+    // of that we're not about to paint anyway can be copied over from the front buffer,
+    // except for where the front buffer has the cursor on it. Those bits have to be painted again.
+    auto stale_rects = move(m_last_frame_dirty_rects);
+    stale_rects.subtract(dirty_rects);
+    auto front_cursor_rect = m_front_cursor_plane->painted_rect();
+    if (stale_rects.intersects(front_cursor_rect)) {
+        DisjointRectSet stale_rects_under_cursor;
+        stale_rects_under_cursor.add(stale_rects);
+        stale_rects_under_cursor.intersect(front_cursor_rect);
+        dirty_rects.add(stale_rects_under_cursor);
+        stale_rects.subtract(front_cursor_rect);
     }
 
-    for (int y = 0; y < rect.height(); ++y) {
-        fast_u32_copy(to_ptr, from_ptr, rect.width());
-        from_ptr = (const RGBA32*)((const u8*)from_ptr + pitch);
-        to_ptr = (RGBA32*)((u8*)to_ptr + pitch);
+    for (auto& rect : stale_rects.rects()) {
+#ifdef DEBUG_COUNTERS
+        dbgprintf("[WM] catch up #%u (%d,%d %dx%d)\n", ++m_flush_count, rect.x(), rect.y(), rect.width(), rect.height());
+#endif
+        copy_pixels(*m_back_bitmap, rect.location(), *m_front_bitmap, rect);
     }
 }
 
@@ -282,20 +425,23 @@ void WSCompositor::invalidate(const Rect& a_rect)
 
     m_dirty_rects.add(rect);
 
-    // We delay composition by a timer interval, but to not affect latency too
-    // much, if a pending compose is not already scheduled, we also schedule an
-    // immediate compose the next spin of the event loop.
-    if (!m_compose_timer->is_active()) {
 #if defined(COMPOSITOR_DEBUG)
-        dbgprintf("Invalidated (starting immediate frame): %dx%d %dx%d\n", a_rect.x(), a_rect.y(), a_rect.width(), a_rect.height());
+    dbgprintf("Invalidated (%s): %dx%d %dx%d\n", m_frame_timer->is_active() ? "frame callback pending" : "scheduling frame", a_rect.x(), a_rect.y(), a_rect.width(), a_rect.height());
 #endif
-        m_compose_timer->start();
-        m_immediate_compose_timer->start();
-    } else {
-#if defined(COMPOSITOR_DEBUG)
-        dbgprintf("Invalidated (frame callback pending): %dx%d %dx%d\n", a_rect.x(), a_rect.y(), a_rect.width(), a_rect.height());
-#endif
-    }
+    schedule_frame();
+}
+
+void WSCompositor::schedule_frame()
+{
+    if (m_frame_timer->is_active())
+        return;
+
+    // Compose at most once per display refresh. If we've been idle for longer than that,
+    // compose the next spin of the event loop so that we don't add any latency.
+    int time_until_next_frame = 0;
+    if (m_last_frame_time.is_valid())
+        time_until_next_frame = max(0, frame_interval_ms - m_last_frame_time.elapsed());
+    m_frame_timer->start(time_until_next_frame);
 }
 
 bool WSCompositor::set_wallpaper(const String& path, Function<void(bool)>&& callback)
@@ -312,17 +458,35 @@ bool WSCompositor::set_wallpaper(const String& path, Function<void(bool)>&& call
             }
             m_wallpaper_path = path;
             m_wallpaper = move(bitmap);
+            m_scaled_wallpaper = nullptr;
             invalidate();
             callback(true);
         });
     return true;
 }
 
+const GraphicsBitmap& WSCompositor::scaled_wallpaper()
+{
+    ASSERT(m_wallpaper);
+    auto& screen = WSScreen::the();
+    if (m_scaled_wallpaper && m_scaled_wallpaper->size() == screen.size())
+        return *m_scaled_wallpaper;
+
+    // NOTE: Fresh bitmaps are zero-filled, so a wallpaper with alpha starts out fully transparent.
+    auto format = m_wallpaper->has_alpha_channel() ? GraphicsBitmap::Format::RGBA32Premultiplied : GraphicsBitmap::Format::RGB32;
+    m_scaled_wallpaper = GraphicsBitmap::create(format, screen.size());
+    Painter painter(*m_scaled_wallpaper);
+    painter.draw_scaled_bitmap(m_scaled_wallpaper->rect(), *m_wallpaper, m_wallpaper->rect(), Painter::ScalingMode::BoxFilter);
+    return *m_scaled_wallpaper;
+}
+
 void WSCompositor::flip_buffers()
 {
     ASSERT(m_screen_can_set_buffer);
     swap(m_front_bitmap, m_back_bitmap);
     swap(m_front_painter, m_back_painter);
+    swap(m_tile_front_painters, m_tile_back_painters);
+    swap(m_front_cursor_plane, m_back_cursor_plane);
     WSScreen::the().set_buffer(m_buffers_are_flipped ? 0 : 1);
     m_buffers_are_flipped = !m_buffers_are_flipped;
 }
@@ -391,7 +555,8 @@ void WSCompositor::invalidate_cursor()
     auto& wm = WSWindowManager::the();
     if (wm.dnd_client())
         invalidate(wm.dnd_rect());
-    invalidate(current_cursor_rect());
+    m_cursor_changed = true;
+    schedule_frame();
 }
 
 void WSCompositor::draw_geometry_label()
@@ -416,12 +581,9 @@ void WSCompositor::draw_geometry_label()
     m_last_geometry_label_rect = geometry_label_rect;
 }
 
-void WSCompositor::draw_cursor()
+void WSCompositor::draw_dnd_overlay()
 {
     auto& wm = WSWindowManager::the();
-    Rect cursor_rect = current_cursor_rect();
-    m_back_painter->blit(cursor_rect.location(), wm.active_cursor().bitmap(), wm.active_cursor().rect());
-
     if (wm.dnd_client()) {
         auto dnd_rect = wm.dnd_rect();
         m_back_painter->fill_rect(dnd_rect, Color(110, 34, 9, 200));
@@ -438,5 +600,4 @@ void WSCompositor::draw_cursor()
     } else {
         m_last_dnd_rect = {};
     }
-    m_last_cursor_rect = cursor_rect;
 }
@@ -1,14 +1,20 @@
 #pragma once
 
+#include <AK/NonnullOwnPtrVector.h>
 #include <AK/OwnPtr.h>
 #include <AK/RefPtr.h>
+#include <LibCore/CElapsedTimer.h>
 #include <LibCore/CObject.h>
 #include <LibCore/CTimer.h>
 #include <LibDraw/DisjointRectSet.h>
 #include <LibDraw/GraphicsBitmap.h>
+#include <LibThread/Lock.h>
 
 class Painter;
 class WSCursor;
+class WSCursorPlane;
+class WSTileWorkerPool;
+class WSWindow;
 
 enum class WallpaperMode {
     Simple,
@@ -38,17 +44,34 @@ public:
 private:
     WSCompositor();
     void init_bitmaps();
+    void schedule_frame();
     void flip_buffers();
     void flush(const Rect&);
-    void draw_cursor();
+    void catch_up_back_buffer(DisjointRectSet& dirty_rects);
+
+    struct WindowToCompose {
+        WSWindow* window { nullptr };
+        Rect frame_rect;
+        GraphicsBitmap* backing_store { nullptr };
+        Rect backing_rect;
+        bool is_fully_visible { false };
+    };
+    void create_tile_painters();
+    void prepare_tiles(const DisjointRectSet& dirty_rects);
+    void paint_tile(Painter&, const Rect&);
+    void paint_wallpaper(Painter&, const Rect&);
+    void paint_window(Painter&, const WindowToCompose&, const Rect& dirty_rect);
+    static Rect backing_rect_for_window(WSWindow&, const GraphicsBitmap& backing_store);
+    void draw_dnd_overlay();
     void draw_geometry_label();
     void draw_menubar();
     void run_animations();
+    const GraphicsBitmap& scaled_wallpaper();
 
     unsigned m_compose_count { 0 };
     unsigned m_flush_count { 0 };
-    RefPtr<CTimer> m_compose_timer;
-    RefPtr<CTimer> m_immediate_compose_timer;
+    RefPtr<CTimer> m_frame_timer;
+    CElapsedTimer m_last_frame_time;
     bool m_flash_flush { false };
     bool m_buffers_are_flipped { false };
     bool m_screen_can_set_buffer { false };
@@ -58,13 +81,33 @@ private:
     OwnPtr<Painter> m_back_painter;
     OwnPtr<Painter> m_front_painter;
 
-    DisjointRectSet m_dirty_rects;
+    // Lots of scattered damage (e.g. while dragging things around) collapses into one big rect.
+    DisjointRectSet m_dirty_rects { 64 };
+    // When flipping, what was painted into the front buffer but is still missing from the back buffer.
+    DisjointRectSet m_last_frame_dirty_rects;
+
+    bool m_cursor_changed { false };
+    OwnPtr<WSCursorPlane> m_front_cursor_plane;
+    OwnPtr<WSCursorPlane> m_back_cursor_plane;
+
+    // What the tiles of the current frame need to paint. These are kept around between frames
+    // so that composing doesn't have to allocate.
+    OwnPtr<WSTileWorkerPool> m_tile_worker_pool;
+    // One painter per tile painting thread for each buffer, swapped along with the buffers.
+    NonnullOwnPtrVector<Painter> m_tile_back_painters;
+    NonnullOwnPtrVector<Painter> m_tile_front_painters;
+    Vector<Rect> m_tiles;
+    Vector<WindowToCompose> m_windows_to_compose;
+    Color m_desktop_background_color;
+    Color m_window_background_color;
+    LibThread::Lock m_frame_paint_lock;
 
-    Rect m_last_cursor_rect;
     Rect m_last_dnd_rect;
     Rect m_last_geometry_label_rect;
 
     String m_wallpaper_path;
     WallpaperMode m_wallpaper_mode { WallpaperMode::Unchecked };
     RefPtr<GraphicsBitmap> m_wallpaper;
+    // The wallpaper scaled to the screen size, for WallpaperMode::Scaled. Built when first needed.
+    RefPtr<GraphicsBitmap> m_scaled_wallpaper;
 };
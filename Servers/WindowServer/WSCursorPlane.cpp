@@ -0,0 +1,38 @@
+#include "WSCursorPlane.h"
+#include "WSCursor.h"
+
+WSSoftwareCursorPlane::WSSoftwareCursorPlane(GraphicsBitmap& framebuffer)
+    : m_framebuffer(framebuffer)
+    , m_painter(framebuffer)
+{
+}
+
+WSSoftwareCursorPlane::~WSSoftwareCursorPlane()
+{
+}
+
+void WSSoftwareCursorPlane::show(const WSCursor& cursor, const Point& location)
+{
+    hide();
+
+    Rect cursor_rect { location.translated(-cursor.hotspot()), cursor.size() };
+    auto rect = cursor_rect.intersected(m_framebuffer->rect());
+    if (rect.is_empty())
+        return;
+
+    if (!m_save_under || m_save_under->width() < rect.width() || m_save_under->height() < rect.height())
+        m_save_under = GraphicsBitmap::create(GraphicsBitmap::Format::RGB32, rect.size());
+    Painter save_under_painter(*m_save_under);
+    save_under_painter.blit({}, *m_framebuffer, rect);
+
+    m_painter.blit(cursor_rect.location(), cursor.bitmap(), cursor.rect());
+    m_painted_rect = rect;
+}
+
+void WSSoftwareCursorPlane::hide()
+{
+    if (m_painted_rect.is_empty())
+        return;
+    m_painter.blit(m_painted_rect.location(), *m_save_under, { {}, m_painted_rect.size() });
+    m_painted_rect = {};
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <AK/RefPtr.h>
+#include <LibDraw/GraphicsBitmap.h>
+#include <LibDraw/Painter.h>
+
+class WSCursor;
+
+// A cursor plane shows the mouse cursor on top of one framebuffer, without the compositor
+// having to paint it as part of the screen contents.
+//
+// Display hardware with a cursor sprite would do this by itself and never touch the pixels
+// in the framebuffer. Neither BXVGADevice nor MBVGADevice has one, so for now every plane
+// is a WSSoftwareCursorPlane.
+class WSCursorPlane {
+public:
+    virtual ~WSCursorPlane() {}
+
+    // Shows `cursor` with its hotspot at `location`, taking it away from where it was before.
+    virtual void show(const WSCursor&, const Point& location) = 0;
+
+    // Takes the cursor off the framebuffer, putting back what was underneath it.
+    virtual void hide() = 0;
+
+    // Call this after painting over the cursor, so that hide() doesn't put stale pixels back.
+    virtual void did_paint_over_cursor() = 0;
+
+    // The part of the framebuffer that has the cursor painted into it, if any.
+    virtual Rect painted_rect() const = 0;
+
+protected:
+    WSCursorPlane() {}
+};
+
+// Paints the cursor into the framebuffer and saves the pixels it covers, so that moving it
+// only touches the pixels under the old and the new cursor rect.
+class WSSoftwareCursorPlane final : public WSCursorPlane {
+public:
+    explicit WSSoftwareCursorPlane(GraphicsBitmap& framebuffer);
+    virtual ~WSSoftwareCursorPlane() override;
+
+    virtual void show(const WSCursor&, const Point& location) override;
+    virtual void hide() override;
+    virtual void did_paint_over_cursor() override { m_painted_rect = {}; }
+    virtual Rect painted_rect() const override { return m_painted_rect; }
+
+private:
+    NonnullRefPtr<GraphicsBitmap> m_framebuffer;
+    Painter m_painter;
+    RefPtr<GraphicsBitmap> m_save_under;
+    Rect m_painted_rect;
+};
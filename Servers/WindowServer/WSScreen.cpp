@@ -1,5 +1,6 @@
 #include "WSScreen.h"
 #include "WSCompositor.h"
+#include "WSCursorPlane.h"
 #include "WSEvent.h"
 #include "WSEventLoop.h"
 #include "WSWindowManager.h"
@@ -71,6 +72,12 @@ void WSScreen::set_buffer(int index)
     ASSERT(rc == 0);
 }
 
+NonnullOwnPtr<WSCursorPlane> WSScreen::create_cursor_plane(GraphicsBitmap& framebuffer)
+{
+    // FIXME: Use a hardware cursor plane once we have a display device that has one.
+    return make<WSSoftwareCursorPlane>(framebuffer);
+}
+
 void WSScreen::on_receive_mouse_data(int dx, int dy, int dz, unsigned buttons)
 {
     auto prev_location = m_cursor_location;
@@ -1,10 +1,14 @@
 #pragma once
 
+#include <AK/OwnPtr.h>
 #include <Kernel/KeyCode.h>
 #include <LibDraw/Color.h>
 #include <LibDraw/Rect.h>
 #include <LibDraw/Size.h>
 
+class GraphicsBitmap;
+class WSCursorPlane;
+
 class WSScreen {
 public:
     WSScreen(unsigned width, unsigned height);
@@ -25,6 +29,7 @@ public:
     Rect rect() const { return { 0, 0, width(), height() }; }
 
     Point cursor_location() const { return m_cursor_location; }
+    NonnullOwnPtr<WSCursorPlane> create_cursor_plane(GraphicsBitmap& framebuffer);
     unsigned mouse_button_state() const { return m_mouse_button_state; }
 
     void on_receive_mouse_data(int dx, int dy, int dz, unsigned buttons);
@@ -0,0 +1,124 @@
+#include "WSTileWorkerPool.h"
+#include <AK/StringView.h>
+#include <errno.h>
+
+WSTileWorkerPool::WSTileWorkerPool(int thread_count, Function<void(int thread_index, int tile_index)> paint_tile)
+    : m_paint_tile(move(paint_tile))
+{
+    pthread_mutex_init(&m_mutex, nullptr);
+    pthread_cond_init(&m_tiles_available, nullptr);
+    pthread_cond_init(&m_tiles_done, nullptr);
+
+    // NOTE: The contexts are all in place before the first thread starts, since appending
+    //       could move them out from under a running thread.
+    for (int i = 0; i < thread_count; ++i)
+        m_worker_contexts.append({ this, i + 1 });
+
+    StringView thread_name = "Compositor worker";
+    for (auto& context : m_worker_contexts) {
+        pthread_t thread;
+        int rc = pthread_create(&thread, nullptr, worker_entry, &context);
+        ASSERT(rc == 0);
+        pthread_setname_np(thread, thread_name.characters_without_null_termination(), thread_name.length());
+        m_threads.append(thread);
+    }
+}
+
+WSTileWorkerPool::~WSTileWorkerPool()
+{
+    pthread_mutex_lock(&m_mutex);
+    m_shutting_down = true;
+    pthread_cond_broadcast(&m_tiles_available);
+    pthread_mutex_unlock(&m_mutex);
+
+    for (auto thread : m_threads) {
+        // NOTE: A thread that is already gone can't be joined anymore, so ESRCH is fine too.
+        int rc = pthread_join(thread, nullptr);
+        ASSERT(rc == 0 || rc == -ESRCH);
+    }
+
+    pthread_cond_destroy(&m_tiles_available);
+    pthread_cond_destroy(&m_tiles_done);
+    pthread_mutex_destroy(&m_mutex);
+}
+
+int WSTileWorkerPool::paint_available_tiles(int thread_index, int generation, int tile_count)
+{
+    // The next tile to paint is claimed together with the generation it belongs to,
+    // so a thread that is late for one frame can't claim a tile of the next one.
+    int painted_count = 0;
+    for (;;) {
+        u32 next_tile = m_next_tile.load();
+        if ((int)(next_tile >> 16) != (generation & 0xffff) || (int)(next_tile & 0xffff) >= tile_count)
+            break;
+        if (!m_next_tile.compare_exchange_strong(next_tile, next_tile + 1))
+            continue;
+        m_paint_tile(thread_index, next_tile & 0xffff);
+        ++painted_count;
+    }
+    return painted_count;
+}
+
+void WSTileWorkerPool::paint_tiles(int tile_count)
+{
+    if (m_threads.is_empty()) {
+        for (int i = 0; i < tile_count; ++i)
+            m_paint_tile(0, i);
+        return;
+    }
+
+    ASSERT(tile_count <= 0xffff);
+    pthread_mutex_lock(&m_mutex);
+    ++m_generation;
+    m_tile_count = tile_count;
+    m_tiles_done_count = 0;
+    m_next_tile.store((m_generation & 0xffff) << 16);
+    int generation = m_generation;
+    pthread_cond_broadcast(&m_tiles_available);
+    pthread_mutex_unlock(&m_mutex);
+
+    int painted_count = paint_available_tiles(0, generation, tile_count);
+
+    pthread_mutex_lock(&m_mutex);
+    m_tiles_done_count += painted_count;
+    while (m_tiles_done_count < m_tile_count)
+        pthread_cond_wait(&m_tiles_done, &m_mutex);
+    pthread_mutex_unlock(&m_mutex);
+}
+
+void* WSTileWorkerPool::worker_entry(void* arg)
+{
+    auto& context = *static_cast<WorkerContext*>(arg);
+    context.pool->worker_main(context.thread_index);
+    return nullptr;
+}
+
+void WSTileWorkerPool::worker_main(int thread_index)
+{
+    int last_generation = 0;
+    for (;;) {
+        pthread_mutex_lock(&m_mutex);
+        while (m_generation == last_generation && !m_shutting_down)
+            pthread_cond_wait(&m_tiles_available, &m_mutex);
+        if (m_shutting_down) {
+            pthread_mutex_unlock(&m_mutex);
+            return;
+        }
+        last_generation = m_generation;
+        int tile_count = m_tile_count;
+        pthread_mutex_unlock(&m_mutex);
+
+        // NOTE: If we were slow to get here, the tiles may all be gone already. That's fine,
+        //       we just go back to waiting for the next frame.
+        int painted_count = paint_available_tiles(thread_index, last_generation, tile_count);
+        if (!painted_count)
+            continue;
+
+        pthread_mutex_lock(&m_mutex);
+        ASSERT(m_generation == last_generation);
+        m_tiles_done_count += painted_count;
+        if (m_tiles_done_count == m_tile_count)
+            pthread_cond_signal(&m_tiles_done);
+        pthread_mutex_unlock(&m_mutex);
+    }
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <AK/Atomic.h>
+#include <AK/Function.h>
+#include <AK/Vector.h>
+#include <pthread.h>
+
+// A few threads that help the compositor paint the tiles of a frame.
+//
+// paint_tiles() hands out the tiles to the workers and the calling thread alike, and only
+// returns once every tile has been painted. That makes it the barrier between composing
+// a frame and putting it on the screen.
+//
+// Each thread is told its index along with the tile, so it can keep state of its own
+// (like a Painter) around from one tile to the next. The calling thread is index 0,
+// the workers are 1 through thread_count().
+//
+// With no worker threads, the calling thread simply paints all the tiles by itself.
+class WSTileWorkerPool {
+public:
+    WSTileWorkerPool(int thread_count, Function<void(int thread_index, int tile_index)> paint_tile);
+    ~WSTileWorkerPool();
+
+    int thread_count() const { return m_threads.size(); }
+
+    void paint_tiles(int tile_count);
+
+private:
+    struct WorkerContext {
+        WSTileWorkerPool* pool;
+        int thread_index;
+    };
+    static void* worker_entry(void*);
+    void worker_main(int thread_index);
+    int paint_available_tiles(int thread_index, int generation, int tile_count);
+
+    Function<void(int, int)> m_paint_tile;
+    Vector<pthread_t> m_threads;
+    Vector<WorkerContext> m_worker_contexts;
+
+    pthread_mutex_t m_mutex;
+    pthread_cond_t m_tiles_available;
+    pthread_cond_t m_tiles_done;
+
+    // These are all protected by m_mutex, except for m_next_tile which the threads claim tiles with.
+    // It holds the low 16 bits of the generation in its top half and the next tile index in its bottom half.
+    int m_generation { 0 };
+    int m_tile_count { 0 };
+    int m_tiles_done_count { 0 };
+    bool m_shutting_down { false };
+    AK::Atomic<u32> m_next_tile { 0 };
+};
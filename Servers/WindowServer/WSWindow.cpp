@@ -148,6 +148,34 @@ void WSWindow::set_opacity(float opacity)
      WSWindowManager::the().notify_opacity_changed(*this);
 }
 
+void WSWindow::set_swapchain(int swapchain_id, NonnullRefPtrVector<GraphicsBitmap>&& buffers)
+{
+    // NOTE: We keep showing the current backing store until the client presents a buffer from the new swapchain.
+    //       That way a window that's being resized doesn't go blank while the client catches up.
+    m_swapchain_id = swapchain_id;
+    m_swapchain = move(buffers);
+    m_presented_buffer_index = -1;
+}
+
+int WSWindow::present_swapchain_buffer(int buffer_index)
+{
+    ASSERT(buffer_index >= 0 && buffer_index < m_swapchain.size());
+    int replaced_buffer_index = m_presented_buffer_index;
+    m_backing_store = m_swapchain.ptr_at(buffer_index);
+    m_presented_buffer_index = buffer_index;
+    if (replaced_buffer_index == buffer_index)
+        return -1;
+    return replaced_buffer_index;
+}
+
+void WSWindow::set_has_alpha_channel(bool has_alpha_channel)
+{
+    if (m_has_alpha_channel == has_alpha_channel)
+        return;
+    m_has_alpha_channel = has_alpha_channel;
+    WSWindowManager::the().notify_opacity_changed(*this);
+}
+
 void WSWindow::set_occluded(bool occluded)
 {
     if (m_occluded == occluded)
@@ -251,6 +279,7 @@ void WSWindow::set_visible(bool b)
     if (m_visible == b)
         return;
     m_visible = b;
+    WSWindowManager::the().notify_visibility_changed(*this);
     invalidate();
 }
 
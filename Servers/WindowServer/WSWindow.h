@@ -1,6 +1,7 @@
 #pragma once
 
 #include <AK/InlineLinkedList.h>
+#include <AK/NonnullRefPtrVector.h>
 #include <AK/String.h>
 #include <LibCore/CObject.h>
 #include <LibDraw/DisjointRectSet.h>
@@ -67,6 +68,14 @@ public:
     bool is_occluded() const { return m_occluded; }
     void set_occluded(bool);
 
+    // The parts of the frame that aren't covered by an opaque window in front of this one.
+    // These are kept up to date by WSWindowManager::recompute_occlusions().
+    const DisjointRectSet& visible_rects() const { return m_visible_rects; }
+    void set_visible_rects(DisjointRectSet&& rects) { m_visible_rects = move(rects); }
+
+    // An opaque window hides everything behind it, so nothing there needs to be painted.
+    bool is_opaque() const { return m_opacity == 1.0f && !m_has_alpha_channel; }
+
     bool show_titlebar() const { return m_show_titlebar; }
     void set_show_titlebar(bool show) { m_show_titlebar = show; }
 
@@ -144,25 +153,21 @@ public:
     const GraphicsBitmap* backing_store() const { return m_backing_store.ptr(); }
     GraphicsBitmap* backing_store() { return m_backing_store.ptr(); }
 
-    void set_backing_store(RefPtr<GraphicsBitmap>&& backing_store)
-    {
-        m_last_backing_store = move(m_backing_store);
-        m_backing_store = move(backing_store);
-    }
-
-    void swap_backing_stores()
-    {
-        swap(m_backing_store, m_last_backing_store);
-    }
-
-    GraphicsBitmap* last_backing_store() { return m_last_backing_store.ptr(); }
+    // Client windows hand us a swapchain of backing stores once per size, and then tell us
+    // which one of them to show whenever they've finished painting.
+    int swapchain_id() const { return m_swapchain_id; }
+    int swapchain_size() const { return m_swapchain.size(); }
+    void set_swapchain(int swapchain_id, NonnullRefPtrVector<GraphicsBitmap>&&);
+    // Shows the given buffer of the swapchain. Returns the index of the buffer it replaced, which
+    // the client can now paint into again, or -1 if there's no such buffer.
+    int present_swapchain_buffer(int buffer_index);
 
     void set_global_cursor_tracking_enabled(bool);
     void set_automatic_cursor_tracking_enabled(bool enabled) { m_automatic_cursor_tracking_enabled = enabled; }
     bool global_cursor_tracking() const { return m_global_cursor_tracking_enabled || m_automatic_cursor_tracking_enabled; }
 
     bool has_alpha_channel() const { return m_has_alpha_channel; }
-    void set_has_alpha_channel(bool value) { m_has_alpha_channel = value; }
+    void set_has_alpha_channel(bool);
 
     Size size_increment() const { return m_size_increment; }
     void set_size_increment(const Size& increment) { m_size_increment = increment; }
@@ -218,9 +223,12 @@ private:
     WindowTileType m_tiled { WindowTileType::None };
     Rect m_untiled_rect;
     bool m_occluded { false };
+    DisjointRectSet m_visible_rects;
     bool m_show_titlebar { true };
     RefPtr<GraphicsBitmap> m_backing_store;
-    RefPtr<GraphicsBitmap> m_last_backing_store;
+    NonnullRefPtrVector<GraphicsBitmap> m_swapchain;
+    int m_swapchain_id { 0 };
+    int m_presented_buffer_index { -1 };
     int m_window_id { -1 };
     float m_opacity { 1 };
     Size m_size_increment;
@@ -229,7 +237,7 @@ private:
     RefPtr<WSCursor> m_override_cursor;
     WSWindowFrame m_frame;
     unsigned m_wm_event_mask { 0 };
-    DisjointRectSet m_pending_paint_rects;
+    DisjointRectSet m_pending_paint_rects { 64 };
     Rect m_unmaximized_rect;
     Rect m_rect_in_menubar;
     RefPtr<WSMenu> m_window_menu;
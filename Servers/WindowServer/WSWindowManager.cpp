@@ -56,20 +56,20 @@ WSWindowManager::~WSWindowManager()
 NonnullRefPtr<WSCursor> WSWindowManager::get_cursor(const String& name, const Point& hotspot)
 {
     auto path = m_wm_config->read_entry("Cursor", name, "/res/cursors/arrow.png");
-    auto gb = GraphicsBitmap::load_from_file(path);
+    auto gb = GraphicsBitmap::load_from_file(path, GraphicsBitmap::PremultiplyAlpha::Yes);
     if (gb)
         return WSCursor::create(*gb, hotspot);
-    return WSCursor::create(*GraphicsBitmap::load_from_file("/res/cursors/arrow.png"));
+    return WSCursor::create(*GraphicsBitmap::load_from_file("/res/cursors/arrow.png", GraphicsBitmap::PremultiplyAlpha::Yes));
 }
 
 NonnullRefPtr<WSCursor> WSWindowManager::get_cursor(const String& name)
 {
     auto path = m_wm_config->read_entry("Cursor", name, "/res/cursors/arrow.png");
-    auto gb = GraphicsBitmap::load_from_file(path);
+    auto gb = GraphicsBitmap::load_from_file(path, GraphicsBitmap::PremultiplyAlpha::Yes);
 
     if (gb)
         return WSCursor::create(*gb);
-    return WSCursor::create(*GraphicsBitmap::load_from_file("/res/cursors/arrow.png"));
+    return WSCursor::create(*GraphicsBitmap::load_from_file("/res/cursors/arrow.png", GraphicsBitmap::PremultiplyAlpha::Yes));
 }
 
 void WSWindowManager::reload_config(bool set_screen)
@@ -117,6 +117,7 @@ const Font& WSWindowManager::app_menu_font() const
 void WSWindowManager::set_resolution(int width, int height)
 {
     WSCompositor::the().set_resolution(width, height);
+    recompute_occlusions();
     m_menu_manager.set_needs_window_resize();
     WSClientConnection::for_each_client([&](WSClientConnection& client) {
         client.notify_about_new_screen_rect(WSScreen::the().rect());
@@ -280,17 +281,34 @@ void WSWindowManager::notify_rect_changed(WSWindow& window, const Rect& old_rect
 
 void WSWindowManager::recompute_occlusions()
 {
-    for_each_visible_window_from_back_to_front([&](WSWindow& window) {
-        if (m_switcher.is_visible()) {
-            window.set_occluded(false);
-        } else {
-            if (any_opaque_window_above_this_one_contains_rect(window, window.frame().rect()))
-                window.set_occluded(true);
-            else
-                window.set_occluded(false);
-        }
+    // Walk the window stack from the front, carving the opaque windows out of everything behind them.
+    // The compositor then only paints what's left over, so every pixel covered by an opaque window
+    // gets painted exactly once.
+    auto screen_rect = WSScreen::the().rect();
+    DisjointRectSet covered_rects;
+
+    for_each_window([&](WSWindow& window) {
+        if (!window.is_visible() || window.is_minimized())
+            window.set_visible_rects({});
         return IterationDecision::Continue;
     });
+
+    for_each_visible_window_from_front_to_back([&](WSWindow& window) {
+        DisjointRectSet visible_rects;
+        visible_rects.add(window.frame().rect().intersected(screen_rect));
+        visible_rects.subtract(covered_rects);
+        if (window.is_opaque())
+            covered_rects.add(visible_rects);
+
+        // NOTE: The window switcher shows live thumbnails, so nothing counts as occluded while it's up.
+        window.set_occluded(!m_switcher.is_visible() && visible_rects.is_empty());
+        window.set_visible_rects(move(visible_rects));
+        return IterationDecision::Continue;
+    });
+
+    m_visible_desktop_rects.clear();
+    m_visible_desktop_rects.add(screen_rect);
+    m_visible_desktop_rects.subtract(covered_rects);
 }
 
 void WSWindowManager::notify_opacity_changed(WSWindow&)
@@ -298,8 +316,14 @@ void WSWindowManager::notify_opacity_changed(WSWindow&)
     recompute_occlusions();
 }
 
+void WSWindowManager::notify_visibility_changed(WSWindow&)
+{
+    recompute_occlusions();
+}
+
 void WSWindowManager::notify_minimization_state_changed(WSWindow& window)
 {
+    recompute_occlusions();
     tell_wm_listeners_window_state_changed(window);
 
     if (window.client())
@@ -854,56 +878,6 @@ void WSWindowManager::clear_resize_candidate()
     m_resize_candidate = nullptr;
 }
 
-bool WSWindowManager::any_opaque_window_contains_rect(const Rect& rect)
-{
-    bool found_containing_window = false;
-    for_each_visible_window_from_back_to_front([&](WSWindow& window) {
-        if (window.is_minimized())
-            return IterationDecision::Continue;
-        if (window.opacity() < 1.0f)
-            return IterationDecision::Continue;
-        if (window.has_alpha_channel()) {
-            // FIXME: Just because the window has an alpha channel doesn't mean it's not opaque.
-            //        Maybe there's some way we could know this?
-            return IterationDecision::Continue;
-        }
-        if (window.frame().rect().contains(rect)) {
-            found_containing_window = true;
-            return IterationDecision::Break;
-        }
-        return IterationDecision::Continue;
-    });
-    return found_containing_window;
-};
-
-bool WSWindowManager::any_opaque_window_above_this_one_contains_rect(const WSWindow& a_window, const Rect& rect)
-{
-    bool found_containing_window = false;
-    bool checking = false;
-    for_each_visible_window_from_back_to_front([&](WSWindow& window) {
-        if (&window == &a_window) {
-            checking = true;
-            return IterationDecision::Continue;
-        }
-        if (!checking)
-            return IterationDecision::Continue;
-        if (!window.is_visible())
-            return IterationDecision::Continue;
-        if (window.is_minimized())
-            return IterationDecision::Continue;
-        if (window.opacity() < 1.0f)
-            return IterationDecision::Continue;
-        if (window.has_alpha_channel())
-            return IterationDecision::Continue;
-        if (window.frame().rect().contains(rect)) {
-            found_containing_window = true;
-            return IterationDecision::Break;
-        }
-        return IterationDecision::Continue;
-    });
-    return found_containing_window;
-};
-
 Rect WSWindowManager::menubar_rect() const
 {
     if (active_fullscreen_window())
@@ -997,6 +971,8 @@ void WSWindowManager::set_highlight_window(WSWindow* window)
     if (auto* previous_highlight_window = m_highlight_window.ptr())
         invalidate(*previous_highlight_window);
     m_highlight_window = window ? window->make_weak_ptr() : nullptr;
+    // The highlighted window is stacked on top of everything else.
+    recompute_occlusions();
     if (m_highlight_window)
         invalidate(*m_highlight_window);
 }
@@ -1092,7 +1068,14 @@ void WSWindowManager::invalidate(const WSWindow& window, const Rect& rect)
     inner_rect.move_by(window.position());
     // FIXME: This seems slightly wrong; the inner rect shouldn't intersect the border part of the outer rect.
     inner_rect.intersect(outer_rect);
-    invalidate(inner_rect);
+
+    // Whatever is behind an opaque window won't be painted anyway, so don't mark it as dirty.
+    if (&window == active_fullscreen_window()) {
+        invalidate(inner_rect);
+        return;
+    }
+    for (auto& visible_rect : window.visible_rects().rects())
+        invalidate(inner_rect.intersected(visible_rect));
 }
 
 const WSClientConnection* WSWindowManager::active_client() const
@@ -68,6 +68,7 @@ public:
     void notify_rect_changed(WSWindow&, const Rect& oldRect, const Rect& newRect);
     void notify_minimization_state_changed(WSWindow&);
     void notify_opacity_changed(WSWindow&);
+    void notify_visibility_changed(WSWindow&);
     void notify_occlusion_state_changed(WSWindow&);
     void notify_client_changed_app_menubar(WSClientConnection&);
 
@@ -136,8 +137,8 @@ public:
     void clear_resize_candidate();
     ResizeDirection resize_direction_of_window(const WSWindow&);
 
-    bool any_opaque_window_contains_rect(const Rect&);
-    bool any_opaque_window_above_this_one_contains_rect(const WSWindow&, const Rect&);
+    // The parts of the screen where the desktop shows through, i.e. not covered by any opaque window.
+    const DisjointRectSet& visible_desktop_rects() const { return m_visible_desktop_rects; }
 
     void tell_wm_listeners_window_state_changed(WSWindow&);
     void tell_wm_listeners_window_icon_changed(WSWindow&);
@@ -213,6 +214,7 @@ private:
     Color m_highlight_window_title_color;
 
     InlineLinkedList<WSWindow> m_windows_in_order;
+    DisjointRectSet m_visible_desktop_rects;
 
     struct DoubleClickInfo {
         struct ClickMetadata {
@@ -5,6 +5,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/sendfile.h>
 #include <unistd.h>
 
 int main(int argc, char** argv)
@@ -24,20 +25,14 @@ int main(int argc, char** argv)
     }
     for (auto& fd : fds) {
         for (;;) {
-            char buf[32768];
-            ssize_t nread = read(fd, buf, sizeof(buf));
-            if (nread == 0)
+            // Let the kernel move the data straight from fd to stdout.
+            ssize_t nsent = sendfile(1, fd, nullptr, 65536);
+            if (nsent == 0)
                 break;
-            if (nread < 0) {
-                perror("read");
+            if (nsent < 0) {
+                perror("sendfile");
                 return 2;
             }
-            ssize_t nwritten = write(1, buf, nread);
-            if (nwritten < 0) {
-                perror("write");
-                return 3;
-            }
-            ASSERT(nwritten == nread);
         }
         close(fd);
     }
@@ -0,0 +1,246 @@
+#include <AK/ByteBuffer.h>
+#include <AK/String.h>
+#include <AK/Types.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Every message starts with one of these. The other side echoes messages back if asked to,
+// and a message with no payload tells it to go away.
+struct MessageHeader {
+    u32 payload_size;
+    u32 should_echo;
+};
+
+static void exit_with_usage(int rc)
+{
+    fprintf(stderr, "Usage: ipc_benchmark [-h] [-n round_trips] [-s message_size] [-b block_size] [-m megabytes]\n");
+    exit(rc);
+}
+
+static u64 now_in_usec()
+{
+    timeval now;
+    gettimeofday(&now, nullptr);
+    return (u64)now.tv_sec * 1000000 + now.tv_usec;
+}
+
+// Keeps going until all of the buffers are full, like a read() that never comes up short.
+static bool read_exactly(int fd, iovec* vecs, int count)
+{
+    while (count) {
+        ssize_t nread = readv(fd, vecs, count);
+        if (nread <= 0) {
+            if (nread < 0)
+                perror("readv");
+            return false;
+        }
+        while (count && (size_t)nread >= vecs->iov_len) {
+            nread -= vecs->iov_len;
+            ++vecs;
+            --count;
+        }
+        if (count) {
+            vecs->iov_base = (u8*)vecs->iov_base + nread;
+            vecs->iov_len -= nread;
+        }
+    }
+    return true;
+}
+
+static bool send_message(int fd, const MessageHeader& header, const u8* payload)
+{
+    iovec vecs[2] = {
+        { const_cast<MessageHeader*>(&header), sizeof(header) },
+        { const_cast<u8*>(payload), header.payload_size },
+    };
+    ssize_t nwritten = writev(fd, vecs, 2);
+    if (nwritten < 0) {
+        perror("writev");
+        return false;
+    }
+    if ((size_t)nwritten != sizeof(header) + header.payload_size) {
+        fprintf(stderr, "writev: Short write (%d bytes)\n", nwritten);
+        return false;
+    }
+    return true;
+}
+
+static bool receive_message(int fd, MessageHeader& header, ByteBuffer& payload)
+{
+    iovec vec { &header, sizeof(header) };
+    if (!read_exactly(fd, &vec, 1))
+        return false;
+    if ((size_t)payload.size() < header.payload_size)
+        payload = ByteBuffer::create_uninitialized(header.payload_size);
+    iovec payload_vec { payload.data(), header.payload_size };
+    return read_exactly(fd, &payload_vec, 1);
+}
+
+static int run_peer(const char* path)
+{
+    int fd = socket(AF_LOCAL, SOCK_STREAM, 0);
+    if (fd < 0) {
+        perror("socket");
+        return 1;
+    }
+    sockaddr_un address;
+    address.sun_family = AF_LOCAL;
+    strcpy(address.sun_path, path);
+    if (connect(fd, (const sockaddr*)&address, sizeof(address)) < 0) {
+        perror("connect");
+        return 1;
+    }
+
+    ByteBuffer payload;
+    for (;;) {
+        MessageHeader header;
+        if (!receive_message(fd, header, payload))
+            return 1;
+        if (!header.payload_size)
+            break;
+        if (header.should_echo && !send_message(fd, header, payload.data()))
+            return 1;
+    }
+    close(fd);
+    return 0;
+}
+
+static void benchmark_round_trips(int fd, int round_trips, int message_size)
+{
+    auto payload = ByteBuffer::create_zeroed(message_size);
+    ByteBuffer reply;
+    MessageHeader header { (u32)message_size, true };
+
+    u64 start = now_in_usec();
+    for (int i = 0; i < round_trips; ++i) {
+        MessageHeader reply_header;
+        if (!send_message(fd, header, payload.data()) || !receive_message(fd, reply_header, reply))
+            exit(1);
+    }
+    u64 elapsed = max(now_in_usec() - start, (u64)1);
+
+    printf("Round trips: count=%d message_size=%d time=%llums latency=%llu.%02lluus\n",
+        round_trips,
+        message_size,
+        elapsed / 1000,
+        elapsed / round_trips,
+        (elapsed * 100 / round_trips) % 100);
+}
+
+static void benchmark_throughput(int fd, int block_size, int megabytes)
+{
+    auto payload = ByteBuffer::create_zeroed(block_size);
+    ByteBuffer reply;
+    u64 total_bytes = (u64)megabytes * MB;
+    MessageHeader header { (u32)block_size, false };
+
+    u64 start = now_in_usec();
+    for (u64 nsent = 0; nsent < total_bytes; nsent += block_size) {
+        if (!send_message(fd, header, payload.data()))
+            exit(1);
+    }
+    // Wait for the other side to catch up before stopping the clock.
+    MessageHeader sync_header { 1, true };
+    MessageHeader reply_header;
+    if (!send_message(fd, sync_header, payload.data()) || !receive_message(fd, reply_header, reply))
+        exit(1);
+    u64 elapsed = max(now_in_usec() - start, (u64)1);
+
+    printf("Throughput: block_size=%d total=%dMB time=%llums bps=%llu\n",
+        block_size,
+        megabytes,
+        elapsed / 1000,
+        total_bytes * 1000000 / elapsed);
+}
+
+int main(int argc, char** argv)
+{
+    int round_trips = 10000;
+    int message_size = 64;
+    int block_size = 4096;
+    int megabytes = 64;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "hn:s:b:m:")) != -1) {
+        switch (opt) {
+        case 'h':
+            exit_with_usage(0);
+            break;
+        case 'n':
+            round_trips = atoi(optarg);
+            break;
+        case 's':
+            message_size = atoi(optarg);
+            break;
+        case 'b':
+            block_size = atoi(optarg);
+            break;
+        case 'm':
+            megabytes = atoi(optarg);
+            break;
+        default:
+            exit_with_usage(1);
+        }
+    }
+
+    if (round_trips <= 0 || message_size <= 0 || block_size <= 0 || megabytes <= 0)
+        exit_with_usage(1);
+
+    mkdir("/tmp/portal", 0755);
+    auto path = String::format("/tmp/portal/ipc_benchmark.%d", getpid());
+
+    int server_fd = socket(AF_LOCAL, SOCK_STREAM, 0);
+    if (server_fd < 0) {
+        perror("socket");
+        return 1;
+    }
+    sockaddr_un address;
+    address.sun_family = AF_LOCAL;
+    strcpy(address.sun_path, path.characters());
+    if (bind(server_fd, (const sockaddr*)&address, sizeof(address)) < 0) {
+        perror("bind");
+        return 1;
+    }
+    if (listen(server_fd, 1) < 0) {
+        perror("listen");
+        return 1;
+    }
+
+    pid_t peer_pid = fork();
+    if (peer_pid < 0) {
+        perror("fork");
+        return 1;
+    }
+    if (peer_pid == 0) {
+        close(server_fd);
+        return run_peer(path.characters());
+    }
+
+    sockaddr_un peer_address;
+    socklen_t peer_address_size = sizeof(peer_address);
+    int fd = accept(server_fd, (sockaddr*)&peer_address, &peer_address_size);
+    if (fd < 0) {
+        perror("accept");
+        return 1;
+    }
+    close(server_fd);
+    unlink(path.characters());
+
+    benchmark_round_trips(fd, round_trips, message_size);
+    benchmark_throughput(fd, block_size, megabytes);
+
+    MessageHeader goodbye { 0, false };
+    send_message(fd, goodbye, nullptr);
+    close(fd);
+    waitpid(peer_pid, nullptr, 0);
+    return 0;
+}
@@ -0,0 +1,100 @@
+#include <AK/IPv4Address.h>
+#include <AK/JsonArray.h>
+#include <AK/JsonObject.h>
+#include <AK/String.h>
+#include <LibCore/CFile.h>
+#include <net/route.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+
+static void print_usage(const char* argv0)
+{
+    fprintf(stderr, "usage: %s\n", argv0);
+    fprintf(stderr, "       %s add <destination> <netmask> <gateway> [interface]\n", argv0);
+    fprintf(stderr, "       %s del <destination> <netmask>\n", argv0);
+}
+
+static bool parse_address(const char* string, sockaddr& address)
+{
+    auto ipv4_address = IPv4Address::from_string(string);
+    if (!ipv4_address.has_value()) {
+        fprintf(stderr, "Invalid IPv4 address: '%s'\n", string);
+        return false;
+    }
+    address.sa_family = AF_INET;
+    ((sockaddr_in&)address).sin_addr.s_addr = ipv4_address.value().to_in_addr_t();
+    return true;
+}
+
+static int modify_route(int argc, char** argv)
+{
+    bool is_add = !strcmp(argv[1], "add");
+    if ((is_add && (argc < 5 || argc > 6)) || (!is_add && argc != 4)) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    struct rtentry route;
+    memset(&route, 0, sizeof(route));
+    route.rt_flags = RTF_UP;
+
+    if (!parse_address(argv[2], route.rt_dst) || !parse_address(argv[3], route.rt_genmask))
+        return 1;
+
+    if (is_add) {
+        if (!parse_address(argv[4], route.rt_gateway))
+            return 1;
+        if (((sockaddr_in&)route.rt_gateway).sin_addr.s_addr != 0)
+            route.rt_flags |= RTF_GATEWAY;
+        if (argc == 6)
+            route.rt_dev = argv[5];
+    }
+
+    int fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_IP);
+    if (fd < 0) {
+        perror("socket");
+        return 1;
+    }
+
+    int rc = ioctl(fd, is_add ? SIOCADDRT : SIOCDELRT, &route);
+    if (rc < 0) {
+        perror(is_add ? "ioctl(SIOCADDRT)" : "ioctl(SIOCDELRT)");
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc > 1) {
+        if (strcmp(argv[1], "add") && strcmp(argv[1], "del")) {
+            print_usage(argv[0]);
+            return 1;
+        }
+        return modify_route(argc, argv);
+    }
+
+    auto file = CFile::construct("/proc/net/route");
+    if (!file->open(CIODevice::ReadOnly)) {
+        fprintf(stderr, "Error: %s\n", file->error_string());
+        return 1;
+    }
+
+    printf("Destination      Netmask          Gateway          Interface\n");
+
+    auto file_contents = file->read_all();
+    auto json = JsonValue::from_string(file_contents).as_array();
+    json.for_each([](auto& value) {
+        auto route = value.as_object();
+        printf("%-16s %-16s %-16s %s\n",
+            route.get("destination").to_string().characters(),
+            route.get("netmask").to_string().characters(),
+            route.get("gateway").to_string().characters(),
+            route.get("adapter").to_string().characters());
+    });
+
+    return 0;
+}
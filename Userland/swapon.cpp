@@ -0,0 +1,15 @@
+#include <serenity.h>
+#include <stdio.h>
+
+int main(int argc, char** argv)
+{
+    if (argc != 2) {
+        fprintf(stderr, "usage: swapon <path>\n");
+        return 1;
+    }
+    if (swapon(argv[1]) < 0) {
+        perror("swapon");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,62 @@
+#include <AK/String.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+
+// Touch more anonymous memory than the machine has, then check that every page
+// comes back intact. With swap active (and e.g. QEMU booted with -m 64), this
+// pushes pages out to swap and faults them back in.
+
+static u32 pattern_for(size_t page, size_t word)
+{
+    return (u32)(page * 2654435761u) ^ (u32)word;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 2) {
+        fprintf(stderr, "usage: test_swap <megabytes>\n");
+        return 1;
+    }
+    bool ok;
+    unsigned megabytes = String(argv[1]).to_uint(ok);
+    if (!ok || !megabytes) {
+        fprintf(stderr, "test_swap: invalid size '%s'\n", argv[1]);
+        return 1;
+    }
+
+    size_t size = megabytes * MB;
+    size_t page_count = size / PAGE_SIZE;
+    size_t words_per_page = PAGE_SIZE / sizeof(u32);
+    auto* data = (u32*)mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, 0, 0);
+    if (data == MAP_FAILED) {
+        perror("mmap");
+        return 1;
+    }
+
+    printf("Filling %u pages...\n", page_count);
+    for (size_t page = 0; page < page_count; ++page) {
+        u32* words = data + page * words_per_page;
+        for (size_t word = 0; word < words_per_page; ++word)
+            words[word] = pattern_for(page, word);
+    }
+
+    // Go over everything twice, so pages that were faulted back in the first
+    // time around get pushed out again before we read them the second time.
+    for (int pass = 1; pass <= 2; ++pass) {
+        printf("Verifying (pass %d)...\n", pass);
+        for (size_t page = 0; page < page_count; ++page) {
+            u32* words = data + page * words_per_page;
+            for (size_t word = 0; word < words_per_page; ++word) {
+                if (words[word] != pattern_for(page, word)) {
+                    fprintf(stderr, "test_swap: mismatch in page %u at word %u: %08x != %08x\n", page, word, words[word], pattern_for(page, word));
+                    return 1;
+                }
+            }
+        }
+    }
+
+    printf("PASS\n");
+    return 0;
+}